@@ -139,11 +139,24 @@ server_option = ('serverId', {
     'help': 'To target a specific server, include an int32 "serverId" field. Obtain the id by calling :symbol:`mongoc_client_select_server`, then :symbol:`mongoc_server_description_id` on its return value.'
 })
 
+timeout_option = ('timeoutMS', {
+    'type': 'int64_t',
+    'convert': '_mongoc_convert_int64_positive',
+    'help': 'A positive number of milliseconds the whole operation may take, including server selection, connecting, authenticating, and waiting for the reply. Overrides the ``timeoutMS`` URI option.'
+})
+
+pipeline_depth_option = ('pipelineDepth', {
+    'type': 'int32_t',
+    'convert': '_mongoc_convert_int32_positive',
+    'help': 'A positive number of write batches to keep in flight on the connection for an unordered bulk write. Batches are sent without waiting for the previous reply, and results are merged in order. Defaults to 1. Ignored for ordered bulk writes, retryable writes and transactions.'
+})
+
 opts_structs = OrderedDict([
     ('mongoc_crud_opts_t', Shared([
         write_concern_option,
         session_option,
         validate_option,
+        timeout_option,
     ])),
 
     ('mongoc_update_opts_t', Shared([
@@ -192,7 +205,9 @@ opts_structs = OrderedDict([
         write_concern_option,
         ordered_option,
         session_option,
-    ], allow_extra=False, ordered='true')),
+        timeout_option,
+        pipeline_depth_option,
+    ], allow_extra=False, ordered='true', pipelineDepth='1')),
 
     ('mongoc_bulk_insert_opts_t', Struct([
         validate_option,
@@ -258,6 +273,7 @@ opts_structs = OrderedDict([
         session_option,
         collation_option,
         server_option,
+        timeout_option,
     ])),
 
     # Only for documentation - we use mongoc_read_write_opts_t for real parsing.
@@ -266,6 +282,7 @@ opts_structs = OrderedDict([
         session_option,
         collation_option,
         server_option,
+        timeout_option,
     ], generate_code=False)),
 
     ('mongoc_write_opts_t', Struct([
@@ -273,6 +290,7 @@ opts_structs = OrderedDict([
         session_option,
         collation_option,
         server_option,
+        timeout_option,
     ], generate_code=False)),
 ])
 
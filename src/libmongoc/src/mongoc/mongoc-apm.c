@@ -31,17 +31,36 @@ append_documents_from_cmd (const mongoc_cmd_t *cmd,
 {
    int32_t doc_len;
    bson_t doc;
+   const uint8_t *payload;
    const uint8_t *pos;
+   uint8_t *gathered = NULL;
    const char *field_name;
    bson_t bson;
    char str[16];
    const char *key;
    uint32_t i;
+   size_t j;
+   size_t off;
 
-   if (!cmd->payload || !cmd->payload_size) {
+   if ((!cmd->payload && !cmd->payload_iov) || !cmd->payload_size) {
       return;
    }
 
+   payload = cmd->payload;
+   if (cmd->payload_iov) {
+      /* a document may span buffers, copy them together for the event */
+      gathered = (uint8_t *) bson_malloc ((size_t) cmd->payload_size);
+      for (j = 0, off = 0; j < cmd->payload_iovcnt; j++) {
+         memcpy (gathered + off,
+                 cmd->payload_iov[j].iov_base,
+                 cmd->payload_iov[j].iov_len);
+         off += cmd->payload_iov[j].iov_len;
+      }
+
+      BSON_ASSERT (off == (size_t) cmd->payload_size);
+      payload = gathered;
+   }
+
    if (!event->command_owned) {
       event->command = bson_copy (event->command);
       event->command_owned = true;
@@ -53,9 +72,9 @@ append_documents_from_cmd (const mongoc_cmd_t *cmd,
    BSON_ASSERT (field_name);
    BSON_ASSERT (BSON_APPEND_ARRAY_BEGIN (event->command, field_name, &bson));
 
-   pos = cmd->payload;
+   pos = payload;
    i = 0;
-   while (pos < cmd->payload + cmd->payload_size) {
+   while (pos < payload + cmd->payload_size) {
       memcpy (&doc_len, pos, sizeof (doc_len));
       doc_len = BSON_UINT32_FROM_LE (doc_len);
       BSON_ASSERT (bson_init_static (&doc, pos, (size_t) doc_len));
@@ -67,6 +86,7 @@ append_documents_from_cmd (const mongoc_cmd_t *cmd,
    }
 
    bson_append_array_end (event->command, &bson);
+   bson_free (gathered);
 }
 
 
@@ -134,22 +134,36 @@ mongoc_async_cmd_run (mongoc_async_cmd_t *acmd)
 }
 
 void
-_mongoc_async_cmd_init_send (mongoc_async_cmd_t *acmd, const char *dbname)
+_mongoc_async_cmd_init_send (const int32_t cmd_opcode,
+                             mongoc_async_cmd_t *acmd,
+                             const char *dbname)
 {
-   bson_snprintf (acmd->ns, sizeof acmd->ns, "%s.$cmd", dbname);
-
    acmd->rpc.header.msg_len = 0;
    acmd->rpc.header.request_id = ++acmd->async->request_id;
    acmd->rpc.header.response_to = 0;
-   acmd->rpc.header.opcode = MONGOC_OPCODE_QUERY;
-   acmd->rpc.query.flags = MONGOC_QUERY_SLAVE_OK;
-   acmd->rpc.query.collection = acmd->ns;
-   acmd->rpc.query.skip = 0;
-   acmd->rpc.query.n_return = -1;
-   acmd->rpc.query.query = bson_get_data (&acmd->cmd);
-   acmd->rpc.query.fields = NULL;
-
-   /* This will always be isMaster, which are not allowed to be compressed */
+
+   if (cmd_opcode == MONGOC_OPCODE_MSG) {
+      /* the command already carries "$db" */
+      acmd->rpc.header.opcode = MONGOC_OPCODE_MSG;
+      acmd->rpc.msg.flags = 0;
+      acmd->rpc.msg.n_sections = 1;
+      acmd->rpc.msg.sections[0].payload_type = 0;
+      acmd->rpc.msg.sections[0].payload.bson_document =
+         bson_get_data (&acmd->cmd);
+   } else {
+      bson_snprintf (acmd->ns, sizeof acmd->ns, "%s.$cmd", dbname);
+
+      acmd->rpc.header.opcode = MONGOC_OPCODE_QUERY;
+      acmd->rpc.query.flags = MONGOC_QUERY_SLAVE_OK;
+      acmd->rpc.query.collection = acmd->ns;
+      acmd->rpc.query.skip = 0;
+      acmd->rpc.query.n_return = -1;
+      acmd->rpc.query.query = bson_get_data (&acmd->cmd);
+      acmd->rpc.query.fields = NULL;
+   }
+
+   /* Neither isMaster nor the commands of mongoc_client_async_command are
+    * compressed */
    _mongoc_rpc_gather (&acmd->rpc, &acmd->array);
    acmd->iovec = (mongoc_iovec_t *) acmd->array.data;
    acmd->niovec = acmd->array.len;
@@ -182,6 +196,7 @@ mongoc_async_cmd_new (mongoc_async_t *async,
                       void *setup_ctx,
                       const char *dbname,
                       const bson_t *cmd,
+                      const int32_t cmd_opcode, /* OP_QUERY or OP_MSG */
                       mongoc_async_cmd_cb_t cb,
                       void *cb_data,
                       int64_t timeout_msec)
@@ -208,7 +223,7 @@ mongoc_async_cmd_new (mongoc_async_t *async,
    _mongoc_array_init (&acmd->array, sizeof (mongoc_iovec_t));
    _mongoc_buffer_init (&acmd->buffer, NULL, 0, NULL, NULL);
 
-   _mongoc_async_cmd_init_send (acmd, dbname);
+   _mongoc_async_cmd_init_send (cmd_opcode, acmd, dbname);
 
    _mongoc_async_cmd_state_start (acmd, is_setup_done);
 
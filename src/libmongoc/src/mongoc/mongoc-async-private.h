@@ -66,6 +66,12 @@ mongoc_async_destroy (mongoc_async_t *async);
 void
 mongoc_async_run (mongoc_async_t *async);
 
+bool
+mongoc_async_cmd_handle_revents (struct _mongoc_async_cmd *acmd, int revents);
+
+void
+mongoc_async_expire (mongoc_async_t *async, int64_t now);
+
 BSON_END_DECLS
 
 #endif /* MONGOC_ASYNC_PRIVATE_H */
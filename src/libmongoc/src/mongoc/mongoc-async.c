@@ -135,29 +135,8 @@ mongoc_async_run (mongoc_async_t *async)
 
       if (nactive > 0) {
          for (i = 0; i < nstreams; i++) {
-            mongoc_async_cmd_t *iter = acmds_polled[i];
-            if (poller[i].revents & (POLLERR | POLLHUP)) {
-               int hup = poller[i].revents & POLLHUP;
-               if (iter->state == MONGOC_ASYNC_CMD_SEND) {
-                  bson_set_error (&iter->error,
-                                  MONGOC_ERROR_STREAM,
-                                  MONGOC_ERROR_STREAM_CONNECT,
-                                  hup ? "connection refused"
-                                      : "unknown connection error");
-               } else {
-                  bson_set_error (&iter->error,
-                                  MONGOC_ERROR_STREAM,
-                                  MONGOC_ERROR_STREAM_SOCKET,
-                                  hup ? "connection closed"
-                                      : "unknown socket error");
-               }
-
-               iter->state = MONGOC_ASYNC_CMD_ERROR_STATE;
-            }
-
-            if ((poller[i].revents & poller[i].events) ||
-                iter->state == MONGOC_ASYNC_CMD_ERROR_STATE) {
-               (void) mongoc_async_cmd_run (iter);
+            if (mongoc_async_cmd_handle_revents (acmds_polled[i],
+                                                 poller[i].revents)) {
                nactive--;
             }
 
@@ -167,35 +146,7 @@ mongoc_async_run (mongoc_async_t *async)
          }
       }
 
-      DL_FOREACH_SAFE (async->cmds, acmd, tmp)
-      {
-         bool remove_cmd = false;
-         mongoc_async_cmd_result_t result;
-
-         /* check if an initiated cmd has passed the connection timeout.  */
-         if (acmd->state != MONGOC_ASYNC_CMD_INITIATE &&
-             now > acmd->connect_started + acmd->timeout_msec * 1000) {
-            bson_set_error (&acmd->error,
-                            MONGOC_ERROR_STREAM,
-                            MONGOC_ERROR_STREAM_CONNECT,
-                            acmd->state == MONGOC_ASYNC_CMD_SEND
-                               ? "connection timeout"
-                               : "socket timeout");
-
-            remove_cmd = true;
-            result = MONGOC_ASYNC_CMD_TIMEOUT;
-         } else if (acmd->state == MONGOC_ASYNC_CMD_CANCELED_STATE) {
-            remove_cmd = true;
-            result = MONGOC_ASYNC_CMD_ERROR;
-         }
-
-         if (remove_cmd) {
-            acmd->cb (acmd, result, NULL, (now - acmd->connect_started) / 1000);
-
-            /* Remove acmd from the async->cmds doubly-linked list */
-            mongoc_async_cmd_destroy (acmd);
-         }
-      }
+      mongoc_async_expire (async, now);
 
       now = bson_get_monotonic_time ();
    }
@@ -203,3 +154,99 @@ mongoc_async_run (mongoc_async_t *async)
    bson_free (poller);
    bson_free (acmds_polled);
 }
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_async_cmd_handle_revents --
+ *
+ *       Advance @acmd if @revents, the result of polling its stream for
+ *       acmd->events, says it is ready or its connection failed.
+ *
+ * Returns:
+ *       True if @acmd was run, false if it is still waiting.
+ *
+ * Side effects:
+ *       @acmd is destroyed if it completed or failed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_async_cmd_handle_revents (mongoc_async_cmd_t *acmd, int revents)
+{
+   if (revents & (POLLERR | POLLHUP)) {
+      int hup = revents & POLLHUP;
+      if (acmd->state == MONGOC_ASYNC_CMD_SEND) {
+         bson_set_error (&acmd->error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_CONNECT,
+                         hup ? "connection refused"
+                             : "unknown connection error");
+      } else {
+         bson_set_error (&acmd->error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         hup ? "connection closed" : "unknown socket error");
+      }
+
+      acmd->state = MONGOC_ASYNC_CMD_ERROR_STATE;
+   }
+
+   if ((revents & acmd->events) ||
+       acmd->state == MONGOC_ASYNC_CMD_ERROR_STATE) {
+      (void) mongoc_async_cmd_run (acmd);
+      return true;
+   }
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_async_expire --
+ *
+ *       Fail each initiated command of @async that has passed its timeout
+ *       as of @now, and remove canceled commands.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_async_expire (mongoc_async_t *async, int64_t now)
+{
+   mongoc_async_cmd_t *acmd, *tmp;
+
+   DL_FOREACH_SAFE (async->cmds, acmd, tmp)
+   {
+      bool remove_cmd = false;
+      mongoc_async_cmd_result_t result;
+
+      /* check if an initiated cmd has passed the connection timeout.  */
+      if (acmd->state != MONGOC_ASYNC_CMD_INITIATE &&
+          now > acmd->connect_started + acmd->timeout_msec * 1000) {
+         bson_set_error (&acmd->error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_CONNECT,
+                         acmd->state == MONGOC_ASYNC_CMD_SEND
+                            ? "connection timeout"
+                            : "socket timeout");
+
+         remove_cmd = true;
+         result = MONGOC_ASYNC_CMD_TIMEOUT;
+      } else if (acmd->state == MONGOC_ASYNC_CMD_CANCELED_STATE) {
+         remove_cmd = true;
+         result = MONGOC_ASYNC_CMD_ERROR;
+      }
+
+      if (remove_cmd) {
+         acmd->cb (acmd, result, NULL, (now - acmd->connect_started) / 1000);
+
+         /* Remove acmd from the async->cmds doubly-linked list */
+         mongoc_async_cmd_destroy (acmd);
+      }
+   }
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_ATOMIC_PRIVATE_H
+#define MONGOC_ATOMIC_PRIVATE_H
+
+#if !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+BSON_BEGIN_DECLS
+
+/* pointer-sized atomics, which libbson does not provide. like libbson's
+ * atomics these are full barriers */
+
+#if defined(_WIN32)
+#define _mongoc_atomic_ptr_cas(p, expected, desired)                \
+   (InterlockedCompareExchangePointer (                             \
+       (PVOID volatile *) (p), (PVOID) (desired), (PVOID) (expected)) == \
+    (PVOID) (expected))
+#define _mongoc_atomic_ptr_exchange(p, v) \
+   InterlockedExchangePointer ((PVOID volatile *) (p), (PVOID) (v))
+#elif defined(__GNUC__)
+#define _mongoc_atomic_ptr_cas(p, expected, desired) \
+   __sync_bool_compare_and_swap ((p), (expected), (desired))
+static BSON_INLINE void *
+_mongoc_atomic_ptr_exchange (void *volatile *p, void *v)
+{
+   void *old;
+
+   do {
+      old = *p;
+   } while (!__sync_bool_compare_and_swap (p, old, v));
+
+   return old;
+}
+#else
+#error "No atomic compare-and-swap for this compiler."
+#endif
+
+/* read a pointer that other threads update with the functions above */
+static BSON_INLINE void *
+_mongoc_atomic_ptr_get (void *volatile *p)
+{
+   void *v = *p;
+   bson_memory_barrier ();
+   return v;
+}
+
+/* read a 64-bit integer without tearing, even while other threads update
+ * it. no barriers: readers may see an older value */
+static BSON_INLINE int64_t
+_mongoc_atomic_int64_get (volatile int64_t *p)
+{
+#if BSON_WORD_SIZE == 64
+   return *p;
+#else
+   return bson_atomic_int64_add (p, 0);
+#endif
+}
+
+/* callers must serialize writers, e.g. with a mutex */
+static BSON_INLINE void
+_mongoc_atomic_int64_set (volatile int64_t *p, int64_t v)
+{
+#if BSON_WORD_SIZE == 64
+   *p = v;
+#else
+   bson_atomic_int64_add (p, v - *p);
+#endif
+}
+
+/* 64-bit compare-and-swap, a full barrier. true if *p was @expected and is
+ * now @desired */
+static BSON_INLINE bool
+_mongoc_atomic_int64_cas (volatile int64_t *p,
+                          int64_t expected,
+                          int64_t desired)
+{
+#if defined(_WIN32)
+   return InterlockedCompareExchange64 ((LONGLONG volatile *) p,
+                                        (LONGLONG) desired,
+                                        (LONGLONG) expected) ==
+          (LONGLONG) expected;
+#else
+   return __sync_bool_compare_and_swap (p, expected, desired);
+#endif
+}
+
+/* store a 64-bit integer that several threads may write at once */
+static BSON_INLINE void
+_mongoc_atomic_int64_store (volatile int64_t *p, int64_t v)
+{
+   int64_t old;
+
+   do {
+      old = _mongoc_atomic_int64_get (p);
+   } while (!_mongoc_atomic_int64_cas (p, old, v));
+}
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_ATOMIC_PRIVATE_H */
@@ -40,6 +40,24 @@ struct _mongoc_bulk_operation_t {
    mongoc_write_result_t result;
    bool executed;
    int64_t operation_id;
+   int64_t timeout_ms; /* the "timeoutMS" option, or 0 */
+   int32_t pipeline_depth; /* the "pipelineDepth" option, 1 by default */
+
+   /* see mongoc_bulk_operation_set_auto_flush */
+   bool auto_flush;
+   bool counts_only;
+   bool stopped; /* an auto flush failed and the bulk can't go on */
+   size_t max_buffered_bytes;
+   /* payload bytes of commands[0 .. buffered_commands - 1] */
+   size_t buffered_bytes;
+   size_t buffered_commands;
+   /* server limits, from the last server used */
+   int32_t max_write_batch_size;
+   int32_t max_msg_size;
+   uint32_t n_flushed; /* operations sent by auto flushes so far */
+   bson_error_t flush_error; /* the first auto flush error */
+   mongoc_bulk_operation_error_cb_t error_cb;
+   void *error_cb_context;
 };
 
 
@@ -54,6 +54,9 @@ mongoc_bulk_operation_new (bool ordered)
       MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT;
    bulk->flags.ordered = ordered;
    bulk->server_id = 0;
+   bulk->pipeline_depth = 1;
+   bulk->max_write_batch_size = MONGOC_DEFAULT_WRITE_BATCH_SIZE;
+   bulk->max_msg_size = MONGOC_DEFAULT_MAX_MSG_SIZE;
 
    _mongoc_array_init (&bulk->commands, sizeof (mongoc_write_command_t));
    _mongoc_write_result_init (&bulk->result);
@@ -123,6 +126,14 @@ mongoc_bulk_operation_destroy (mongoc_bulk_operation_t *bulk) /* IN */
 
 #define BULK_RETURN_IF_PRIOR_ERROR                                            \
    do {                                                                       \
+      if (bulk->stopped) {                                                    \
+         bson_set_error (error,                                               \
+                         MONGOC_ERROR_COMMAND,                                \
+                         MONGOC_ERROR_COMMAND_INVALID_ARG,                    \
+                         "Bulk operation stopped after an error: %s",         \
+                         bulk->flush_error.message);                          \
+         return false;                                                        \
+      }                                                                       \
       if (bulk->result.error.domain) {                                        \
          if (error != &bulk->result.error) {                                  \
             bson_set_error (error,                                            \
@@ -136,6 +147,10 @@ mongoc_bulk_operation_destroy (mongoc_bulk_operation_t *bulk) /* IN */
    } while (0)
 
 
+static void
+_mongoc_bulk_operation_auto_flush (mongoc_bulk_operation_t *bulk);
+
+
 bool
 _mongoc_bulk_operation_remove_with_opts (
    mongoc_bulk_operation_t *bulk,
@@ -198,6 +213,11 @@ _mongoc_bulk_operation_remove_with_opts (
 
 done:
    bson_destroy (&opts);
+
+   if (ret) {
+      _mongoc_bulk_operation_auto_flush (bulk);
+   }
+
    RETURN (ret);
 }
 
@@ -392,6 +412,11 @@ mongoc_bulk_operation_insert_with_opts (mongoc_bulk_operation_t *bulk,
 
 done:
    _mongoc_bulk_insert_opts_cleanup (&insert_opts);
+
+   if (ret) {
+      _mongoc_bulk_operation_auto_flush (bulk);
+   }
+
    RETURN (ret);
 }
 
@@ -436,6 +461,7 @@ _mongoc_bulk_operation_update_append (
          last->flags.has_multi_write |= update_opts->multi;
          _mongoc_write_command_update_append (last, selector, document, &opts);
          bson_destroy (&opts);
+         _mongoc_bulk_operation_auto_flush (bulk);
          return;
       }
    }
@@ -449,6 +475,7 @@ _mongoc_bulk_operation_update_append (
 
    _mongoc_array_append_val (&bulk->commands, command);
    bson_destroy (&opts);
+   _mongoc_bulk_operation_auto_flush (bulk);
 }
 
 static bool
@@ -687,17 +714,208 @@ mongoc_bulk_operation_replace_one (mongoc_bulk_operation_t *bulk,
    EXIT;
 }
 
+/* send the queued commands, numbering their operations from n_flushed.
+ * returns false if no server could be selected, with reply initialized and
+ * error set */
+static bool
+_mongoc_bulk_operation_run (mongoc_bulk_operation_t *bulk,
+                            bson_t *reply,
+                            bson_error_t *error)
+{
+   mongoc_cluster_t *cluster;
+   mongoc_write_command_t *command;
+   mongoc_server_stream_t *server_stream;
+   int64_t prev_deadline;
+   uint32_t offset = bulk->n_flushed;
+   int i;
+
+   cluster = &bulk->client->cluster;
+
+   /* the whole bulk write shares one timeoutMS */
+   prev_deadline = _mongoc_cluster_begin_operation (cluster, bulk->timeout_ms);
+
+   for (i = 0; i < bulk->commands.len; i++) {
+      if (bulk->server_id) {
+         server_stream =
+            mongoc_cluster_stream_for_server (cluster,
+                                              bulk->server_id,
+                                              true /* reconnect_ok */,
+                                              bulk->session,
+                                              reply,
+                                              error);
+      } else {
+         server_stream = mongoc_cluster_stream_for_writes (
+            cluster, bulk->session, reply, error);
+      }
+
+      if (!server_stream) {
+         /* stream_for_server and stream_for_writes initialize reply on error */
+         _mongoc_cluster_end_operation (cluster, prev_deadline);
+         return false;
+      }
+
+      command =
+         &_mongoc_array_index (&bulk->commands, mongoc_write_command_t, i);
+      command->pipeline_depth = (uint32_t) bulk->pipeline_depth;
+
+      _mongoc_write_command_execute (command,
+                                     bulk->client,
+                                     server_stream,
+                                     bulk->database,
+                                     bulk->collection,
+                                     bulk->write_concern,
+                                     offset,
+                                     bulk->session,
+                                     &bulk->result);
+
+      bulk->server_id = server_stream->sd->id;
+      bulk->max_write_batch_size =
+         mongoc_server_stream_max_write_batch_size (server_stream);
+      bulk->max_msg_size = mongoc_server_stream_max_msg_size (server_stream);
+
+      if (bulk->result.failed &&
+          (bulk->flags.ordered || bulk->result.must_stop)) {
+         mongoc_server_stream_cleanup (server_stream);
+         break;
+      }
+
+      offset += command->n_documents;
+      mongoc_server_stream_cleanup (server_stream);
+   }
+
+   _mongoc_cluster_end_operation (cluster, prev_deadline);
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_bulk_operation_flush --
+ *
+ *       Send the operations queued so far and forget them, keeping only
+ *       their results. Errors are passed to the bulk's error callback; in
+ *       "counts only" mode the per-operation results are dropped once the
+ *       callback has seen them, so memory stays bounded however many
+ *       operations the bulk streams.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_bulk_operation_flush (mongoc_bulk_operation_t *bulk)
+{
+   mongoc_write_result_t *result = &bulk->result;
+   mongoc_write_command_t *command;
+   uint32_t write_errors_len = result->writeErrors.len;
+   uint32_t n_write_concern_errors = result->n_writeConcernErrors;
+   bool was_failed = result->failed;
+   bson_error_t error = {0};
+   bson_t reply;
+   int i;
+
+   ENTRY;
+
+   if (!_mongoc_bulk_operation_run (bulk, &reply, &error)) {
+      /* the queued operations were not sent */
+      result->failed = true;
+      result->must_stop = true;
+   } else {
+      bson_init (&reply);
+
+      if (result->writeErrors.len != write_errors_len ||
+          result->n_writeConcernErrors != n_write_concern_errors ||
+          result->error.code || (result->failed && !was_failed)) {
+         MONGOC_WRITE_RESULT_COMPLETE (result,
+                                       bulk->client->error_api_version,
+                                       bulk->write_concern,
+                                       MONGOC_ERROR_COMMAND /* err domain */,
+                                       &reply,
+                                       &error);
+      }
+   }
+
+   if (error.code && bulk->error_cb) {
+      bulk->error_cb (&reply, &error, bulk->error_cb_context);
+   }
+
+   if (error.code && !bulk->flush_error.code) {
+      memcpy (&bulk->flush_error, &error, sizeof error);
+   }
+
+   bson_destroy (&reply);
+
+   /* the error is in flush_error now; appends must not see it as a prior
+    * error, an unordered bulk goes on after a failed flush */
+   memset (&result->error, 0, sizeof result->error);
+
+   if (bulk->counts_only) {
+      bson_reinit (&result->upserted);
+      bson_reinit (&result->writeErrors);
+      bson_reinit (&result->writeConcernErrors);
+      result->n_writeConcernErrors = 0;
+      result->upsert_append_count = 0;
+   }
+
+   if (result->failed && (bulk->flags.ordered || result->must_stop)) {
+      bulk->stopped = true;
+   }
+
+   for (i = 0; i < bulk->commands.len; i++) {
+      command =
+         &_mongoc_array_index (&bulk->commands, mongoc_write_command_t, i);
+      bulk->n_flushed += command->n_documents;
+      _mongoc_write_command_destroy (command);
+   }
+
+   bulk->commands.len = 0;
+   bulk->buffered_bytes = 0;
+   bulk->buffered_commands = 0;
+
+   EXIT;
+}
+
+
+/* flush if the last command fills a batch or the bulk buffers too much */
+static void
+_mongoc_bulk_operation_auto_flush (mongoc_bulk_operation_t *bulk)
+{
+   mongoc_write_command_t *command;
+   size_t max_bytes;
+
+   if (!bulk->auto_flush || !bulk->commands.len || !bulk->client ||
+       !bulk->database || !bulk->collection) {
+      return;
+   }
+
+   /* the total for all but the last command, which may still grow */
+   while (bulk->buffered_commands + 1 < bulk->commands.len) {
+      command = &_mongoc_array_index (
+         &bulk->commands, mongoc_write_command_t, bulk->buffered_commands);
+      bulk->buffered_bytes += command->payload.len;
+      bulk->buffered_commands++;
+   }
+
+   command = &_mongoc_array_index (
+      &bulk->commands, mongoc_write_command_t, bulk->commands.len - 1);
+
+   max_bytes = bulk->max_buffered_bytes ? bulk->max_buffered_bytes
+                                        : (size_t) bulk->max_msg_size;
+
+   if (command->n_documents >= bulk->max_write_batch_size ||
+       bulk->buffered_bytes + command->payload.len >= max_bytes) {
+      _mongoc_bulk_operation_flush (bulk);
+   }
+}
+
+
 uint32_t
 mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
                                bson_t *reply,                 /* OUT */
                                bson_error_t *error)           /* OUT */
 {
-   mongoc_cluster_t *cluster;
-   mongoc_write_command_t *command;
-   mongoc_server_stream_t *server_stream;
    bool ret;
-   uint32_t offset = 0;
-   int i;
 
    ENTRY;
 
@@ -711,7 +929,6 @@ mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
                       "and one has not been set.");
       GOTO (err);
    }
-   cluster = &bulk->client->cluster;
 
    if (bulk->executed) {
       _mongoc_write_result_destroy (&bulk->result);
@@ -746,7 +963,7 @@ mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
       GOTO (err);
    }
 
-   if (!bulk->commands.len) {
+   if (!bulk->commands.len && !bulk->n_flushed) {
       bson_set_error (error,
                       MONGOC_ERROR_COMMAND,
                       MONGOC_ERROR_COMMAND_INVALID_ARG,
@@ -754,51 +971,12 @@ mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
       GOTO (err);
    }
 
-   for (i = 0; i < bulk->commands.len; i++) {
-      if (bulk->server_id) {
-         server_stream =
-            mongoc_cluster_stream_for_server (cluster,
-                                              bulk->server_id,
-                                              true /* reconnect_ok */,
-                                              bulk->session,
-                                              reply,
-                                              error);
-      } else {
-         server_stream = mongoc_cluster_stream_for_writes (
-            cluster, bulk->session, reply, error);
-      }
-
-      if (!server_stream) {
-         /* stream_for_server and stream_for_writes initialize reply on error */
-         RETURN (false);
-      }
-
-      command =
-         &_mongoc_array_index (&bulk->commands, mongoc_write_command_t, i);
-
-      _mongoc_write_command_execute (command,
-                                     bulk->client,
-                                     server_stream,
-                                     bulk->database,
-                                     bulk->collection,
-                                     bulk->write_concern,
-                                     offset,
-                                     bulk->session,
-                                     &bulk->result);
-
-      bulk->server_id = server_stream->sd->id;
-
-      if (bulk->result.failed &&
-          (bulk->flags.ordered || bulk->result.must_stop)) {
-         mongoc_server_stream_cleanup (server_stream);
-         GOTO (cleanup);
-      }
-
-      offset += command->n_documents;
-      mongoc_server_stream_cleanup (server_stream);
+   /* send whatever auto flushes left */
+   if (bulk->commands.len && !bulk->stopped &&
+       !_mongoc_bulk_operation_run (bulk, reply, error)) {
+      RETURN (false);
    }
 
-cleanup:
    _mongoc_bson_init_if_set (reply);
    ret = MONGOC_WRITE_RESULT_COMPLETE (&bulk->result,
                                        bulk->client->error_api_version,
@@ -807,6 +985,11 @@ cleanup:
                                        reply,
                                        error);
 
+   /* in "counts only" mode the failed flush's errors are gone */
+   if (!ret && error && !error->code && bulk->flush_error.code) {
+      memcpy (error, &bulk->flush_error, sizeof (bson_error_t));
+   }
+
    RETURN (ret ? bulk->server_id : 0);
 
 err:
@@ -934,3 +1117,29 @@ mongoc_bulk_operation_set_bypass_document_validation (
       bypass ? MONGOC_BYPASS_DOCUMENT_VALIDATION_TRUE
              : MONGOC_BYPASS_DOCUMENT_VALIDATION_FALSE;
 }
+
+
+void
+mongoc_bulk_operation_set_auto_flush (mongoc_bulk_operation_t *bulk,
+                                      size_t max_buffered_bytes,
+                                      bool counts_only)
+{
+   BSON_ASSERT (bulk);
+
+   bulk->auto_flush = true;
+   bulk->max_buffered_bytes = max_buffered_bytes;
+   bulk->counts_only = counts_only;
+}
+
+
+void
+mongoc_bulk_operation_set_error_callback (
+   mongoc_bulk_operation_t *bulk,
+   mongoc_bulk_operation_error_cb_t error_cb,
+   void *context)
+{
+   BSON_ASSERT (bulk);
+
+   bulk->error_cb = error_cb;
+   bulk->error_cb_context = context;
+}
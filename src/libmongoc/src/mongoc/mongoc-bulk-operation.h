@@ -37,6 +37,9 @@ struct _mongoc_client_session_t;
 
 typedef struct _mongoc_bulk_operation_t mongoc_bulk_operation_t;
 typedef struct _mongoc_bulk_write_flags_t mongoc_bulk_write_flags_t;
+typedef void (*mongoc_bulk_operation_error_cb_t) (const bson_t *reply,
+                                                 const bson_error_t *error,
+                                                 void *context);
 
 
 MONGOC_EXPORT (void)
@@ -113,6 +116,15 @@ mongoc_bulk_operation_update_one_with_opts (mongoc_bulk_operation_t *bulk,
 MONGOC_EXPORT (void)
 mongoc_bulk_operation_set_bypass_document_validation (
    mongoc_bulk_operation_t *bulk, bool bypass);
+MONGOC_EXPORT (void)
+mongoc_bulk_operation_set_auto_flush (mongoc_bulk_operation_t *bulk,
+                                      size_t max_buffered_bytes,
+                                      bool counts_only);
+MONGOC_EXPORT (void)
+mongoc_bulk_operation_set_error_callback (
+   mongoc_bulk_operation_t *bulk,
+   mongoc_bulk_operation_error_cb_t error_cb,
+   void *context);
 
 
 /*
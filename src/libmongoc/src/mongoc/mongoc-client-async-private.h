@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_CLIENT_ASYNC_PRIVATE_H
+#define MONGOC_CLIENT_ASYNC_PRIVATE_H
+
+#if !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-async-private.h"
+#include "mongoc-client.h"
+#include "mongoc-cluster-private.h"
+
+BSON_BEGIN_DECLS
+
+/* a connection owned by the async layer, separate from the cluster's own
+ * connections so async I/O never interleaves with blocking operations or
+ * with the topology scanner */
+typedef struct _mongoc_client_async_conn_t {
+   uint32_t server_id;
+   mongoc_cluster_node_t *node;
+   struct _mongoc_client_async_conn_t *next;
+} mongoc_client_async_conn_t;
+
+/* an in-flight command, the "data" of its mongoc_async_cmd_t */
+typedef struct _mongoc_client_async_op_t {
+   mongoc_client_t *client;
+   mongoc_client_async_conn_t *conn;
+   mongoc_client_async_cb_t cb;
+   void *ctx;
+} mongoc_client_async_op_t;
+
+typedef struct _mongoc_client_async_t {
+   mongoc_async_t *async;
+   /* connections with no command in flight, most recently used first */
+   mongoc_client_async_conn_t *idle;
+} mongoc_client_async_t;
+
+void
+_mongoc_client_async_destroy (mongoc_client_async_t *client_async);
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_CLIENT_ASYNC_PRIVATE_H */
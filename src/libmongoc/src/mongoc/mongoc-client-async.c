@@ -0,0 +1,438 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-async-cmd-private.h"
+#include "mongoc-client-async-private.h"
+#include "mongoc-client-private.h"
+#include "mongoc-cmd-private.h"
+#include "mongoc-error.h"
+#include "mongoc-opcode.h"
+#include "mongoc-socket-private.h"
+#include "mongoc-stream-private.h"
+#include "mongoc-stream-socket.h"
+#include "mongoc-topology-private.h"
+#include "mongoc-trace-private.h"
+#include "utlist.h"
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "client-async"
+
+
+static mongoc_socket_t *
+_mongoc_client_async_get_socket (mongoc_stream_t *stream)
+{
+   mongoc_stream_t *base;
+
+   while (stream->type != MONGOC_STREAM_SOCKET) {
+      base = mongoc_stream_get_base_stream (stream);
+      if (!base || base == stream) {
+         return NULL;
+      }
+
+      stream = base;
+   }
+
+   return mongoc_stream_socket_get_socket ((mongoc_stream_socket_t *) stream);
+}
+
+
+static void
+_mongoc_client_async_conn_destroy (mongoc_client_async_conn_t *conn)
+{
+   _mongoc_cluster_node_destroy (conn->node);
+   bson_free (conn);
+}
+
+
+/* reuse an idle connection to @server_id, or open a new one */
+static mongoc_client_async_conn_t *
+_mongoc_client_async_conn_checkout (mongoc_client_t *client,
+                                    uint32_t server_id,
+                                    bson_error_t *error)
+{
+   mongoc_client_async_t *client_async = client->async;
+   mongoc_client_async_conn_t *conn;
+   mongoc_cluster_node_t *node;
+
+   for (;;) {
+      LL_SEARCH_SCALAR (client_async->idle, conn, server_id, server_id);
+      if (!conn) {
+         break;
+      }
+
+      LL_DELETE (client_async->idle, conn);
+      conn->next = NULL;
+
+      if (!mongoc_stream_check_closed (conn->node->stream)) {
+         return conn;
+      }
+
+      _mongoc_client_async_conn_destroy (conn);
+   }
+
+   node = _mongoc_cluster_node_connect (&client->cluster, server_id, error);
+   if (!node) {
+      return NULL;
+   }
+
+   if (!_mongoc_client_async_get_socket (node->stream)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_INVALID_TYPE,
+                      "Async commands require a socket stream");
+      _mongoc_cluster_node_destroy (node);
+      return NULL;
+   }
+
+   conn = (mongoc_client_async_conn_t *) bson_malloc0 (sizeof *conn);
+   conn->server_id = server_id;
+   conn->node = node;
+
+   return conn;
+}
+
+
+static void
+_mongoc_client_async_cmd_cb (mongoc_async_cmd_t *acmd,
+                             mongoc_async_cmd_result_t result,
+                             const bson_t *bson,
+                             int64_t rtt_msec)
+{
+   mongoc_client_async_op_t *op = (mongoc_client_async_op_t *) acmd->data;
+   mongoc_client_t *client = op->client;
+   bson_t empty = BSON_INITIALIZER;
+   bson_error_t error;
+   bool ok;
+
+   if (result == MONGOC_ASYNC_CMD_CONNECTED) {
+      /* the connection was established before the command was submitted */
+      return;
+   }
+
+   if (result == MONGOC_ASYNC_CMD_SUCCESS) {
+      _mongoc_topology_update_cluster_time (client->topology, bson);
+      ok = _mongoc_cmd_check_ok (bson, client->error_api_version, &error);
+
+      /* the server answered, so the connection can carry another command */
+      LL_PREPEND (client->async->idle, op->conn);
+      op->cb (bson, ok ? NULL : &error, op->ctx);
+   } else {
+      memcpy (&error, &acmd->error, sizeof error);
+
+      if (result != MONGOC_ASYNC_CMD_TIMEOUT) {
+         mongoc_topology_invalidate_server (
+            client->topology, op->conn->server_id, &error);
+      }
+
+      /* a partial message may be in flight, never reuse the connection */
+      _mongoc_client_async_conn_destroy (op->conn);
+      op->cb (&empty, &error, op->ctx);
+   }
+
+   bson_free (op);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_command --
+ *
+ *       Select a server for @read_prefs and send @command to it without
+ *       waiting for the reply. @cb is called with the reply from
+ *       mongoc_client_async_perform once it arrives or the command fails.
+ *
+ *       Server selection and opening a new connection block; once a
+ *       connection to the server is idle it is reused without blocking.
+ *
+ * Returns:
+ *       True if the command was sent or queued to be sent, false if
+ *       server selection or connecting failed and @error is set. @cb is
+ *       called exactly once if this returns true, and never otherwise.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_async_command (mongoc_client_t *client,
+                             const char *db_name,
+                             const bson_t *command,
+                             const mongoc_read_prefs_t *read_prefs,
+                             mongoc_client_async_cb_t cb,
+                             void *ctx,
+                             bson_error_t *error)
+{
+   mongoc_client_async_conn_t *conn;
+   mongoc_server_stream_t *server_stream = NULL;
+   mongoc_cmd_parts_t parts;
+   mongoc_client_async_op_t *op;
+   uint32_t server_id;
+   int64_t timeout_msec;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (client);
+   BSON_ASSERT (db_name);
+   BSON_ASSERT (command);
+   BSON_ASSERT (cb);
+
+   if (!client->async) {
+      client->async =
+         (mongoc_client_async_t *) bson_malloc0 (sizeof *client->async);
+      client->async->async = mongoc_async_new ();
+   }
+
+   server_id = mongoc_topology_select_server_id (
+      client->topology, MONGOC_SS_READ, read_prefs, error);
+   if (!server_id) {
+      RETURN (false);
+   }
+
+   conn = _mongoc_client_async_conn_checkout (client, server_id, error);
+   if (!conn) {
+      RETURN (false);
+   }
+
+   mongoc_cmd_parts_init (&parts, client, db_name, MONGOC_QUERY_NONE, command);
+   parts.read_prefs = read_prefs;
+   /* the command outlives the parts, so it cannot borrow an implicit
+    * session from the pool */
+   parts.prohibit_lsid = true;
+
+   server_stream = _mongoc_cluster_create_server_stream (
+      client->topology, server_id, conn->node->stream, error);
+   if (!server_stream ||
+       !mongoc_cmd_parts_assemble (&parts, server_stream, error)) {
+      LL_PREPEND (client->async->idle, conn);
+      GOTO (done);
+   }
+
+   /* socketTimeoutMS=0 would expire the command at once */
+   timeout_msec = client->cluster.sockettimeoutms
+                     ? client->cluster.sockettimeoutms
+                     : MONGOC_DEFAULT_SOCKETTIMEOUTMS;
+
+   op = (mongoc_client_async_op_t *) bson_malloc0 (sizeof *op);
+   op->client = client;
+   op->conn = conn;
+   op->cb = cb;
+   op->ctx = ctx;
+
+   mongoc_async_cmd_new (client->async->async,
+                         conn->node->stream,
+                         true, /* is setup done */
+                         NULL, /* dns result, n/a */
+                         NULL, /* initiator, n/a */
+                         0,    /* initiate delay */
+                         NULL, /* setup */
+                         NULL, /* setup ctx */
+                         db_name,
+                         parts.assembled.command,
+                         conn->node->max_wire_version >= WIRE_VERSION_OP_MSG
+                            ? MONGOC_OPCODE_MSG
+                            : MONGOC_OPCODE_QUERY,
+                         &_mongoc_client_async_cmd_cb,
+                         op,
+                         timeout_msec);
+
+   ret = true;
+
+done:
+   mongoc_server_stream_cleanup (server_stream); /* null ok */
+   mongoc_cmd_parts_cleanup (&parts);
+
+   RETURN (ret);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_get_pollfds --
+ *
+ *       Fill in up to @n_fds entries of @fds with the sockets of @client's
+ *       in-flight async commands and the events each one waits for.
+ *
+ * Returns:
+ *       The number of in-flight commands, which may be more than @n_fds.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+mongoc_client_async_get_pollfds (mongoc_client_t *client,
+                                 struct pollfd *fds,
+                                 size_t n_fds)
+{
+   mongoc_async_cmd_t *acmd;
+   size_t n = 0;
+
+   BSON_ASSERT (client);
+
+   if (!client->async) {
+      return 0;
+   }
+
+   DL_FOREACH (client->async->async->cmds, acmd)
+   {
+      if (n < n_fds) {
+         fds[n].fd = _mongoc_client_async_get_socket (acmd->stream)->sd;
+         fds[n].events = (short) acmd->events;
+         fds[n].revents = 0;
+      }
+
+      n++;
+   }
+
+   return n;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_get_timeout_msec --
+ *
+ *       How long the caller may wait for socket events before it must call
+ *       mongoc_client_async_perform to expire timed out commands.
+ *
+ * Returns:
+ *       Milliseconds until the earliest deadline, 0 if a deadline has
+ *       passed, or -1 if there are no in-flight commands.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int32_t
+mongoc_client_async_get_timeout_msec (mongoc_client_t *client)
+{
+   mongoc_async_cmd_t *acmd;
+   int64_t expire_at = INT64_MAX;
+   int64_t now;
+
+   BSON_ASSERT (client);
+
+   if (!client->async || !client->async->async->ncmds) {
+      return -1;
+   }
+
+   DL_FOREACH (client->async->async->cmds, acmd)
+   {
+      expire_at = BSON_MIN (expire_at,
+                            acmd->connect_started + acmd->timeout_msec * 1000);
+   }
+
+   now = bson_get_monotonic_time ();
+   if (expire_at <= now) {
+      return 0;
+   }
+
+   /* round up, so waiting the full timeout actually reaches the deadline */
+   return (int32_t) BSON_MIN ((expire_at - now + 999) / 1000, INT32_MAX);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_perform --
+ *
+ *       Advance the async commands whose sockets have events in @fds,
+ *       which is typically the array filled in by
+ *       mongoc_client_async_get_pollfds after poll () set its revents,
+ *       then fail commands that have timed out. Never blocks.
+ *
+ *       Completion callbacks run from this function, and may submit new
+ *       commands.
+ *
+ * Returns:
+ *       The number of commands still in flight.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+mongoc_client_async_perform (mongoc_client_t *client,
+                             const struct pollfd *fds,
+                             size_t n_fds)
+{
+   mongoc_async_t *async;
+   mongoc_async_cmd_t *acmd;
+   size_t i;
+
+   BSON_ASSERT (client);
+
+   if (!client->async) {
+      return 0;
+   }
+
+   async = client->async->async;
+
+   for (i = 0; i < n_fds; i++) {
+      if (!fds[i].revents) {
+         continue;
+      }
+
+      DL_FOREACH (async->cmds, acmd)
+      {
+         if (_mongoc_client_async_get_socket (acmd->stream)->sd ==
+             fds[i].fd) {
+            /* may destroy acmd, stop iterating */
+            (void) mongoc_async_cmd_handle_revents (acmd, fds[i].revents);
+            break;
+         }
+      }
+   }
+
+   mongoc_async_expire (async, bson_get_monotonic_time ());
+
+   return async->ncmds;
+}
+
+
+void
+_mongoc_client_async_destroy (mongoc_client_async_t *client_async)
+{
+   mongoc_async_cmd_t *acmd, *tmp;
+   mongoc_client_async_op_t *op;
+   mongoc_client_async_conn_t *conn, *conn_tmp;
+   bson_t empty = BSON_INITIALIZER;
+   bson_error_t error;
+
+   bson_set_error (&error,
+                   MONGOC_ERROR_CLIENT,
+                   MONGOC_ERROR_CLIENT_NOT_READY,
+                   "Client destroyed before the async command completed");
+
+   DL_FOREACH_SAFE (client_async->async->cmds, acmd, tmp)
+   {
+      op = (mongoc_client_async_op_t *) acmd->data;
+      _mongoc_client_async_conn_destroy (op->conn);
+      op->cb (&empty, &error, op->ctx);
+      bson_free (op);
+      mongoc_async_cmd_destroy (acmd);
+   }
+
+   LL_FOREACH_SAFE (client_async->idle, conn, conn_tmp)
+   {
+      _mongoc_client_async_conn_destroy (conn);
+   }
+
+   mongoc_async_destroy (client_async->async);
+   bson_free (client_async);
+}
@@ -40,6 +40,10 @@ size_t
 mongoc_client_pool_num_pushed (mongoc_client_pool_t *pool);
 mongoc_topology_t *
 _mongoc_client_pool_get_topology (mongoc_client_pool_t *pool);
+size_t
+_mongoc_client_pool_num_idle_connections (mongoc_client_pool_t *pool);
+uint32_t
+_mongoc_client_pool_num_waiters (mongoc_client_pool_t *pool);
 
 BSON_END_DECLS
 
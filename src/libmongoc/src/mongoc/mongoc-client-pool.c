@@ -17,23 +17,59 @@
 
 #include "mongoc.h"
 #include "mongoc-apm-private.h"
+#include "mongoc-atomic-private.h"
 #include "mongoc-counters-private.h"
 #include "mongoc-client-pool-private.h"
 #include "mongoc-client-pool.h"
 #include "mongoc-client-private.h"
+#include "mongoc-connection-pool-private.h"
 #include "mongoc-queue-private.h"
 #include "mongoc-thread-private.h"
 #include "mongoc-topology-private.h"
 #include "mongoc-trace-private.h"
+#include "mongoc-write-coalescer-private.h"
 
 #ifdef MONGOC_ENABLE_SSL
 #include "mongoc-ssl-private.h"
 #endif
 
+/* a thread blocked in mongoc_client_pool_pop. waiters are served in FIFO
+ * order: push hands its client straight to the oldest waiter, so a thread
+ * that arrives later cannot take the client first */
+typedef struct _mongoc_client_pool_waiter_t {
+   mongoc_cond_t cond;
+   mongoc_client_t *client;
+   struct _mongoc_client_pool_waiter_t *next;
+} mongoc_client_pool_waiter_t;
+
+/* idle clients that pop and push exchange without taking the mutex. each
+ * slot fills a cache line, the array is allocated on a line boundary so
+ * no two slots share one, and a thread starts at the "home" slot for
+ * its CPU, so threads on different cores rarely touch the same line. push
+ * puts its client in the home slot, so the next pop on that CPU gets the
+ * client used most recently, whose connections are most likely alive */
+#define MONGOC_CLIENT_POOL_SLOTS 64
+#define MONGOC_CLIENT_POOL_SLOT_SIZE 64
+
+typedef struct {
+   mongoc_client_t *volatile client;
+   char pad[MONGOC_CLIENT_POOL_SLOT_SIZE - sizeof (mongoc_client_t *)];
+} mongoc_client_pool_slot_t;
+
 struct _mongoc_client_pool_t {
+   /* MONGOC_CLIENT_POOL_SLOTS slots, aligned within slots_mem */
+   mongoc_client_pool_slot_t *slots;
+   void *slots_mem;
    mongoc_mutex_t mutex;
-   mongoc_cond_t cond;
+   /* idle clients that did not fit in a slot, or all of them if minPoolSize
+    * is set, since it trims the oldest idle clients */
    mongoc_queue_t queue;
+   mongoc_client_pool_waiter_t *waiters_head;
+   mongoc_client_pool_waiter_t *waiters_tail;
+   /* read without the mutex to decide whether the fast path may be used */
+   volatile int32_t n_waiters;
+   /* from waitQueueTimeoutMS, 0 means mongoc_client_pool_pop waits forever */
+   int32_t wait_queue_timeout_msec;
    mongoc_topology_t *topology;
    mongoc_uri_t *uri;
    uint32_t min_pool_size;
@@ -48,6 +84,10 @@ struct _mongoc_client_pool_t {
    void *apm_context;
    int32_t error_api_version;
    bool error_api_set;
+   /* connections shared by all clients, if sharedConnectionPool=true */
+   mongoc_connection_pool_t *conn_pool;
+   /* groups clients' inserts, if coalesceWritesMS is set */
+   mongoc_write_coalescer_t *write_coalescer;
 };
 
 
@@ -86,6 +126,7 @@ mongoc_client_pool_new (const mongoc_uri_t *uri)
    const bson_t *b;
    bson_iter_t iter;
    const char *appname;
+   int32_t linger_ms;
 
 
    ENTRY;
@@ -101,6 +142,13 @@ mongoc_client_pool_new (const mongoc_uri_t *uri)
 #endif
 
    pool = (mongoc_client_pool_t *) bson_malloc0 (sizeof *pool);
+   /* bson_malloc guarantees no more than malloc's alignment */
+   pool->slots_mem = bson_malloc0 (
+      MONGOC_CLIENT_POOL_SLOTS * sizeof (mongoc_client_pool_slot_t) +
+      MONGOC_CLIENT_POOL_SLOT_SIZE - 1);
+   pool->slots = (mongoc_client_pool_slot_t *) (
+      ((uintptr_t) pool->slots_mem + MONGOC_CLIENT_POOL_SLOT_SIZE - 1) &
+      ~(uintptr_t) (MONGOC_CLIENT_POOL_SLOT_SIZE - 1));
    mongoc_mutex_init (&pool->mutex);
    _mongoc_queue_init (&pool->queue);
    pool->uri = mongoc_uri_copy (uri);
@@ -131,6 +179,31 @@ mongoc_client_pool_new (const mongoc_uri_t *uri)
       }
    }
 
+   pool->wait_queue_timeout_msec = BSON_MAX (
+      0,
+      mongoc_uri_get_option_as_int32 (
+         pool->uri, MONGOC_URI_WAITQUEUETIMEOUTMS, 0));
+
+   if (mongoc_uri_get_option_as_bool (
+          pool->uri, MONGOC_URI_SHAREDCONNECTIONPOOL, false)) {
+      pool->conn_pool = _mongoc_connection_pool_new (
+         pool->max_pool_size,
+         mongoc_uri_get_option_as_int32 (
+            pool->uri, MONGOC_URI_MAXIDLETIMEMS, 0));
+   }
+
+   linger_ms = mongoc_uri_get_option_as_int32 (
+      pool->uri, MONGOC_URI_COALESCEWRITESMS, 0);
+   if (linger_ms > 0) {
+      pool->write_coalescer = _mongoc_write_coalescer_new (
+         linger_ms,
+         BSON_MAX (1,
+                   mongoc_uri_get_option_as_int32 (
+                      pool->uri,
+                      MONGOC_URI_COALESCEMAXBATCHSIZE,
+                      MONGOC_DEFAULT_WRITE_BATCH_SIZE)));
+   }
+
    appname =
       mongoc_uri_get_option_as_utf8 (pool->uri, MONGOC_URI_APPNAME, NULL);
    if (appname) {
@@ -153,10 +226,79 @@ mongoc_client_pool_new (const mongoc_uri_t *uri)
 }
 
 
+/* take a client from the lock-free slots, or return NULL */
+static mongoc_client_t *
+_mongoc_client_pool_take_idle (mongoc_client_pool_t *pool)
+{
+   mongoc_client_pool_slot_t *slot;
+   mongoc_client_t *client;
+   unsigned start;
+   unsigned i;
+
+   start = (unsigned) _mongoc_sched_getcpu ();
+
+   for (i = 0; i < MONGOC_CLIENT_POOL_SLOTS; i++) {
+      slot = &pool->slots[(start + i) % MONGOC_CLIENT_POOL_SLOTS];
+      /* read before exchanging, to avoid dirtying empty slots' lines */
+      if (slot->client) {
+         client = (mongoc_client_t *) _mongoc_atomic_ptr_exchange (
+            (void *volatile *) &slot->client, NULL);
+         if (client) {
+            return client;
+         }
+      }
+   }
+
+   return NULL;
+}
+
+
+/* put a client in a lock-free slot. if all are full, return the client
+ * that could not be placed, which may not be the one passed in */
+static mongoc_client_t *
+_mongoc_client_pool_put_idle (mongoc_client_pool_t *pool,
+                              mongoc_client_t *client)
+{
+   mongoc_client_pool_slot_t *slot;
+   unsigned start;
+   unsigned i;
+
+   start = (unsigned) _mongoc_sched_getcpu ();
+
+   /* displace the home slot's client to any other free slot */
+   client = (mongoc_client_t *) _mongoc_atomic_ptr_exchange (
+      (void *volatile *) &pool->slots[start % MONGOC_CLIENT_POOL_SLOTS].client,
+      (void *) client);
+
+   if (!client) {
+      return NULL;
+   }
+
+   for (i = 1; i < MONGOC_CLIENT_POOL_SLOTS; i++) {
+      slot = &pool->slots[(start + i) % MONGOC_CLIENT_POOL_SLOTS];
+      if (!slot->client &&
+          _mongoc_atomic_ptr_cas (
+             (void *volatile *) &slot->client, NULL, (void *) client)) {
+         return NULL;
+      }
+   }
+
+   return client;
+}
+
+
+static bool
+_mongoc_client_pool_has_waiters (mongoc_client_pool_t *pool)
+{
+   return pool->n_waiters > 0;
+}
+
+
 void
 mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
 {
    mongoc_client_t *client;
+   mongoc_queue_item_t *item;
 
    ENTRY;
 
@@ -164,8 +306,17 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
       EXIT;
    }
 
+   /* gather the server sessions idle clients cached, to end them */
+   while ((client = _mongoc_client_pool_take_idle (pool))) {
+      _mongoc_queue_push_tail (&pool->queue, client);
+   }
+
+   for (item = pool->queue.head; item; item = item->next) {
+      _mongoc_client_flush_server_sessions ((mongoc_client_t *) item->data);
+   }
+
    if (pool->topology->session_pool) {
-      client = mongoc_client_pool_pop (pool);
+      client = mongoc_client_pool_pop_with_timeout (pool, -1);
       _mongoc_client_end_sessions (client);
       mongoc_client_pool_push (pool, client);
    }
@@ -175,16 +326,23 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
       mongoc_client_destroy (client);
    }
 
+   while ((client = _mongoc_client_pool_take_idle (pool))) {
+      mongoc_client_destroy (client);
+   }
+
+   /* after the clients, which may have connections checked out */
+   _mongoc_connection_pool_destroy (pool->conn_pool);
+   _mongoc_write_coalescer_destroy (pool->write_coalescer);
    mongoc_topology_destroy (pool->topology);
 
    mongoc_uri_destroy (pool->uri);
    mongoc_mutex_destroy (&pool->mutex);
-   mongoc_cond_destroy (&pool->cond);
 
 #ifdef MONGOC_ENABLE_SSL
    _mongoc_ssl_opts_cleanup (&pool->ssl_opts);
 #endif
 
+   bson_free (pool->slots_mem);
    bson_free (pool);
 
    mongoc_counter_client_pools_active_dec ();
@@ -208,44 +366,254 @@ _start_scanner_if_needed (mongoc_client_pool_t *pool)
    }
 }
 
+/*
+ * Create a client for the pool.
+ *
+ * This function assumes the pool's mutex is locked
+ */
+static mongoc_client_t *
+_mongoc_client_pool_new_client (mongoc_client_pool_t *pool)
+{
+   mongoc_client_t *client;
+
+   client = _mongoc_client_new_from_uri (pool->topology);
+
+   /* for tests */
+   mongoc_client_set_stream_initiator (
+      client,
+      pool->topology->scanner->initiator,
+      pool->topology->scanner->initiator_context);
+
+   client->error_api_version = pool->error_api_version;
+   client->cluster.conn_pool = pool->conn_pool;
+   client->write_coalescer = pool->write_coalescer;
+   _mongoc_client_set_apm_callbacks_private (
+      client, &pool->apm_callbacks, pool->apm_context);
+#ifdef MONGOC_ENABLE_SSL
+   if (pool->ssl_opts_set) {
+      mongoc_client_set_ssl_opts (client, &pool->ssl_opts);
+   }
+#endif
+   pool->size++;
+
+   return client;
+}
+
+
+static void
+_mongoc_client_pool_enqueue_waiter (mongoc_client_pool_t *pool,
+                                    mongoc_client_pool_waiter_t *waiter)
+{
+   if (pool->waiters_tail) {
+      pool->waiters_tail->next = waiter;
+   } else {
+      pool->waiters_head = waiter;
+   }
+
+   pool->waiters_tail = waiter;
+   /* a full barrier: a pusher that stores into a slot after this sees the
+    * waiter, and the caller's scan of the slots after this sees any client
+    * stored before */
+   bson_atomic_int_add (&pool->n_waiters, 1);
+
+   mongoc_counter_client_pool_waiters_inc ();
+
+   /* queue depth, including this waiter */
+   if (pool->n_waiters == 1) {
+      mongoc_counter_client_pool_depth_1_inc ();
+   } else if (pool->n_waiters <= 8) {
+      mongoc_counter_client_pool_depth_2_8_inc ();
+   } else if (pool->n_waiters <= 64) {
+      mongoc_counter_client_pool_depth_9_64_inc ();
+   } else {
+      mongoc_counter_client_pool_depth_gt_64_inc ();
+   }
+}
+
+
+static void
+_mongoc_client_pool_remove_waiter (mongoc_client_pool_t *pool,
+                                   mongoc_client_pool_waiter_t *waiter)
+{
+   mongoc_client_pool_waiter_t *prev = NULL;
+   mongoc_client_pool_waiter_t *iter;
+
+   for (iter = pool->waiters_head; iter; prev = iter, iter = iter->next) {
+      if (iter == waiter) {
+         if (prev) {
+            prev->next = iter->next;
+         } else {
+            pool->waiters_head = iter->next;
+         }
+
+         if (pool->waiters_tail == iter) {
+            pool->waiters_tail = prev;
+         }
+
+         iter->next = NULL;
+         bson_atomic_int_add (&pool->n_waiters, -1);
+         mongoc_counter_client_pool_waiters_dec ();
+         return;
+      }
+   }
+}
+
+
+/*
+ * Give a client to the oldest waiter, if any.
+ *
+ * This function assumes the pool's mutex is locked
+ */
+static bool
+_mongoc_client_pool_hand_off (mongoc_client_pool_t *pool,
+                              mongoc_client_t *client)
+{
+   mongoc_client_pool_waiter_t *waiter = pool->waiters_head;
+
+   if (!waiter) {
+      return false;
+   }
+
+   _mongoc_client_pool_remove_waiter (pool, waiter);
+   waiter->client = client;
+   mongoc_cond_signal (&waiter->cond);
+
+   return true;
+}
+
+
+static void
+_mongoc_client_pool_record_wait (int64_t usec)
+{
+   mongoc_counter_client_pool_waits_inc ();
+   mongoc_counter_client_pool_wait_usec_add (usec);
+
+   if (usec < 1000) {
+      mongoc_counter_client_pool_wait_lt_1ms_inc ();
+   } else if (usec < 10 * 1000) {
+      mongoc_counter_client_pool_wait_lt_10ms_inc ();
+   } else if (usec < 100 * 1000) {
+      mongoc_counter_client_pool_wait_lt_100ms_inc ();
+   } else if (usec < 1000 * 1000) {
+      mongoc_counter_client_pool_wait_lt_1s_inc ();
+   } else {
+      mongoc_counter_client_pool_wait_ge_1s_inc ();
+   }
+}
+
+
 mongoc_client_t *
 mongoc_client_pool_pop (mongoc_client_pool_t *pool)
 {
+   int32_t timeout_msec;
+
+   BSON_ASSERT (pool);
+
+   timeout_msec = pool->wait_queue_timeout_msec;
+
+   return mongoc_client_pool_pop_with_timeout (
+      pool, timeout_msec > 0 ? timeout_msec : -1);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_pool_pop_with_timeout --
+ *
+ *       Pop a client, creating one if the pool is below maxPoolSize, or
+ *       wait up to @timeout_msec for another thread to push one. Waiters
+ *       are served in the order they arrived. A negative @timeout_msec
+ *       waits forever, zero does not wait at all.
+ *
+ * Returns:
+ *       A client, or NULL if none was available before the timeout.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_client_t *
+mongoc_client_pool_pop_with_timeout (mongoc_client_pool_t *pool,
+                                     int32_t timeout_msec)
+{
+   mongoc_client_pool_waiter_t waiter;
    mongoc_client_t *client;
+   int64_t started;
+   int64_t expire_at;
+   int64_t now;
 
    ENTRY;
 
    BSON_ASSERT (pool);
 
+   mongoc_counter_client_pool_checkouts_inc ();
+
+   /* no mutex while idle clients are available and nobody is waiting.
+    * clients only exist once the slow path below has started the scanner */
+   if (!_mongoc_client_pool_has_waiters (pool)) {
+      client = _mongoc_client_pool_take_idle (pool);
+      if (client) {
+         RETURN (client);
+      }
+   }
+
    mongoc_mutex_lock (&pool->mutex);
 
-again:
-   if (!(client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
-      if (pool->size < pool->max_pool_size) {
-         client = _mongoc_client_new_from_uri (pool->topology);
+   /* if any client is queued, nobody is waiting */
+   client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue);
 
-         /* for tests */
-         mongoc_client_set_stream_initiator (
-            client,
-            pool->topology->scanner->initiator,
-            pool->topology->scanner->initiator_context);
+   if (!client && !pool->waiters_head) {
+      client = _mongoc_client_pool_take_idle (pool);
+   }
 
-         client->error_api_version = pool->error_api_version;
-         _mongoc_client_set_apm_callbacks_private (
-            client, &pool->apm_callbacks, pool->apm_context);
-#ifdef MONGOC_ENABLE_SSL
-         if (pool->ssl_opts_set) {
-            mongoc_client_set_ssl_opts (client, &pool->ssl_opts);
+   if (!client && !pool->waiters_head &&
+       pool->size < pool->max_pool_size) {
+      client = _mongoc_client_pool_new_client (pool);
+   }
+
+   if (!client && timeout_msec != 0) {
+      started = bson_get_monotonic_time ();
+      expire_at = started + (int64_t) timeout_msec * 1000;
+
+      mongoc_cond_init (&waiter.cond);
+      waiter.client = NULL;
+      waiter.next = NULL;
+      _mongoc_client_pool_enqueue_waiter (pool, &waiter);
+
+      /* a client pushed to a slot before the pusher could see this waiter */
+      waiter.client = _mongoc_client_pool_take_idle (pool);
+      if (waiter.client) {
+         _mongoc_client_pool_remove_waiter (pool, &waiter);
+      }
+
+      while (!waiter.client) {
+         if (timeout_msec < 0) {
+            mongoc_cond_wait (&waiter.cond, &pool->mutex);
+            continue;
          }
-#endif
-         pool->size++;
-      } else {
-         mongoc_cond_wait (&pool->cond, &pool->mutex);
-         GOTO (again);
+
+         now = bson_get_monotonic_time ();
+         if (now >= expire_at) {
+            break;
+         }
+
+         mongoc_cond_timedwait (
+            &waiter.cond, &pool->mutex, (expire_at - now + 999) / 1000);
       }
+
+      client = waiter.client;
+      if (!client) {
+         _mongoc_client_pool_remove_waiter (pool, &waiter);
+         mongoc_counter_client_pool_wait_timeouts_inc ();
+      }
+
+      mongoc_cond_destroy (&waiter.cond);
+      _mongoc_client_pool_record_wait (bson_get_monotonic_time () - started);
    }
 
-   _start_scanner_if_needed (pool);
+   if (client) {
+      _start_scanner_if_needed (pool);
+   }
    mongoc_mutex_unlock (&pool->mutex);
 
    RETURN (client);
@@ -261,18 +629,24 @@ mongoc_client_pool_try_pop (mongoc_client_pool_t *pool)
 
    BSON_ASSERT (pool);
 
+   if (!_mongoc_client_pool_has_waiters (pool)) {
+      client = _mongoc_client_pool_take_idle (pool);
+      if (client) {
+         RETURN (client);
+      }
+   }
+
    mongoc_mutex_lock (&pool->mutex);
 
-   if (!(client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
-      if (pool->size < pool->max_pool_size) {
-         client = _mongoc_client_new_from_uri (pool->topology);
-#ifdef MONGOC_ENABLE_SSL
-         if (pool->ssl_opts_set) {
-            mongoc_client_set_ssl_opts (client, &pool->ssl_opts);
-         }
-#endif
-         pool->size++;
-      }
+   client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue);
+   if (!client && !pool->waiters_head) {
+      client = _mongoc_client_pool_take_idle (pool);
+   }
+
+   /* a new client would jump ahead of the waiters queued for one */
+   if (!client && !pool->waiters_head &&
+       pool->size < pool->max_pool_size) {
+      client = _mongoc_client_pool_new_client (pool);
    }
 
    if (client) {
@@ -292,7 +666,39 @@ mongoc_client_pool_push (mongoc_client_pool_t *pool, mongoc_client_t *client)
    BSON_ASSERT (pool);
    BSON_ASSERT (client);
 
+   /* an idle client holds no shared connections */
+   _mongoc_cluster_release_idle_nodes (&client->cluster);
+
+   if (!pool->min_pool_size && !_mongoc_client_pool_has_waiters (pool)) {
+      client = _mongoc_client_pool_put_idle (pool, client);
+
+      /* the exchange above was a full barrier, so a thread that began
+       * waiting without seeing the client is visible now */
+      if (_mongoc_client_pool_has_waiters (pool)) {
+         mongoc_client_t *idle;
+
+         mongoc_mutex_lock (&pool->mutex);
+         while (pool->waiters_head &&
+                (idle = _mongoc_client_pool_take_idle (pool))) {
+            _mongoc_client_pool_hand_off (pool, idle);
+         }
+         mongoc_mutex_unlock (&pool->mutex);
+      }
+
+      if (!client) {
+         EXIT;
+      }
+
+      /* the slots are full, queue the client that did not fit */
+   }
+
    mongoc_mutex_lock (&pool->mutex);
+
+   if (_mongoc_client_pool_hand_off (pool, client)) {
+      mongoc_mutex_unlock (&pool->mutex);
+      EXIT;
+   }
+
    _mongoc_queue_push_head (&pool->queue, client);
 
    if (pool->min_pool_size &&
@@ -305,7 +711,6 @@ mongoc_client_pool_push (mongoc_client_pool_t *pool, mongoc_client_t *client)
       }
    }
 
-   mongoc_cond_signal (&pool->cond);
    mongoc_mutex_unlock (&pool->mutex);
 
    EXIT;
@@ -341,11 +746,17 @@ size_t
 mongoc_client_pool_num_pushed (mongoc_client_pool_t *pool)
 {
    size_t num_pushed = 0;
+   int i;
 
    ENTRY;
 
    mongoc_mutex_lock (&pool->mutex);
    num_pushed = pool->queue.length;
+   for (i = 0; i < MONGOC_CLIENT_POOL_SLOTS; i++) {
+      if (_mongoc_atomic_ptr_get ((void *volatile *) &pool->slots[i].client)) {
+         num_pushed++;
+      }
+   }
    mongoc_mutex_unlock (&pool->mutex);
 
    RETURN (num_pushed);
@@ -359,6 +770,29 @@ _mongoc_client_pool_get_topology (mongoc_client_pool_t *pool)
 }
 
 
+/* for tests */
+size_t
+_mongoc_client_pool_num_idle_connections (mongoc_client_pool_t *pool)
+{
+   return pool->conn_pool ? _mongoc_connection_pool_num_idle (pool->conn_pool)
+                          : 0;
+}
+
+
+/* for tests */
+uint32_t
+_mongoc_client_pool_num_waiters (mongoc_client_pool_t *pool)
+{
+   uint32_t n_waiters;
+
+   mongoc_mutex_lock (&pool->mutex);
+   n_waiters = (uint32_t) pool->n_waiters;
+   mongoc_mutex_unlock (&pool->mutex);
+
+   return n_waiters;
+}
+
+
 void
 mongoc_client_pool_max_size (mongoc_client_pool_t *pool, uint32_t max_pool_size)
 {
@@ -366,6 +800,16 @@ mongoc_client_pool_max_size (mongoc_client_pool_t *pool, uint32_t max_pool_size)
 
    mongoc_mutex_lock (&pool->mutex);
    pool->max_pool_size = max_pool_size;
+   if (pool->conn_pool) {
+      _mongoc_connection_pool_set_max_idle (pool->conn_pool, max_pool_size);
+   }
+
+   /* waiters may now create clients, oldest first */
+   while (pool->waiters_head && pool->size < pool->max_pool_size) {
+      _mongoc_client_pool_hand_off (pool,
+                                    _mongoc_client_pool_new_client (pool));
+   }
+
    mongoc_mutex_unlock (&pool->mutex);
 
    EXIT;
@@ -49,6 +49,9 @@ MONGOC_EXPORT (void)
 mongoc_client_pool_push (mongoc_client_pool_t *pool, mongoc_client_t *client);
 MONGOC_EXPORT (mongoc_client_t *)
 mongoc_client_pool_try_pop (mongoc_client_pool_t *pool);
+MONGOC_EXPORT (mongoc_client_t *)
+mongoc_client_pool_pop_with_timeout (mongoc_client_pool_t *pool,
+                                     int32_t timeout_msec);
 MONGOC_EXPORT (void)
 mongoc_client_pool_max_size (mongoc_client_pool_t *pool,
                              uint32_t max_pool_size);
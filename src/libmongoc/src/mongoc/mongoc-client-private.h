@@ -26,6 +26,7 @@
 #include "mongoc-apm-private.h"
 #include "mongoc-buffer-private.h"
 #include "mongoc-client.h"
+#include "mongoc-client-async-private.h"
 #include "mongoc-cluster-private.h"
 #include "mongoc-config.h"
 #include "mongoc-host-list.h"
@@ -65,7 +66,11 @@ BSON_BEGIN_DECLS
 #define WIRE_VERSION_ARRAY_FILTERS 6
 /* first version to support retryable writes  */
 #define WIRE_VERSION_RETRY_WRITES 6
+/* first version to stream getMore replies with OP_MSG exhaustAllowed */
+#define WIRE_VERSION_EXHAUST_GETMORE 8
 
+/* how many ended server sessions a client keeps for reuse */
+#define MONGOC_CLIENT_SESSION_CACHE_SIZE 8
 
 struct _mongoc_client_t {
    mongoc_uri_t *uri;
@@ -95,6 +100,18 @@ struct _mongoc_client_t {
    /* mongoc_client_session_t's in use, to look up lsids and clusterTimes */
    mongoc_set_t *client_sessions;
    unsigned int csid_rand_seed;
+
+   /* server sessions this client ended most recently, newest first, which
+    * it reuses without locking the topology's session pool */
+   mongoc_server_session_t *session_cache;
+   uint32_t n_cached_sessions;
+   mongoc_lsid_reserve_t lsid_reserve;
+
+   /* state of mongoc_client_async_command, created on first use */
+   mongoc_client_async_t *async;
+
+   /* the pool's, if it has coalesceWritesMS */
+   struct _mongoc_write_coalescer_t *write_coalescer;
 };
 
 
@@ -154,6 +171,16 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
                             const char *db,
                             const char *collection,
                             mongoc_client_session_t *cs);
+
+void
+_mongoc_client_killcursors_command (mongoc_cluster_t *cluster,
+                                    mongoc_server_stream_t *server_stream,
+                                    int64_t cursor_id,
+                                    const char *db,
+                                    const char *collection,
+                                    mongoc_client_session_t *cs,
+                                    const bson_t *lsid);
+
 bool
 _mongoc_client_command_with_opts (mongoc_client_t *client,
                                   const char *db_name,
@@ -172,6 +199,9 @@ mongoc_server_session_t *
 _mongoc_client_pop_server_session (mongoc_client_t *client,
                                    bson_error_t *error);
 
+void
+_mongoc_client_flush_server_sessions (mongoc_client_t *client);
+
 bool
 _mongoc_client_lookup_session (const mongoc_client_t *client,
                                uint32_t client_session_id,
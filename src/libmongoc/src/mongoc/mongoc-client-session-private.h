@@ -51,6 +51,15 @@ typedef struct _mongoc_server_session_t {
    int64_t txn_number; /* transaction number */
 } mongoc_server_session_t;
 
+/* random UUIDs for new server sessions' lsids, generated in bulk since
+ * each call to the cryptographic random number generator is costly */
+#define MONGOC_LSID_RESERVE_SIZE 32
+
+typedef struct _mongoc_lsid_reserve_t {
+   uint8_t uuids[MONGOC_LSID_RESERVE_SIZE][16];
+   uint32_t n;
+} mongoc_lsid_reserve_t;
+
 typedef enum {
    MONGOC_TRANSACTION_NONE,
    MONGOC_TRANSACTION_STARTING,
@@ -91,7 +100,8 @@ _mongoc_client_session_handle_reply (mongoc_client_session_t *session,
                                      const bson_t *reply);
 
 mongoc_server_session_t *
-_mongoc_server_session_new (bson_error_t *error);
+_mongoc_server_session_new (mongoc_lsid_reserve_t *reserve,
+                            bson_error_t *error);
 
 bool
 _mongoc_server_session_timed_out (const mongoc_server_session_t *server_session,
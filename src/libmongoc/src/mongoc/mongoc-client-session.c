@@ -396,10 +396,16 @@ mongoc_session_opts_destroy (mongoc_session_opt_t *opts)
 }
 
 
+/* generate @n UUIDs, 16 bytes each, with one call to the random number
+ * generator */
 static bool
-_mongoc_server_session_uuid (uint8_t *data /* OUT */, bson_error_t *error)
+_mongoc_server_session_uuids (uint8_t *data /* OUT */,
+                              size_t n,
+                              bson_error_t *error)
 {
 #ifdef MONGOC_ENABLE_CRYPTO
+   size_t i;
+
    /* https://tools.ietf.org/html/rfc4122#page-14
     *   o  Set the two most significant bits (bits 6 and 7) of the
     *      clock_seq_hi_and_reserved to zero and one, respectively.
@@ -412,7 +418,7 @@ _mongoc_server_session_uuid (uint8_t *data /* OUT */, bson_error_t *error)
     *      values.
     */
 
-   if (!_mongoc_rand_bytes (data, 16)) {
+   if (!_mongoc_rand_bytes (data, (int) (n * 16))) {
       bson_set_error (error,
                       MONGOC_ERROR_CLIENT,
                       MONGOC_ERROR_CLIENT_SESSION_FAILURE,
@@ -421,8 +427,10 @@ _mongoc_server_session_uuid (uint8_t *data /* OUT */, bson_error_t *error)
       return false;
    }
 
-   data[6] = (uint8_t) (0x40 | (data[6] & 0xf));
-   data[8] = (uint8_t) (0x80 | (data[8] & 0x3f));
+   for (i = 0; i < n; i++, data += 16) {
+      data[6] = (uint8_t) (0x40 | (data[6] & 0xf));
+      data[8] = (uint8_t) (0x80 | (data[8] & 0x3f));
+   }
 
    return true;
 #else
@@ -511,24 +519,32 @@ _mongoc_client_session_handle_reply (mongoc_client_session_t *session,
 
 
 mongoc_server_session_t *
-_mongoc_server_session_new (bson_error_t *error)
+_mongoc_server_session_new (mongoc_lsid_reserve_t *reserve,
+                            bson_error_t *error)
 {
-   uint8_t uuid_data[16];
+   const uint8_t *uuid_data;
    mongoc_server_session_t *s;
 
    ENTRY;
 
-   if (!_mongoc_server_session_uuid (uuid_data, error)) {
-      RETURN (NULL);
+   if (!reserve->n) {
+      if (!_mongoc_server_session_uuids (
+             &reserve->uuids[0][0], MONGOC_LSID_RESERVE_SIZE, error)) {
+         RETURN (NULL);
+      }
+
+      reserve->n = MONGOC_LSID_RESERVE_SIZE;
    }
 
+   uuid_data = reserve->uuids[--reserve->n];
+
    s = bson_malloc0 (sizeof (mongoc_server_session_t));
    s->last_used_usec = SESSION_NEVER_USED;
    s->prev = NULL;
    s->next = NULL;
    bson_init (&s->lsid);
    bson_append_binary (
-      &s->lsid, "id", 2, BSON_SUBTYPE_UUID, uuid_data, sizeof uuid_data);
+      &s->lsid, "id", 2, BSON_SUBTYPE_UUID, uuid_data, 16);
 
    /* transaction number is a positive integer and will be incremented before
     * each use, so ensure it is initialized to zero. */
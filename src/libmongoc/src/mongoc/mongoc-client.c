@@ -63,6 +63,11 @@
 #include "mongoc-ssl-private.h"
 #include "mongoc-cmd-private.h"
 #include "mongoc-opts-private.h"
+#include "utlist.h"
+#endif
+
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+#include "mongoc-stream-tls-openssl-private.h"
 #endif
 
 
@@ -78,14 +83,6 @@ _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
                                const char *db,
                                const char *collection);
 
-static void
-_mongoc_client_killcursors_command (mongoc_cluster_t *cluster,
-                                    mongoc_server_stream_t *server_stream,
-                                    int64_t cursor_id,
-                                    const char *db,
-                                    const char *collection,
-                                    mongoc_client_session_t *cs);
-
 #define DNS_ERROR(_msg, ...)                               \
    do {                                                    \
       bson_set_error (error,                               \
@@ -504,7 +501,8 @@ _mongoc_client_get_rr (const char *service,
  *
  * mongoc_client_connect_tcp --
  *
- *       Connect to a host using a TCP socket.
+ *       Connect to a host using a TCP socket, waiting at most
+ *       @connecttimeoutms for each address the host resolves to.
  *
  *       This will be performed synchronously and return a mongoc_stream_t
  *       that can be used to connect with the remote host.
@@ -520,27 +518,21 @@ _mongoc_client_get_rr (const char *service,
  */
 
 static mongoc_stream_t *
-mongoc_client_connect_tcp (const mongoc_uri_t *uri,
+mongoc_client_connect_tcp (int32_t connecttimeoutms,
                            const mongoc_host_list_t *host,
                            bson_error_t *error)
 {
    mongoc_socket_t *sock = NULL;
    struct addrinfo hints;
    struct addrinfo *result, *rp;
-   int32_t connecttimeoutms;
    int64_t expire_at;
    char portstr[8];
    int s;
 
    ENTRY;
 
-   BSON_ASSERT (uri);
-   BSON_ASSERT (host);
-
-   connecttimeoutms = mongoc_uri_get_option_as_int32 (
-      uri, MONGOC_URI_CONNECTTIMEOUTMS, MONGOC_DEFAULT_CONNECTTIMEOUTMS);
-
    BSON_ASSERT (connecttimeoutms);
+   BSON_ASSERT (host);
 
    bson_snprintf (portstr, sizeof portstr, "%hu", host->port);
 
@@ -701,15 +693,21 @@ mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
                                         bson_error_t *error)
 {
    mongoc_stream_t *base_stream = NULL;
-#ifdef MONGOC_ENABLE_SSL
    mongoc_client_t *client = (mongoc_client_t *) user_data;
-   const char *mechanism;
    int32_t connecttimeoutms;
+#ifdef MONGOC_ENABLE_SSL
+   const char *mechanism;
 #endif
 
    BSON_ASSERT (uri);
    BSON_ASSERT (host);
 
+   /* no longer than the operation that needs the connection has left */
+   connecttimeoutms = _mongoc_cluster_timeout_ms (
+      client->cluster.deadline,
+      mongoc_uri_get_option_as_int32 (
+         uri, MONGOC_URI_CONNECTTIMEOUTMS, MONGOC_DEFAULT_CONNECTTIMEOUTMS));
+
 #ifndef MONGOC_ENABLE_SSL
    if (mongoc_uri_get_ssl (uri)) {
       bson_set_error (error,
@@ -727,7 +725,7 @@ mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
    case AF_INET6:
 #endif
    case AF_INET:
-      base_stream = mongoc_client_connect_tcp (uri, host, error);
+      base_stream = mongoc_client_connect_tcp (connecttimeoutms, host, error);
       break;
    case AF_UNIX:
       base_stream = mongoc_client_connect_unix (uri, host, error);
@@ -761,8 +759,19 @@ mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
             return NULL;
          }
 
-         connecttimeoutms = mongoc_uri_get_option_as_int32 (
-            uri, MONGOC_URI_CONNECTTIMEOUTMS, MONGOC_DEFAULT_CONNECTTIMEOUTMS);
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+         if (client->topology->scanner->tls_session_cache) {
+            _mongoc_stream_tls_openssl_set_session_cache (
+               base_stream,
+               client->topology->scanner->tls_session_cache,
+               host->host_and_port);
+         }
+
+         if (mongoc_uri_get_option_as_bool (uri, MONGOC_URI_SSLKTLS, false) &&
+             !_mongoc_stream_tls_openssl_enable_ktls (base_stream)) {
+            TRACE ("%s", "kernel TLS is not available");
+         }
+#endif
 
          if (!mongoc_stream_tls_handshake_block (
                 base_stream, host->host, connecttimeoutms, error)) {
@@ -1064,7 +1073,15 @@ void
 mongoc_client_destroy (mongoc_client_t *client)
 {
    if (client) {
+      if (client->async) {
+         _mongoc_client_async_destroy (client->async);
+      }
+
+      _mongoc_client_flush_server_sessions (client);
+
       if (client->topology->single_threaded) {
+         /* kill hedged reads' cursors before their sessions end */
+         _mongoc_cluster_drain_orphans (&client->cluster);
          _mongoc_client_end_sessions (client);
          mongoc_topology_destroy (client->topology);
       }
@@ -1681,6 +1698,9 @@ mongoc_client_command_simple (mongoc_client_t *client,
  *       The mongoc_client_t's read preference, read concern, and write concern
  *       are *NOT* applied.
  *
+ *       If @borrow_reply is true, @reply may point into the cluster's
+ *       receive buffer rather than own a copy of the server reply.
+ *
  * Returns:
  *       Success or failure.
  *       A write concern timeout or write concern error is considered a failure.
@@ -1691,19 +1711,21 @@ mongoc_client_command_simple (mongoc_client_t *client,
  *
  *--------------------------------------------------------------------------
  */
-bool
-_mongoc_client_command_with_opts (mongoc_client_t *client,
-                                  const char *db_name,
-                                  const bson_t *command,
-                                  mongoc_command_mode_t mode,
-                                  const bson_t *opts,
-                                  mongoc_query_flags_t flags,
-                                  const mongoc_read_prefs_t *user_prefs,
-                                  const mongoc_read_prefs_t *default_prefs,
-                                  mongoc_read_concern_t *default_rc,
-                                  mongoc_write_concern_t *default_wc,
-                                  bson_t *reply,
-                                  bson_error_t *error)
+static bool
+_mongoc_client_command_with_opts_internal (
+   mongoc_client_t *client,
+   const char *db_name,
+   const bson_t *command,
+   mongoc_command_mode_t mode,
+   const bson_t *opts,
+   mongoc_query_flags_t flags,
+   const mongoc_read_prefs_t *user_prefs,
+   const mongoc_read_prefs_t *default_prefs,
+   mongoc_read_concern_t *default_rc,
+   mongoc_write_concern_t *default_wc,
+   bool borrow_reply,
+   bson_t *reply,
+   bson_error_t *error)
 {
    mongoc_read_write_opts_t read_write_opts;
    mongoc_cmd_parts_t parts;
@@ -1716,6 +1738,7 @@ _mongoc_client_command_with_opts (mongoc_client_t *client,
    bson_t *reply_ptr;
    int32_t wire_version;
    int32_t wc_wire_version;
+   int64_t prev_deadline;
    bool reply_initialized = false;
    bool ret = false;
 
@@ -1728,15 +1751,20 @@ _mongoc_client_command_with_opts (mongoc_client_t *client,
    command_name = _mongoc_get_command_name (command);
    cluster = &client->cluster;
    reply_ptr = reply ? reply : &reply_local;
+   /* restored when done, whether or not the operation began */
+   prev_deadline = cluster->deadline;
 
    mongoc_cmd_parts_init (&parts, client, db_name, flags, command);
    parts.is_read_command = (mode & MONGOC_CMD_READ);
    parts.is_write_command = (mode & MONGOC_CMD_WRITE);
+   parts.assembled.borrow_reply = borrow_reply;
 
    if (!_mongoc_read_write_opts_parse (client, opts, &read_write_opts, error)) {
       GOTO (done);
    }
 
+   (void) _mongoc_cluster_begin_operation (cluster, read_write_opts.timeoutMS);
+
    cs = read_write_opts.client_session;
 
    if (!command_name) {
@@ -1880,6 +1908,7 @@ done:
       mongoc_server_stream_cleanup (server_stream);
    }
 
+   _mongoc_cluster_end_operation (cluster, prev_deadline);
    mongoc_cmd_parts_cleanup (&parts);
    _mongoc_read_write_opts_cleanup (&read_write_opts);
 
@@ -1887,6 +1916,36 @@ done:
 }
 
 
+bool
+_mongoc_client_command_with_opts (mongoc_client_t *client,
+                                  const char *db_name,
+                                  const bson_t *command,
+                                  mongoc_command_mode_t mode,
+                                  const bson_t *opts,
+                                  mongoc_query_flags_t flags,
+                                  const mongoc_read_prefs_t *user_prefs,
+                                  const mongoc_read_prefs_t *default_prefs,
+                                  mongoc_read_concern_t *default_rc,
+                                  mongoc_write_concern_t *default_wc,
+                                  bson_t *reply,
+                                  bson_error_t *error)
+{
+   return _mongoc_client_command_with_opts_internal (client,
+                                                     db_name,
+                                                     command,
+                                                     mode,
+                                                     opts,
+                                                     flags,
+                                                     user_prefs,
+                                                     default_prefs,
+                                                     default_rc,
+                                                     default_wc,
+                                                     false /* borrow */,
+                                                     reply,
+                                                     error);
+}
+
+
 bool
 mongoc_client_read_command_with_opts (mongoc_client_t *client,
                                       const char *db_name,
@@ -1983,6 +2042,153 @@ mongoc_client_command_with_opts (mongoc_client_t *client,
 }
 
 
+bool
+mongoc_client_command_with_opts_borrowed (
+   mongoc_client_t *client,
+   const char *db_name,
+   const bson_t *command,
+   const mongoc_read_prefs_t *read_prefs,
+   const bson_t *opts,
+   bson_t *reply,
+   bson_error_t *error)
+{
+   return _mongoc_client_command_with_opts_internal (client,
+                                                     db_name,
+                                                     command,
+                                                     MONGOC_CMD_RAW,
+                                                     opts,
+                                                     MONGOC_QUERY_NONE,
+                                                     read_prefs,
+                                                     NULL,
+                                                     client->read_concern,
+                                                     client->write_concern,
+                                                     true /* borrow */,
+                                                     reply,
+                                                     error);
+}
+
+
+bool
+mongoc_client_command_batch_with_opts (mongoc_client_t *client,
+                                       const char *db_name,
+                                       const bson_t **commands,
+                                       size_t n_commands,
+                                       const mongoc_read_prefs_t *read_prefs,
+                                       const bson_t *opts,
+                                       bson_t *replies,
+                                       bson_error_t *error)
+{
+   mongoc_read_write_opts_t read_write_opts;
+   mongoc_cmd_parts_t *parts = NULL;
+   mongoc_cmd_t **cmds = NULL;
+   mongoc_server_stream_t *server_stream = NULL;
+   mongoc_cluster_t *cluster;
+   int64_t operation_id;
+   int32_t wire_version;
+   size_t n_parts = 0;
+   size_t i;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (client);
+   BSON_ASSERT (db_name);
+   BSON_ASSERT (commands || !n_commands);
+   BSON_ASSERT (replies || !n_commands);
+
+   cluster = &client->cluster;
+
+   if (!_mongoc_read_write_opts_parse (client, opts, &read_write_opts, error)) {
+      GOTO (done);
+   }
+
+   for (i = 0; i < n_commands; i++) {
+      if (!commands[i] || !_mongoc_get_command_name (commands[i])) {
+         bson_set_error (error,
+                         MONGOC_ERROR_COMMAND,
+                         MONGOC_ERROR_COMMAND_INVALID_ARG,
+                         "Empty command document at index %d",
+                         (int) i);
+         GOTO (done);
+      }
+   }
+
+   if (!_mongoc_read_prefs_validate (read_prefs, error)) {
+      GOTO (done);
+   }
+
+   /* every command in the batch goes to the same server */
+   if (read_write_opts.serverId) {
+      server_stream =
+         mongoc_cluster_stream_for_server (cluster,
+                                           read_write_opts.serverId,
+                                           true /* reconnect ok */,
+                                           read_write_opts.client_session,
+                                           NULL,
+                                           error);
+   } else {
+      server_stream = mongoc_cluster_stream_for_reads (
+         cluster, read_prefs, read_write_opts.client_session, NULL, error);
+   }
+
+   if (!server_stream) {
+      GOTO (done);
+   }
+
+   wire_version = server_stream->sd->max_wire_version;
+   operation_id = ++cluster->operation_id;
+   parts = bson_malloc (n_commands * sizeof (mongoc_cmd_parts_t));
+   cmds = bson_malloc (n_commands * sizeof (mongoc_cmd_t *));
+
+   for (n_parts = 0; n_parts < n_commands; n_parts++) {
+      mongoc_cmd_parts_t *part = &parts[n_parts];
+
+      mongoc_cmd_parts_init (
+         part, client, db_name, MONGOC_QUERY_NONE, commands[n_parts]);
+      part->read_prefs = read_prefs;
+      if (read_write_opts.serverId &&
+          server_stream->sd->type != MONGOC_SERVER_MONGOS) {
+         part->user_query_flags |= MONGOC_QUERY_SLAVE_OK;
+      }
+
+      part->assembled.operation_id = operation_id;
+      if (!mongoc_cmd_parts_append_read_write (
+             part, &read_write_opts, wire_version, error) ||
+          !mongoc_cmd_parts_assemble (part, server_stream, error)) {
+         n_parts++;
+         GOTO (done);
+      }
+
+      cmds[n_parts] = &part->assembled;
+   }
+
+   ret = mongoc_cluster_run_opmsg_pipeline (
+      cluster, cmds, n_commands, replies, error);
+
+   /* all replies are initialized */
+   n_commands = 0;
+
+done:
+   for (i = 0; i < n_commands; i++) {
+      bson_init (&replies[i]);
+   }
+
+   for (i = 0; i < n_parts; i++) {
+      mongoc_cmd_parts_cleanup (&parts[i]);
+   }
+
+   if (server_stream) {
+      mongoc_server_stream_cleanup (server_stream);
+   }
+
+   bson_free (parts);
+   bson_free (cmds);
+   _mongoc_read_write_opts_cleanup (&read_write_opts);
+
+   RETURN (ret);
+}
+
+
 bool
 mongoc_client_command_simple_with_server_id (
    mongoc_client_t *client,
@@ -2069,7 +2275,7 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
    if (db && collection &&
        server_stream->sd->max_wire_version >= WIRE_VERSION_KILLCURSORS_CMD) {
       _mongoc_client_killcursors_command (
-         &client->cluster, server_stream, cursor_id, db, collection, cs);
+         &client->cluster, server_stream, cursor_id, db, collection, cs, NULL);
    } else {
       _mongoc_client_op_killcursors (&client->cluster,
                                      server_stream,
@@ -2268,13 +2474,14 @@ _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
 }
 
 
-static void
+void
 _mongoc_client_killcursors_command (mongoc_cluster_t *cluster,
                                     mongoc_server_stream_t *server_stream,
                                     int64_t cursor_id,
                                     const char *db,
                                     const char *collection,
-                                    mongoc_client_session_t *cs)
+                                    mongoc_client_session_t *cs,
+                                    const bson_t *lsid)
 {
    bson_t command = BSON_INITIALIZER;
    mongoc_cmd_parts_t parts;
@@ -2287,6 +2494,13 @@ _mongoc_client_killcursors_command (mongoc_cluster_t *cluster,
    parts.assembled.operation_id = ++cluster->operation_id;
    mongoc_cmd_parts_set_session (&parts, cs);
 
+   /* the cursor was opened under a session that may have ended: send its id
+    * as-is, rather than a new implicit session's */
+   if (!cs && lsid) {
+      BSON_APPEND_DOCUMENT (&command, "lsid", lsid);
+      parts.prohibit_lsid = true;
+   }
+
    if (mongoc_cmd_parts_assemble (&parts, server_stream, NULL)) {
       /* Find, getMore And killCursors Commands Spec: "The result from the
        * killCursors command MAY be safely ignored."
@@ -2666,10 +2880,82 @@ mongoc_client_set_appname (mongoc_client_t *client, const char *appname)
    return _mongoc_topology_set_appname (client->topology, appname);
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_pop_server_session --
+ *
+ *       Internal function. Get the server session @client ended most
+ *       recently, else one from the topology's pool, else create one. On
+ *       error, return NULL and fill out @error.
+ *
+ *       Implicit sessions pop and push a server session for every
+ *       command; keeping recent ones on the client, which only one thread
+ *       uses at a time, avoids the topology mutex in the common case.
+ *
+ *--------------------------------------------------------------------------
+ */
+
 mongoc_server_session_t *
 _mongoc_client_pop_server_session (mongoc_client_t *client, bson_error_t *error)
 {
-   return _mongoc_topology_pop_server_session (client->topology, error);
+   mongoc_server_session_t *ss;
+   int64_t timeout;
+
+   ENTRY;
+
+   timeout = _mongoc_topology_session_timeout_minutes (client->topology);
+
+   /* if sessions support is unknown, the topology decides whether to
+    * connect and check */
+   if (timeout != MONGOC_NO_SESSIONS) {
+      while ((ss = client->session_cache)) {
+         CDL_DELETE (client->session_cache, ss);
+         client->n_cached_sessions--;
+         if (!_mongoc_server_session_timed_out (ss, timeout)) {
+            RETURN (ss);
+         }
+
+         _mongoc_server_session_destroy (ss);
+      }
+   }
+
+   if (!_mongoc_topology_pop_server_session (client->topology, &ss, error)) {
+      RETURN (NULL);
+   }
+
+   if (!ss) {
+      ss = _mongoc_server_session_new (&client->lsid_reserve, error);
+   }
+
+   RETURN (ss);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_flush_server_sessions --
+ *
+ *       Internal function. Return the server sessions @client has cached
+ *       to the topology's pool, oldest first, so they can be reused by
+ *       other clients or ended.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_client_flush_server_sessions (mongoc_client_t *client)
+{
+   mongoc_server_session_t *ss;
+
+   while (client->session_cache) {
+      ss = client->session_cache->prev;
+      CDL_DELETE (client->session_cache, ss);
+      _mongoc_topology_push_server_session (client->topology, ss);
+   }
+
+   client->n_cached_sessions = 0;
 }
 
 /*
@@ -2718,11 +3004,57 @@ _mongoc_client_unregister_session (mongoc_client_t *client,
    mongoc_set_rm (client->client_sessions, session->client_session_id);
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_push_server_session --
+ *
+ *       Internal function. Keep a server session on @client for reuse,
+ *       moving the oldest to the topology's pool if the client has too
+ *       many.
+ *
+ *--------------------------------------------------------------------------
+ */
+
 void
 _mongoc_client_push_server_session (mongoc_client_t *client,
                                     mongoc_server_session_t *server_session)
 {
-   _mongoc_topology_push_server_session (client->topology, server_session);
+   mongoc_server_session_t *ss;
+   int64_t timeout;
+
+   ENTRY;
+
+   timeout = _mongoc_topology_session_timeout_minutes (client->topology);
+
+   /* like the topology's pool, reap timed-out sessions from the back */
+   while (client->session_cache) {
+      ss = client->session_cache->prev;
+      if (!_mongoc_server_session_timed_out (ss, timeout)) {
+         break;
+      }
+
+      CDL_DELETE (client->session_cache, ss);
+      client->n_cached_sessions--;
+      _mongoc_server_session_destroy (ss);
+   }
+
+   if (_mongoc_server_session_timed_out (server_session, timeout)) {
+      _mongoc_server_session_destroy (server_session);
+      EXIT;
+   }
+
+   if (client->n_cached_sessions == MONGOC_CLIENT_SESSION_CACHE_SIZE) {
+      ss = client->session_cache->prev;
+      CDL_DELETE (client->session_cache, ss);
+      client->n_cached_sessions--;
+      _mongoc_topology_push_server_session (client->topology, ss);
+   }
+
+   CDL_PREPEND (client->session_cache, server_session);
+   client->n_cached_sessions++;
+
+   EXIT;
 }
 
 /*
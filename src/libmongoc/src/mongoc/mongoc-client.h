@@ -101,6 +101,20 @@ typedef mongoc_stream_t *(*mongoc_stream_initiator_t) (
    bson_error_t *error);
 
 
+/**
+ * mongoc_client_async_cb_t:
+ * @reply: The server reply, or an empty document on network error. Only
+ *         valid for the duration of the callback.
+ * @error: NULL on success, otherwise the error.
+ * @ctx: The context passed to mongoc_client_async_command().
+ *
+ * Called once when a command sent by mongoc_client_async_command() completes.
+ */
+typedef void (*mongoc_client_async_cb_t) (const bson_t *reply,
+                                          const bson_error_t *error,
+                                          void *ctx);
+
+
 MONGOC_EXPORT (mongoc_client_t *)
 mongoc_client_new (const char *uri_string);
 MONGOC_EXPORT (mongoc_client_t *)
@@ -164,6 +178,24 @@ mongoc_client_command_with_opts (mongoc_client_t *client,
                                  bson_t *reply,
                                  bson_error_t *error);
 MONGOC_EXPORT (bool)
+mongoc_client_command_with_opts_borrowed (
+   mongoc_client_t *client,
+   const char *db_name,
+   const bson_t *command,
+   const mongoc_read_prefs_t *read_prefs,
+   const bson_t *opts,
+   bson_t *reply,
+   bson_error_t *error);
+MONGOC_EXPORT (bool)
+mongoc_client_command_batch_with_opts (mongoc_client_t *client,
+                                       const char *db_name,
+                                       const bson_t **commands,
+                                       size_t n_commands,
+                                       const mongoc_read_prefs_t *read_prefs,
+                                       const bson_t *opts,
+                                       bson_t *replies,
+                                       bson_error_t *error);
+MONGOC_EXPORT (bool)
 mongoc_client_command_simple_with_server_id (
    mongoc_client_t *client,
    const char *db_name,
@@ -172,6 +204,24 @@ mongoc_client_command_simple_with_server_id (
    uint32_t server_id,
    bson_t *reply,
    bson_error_t *error);
+MONGOC_EXPORT (bool)
+mongoc_client_async_command (mongoc_client_t *client,
+                             const char *db_name,
+                             const bson_t *command,
+                             const mongoc_read_prefs_t *read_prefs,
+                             mongoc_client_async_cb_t cb,
+                             void *ctx,
+                             bson_error_t *error);
+MONGOC_EXPORT (size_t)
+mongoc_client_async_get_pollfds (mongoc_client_t *client,
+                                 struct pollfd *fds,
+                                 size_t n_fds);
+MONGOC_EXPORT (int32_t)
+mongoc_client_async_get_timeout_msec (mongoc_client_t *client);
+MONGOC_EXPORT (size_t)
+mongoc_client_async_perform (mongoc_client_t *client,
+                             const struct pollfd *fds,
+                             size_t n_fds);
 MONGOC_EXPORT (void)
 mongoc_client_destroy (mongoc_client_t *client);
 MONGOC_EXPORT (mongoc_client_session_t *)
@@ -38,9 +38,17 @@
 #include "mongoc-write-concern.h"
 #include "mongoc-scram-private.h"
 #include "mongoc-cmd-private.h"
+#include "mongoc-connection-pool-private.h"
 
 BSON_BEGIN_DECLS
 
+/* while pipelined replies are outstanding, at most this many commands and
+ * bytes are written ahead of them. a server whose replies fill the socket
+ * buffers stops reading, so what the client writes meanwhile must fit in
+ * the buffers too, or both sides block until the socket times out */
+#define MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS 16
+#define MONGOC_CLUSTER_PIPELINE_MAX_BYTES (1024 * 1024)
+
 
 typedef struct _mongoc_cluster_node_t {
    mongoc_stream_t *stream;
@@ -53,6 +61,15 @@ typedef struct _mongoc_cluster_node_t {
    int32_t max_msg_size;
 
    int64_t timestamp;
+
+   /* server streams using the node, if checked out of a shared pool */
+   uint32_t leases;
+   /* assigned from the cluster's counter when the first lease is taken */
+   uint64_t lease_generation;
+   /* monotonic time the node was returned to the shared pool */
+   int64_t idle_since;
+   /* the reply a hedged read that lost still owes on the connection */
+   mongoc_orphan_reply_t orphan;
 } mongoc_cluster_node_t;
 
 typedef struct _mongoc_cluster_t {
@@ -60,15 +77,33 @@ typedef struct _mongoc_cluster_t {
    uint32_t request_id;
    uint32_t sockettimeoutms;
    uint32_t socketcheckintervalms;
+   /* the timeoutMS URI option, 0 if unset */
+   int32_t timeoutms;
+   /* the monotonic time in microseconds the operation in progress must
+    * finish by, or 0 if it has no deadline */
+   int64_t deadline;
    mongoc_uri_t *uri;
    unsigned requires_auth : 1;
 
    mongoc_client_t *client;
 
    mongoc_set_t *nodes;
+   /* if set, nodes are checked out of this pool, owned by the client pool,
+    * for each operation instead of kept for the client's lifetime */
+   mongoc_connection_pool_t *conn_pool;
+   uint64_t lease_generation;
    mongoc_array_t iov;
+   mongoc_buffer_t compression_buffer;
 
-   mongoc_scram_cache_t *scram_cache;
+   /* OP_MSG replies are read into reply_buffer, which is reused across
+    * commands; a borrowed reply points into it (or into compression_buffer
+    * if the reply was compressed) until the next command */
+   mongoc_buffer_t reply_buffer;
+
+   /* mongoc_compression_policy_t per server id */
+   mongoc_set_t *compression_policies;
+   int32_t compression_threshold;
+   int32_t compression_min_savings;
 } mongoc_cluster_t;
 
 
@@ -142,6 +177,33 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
                                       bson_t *reply,
                                       bson_error_t *error);
 
+bool
+mongoc_cluster_run_opmsg_exhaust_next (mongoc_cluster_t *cluster,
+                                       mongoc_cmd_t *cmd,
+                                       bson_t *reply,
+                                       bson_error_t *error);
+
+bool
+mongoc_cluster_send_opmsg_deferred (mongoc_cluster_t *cluster,
+                                    mongoc_cmd_t *cmd,
+                                    uint32_t *request_id,
+                                    bson_error_t *error);
+
+bool
+mongoc_cluster_recv_opmsg_deferred (mongoc_cluster_t *cluster,
+                                    mongoc_cmd_t *cmd,
+                                    uint32_t request_id,
+                                    int64_t started,
+                                    bson_t *reply,
+                                    bson_error_t *error);
+
+bool
+mongoc_cluster_run_opmsg_pipeline (mongoc_cluster_t *cluster,
+                                   mongoc_cmd_t **cmds,
+                                   size_t n_cmds,
+                                   bson_t *replies,
+                                   bson_error_t *error);
+
 bool
 mongoc_cluster_run_command_parts (mongoc_cluster_t *cluster,
                                   mongoc_server_stream_t *server_stream,
@@ -175,6 +237,34 @@ _mongoc_cluster_create_server_stream (mongoc_topology_t *topology,
                                       uint32_t server_id,
                                       mongoc_stream_t *stream,
                                       bson_error_t *error /* OUT */);
+
+mongoc_cluster_node_t *
+_mongoc_cluster_node_connect (mongoc_cluster_t *cluster,
+                              uint32_t server_id,
+                              bson_error_t *error /* OUT */);
+
+void
+_mongoc_cluster_node_destroy (mongoc_cluster_node_t *node);
+
+void
+_mongoc_cluster_release_server_stream (mongoc_cluster_t *cluster,
+                                       mongoc_server_stream_t *server_stream);
+
+void
+_mongoc_cluster_release_idle_nodes (mongoc_cluster_t *cluster);
+
+void
+_mongoc_cluster_drain_orphans (mongoc_cluster_t *cluster);
+
+int64_t
+_mongoc_cluster_begin_operation (mongoc_cluster_t *cluster, int64_t timeout_ms);
+
+void
+_mongoc_cluster_end_operation (mongoc_cluster_t *cluster, int64_t prev);
+
+int32_t
+_mongoc_cluster_timeout_ms (int64_t deadline, int32_t timeout_ms);
+
 BSON_END_DECLS
 
 
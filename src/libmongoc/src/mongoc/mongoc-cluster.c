@@ -48,6 +48,7 @@
 #include "mongoc-rpc-private.h"
 #include "mongoc-compression-private.h"
 #include "mongoc-cmd-private.h"
+#include "mongoc-read-prefs-private.h"
 #include "utlist.h"
 #include "mongoc-handshake-private.h"
 
@@ -70,22 +71,6 @@
 
 #define IS_NOT_COMMAND(_name) (!!strcasecmp (cmd->command_name, _name))
 
-/**
- * mongoc_op_msg_flags_t:
- * @MONGOC_MSG_CHECKSUM_PRESENT: The message ends with 4 bytes containing a
- * CRC-32C checksum.
- * @MONGOC_MSG_MORE_TO_COME: If set to 0, wait for a server response. If set to
- * 1, do not expect a server response.
- * @MONGOC_MSG_EXHAUST_ALLOWED: If set, allows multiple replies to this request
- * using the moreToCome bit.
- */
-typedef enum {
-   MONGOC_MSG_NONE = 0,
-   MONGOC_MSG_CHECKSUM_PRESENT = 1 << 0,
-   MONGOC_MSG_MORE_TO_COME = 1 << 1,
-   MONGOC_EXHAUST_ALLOWED = 1 << 16,
-} mongoc_op_msg_flags_t;
-
 static mongoc_server_stream_t *
 mongoc_cluster_fetch_stream_single (mongoc_cluster_t *cluster,
                                     uint32_t server_id,
@@ -98,12 +83,65 @@ mongoc_cluster_fetch_stream_pooled (mongoc_cluster_t *cluster,
                                     bool reconnect_ok,
                                     bson_error_t *error);
 
+static bool
+_mongoc_cluster_drain_orphan (mongoc_cluster_t *cluster,
+                              const mongoc_server_stream_t *server_stream,
+                              bson_error_t *error);
+
+/* replies larger than this are not kept around between commands */
+#define MONGOC_CLUSTER_BUFFER_RETAIN_MAX (1024 * 1024)
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_reset_buffer --
+ *
+ *       Empty one of the cluster's reusable buffers before reading a new
+ *       message into it. The allocation is kept for the next command
+ *       unless an unusually large message grew it beyond
+ *       MONGOC_CLUSTER_BUFFER_RETAIN_MAX.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_cluster_reset_buffer (mongoc_buffer_t *buffer)
+{
+   if (buffer->datalen > MONGOC_CLUSTER_BUFFER_RETAIN_MAX) {
+      _mongoc_buffer_destroy (buffer);
+      _mongoc_buffer_init (buffer, NULL, 0, NULL, NULL);
+   } else {
+      _mongoc_buffer_clear (buffer, false);
+   }
+}
+
+
 static bool
 mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
                           mongoc_cmd_t *cmd,
                           bson_t *reply,
                           bson_error_t *error);
 
+static bool
+_mongoc_cluster_should_hedge (mongoc_cluster_t *cluster,
+                              const mongoc_cmd_t *cmd);
+
+static bool
+_mongoc_cluster_run_opmsg_hedged (mongoc_cluster_t *cluster,
+                                  mongoc_cmd_t *cmd,
+                                  bson_t *reply,
+                                  bson_error_t *error);
+
+static bool
+_mongoc_cluster_recv_opmsg (mongoc_cluster_t *cluster,
+                            mongoc_cmd_t *cmd,
+                            uint32_t *response_to,
+                            uint32_t *flags,
+                            bson_t *reply_local,
+                            bson_t *reply,
+                            bson_error_t *error);
+
 static void
 _bson_error_message_printf (bson_error_t *error, const char *format, ...)
    BSON_GNUC_PRINTF (2, 3);
@@ -145,6 +183,75 @@ _mongoc_cluster_buffer_iovec (mongoc_iovec_t *iov,
    return buffer_offset;
 }
 
+
+static void
+_mongoc_cluster_compression_policy_dtor (void *data_, void *ctx_)
+{
+   bson_free (data_);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_compress --
+ *
+ *       Compress the gathered (little endian) @rpc_le for @server_id,
+ *       unless that server's compression policy says it is not worth it.
+ *
+ * Returns:
+ *       false and sets @error if compression failed. If the policy skips
+ *       compression, returns true and leaves @rpc_le unchanged.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_compress (mongoc_cluster_t *cluster,
+                          uint32_t server_id,
+                          int32_t compressor_id,
+                          mongoc_rpc_t *rpc_le,
+                          bson_error_t *error)
+{
+   mongoc_compression_policy_t *policy;
+   size_t size;
+   int64_t start;
+
+   policy = (mongoc_compression_policy_t *) mongoc_set_get (
+      cluster->compression_policies, server_id);
+   if (!policy) {
+      policy = bson_malloc0 (sizeof *policy);
+      mongoc_set_add (cluster->compression_policies, server_id, policy);
+   }
+
+   size = BSON_UINT32_FROM_LE (rpc_le->header.msg_len) - 16;
+   if (!_mongoc_compression_policy_should_compress (
+          policy, size, cluster->compression_threshold)) {
+      mongoc_counter_op_egress_compress_skipped_inc ();
+      return true;
+   }
+
+   start = bson_get_monotonic_time ();
+   if (!_mongoc_rpc_compress (cluster, compressor_id, rpc_le, error)) {
+      return false;
+   }
+
+   mongoc_counter_op_egress_compress_usec_add (
+      bson_get_monotonic_time () - start);
+   _mongoc_compression_policy_record (policy,
+                                      size,
+                                      cluster->compression_buffer.len,
+                                      cluster->compression_min_savings);
+
+   /* a message that grew counts as saving nothing */
+   if (cluster->compression_buffer.len < size) {
+      mongoc_counter_op_egress_compress_saved_add (
+         (int64_t) size - (int64_t) cluster->compression_buffer.len);
+   }
+
+   return true;
+}
+
 /* Allows caller to safely overwrite error->message with a formatted string,
  * even if the formatted string includes original error->message. */
 static void
@@ -178,6 +285,16 @@ _bson_error_message_printf (bson_error_t *error, const char *format, ...)
       RUN_CMD_ERR_DECORATE;                                \
    } while (0)
 
+/* socketTimeoutMS, or less if the operation must finish by @deadline */
+static int32_t
+_mongoc_cluster_socket_timeout_ms (const mongoc_cluster_t *cluster,
+                                   int64_t deadline)
+{
+   return _mongoc_cluster_timeout_ms (deadline,
+                                      (int32_t) cluster->sockettimeoutms);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -216,7 +333,6 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
    int32_t msg_len;
    size_t doc_len;
    bool ret = false;
-   char *output = NULL;
    uint32_t server_id;
 
    ENTRY;
@@ -254,8 +370,8 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
        IS_NOT_COMMAND ("createuser") && IS_NOT_COMMAND ("updateuser") &&
        IS_NOT_COMMAND ("copydbsaslstart") &&
        IS_NOT_COMMAND ("copydbgetnonce") && IS_NOT_COMMAND ("copydb")) {
-      output = _mongoc_rpc_compress (cluster, compressor_id, &rpc, error);
-      if (output == NULL) {
+      if (!_mongoc_cluster_compress (
+             cluster, server_id, compressor_id, &rpc, error)) {
          GOTO (done);
       }
    }
@@ -271,11 +387,12 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
    /*
     * send and receive
     */
-   if (!_mongoc_stream_writev_full (stream,
-                                    cluster->iov.data,
-                                    cluster->iov.len,
-                                    cluster->sockettimeoutms,
-                                    error)) {
+   if (!_mongoc_stream_writev_full (
+          stream,
+          cluster->iov.data,
+          cluster->iov.len,
+          _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline),
+          error)) {
       mongoc_cluster_disconnect_node (cluster, server_id, true, error);
 
       /* add info about the command to writev_full's error message */
@@ -283,11 +400,13 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       GOTO (done);
    }
 
-   if (reply_header_size != mongoc_stream_read (stream,
-                                                &reply_header_buf,
-                                                reply_header_size,
-                                                reply_header_size,
-                                                cluster->sockettimeoutms)) {
+   if (reply_header_size !=
+       mongoc_stream_read (
+          stream,
+          &reply_header_buf,
+          reply_header_size,
+          reply_header_size,
+          _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline))) {
       RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                    MONGOC_ERROR_STREAM_SOCKET,
                    "socket error or timeout");
@@ -321,11 +440,13 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       reply_buf = bson_malloc0 (msg_len);
       memcpy (reply_buf, reply_header_buf, reply_header_size);
 
-      if (doc_len != mongoc_stream_read (stream,
-                                         reply_buf + reply_header_size,
-                                         doc_len,
-                                         doc_len,
-                                         cluster->sockettimeoutms)) {
+      if (doc_len !=
+          mongoc_stream_read (
+             stream,
+             reply_buf + reply_header_size,
+             doc_len,
+             doc_len,
+             _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline))) {
          RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                       MONGOC_ERROR_STREAM_SOCKET,
                       "socket error or timeout");
@@ -364,11 +485,13 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       reply_buf = bson_reserve_buffer (reply_ptr, (uint32_t) doc_len);
       BSON_ASSERT (reply_buf);
 
-      if (doc_len != mongoc_stream_read (stream,
-                                         (void *) reply_buf,
-                                         doc_len,
-                                         doc_len,
-                                         cluster->sockettimeoutms)) {
+      if (doc_len !=
+          mongoc_stream_read (
+             stream,
+             (void *) reply_buf,
+             doc_len,
+             doc_len,
+             _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline))) {
          RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                       MONGOC_ERROR_STREAM_SOCKET,
                       "socket error or timeout");
@@ -399,7 +522,6 @@ done:
    if (reply_ptr == &reply_local) {
       bson_destroy (reply_ptr);
    }
-   bson_free (output);
 
    RETURN (ret);
 }
@@ -492,6 +614,70 @@ handle_not_master_error (mongoc_cluster_t *cluster,
    }
 }
 
+static void
+_mongoc_cluster_monitor_started (mongoc_cluster_t *cluster,
+                                 mongoc_cmd_t *cmd,
+                                 uint32_t request_id)
+{
+   mongoc_apm_callbacks_t *callbacks = &cluster->client->apm_callbacks;
+   mongoc_apm_command_started_t started_event;
+
+   if (callbacks->started) {
+      mongoc_apm_command_started_init_with_cmd (
+         &started_event, cmd, request_id, cluster->client->apm_context);
+
+      callbacks->started (&started_event);
+      mongoc_apm_command_started_cleanup (&started_event);
+   }
+}
+
+
+static void
+_mongoc_cluster_monitor_finished (mongoc_cluster_t *cluster,
+                                  mongoc_cmd_t *cmd,
+                                  uint32_t request_id,
+                                  int64_t started,
+                                  bool succeeded,
+                                  const bson_t *reply,
+                                  const bson_error_t *error)
+{
+   mongoc_apm_callbacks_t *callbacks = &cluster->client->apm_callbacks;
+   const mongoc_server_description_t *sd = cmd->server_stream->sd;
+   mongoc_apm_command_succeeded_t succeeded_event;
+   mongoc_apm_command_failed_t failed_event;
+
+   if (succeeded && callbacks->succeeded) {
+      mongoc_apm_command_succeeded_init (&succeeded_event,
+                                         bson_get_monotonic_time () - started,
+                                         reply,
+                                         cmd->command_name,
+                                         request_id,
+                                         cmd->operation_id,
+                                         &sd->host,
+                                         sd->id,
+                                         cluster->client->apm_context);
+
+      callbacks->succeeded (&succeeded_event);
+      mongoc_apm_command_succeeded_cleanup (&succeeded_event);
+   }
+   if (!succeeded && callbacks->failed) {
+      mongoc_apm_command_failed_init (&failed_event,
+                                      bson_get_monotonic_time () - started,
+                                      cmd->command_name,
+                                      error,
+                                      reply,
+                                      request_id,
+                                      cmd->operation_id,
+                                      &sd->host,
+                                      sd->id,
+                                      cluster->client->apm_context);
+
+      callbacks->failed (&failed_event);
+      mongoc_apm_command_failed_cleanup (&failed_event);
+   }
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -519,10 +705,6 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
    bool retval;
    uint32_t request_id = ++cluster->request_id;
    uint32_t server_id;
-   mongoc_apm_callbacks_t *callbacks;
-   mongoc_apm_command_started_t started_event;
-   mongoc_apm_command_succeeded_t succeeded_event;
-   mongoc_apm_command_failed_t failed_event;
    int64_t started = bson_get_monotonic_time ();
    const mongoc_server_stream_t *server_stream;
    bson_t reply_local;
@@ -533,7 +715,6 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
    server_id = server_stream->sd->id;
    compressor_id = mongoc_server_description_compressor_id (server_stream->sd);
 
-   callbacks = &cluster->client->apm_callbacks;
    if (!reply) {
       reply = &reply_local;
    }
@@ -541,49 +722,23 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
       error = &error_local;
    }
 
-   if (callbacks->started) {
-      mongoc_apm_command_started_init_with_cmd (
-         &started_event, cmd, request_id, cluster->client->apm_context);
-
-      callbacks->started (&started_event);
-      mongoc_apm_command_started_cleanup (&started_event);
-   }
+   _mongoc_cluster_monitor_started (cluster, cmd, request_id);
 
-   if (server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG) {
+   _mongoc_server_description_op_started (server_stream->sd);
+   if (_mongoc_cluster_should_hedge (cluster, cmd)) {
+      /* APM events name the first server even if the second answered */
+      retval = _mongoc_cluster_run_opmsg_hedged (cluster, cmd, reply, error);
+   } else if (server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG) {
       retval = mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
    } else {
       retval = mongoc_cluster_run_command_opquery (
          cluster, cmd, server_stream->stream, compressor_id, reply, error);
    }
-   if (retval && callbacks->succeeded) {
-      mongoc_apm_command_succeeded_init (&succeeded_event,
-                                         bson_get_monotonic_time () - started,
-                                         reply,
-                                         cmd->command_name,
-                                         request_id,
-                                         cmd->operation_id,
-                                         &server_stream->sd->host,
-                                         server_id,
-                                         cluster->client->apm_context);
-
-      callbacks->succeeded (&succeeded_event);
-      mongoc_apm_command_succeeded_cleanup (&succeeded_event);
-   }
-   if (!retval && callbacks->failed) {
-      mongoc_apm_command_failed_init (&failed_event,
-                                      bson_get_monotonic_time () - started,
-                                      cmd->command_name,
-                                      error,
-                                      reply,
-                                      request_id,
-                                      cmd->operation_id,
-                                      &server_stream->sd->host,
-                                      server_id,
-                                      cluster->client->apm_context);
+   _mongoc_server_description_op_finished (
+      server_stream->sd, bson_get_monotonic_time () - started);
 
-      callbacks->failed (&failed_event);
-      mongoc_apm_command_failed_cleanup (&failed_event);
-   }
+   _mongoc_cluster_monitor_finished (
+      cluster, cmd, request_id, started, retval, reply, error);
 
    handle_not_master_error (cluster, server_id, reply);
 
@@ -625,6 +780,7 @@ mongoc_cluster_run_command_private (mongoc_cluster_t *cluster,
    const mongoc_server_stream_t *server_stream;
    bson_t reply_local;
    bson_error_t error_local;
+   int64_t started;
 
    if (!error) {
       error = &error_local;
@@ -634,12 +790,16 @@ mongoc_cluster_run_command_private (mongoc_cluster_t *cluster,
       reply = &reply_local;
    }
    server_stream = cmd->server_stream;
+   started = bson_get_monotonic_time ();
+   _mongoc_server_description_op_started (server_stream->sd);
    if (server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG) {
       retval = mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
    } else {
       retval = mongoc_cluster_run_command_opquery (
          cluster, cmd, cmd->server_stream->stream, -1, reply, error);
    }
+   _mongoc_server_description_op_finished (
+      server_stream->sd, bson_get_monotonic_time () - started);
    handle_not_master_error (cluster, server_stream->sd->id, reply);
    if (reply == &reply_local) {
       bson_destroy (&reply_local);
@@ -699,7 +859,8 @@ mongoc_cluster_run_command_parts (mongoc_cluster_t *cluster,
  *
  *       Run an ismaster command on the given stream. If
  *       @negotiate_sasl_supported_mechs is true, then saslSupportedMechs is
- *       added to the ismaster command.
+ *       added to the ismaster command. If @speculative_auth is not NULL it
+ *       is sent as the speculativeAuthenticate field.
  *
  * Returns:
  *       A mongoc_server_description_t you must destroy or NULL. If the call
@@ -713,6 +874,7 @@ _mongoc_stream_run_ismaster (mongoc_cluster_t *cluster,
                              const char *address,
                              uint32_t server_id,
                              bool negotiate_sasl_supported_mechs,
+                             const bson_t *speculative_auth,
                              bson_error_t *error)
 {
    const bson_t *command;
@@ -733,10 +895,16 @@ _mongoc_stream_run_ismaster (mongoc_cluster_t *cluster,
 
    command = _mongoc_topology_get_ismaster (cluster->client->topology);
 
-   if (negotiate_sasl_supported_mechs) {
+   if (negotiate_sasl_supported_mechs || speculative_auth) {
       copied_command = bson_copy (command);
-      _mongoc_handshake_append_sasl_supported_mechs (cluster->uri,
-                                                     copied_command);
+      if (negotiate_sasl_supported_mechs) {
+         _mongoc_handshake_append_sasl_supported_mechs (cluster->uri,
+                                                        copied_command);
+      }
+      if (speculative_auth) {
+         BSON_APPEND_DOCUMENT (
+            copied_command, "speculativeAuthenticate", speculative_auth);
+      }
       command = copied_command;
    }
 
@@ -821,6 +989,7 @@ static mongoc_server_description_t *
 _mongoc_cluster_run_ismaster (mongoc_cluster_t *cluster,
                               mongoc_cluster_node_t *node,
                               uint32_t server_id,
+                              const bson_t *speculative_auth,
                               bson_error_t *error /* OUT */)
 {
    mongoc_server_description_t *sd;
@@ -837,6 +1006,7 @@ _mongoc_cluster_run_ismaster (mongoc_cluster_t *cluster,
       node->connection_address,
       server_id,
       _mongoc_uri_requires_auth_negotiation (cluster->uri),
+      speculative_auth,
       error);
 
    if (!sd) {
@@ -1126,30 +1296,29 @@ _mongoc_cluster_auth_node_plain (mongoc_cluster_t *cluster,
 }
 
 
+#ifdef MONGOC_ENABLE_SSL
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_build_x509_cmd --
+ *
+ *       Initialize @cmd as a MONGODB-X509 authenticate command, taking the
+ *       username from the URI or else from the client certificate.
+ *
+ * Returns:
+ *       true on success. false on failure and @error is set, @cmd is not
+ *       initialized.
+ *
+ *--------------------------------------------------------------------------
+ */
+
 static bool
-_mongoc_cluster_auth_node_x509 (mongoc_cluster_t *cluster,
-                                mongoc_stream_t *stream,
-                                mongoc_server_description_t *sd,
+_mongoc_cluster_build_x509_cmd (mongoc_cluster_t *cluster,
+                                bson_t *cmd /* OUT */,
                                 bson_error_t *error)
 {
-#ifndef MONGOC_ENABLE_SSL
-   bson_set_error (error,
-                   MONGOC_ERROR_CLIENT,
-                   MONGOC_ERROR_CLIENT_AUTHENTICATE,
-                   "The MONGODB-X509 authentication mechanism requires "
-                   "libmongoc built with ENABLE_SSL");
-   return false;
-#else
-   mongoc_cmd_parts_t parts;
    const char *username_from_uri = NULL;
    char *username_from_subject = NULL;
-   bson_t cmd;
-   bson_t reply;
-   bool ret;
-   mongoc_server_stream_t *server_stream;
-
-   BSON_ASSERT (cluster);
-   BSON_ASSERT (stream);
 
    username_from_uri = mongoc_uri_get_username (cluster->uri);
    if (username_from_uri) {
@@ -1177,14 +1346,48 @@ _mongoc_cluster_auth_node_x509 (mongoc_cluster_t *cluster,
       TRACE ("%s", "X509: got username from certificate");
    }
 
-   bson_init (&cmd);
-   BSON_APPEND_INT32 (&cmd, "authenticate", 1);
-   BSON_APPEND_UTF8 (&cmd, "mechanism", "MONGODB-X509");
-   BSON_APPEND_UTF8 (&cmd,
+   bson_init (cmd);
+   BSON_APPEND_INT32 (cmd, "authenticate", 1);
+   BSON_APPEND_UTF8 (cmd, "mechanism", "MONGODB-X509");
+   BSON_APPEND_UTF8 (cmd,
                      "user",
                      username_from_uri ? username_from_uri
                                        : username_from_subject);
 
+   bson_free (username_from_subject);
+
+   return true;
+}
+#endif
+
+
+static bool
+_mongoc_cluster_auth_node_x509 (mongoc_cluster_t *cluster,
+                                mongoc_stream_t *stream,
+                                mongoc_server_description_t *sd,
+                                bson_error_t *error)
+{
+#ifndef MONGOC_ENABLE_SSL
+   bson_set_error (error,
+                   MONGOC_ERROR_CLIENT,
+                   MONGOC_ERROR_CLIENT_AUTHENTICATE,
+                   "The MONGODB-X509 authentication mechanism requires "
+                   "libmongoc built with ENABLE_SSL");
+   return false;
+#else
+   mongoc_cmd_parts_t parts;
+   bson_t cmd;
+   bson_t reply;
+   bool ret;
+   mongoc_server_stream_t *server_stream;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (stream);
+
+   if (!_mongoc_cluster_build_x509_cmd (cluster, &cmd, error)) {
+      return false;
+   }
+
    mongoc_cmd_parts_init (
       &parts, cluster->client, "$external", MONGOC_QUERY_SLAVE_OK, &cmd);
    parts.prohibit_lsid = true;
@@ -1199,10 +1402,6 @@ _mongoc_cluster_auth_node_x509 (mongoc_cluster_t *cluster,
       error->code = MONGOC_ERROR_CLIENT_AUTHENTICATE;
    }
 
-   if (username_from_subject) {
-      bson_free (username_from_subject);
-   }
-
    bson_destroy (&cmd);
    bson_destroy (&reply);
 
@@ -1212,94 +1411,116 @@ _mongoc_cluster_auth_node_x509 (mongoc_cluster_t *cluster,
 
 
 #ifdef MONGOC_ENABLE_CRYPTO
-static bool
-_mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
-                                 mongoc_stream_t *stream,
-                                 mongoc_server_description_t *sd,
-                                 mongoc_crypto_hash_algorithm_t algo,
-                                 bson_error_t *error)
+static const char *
+_mongoc_cluster_scram_auth_source (mongoc_cluster_t *cluster)
 {
-   mongoc_cmd_parts_t parts;
-   uint32_t buflen = 0;
-   mongoc_scram_t scram;
-   bson_iter_t iter;
-   bool ret = false;
-   const char *tmpstr;
    const char *auth_source;
-   uint8_t buf[4096] = {0};
-   bson_t cmd;
-   bson_t reply;
-   int conv_id = 0;
-   bson_subtype_t btype;
-   mongoc_server_stream_t *server_stream;
-
-   BSON_ASSERT (cluster);
-   BSON_ASSERT (stream);
 
    if (!(auth_source = mongoc_uri_get_auth_source (cluster->uri)) ||
        (*auth_source == '\0')) {
       auth_source = "admin";
    }
 
-   _mongoc_scram_init (&scram, algo);
-
-   _mongoc_scram_set_pass (&scram, mongoc_uri_get_password (cluster->uri));
-   _mongoc_scram_set_user (&scram, mongoc_uri_get_username (cluster->uri));
-
-   /* Apply previously cached SCRAM secrets if available */
-   if (cluster->scram_cache) {
-      _mongoc_scram_set_cache (&scram, cluster->scram_cache);
-   }
+   return auth_source;
+}
 
-   for (;;) {
-      if (!_mongoc_scram_step (
-             &scram, buf, buflen, buf, sizeof buf, &buflen, error)) {
-         goto failure;
-      }
 
-      bson_init (&cmd);
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_build_scram_start --
+ *
+ *       Initialize @scram with the URI's credentials and any cached SCRAM
+ *       secrets, and @cmd as the saslStart command carrying the client's
+ *       first message.
+ *
+ * Returns:
+ *       true on success. false on failure and @error is set, @cmd is not
+ *       initialized. @scram must be destroyed in either case.
+ *
+ *--------------------------------------------------------------------------
+ */
 
-      if (scram.step == 1) {
-         BSON_APPEND_INT32 (&cmd, "saslStart", 1);
-         if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_1) {
-            BSON_APPEND_UTF8 (&cmd, "mechanism", "SCRAM-SHA-1");
-         } else if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_256) {
-            BSON_APPEND_UTF8 (&cmd, "mechanism", "SCRAM-SHA-256");
-         } else {
-            BSON_ASSERT (false);
-         }
-         bson_append_binary (
-            &cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
-         BSON_APPEND_INT32 (&cmd, "autoAuthorize", 1);
-      } else {
-         BSON_APPEND_INT32 (&cmd, "saslContinue", 1);
-         BSON_APPEND_INT32 (&cmd, "conversationId", conv_id);
-         bson_append_binary (
-            &cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
-      }
+static bool
+_mongoc_cluster_build_scram_start (mongoc_cluster_t *cluster,
+                                   mongoc_scram_t *scram,
+                                   mongoc_crypto_hash_algorithm_t algo,
+                                   bson_t *cmd /* OUT */,
+                                   bson_error_t *error)
+{
+   uint8_t buf[4096] = {0};
+   uint32_t buflen = 0;
 
-      TRACE ("SCRAM: authenticating (step %d)", scram.step);
+   _mongoc_scram_init (scram, algo);
 
-      mongoc_cmd_parts_init (
-         &parts, cluster->client, auth_source, MONGOC_QUERY_SLAVE_OK, &cmd);
-      parts.prohibit_lsid = true;
-      server_stream = _mongoc_cluster_create_server_stream (
-         cluster->client->topology, sd->id, stream, error);
-      if (!mongoc_cluster_run_command_parts (
-             cluster, server_stream, &parts, &reply, error)) {
-         mongoc_server_stream_cleanup (server_stream);
-         bson_destroy (&cmd);
-         bson_destroy (&reply);
+   _mongoc_scram_set_pass (scram, mongoc_uri_get_password (cluster->uri));
+   _mongoc_scram_set_user (scram, mongoc_uri_get_username (cluster->uri));
 
-         /* error->message is already set */
-         error->domain = MONGOC_ERROR_CLIENT;
-         error->code = MONGOC_ERROR_CLIENT_AUTHENTICATE;
-         goto failure;
-      }
-      mongoc_server_stream_cleanup (server_stream);
+   /* Apply previously cached SCRAM secrets if available */
+   _mongoc_topology_apply_scram_cache (cluster->client->topology, scram);
+
+   if (!_mongoc_scram_step (
+          scram, buf, buflen, buf, sizeof buf, &buflen, error)) {
+      return false;
+   }
+
+   bson_init (cmd);
+   BSON_APPEND_INT32 (cmd, "saslStart", 1);
+   if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_1) {
+      BSON_APPEND_UTF8 (cmd, "mechanism", "SCRAM-SHA-1");
+   } else if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_256) {
+      BSON_APPEND_UTF8 (cmd, "mechanism", "SCRAM-SHA-256");
+   } else {
+      BSON_ASSERT (false);
+   }
+   bson_append_binary (cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
+   BSON_APPEND_INT32 (cmd, "autoAuthorize", 1);
+
+   return true;
+}
 
-      bson_destroy (&cmd);
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_auth_scram_continue --
+ *
+ *       Finish the SCRAM conversation begun with @scram, given the
+ *       server's @sasl_start_reply, with saslContinue commands on @stream.
+ *       The reply may come from a saslStart command or from the
+ *       speculativeAuthenticate field of the handshake reply.
+ *
+ * Returns:
+ *       true if authenticated. false on failure and @error is set.
+ *
+ * Side effects:
+ *       Updates the topology's SCRAM cache on success.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_auth_scram_continue (mongoc_cluster_t *cluster,
+                                     mongoc_stream_t *stream,
+                                     mongoc_server_description_t *sd,
+                                     mongoc_scram_t *scram,
+                                     const bson_t *sasl_start_reply,
+                                     bson_error_t *error)
+{
+   mongoc_cmd_parts_t parts;
+   uint32_t buflen = 0;
+   bson_iter_t iter;
+   const char *tmpstr;
+   uint8_t buf[4096] = {0};
+   bson_t cmd;
+   bson_t reply;
+   int conv_id = 0;
+   bson_subtype_t btype;
+   mongoc_server_stream_t *server_stream;
+
+   bson_copy_to (sasl_start_reply, &reply);
+
+   for (;;) {
       if (bson_iter_init_find (&iter, &reply, "done") &&
           bson_iter_as_bool (&iter)) {
          bson_destroy (&reply);
@@ -1327,7 +1548,7 @@ _mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
                          "%s",
                          errmsg);
          bson_destroy (&reply);
-         goto failure;
+         return false;
       }
 
       bson_iter_binary (&iter, &btype, &buflen, (const uint8_t **) &tmpstr);
@@ -1338,24 +1559,110 @@ _mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
                          MONGOC_ERROR_CLIENT_AUTHENTICATE,
                          "SCRAM reply from MongoDB is too large.");
          bson_destroy (&reply);
-         goto failure;
+         return false;
       }
 
       memcpy (buf, tmpstr, buflen);
 
       bson_destroy (&reply);
+
+      if (!_mongoc_scram_step (
+             scram, buf, buflen, buf, sizeof buf, &buflen, error)) {
+         return false;
+      }
+
+      bson_init (&cmd);
+      BSON_APPEND_INT32 (&cmd, "saslContinue", 1);
+      BSON_APPEND_INT32 (&cmd, "conversationId", conv_id);
+      bson_append_binary (
+         &cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
+
+      TRACE ("SCRAM: authenticating (step %d)", scram->step);
+
+      mongoc_cmd_parts_init (&parts,
+                             cluster->client,
+                             _mongoc_cluster_scram_auth_source (cluster),
+                             MONGOC_QUERY_SLAVE_OK,
+                             &cmd);
+      parts.prohibit_lsid = true;
+      server_stream = _mongoc_cluster_create_server_stream (
+         cluster->client->topology, sd->id, stream, error);
+      if (!mongoc_cluster_run_command_parts (
+             cluster, server_stream, &parts, &reply, error)) {
+         mongoc_server_stream_cleanup (server_stream);
+         bson_destroy (&cmd);
+         bson_destroy (&reply);
+
+         /* error->message is already set */
+         error->domain = MONGOC_ERROR_CLIENT;
+         error->code = MONGOC_ERROR_CLIENT_AUTHENTICATE;
+         return false;
+      }
+      mongoc_server_stream_cleanup (server_stream);
+
+      bson_destroy (&cmd);
    }
 
    TRACE ("%s", "SCRAM: authenticated");
 
-   ret = true;
-
    /* Save cached SCRAM secrets for future use */
-   if (cluster->scram_cache) {
-      _mongoc_scram_cache_destroy (cluster->scram_cache);
+   _mongoc_topology_update_scram_cache (cluster->client->topology, scram);
+
+   return true;
+}
+
+
+static bool
+_mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
+                                 mongoc_stream_t *stream,
+                                 mongoc_server_description_t *sd,
+                                 mongoc_crypto_hash_algorithm_t algo,
+                                 bson_error_t *error)
+{
+   mongoc_cmd_parts_t parts;
+   mongoc_scram_t scram;
+   bool ret = false;
+   bson_t cmd;
+   bson_t reply;
+   mongoc_server_stream_t *server_stream;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (stream);
+
+   if (!_mongoc_cluster_build_scram_start (
+          cluster, &scram, algo, &cmd, error)) {
+      goto failure;
+   }
+
+   TRACE ("SCRAM: authenticating (step %d)", scram.step);
+
+   mongoc_cmd_parts_init (&parts,
+                          cluster->client,
+                          _mongoc_cluster_scram_auth_source (cluster),
+                          MONGOC_QUERY_SLAVE_OK,
+                          &cmd);
+   parts.prohibit_lsid = true;
+   server_stream = _mongoc_cluster_create_server_stream (
+      cluster->client->topology, sd->id, stream, error);
+   if (!mongoc_cluster_run_command_parts (
+          cluster, server_stream, &parts, &reply, error)) {
+      mongoc_server_stream_cleanup (server_stream);
+      bson_destroy (&cmd);
+      bson_destroy (&reply);
+
+      /* error->message is already set */
+      error->domain = MONGOC_ERROR_CLIENT;
+      error->code = MONGOC_ERROR_CLIENT_AUTHENTICATE;
+      goto failure;
    }
+   mongoc_server_stream_cleanup (server_stream);
+
+   bson_destroy (&cmd);
+
+   ret = _mongoc_cluster_auth_scram_continue (
+      cluster, stream, sd, &scram, &reply, error);
 
-   cluster->scram_cache = _mongoc_scram_get_cache (&scram);
+   bson_destroy (&reply);
 
 failure:
    _mongoc_scram_destroy (&scram);
@@ -1402,6 +1709,118 @@ _mongoc_cluster_auth_node_scram_sha_256 (mongoc_cluster_t *cluster,
 #endif
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_build_speculative_auth --
+ *
+ *       Initialize @cmd with the first step of MONGODB-X509 or SCRAM
+ *       authentication, to send in the handshake's speculativeAuthenticate
+ *       field. Without a configured mechanism SCRAM-SHA-256 is tried, since
+ *       the server's saslSupportedMechs aren't known yet.
+ *
+ * Returns:
+ *       true if @cmd was initialized. false if the mechanism can't be
+ *       attempted speculatively; regular authentication reports any error.
+ *       Destroy @scram in either case.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_build_speculative_auth (mongoc_cluster_t *cluster,
+                                        mongoc_scram_t *scram,
+                                        bson_t *cmd /* OUT */)
+{
+   const char *mechanism;
+
+   mechanism = mongoc_uri_get_auth_mechanism (cluster->uri);
+   if (!mechanism) {
+      mechanism = "SCRAM-SHA-256";
+   }
+
+#ifdef MONGOC_ENABLE_SSL
+   if (0 == strcasecmp (mechanism, "MONGODB-X509")) {
+      bson_error_t error;
+
+      if (!_mongoc_cluster_build_x509_cmd (cluster, cmd, &error)) {
+         return false;
+      }
+
+      BSON_APPEND_UTF8 (cmd, "db", "$external");
+      return true;
+   }
+#endif
+
+#ifdef MONGOC_ENABLE_CRYPTO
+   if (0 == strcasecmp (mechanism, "SCRAM-SHA-1") ||
+       0 == strcasecmp (mechanism, "SCRAM-SHA-256")) {
+      bson_error_t error;
+
+      if (!_mongoc_cluster_build_scram_start (
+             cluster,
+             scram,
+             0 == strcasecmp (mechanism, "SCRAM-SHA-1")
+                ? MONGOC_CRYPTO_ALGORITHM_SHA_1
+                : MONGOC_CRYPTO_ALGORITHM_SHA_256,
+             cmd,
+             &error)) {
+         return false;
+      }
+
+      BSON_APPEND_UTF8 (
+         cmd, "db", _mongoc_cluster_scram_auth_source (cluster));
+      return true;
+   }
+#endif
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_finish_speculative_auth --
+ *
+ *       Finish authenticating after the server ran the first step sent
+ *       with _mongoc_cluster_build_speculative_auth and returned
+ *       @speculative_reply. A MONGODB-X509 reply means the connection is
+ *       authenticated, a SCRAM reply continues the conversation.
+ *
+ * Returns:
+ *       true if authenticated. false on failure and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_finish_speculative_auth (mongoc_cluster_t *cluster,
+                                         mongoc_stream_t *stream,
+                                         mongoc_server_description_t *sd,
+                                         const bson_t *speculative_reply,
+                                         mongoc_scram_t *speculative_scram,
+                                         bson_error_t *error)
+{
+   const char *mechanism;
+
+   mechanism = mongoc_uri_get_auth_mechanism (cluster->uri);
+   if (mechanism && 0 == strcasecmp (mechanism, "MONGODB-X509")) {
+      TRACE ("%s", "X509: authenticated by handshake");
+      return true;
+   }
+
+#ifdef MONGOC_ENABLE_CRYPTO
+   return _mongoc_cluster_auth_scram_continue (
+      cluster, stream, sd, speculative_scram, speculative_reply, error);
+#else
+   /* _mongoc_cluster_build_speculative_auth only sends MONGODB-X509 */
+   BSON_ASSERT (false);
+   return false;
+#endif
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1424,6 +1843,8 @@ _mongoc_cluster_auth_node (
    mongoc_stream_t *stream,
    mongoc_server_description_t *sd,
    const mongoc_handshake_sasl_supported_mechs_t *sasl_supported_mechs,
+   const bson_t *speculative_reply,
+   mongoc_scram_t *speculative_scram,
    bson_error_t *error)
 {
    bool ret = false;
@@ -1450,7 +1871,10 @@ _mongoc_cluster_auth_node (
       }
    }
 
-   if (0 == strcasecmp (mechanism, "MONGODB-CR")) {
+   if (speculative_reply) {
+      ret = _mongoc_cluster_finish_speculative_auth (
+         cluster, stream, sd, speculative_reply, speculative_scram, error);
+   } else if (0 == strcasecmp (mechanism, "MONGODB-CR")) {
       ret = _mongoc_cluster_auth_node_cr (cluster, stream, sd, error);
    } else if (0 == strcasecmp (mechanism, "MONGODB-X509")) {
       ret = _mongoc_cluster_auth_node_x509 (cluster, stream, sd, error);
@@ -1537,12 +1961,13 @@ mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster,
    EXIT;
 }
 
-static void
+void
 _mongoc_cluster_node_destroy (mongoc_cluster_node_t *node)
 {
    /* Failure, or Replica Set reconfigure without this node */
    mongoc_stream_failed (node->stream);
    bson_free (node->connection_address);
+   _mongoc_orphan_reply_clear (&node->orphan);
 
    bson_free (node);
 }
@@ -1584,35 +2009,44 @@ _mongoc_cluster_node_new (mongoc_stream_t *stream,
 /*
  *--------------------------------------------------------------------------
  *
- * mongoc_cluster_add_node --
- *
- *       Add a new node to this cluster for the given server description.
+ * _mongoc_cluster_node_connect --
  *
- *       NOTE: does NOT check if this server is already in the cluster.
+ *       Open a new connection to the server with @server_id, run the
+ *       handshake and authenticate it. The node is not added to @cluster.
  *
  * Returns:
- *       A stream connected to the server, or NULL on failure.
+ *       A node to be freed with _mongoc_cluster_node_destroy, or NULL
+ *       on failure.
  *
  * Side effects:
- *       Adds a cluster node, or sets error on failure.
+ *       Updates the topology from the handshake, or sets error on failure.
  *
  *--------------------------------------------------------------------------
  */
-static mongoc_stream_t *
-_mongoc_cluster_add_node (mongoc_cluster_t *cluster,
-                          uint32_t server_id,
-                          bson_error_t *error /* OUT */)
+mongoc_cluster_node_t *
+_mongoc_cluster_node_connect (mongoc_cluster_t *cluster,
+                              uint32_t server_id,
+                              bson_error_t *error /* OUT */)
 {
    mongoc_host_list_t *host = NULL;
    mongoc_cluster_node_t *cluster_node = NULL;
    mongoc_stream_t *stream;
    mongoc_server_description_t *sd;
    mongoc_handshake_sasl_supported_mechs_t sasl_supported_mechs;
+   mongoc_scram_t scram;
+   bson_t speculative_auth;
+   bool has_speculative_auth = false;
+   bson_t speculative_reply;
+   const bson_t *speculative_reply_ptr = NULL;
+   bson_iter_t iter;
+   const uint8_t *data;
+   uint32_t len;
 
    ENTRY;
 
    BSON_ASSERT (cluster);
-   BSON_ASSERT (!cluster->client->topology->single_threaded);
+
+   memset (&scram, 0, sizeof scram);
 
    host =
       _mongoc_topology_host_by_id (cluster->client->topology, server_id, error);
@@ -1621,7 +2055,7 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
       GOTO (error);
    }
 
-   TRACE ("Adding new server to cluster: %s", host->host_and_port);
+   TRACE ("Connecting to server: %s", host->host_and_port);
 
    stream = _mongoc_client_create_stream (cluster->client, host, error);
 
@@ -1634,7 +2068,19 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
    /* take critical fields from a fresh ismaster */
    cluster_node = _mongoc_cluster_node_new (stream, host->host_and_port);
 
-   sd = _mongoc_cluster_run_ismaster (cluster, cluster_node, server_id, error);
+   /* send the first authentication step with the handshake, saving round
+    * trips if the server supports it */
+   if (cluster->requires_auth) {
+      has_speculative_auth = _mongoc_cluster_build_speculative_auth (
+         cluster, &scram, &speculative_auth);
+   }
+
+   sd = _mongoc_cluster_run_ismaster (cluster,
+                                      cluster_node,
+                                      server_id,
+                                      has_speculative_auth ? &speculative_auth
+                                                           : NULL,
+                                      error);
    if (!sd) {
       GOTO (error);
    }
@@ -1642,9 +2088,25 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
    _mongoc_handshake_parse_sasl_supported_mechs (&sd->last_is_master,
                                                  &sasl_supported_mechs);
 
+   /* the server omits speculativeAuthenticate from its reply if it doesn't
+    * support it or rejected the first step, then authenticate normally */
+   if (has_speculative_auth &&
+       bson_iter_init_find (
+          &iter, &sd->last_is_master, "speculativeAuthenticate") &&
+       BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+      bson_iter_document (&iter, &len, &data);
+      BSON_ASSERT (bson_init_static (&speculative_reply, data, len));
+      speculative_reply_ptr = &speculative_reply;
+   }
+
    if (cluster->requires_auth) {
-      if (!_mongoc_cluster_auth_node (
-             cluster, cluster_node->stream, sd, &sasl_supported_mechs, error)) {
+      if (!_mongoc_cluster_auth_node (cluster,
+                                      cluster_node->stream,
+                                      sd,
+                                      &sasl_supported_mechs,
+                                      speculative_reply_ptr,
+                                      &scram,
+                                      error)) {
          MONGOC_WARNING ("Failed authentication to %s (%s)",
                          host->host_and_port,
                          error->message);
@@ -1653,14 +2115,24 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
       }
    }
    mongoc_server_description_destroy (sd);
-
-   mongoc_set_add (cluster->nodes, server_id, cluster_node);
    _mongoc_host_list_destroy_all (host);
+   if (has_speculative_auth) {
+      bson_destroy (&speculative_auth);
+   }
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_destroy (&scram);
+#endif
 
-   RETURN (stream);
+   RETURN (cluster_node);
 
 error:
    _mongoc_host_list_destroy_all (host); /* null ok */
+   if (has_speculative_auth) {
+      bson_destroy (&speculative_auth);
+   }
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_destroy (&scram);
+#endif
 
    if (cluster_node) {
       _mongoc_cluster_node_destroy (cluster_node); /* also destroys stream */
@@ -1669,29 +2141,68 @@ error:
    RETURN (NULL);
 }
 
-static void
-node_not_found (mongoc_topology_t *topology,
-                uint32_t server_id,
-                bson_error_t *error /* OUT */)
-{
-   mongoc_server_description_t *sd;
-
-   if (!error) {
-      return;
-   }
-
-   sd = mongoc_topology_server_by_id (topology, server_id, error);
-
-   if (!sd) {
-      return;
-   }
-
-   if (sd->error.code) {
-      memcpy (error, &sd->error, sizeof *error);
-   } else {
-      bson_set_error (error,
-                      MONGOC_ERROR_STREAM,
-                      MONGOC_ERROR_STREAM_NOT_ESTABLISHED,
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_add_node --
+ *
+ *       Add a new node to this cluster for the given server description.
+ *
+ *       NOTE: does NOT check if this server is already in the cluster.
+ *
+ * Returns:
+ *       A stream connected to the server, or NULL on failure.
+ *
+ * Side effects:
+ *       Adds a cluster node, or sets error on failure.
+ *
+ *--------------------------------------------------------------------------
+ */
+static mongoc_stream_t *
+_mongoc_cluster_add_node (mongoc_cluster_t *cluster,
+                          uint32_t server_id,
+                          bson_error_t *error /* OUT */)
+{
+   mongoc_cluster_node_t *cluster_node;
+
+   ENTRY;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (!cluster->client->topology->single_threaded);
+
+   cluster_node = _mongoc_cluster_node_connect (cluster, server_id, error);
+   if (!cluster_node) {
+      RETURN (NULL);
+   }
+
+   mongoc_set_add (cluster->nodes, server_id, cluster_node);
+
+   RETURN (cluster_node->stream);
+}
+
+static void
+node_not_found (mongoc_topology_t *topology,
+                uint32_t server_id,
+                bson_error_t *error /* OUT */)
+{
+   mongoc_server_description_t *sd;
+
+   if (!error) {
+      return;
+   }
+
+   sd = mongoc_topology_server_by_id (topology, server_id, error);
+
+   if (!sd) {
+      return;
+   }
+
+   if (sd->error.code) {
+      memcpy (error, &sd->error, sizeof *error);
+   } else {
+      bson_set_error (error,
+                      MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_NOT_ESTABLISHED,
                       "Could not find node %s",
                       sd->host.host_and_port);
    }
@@ -1889,6 +2400,8 @@ mongoc_cluster_fetch_stream_single (mongoc_cluster_t *cluster,
                                       scanner_node->stream,
                                       sd,
                                       &scanner_node->sasl_supported_mechs,
+                                      NULL /* speculative_reply */,
+                                      NULL /* speculative_scram */,
                                       &sd->error)) {
          memcpy (error, &sd->error, sizeof *error);
          mongoc_server_description_destroy (sd);
@@ -1909,9 +2422,28 @@ _mongoc_cluster_create_server_stream (mongoc_topology_t *topology,
                                       mongoc_stream_t *stream,
                                       bson_error_t *error /* OUT */)
 {
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_topology_cluster_time_t *cluster_time;
    mongoc_server_description_t *sd;
    mongoc_server_stream_t *server_stream = NULL;
 
+   /* if pooled, borrow the description from the latest snapshot, and the
+    * latest clusterTime, which the snapshot doesn't have */
+   snapshot = _mongoc_topology_snapshot_acquire (topology, &cluster_time);
+   if (snapshot) {
+      sd = mongoc_topology_description_server_by_id (
+         &snapshot->description, server_id, error);
+
+      if (!sd) {
+         _mongoc_topology_snapshot_release (snapshot);
+         _mongoc_topology_cluster_time_release (cluster_time);
+         return NULL;
+      }
+
+      return _mongoc_server_stream_new_from_snapshot (
+         snapshot, cluster_time, sd, stream);
+   }
+
    /* can't just use mongoc_topology_server_by_id(), since we must hold the
     * lock while copying topology->description.logical_time below */
    mongoc_mutex_lock (&topology->mutex);
@@ -1931,6 +2463,57 @@ _mongoc_cluster_create_server_stream (mongoc_topology_t *topology,
 }
 
 
+/* if @cluster shares connections, @node is leased to the server stream */
+static mongoc_server_stream_t *
+_mongoc_cluster_create_pooled_server_stream (mongoc_cluster_t *cluster,
+                                             uint32_t server_id,
+                                             mongoc_cluster_node_t *node,
+                                             bson_error_t *error /* OUT */)
+{
+   mongoc_server_stream_t *server_stream;
+
+   server_stream = _mongoc_cluster_create_server_stream (
+      cluster->client->topology, server_id, node->stream, error);
+
+   if (server_stream && cluster->conn_pool) {
+      if (!node->leases++) {
+         node->lease_generation = ++cluster->lease_generation;
+      }
+
+      server_stream->cluster = cluster;
+      server_stream->lease_generation = node->lease_generation;
+   }
+
+   return server_stream;
+}
+
+/* take an idle connection to @server_id from the shared pool, discarding
+ * any that predate a topology change or network error */
+static mongoc_cluster_node_t *
+_mongoc_cluster_checkout_shared_node (mongoc_cluster_t *cluster,
+                                      uint32_t server_id)
+{
+   mongoc_cluster_node_t *node;
+   int64_t timestamp;
+
+   timestamp =
+      mongoc_topology_server_timestamp (cluster->client->topology, server_id);
+
+   while ((node = _mongoc_connection_pool_checkout (cluster->conn_pool,
+                                                    server_id))) {
+      if (timestamp != -1 && node->timestamp >= timestamp) {
+         BSON_ASSERT (!node->leases);
+         mongoc_set_add (cluster->nodes, server_id, node);
+         return node;
+      }
+
+      _mongoc_cluster_node_destroy (node);
+   }
+
+   return NULL;
+}
+
+
 static mongoc_server_stream_t *
 mongoc_cluster_fetch_stream_pooled (mongoc_cluster_t *cluster,
                                     uint32_t server_id,
@@ -1938,7 +2521,6 @@ mongoc_cluster_fetch_stream_pooled (mongoc_cluster_t *cluster,
                                     bson_error_t *error /* OUT */)
 {
    mongoc_topology_t *topology;
-   mongoc_stream_t *stream;
    mongoc_cluster_node_t *cluster_node;
    int64_t timestamp;
 
@@ -1957,8 +2539,17 @@ mongoc_cluster_fetch_stream_pooled (mongoc_cluster_t *cluster,
          mongoc_cluster_disconnect_node (
             cluster, server_id, false /* invalidate */, NULL);
       } else {
-         return _mongoc_cluster_create_server_stream (
-            topology, server_id, cluster_node->stream, error);
+         return _mongoc_cluster_create_pooled_server_stream (
+            cluster, server_id, cluster_node, error);
+      }
+   }
+
+   /* an idle shared connection is already open, so reconnect_ok is moot */
+   if (cluster->conn_pool) {
+      cluster_node = _mongoc_cluster_checkout_shared_node (cluster, server_id);
+      if (cluster_node) {
+         return _mongoc_cluster_create_pooled_server_stream (
+            cluster, server_id, cluster_node, error);
       }
    }
 
@@ -1968,13 +2559,160 @@ mongoc_cluster_fetch_stream_pooled (mongoc_cluster_t *cluster,
       return NULL;
    }
 
-   stream = _mongoc_cluster_add_node (cluster, server_id, error);
-   if (stream) {
-      return _mongoc_cluster_create_server_stream (
-         topology, server_id, stream, error);
-   } else {
+   if (!_mongoc_cluster_add_node (cluster, server_id, error)) {
       return NULL;
    }
+
+   cluster_node =
+      (mongoc_cluster_node_t *) mongoc_set_get (cluster->nodes, server_id);
+
+   return _mongoc_cluster_create_pooled_server_stream (
+      cluster, server_id, cluster_node, error);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_release_server_stream --
+ *
+ *       Called when a server stream whose connection was checked out of
+ *       the shared pool is cleaned up. Once no server stream uses the
+ *       connection it goes back to the pool, unless an exhaust cursor is
+ *       still reading from it.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_cluster_release_server_stream (mongoc_cluster_t *cluster,
+                                       mongoc_server_stream_t *server_stream)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_cluster_node_t *node;
+   uint32_t server_id = server_stream->sd->id;
+
+   BSON_ASSERT (cluster->conn_pool);
+
+   node = (mongoc_cluster_node_t *) mongoc_set_get (cluster->nodes, server_id);
+   if (!node || node->lease_generation != server_stream->lease_generation) {
+      /* disconnected after an error, the connection is gone */
+      return;
+   }
+
+   BSON_ASSERT (node->leases > 0);
+   /* connections in the pool owe no hedged read a reply. rather than wait
+    * for one here, keep the connection until the client goes back to its
+    * pool: see _mongoc_cluster_release_idle_nodes */
+   if (--node->leases > 0 || cluster->client->in_exhaust ||
+       node->orphan.request_id) {
+      return;
+   }
+
+   mongoc_set_steal (cluster->nodes, server_id);
+   snapshot = _mongoc_topology_snapshot_acquire (cluster->client->topology,
+                                                 NULL);
+   _mongoc_connection_pool_checkin (
+      cluster->conn_pool, server_id, node, snapshot);
+   _mongoc_topology_snapshot_release (snapshot);
+}
+
+
+/* return every connection no server stream is using to the shared pool,
+ * called when the client goes back to its pool */
+void
+_mongoc_cluster_release_idle_nodes (mongoc_cluster_t *cluster)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_cluster_node_t *node;
+   uint32_t server_id;
+   size_t i;
+
+   if (!cluster->conn_pool) {
+      return;
+   }
+
+   _mongoc_cluster_drain_orphans (cluster);
+
+   snapshot = _mongoc_topology_snapshot_acquire (cluster->client->topology,
+                                                 NULL);
+
+   for (i = cluster->nodes->items_len; i > 0; i--) {
+      node = (mongoc_cluster_node_t *) mongoc_set_get_item_and_id (
+         cluster->nodes, (int) i - 1, &server_id);
+
+      if (!node->leases) {
+         mongoc_set_steal (cluster->nodes, server_id);
+         _mongoc_connection_pool_checkin (
+            cluster->conn_pool, server_id, node, snapshot);
+      }
+   }
+
+   _mongoc_topology_snapshot_release (snapshot);
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_drain_orphans --
+ *
+ *       Read the replies hedged reads that lost still owe on @cluster's
+ *       idle connections, and kill the cursors they opened, before the
+ *       connections are returned to the shared pool, re-scanned, or
+ *       closed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_cluster_drain_orphans (mongoc_cluster_t *cluster)
+{
+   mongoc_topology_t *topology = cluster->client->topology;
+   mongoc_topology_scanner_node_t *scanner_node;
+   mongoc_topology_scanner_node_t *tmp;
+   mongoc_cluster_node_t *node;
+   mongoc_server_stream_t *server_stream;
+   bson_error_t error;
+   uint32_t server_id;
+   size_t i;
+
+   if (topology->single_threaded) {
+      /* draining disconnects a failed node, but leaves it in the list */
+      DL_FOREACH_SAFE (topology->scanner->nodes, scanner_node, tmp)
+      {
+         if (!scanner_node->stream || !scanner_node->orphan.request_id) {
+            continue;
+         }
+
+         server_stream = _mongoc_cluster_create_server_stream (
+            topology, scanner_node->id, scanner_node->stream, &error);
+         if (server_stream) {
+            (void) _mongoc_cluster_drain_orphan (
+               cluster, server_stream, &error);
+            mongoc_server_stream_cleanup (server_stream);
+         }
+      }
+
+      return;
+   }
+
+   /* backwards, since a node disconnected while draining is removed */
+   for (i = cluster->nodes->items_len; i > 0; i--) {
+      node = (mongoc_cluster_node_t *) mongoc_set_get_item_and_id (
+         cluster->nodes, (int) i - 1, &server_id);
+
+      /* a leased connection is drained before its next use */
+      if (node->leases || !node->orphan.request_id) {
+         continue;
+      }
+
+      server_stream = _mongoc_cluster_create_server_stream (
+         topology, server_id, node->stream, &error);
+      if (server_stream) {
+         (void) _mongoc_cluster_drain_orphan (cluster, server_stream, &error);
+         mongoc_server_stream_cleanup (server_stream);
+      }
+   }
 }
 
 /*
@@ -2016,6 +2754,9 @@ mongoc_cluster_init (mongoc_cluster_t *cluster,
    cluster->sockettimeoutms = mongoc_uri_get_option_as_int32 (
       uri, MONGOC_URI_SOCKETTIMEOUTMS, MONGOC_DEFAULT_SOCKETTIMEOUTMS);
 
+   cluster->timeoutms = mongoc_uri_get_option_as_int32 (
+      uri, MONGOC_URI_TIMEOUTMS, 0);
+
    cluster->socketcheckintervalms =
       mongoc_uri_get_option_as_int32 (uri,
                                       MONGOC_URI_SOCKETCHECKINTERVALMS,
@@ -2025,6 +2766,15 @@ mongoc_cluster_init (mongoc_cluster_t *cluster,
    cluster->nodes = mongoc_set_new (8, _mongoc_cluster_node_dtor, NULL);
 
    _mongoc_array_init (&cluster->iov, sizeof (mongoc_iovec_t));
+   _mongoc_buffer_init (&cluster->compression_buffer, NULL, 0, NULL, NULL);
+   _mongoc_buffer_init (&cluster->reply_buffer, NULL, 0, NULL, NULL);
+
+   cluster->compression_policies = mongoc_set_new (
+      8, _mongoc_cluster_compression_policy_dtor, NULL);
+   cluster->compression_threshold = mongoc_uri_get_option_as_int32 (
+      uri, MONGOC_URI_COMPRESSIONTHRESHOLDBYTES, 0);
+   cluster->compression_min_savings = mongoc_uri_get_option_as_int32 (
+      uri, MONGOC_URI_COMPRESSIONMINSAVINGSPERCENT, 0);
 
    cluster->operation_id = rand ();
 
@@ -2060,14 +2810,87 @@ mongoc_cluster_destroy (mongoc_cluster_t *cluster) /* INOUT */
    mongoc_set_destroy (cluster->nodes);
 
    _mongoc_array_destroy (&cluster->iov);
+   _mongoc_buffer_destroy (&cluster->compression_buffer);
+   _mongoc_buffer_destroy (&cluster->reply_buffer);
+   mongoc_set_destroy (cluster->compression_policies);
 
-#ifdef MONGOC_ENABLE_CRYPTO
-   if (cluster->scram_cache) {
-      _mongoc_scram_cache_destroy (cluster->scram_cache);
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_begin_operation --
+ *
+ *       Start an operation that may take @timeout_ms in total, or the
+ *       timeoutMS URI option if @timeout_ms is 0. Server selection,
+ *       connecting, authenticating, and each send and receive until the
+ *       matching _mongoc_cluster_end_operation use only what is left of
+ *       it. An operation begun within another keeps the sooner deadline.
+ *
+ * Returns:
+ *       The previous deadline, to pass to _mongoc_cluster_end_operation.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int64_t
+_mongoc_cluster_begin_operation (mongoc_cluster_t *cluster, int64_t timeout_ms)
+{
+   int64_t prev = cluster->deadline;
+   int64_t deadline;
+
+   if (timeout_ms <= 0) {
+      timeout_ms = cluster->timeoutms;
    }
-#endif
 
-   EXIT;
+   if (timeout_ms > 0) {
+      deadline = bson_get_monotonic_time () + timeout_ms * 1000;
+      if (!prev || deadline < prev) {
+         cluster->deadline = deadline;
+      }
+   }
+
+   return prev;
+}
+
+
+void
+_mongoc_cluster_end_operation (mongoc_cluster_t *cluster, int64_t prev)
+{
+   cluster->deadline = prev;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_timeout_ms --
+ *
+ *       The timeout for one blocking step of an operation that must finish
+ *       by @deadline: @timeout_ms, or the time left if that is less. At
+ *       least 1ms, so a step that starts late fails with a timeout rather
+ *       than blocking.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int32_t
+_mongoc_cluster_timeout_ms (int64_t deadline, int32_t timeout_ms)
+{
+   int64_t left_ms;
+
+   if (!deadline) {
+      return timeout_ms;
+   }
+
+   left_ms = BSON_MAX ((deadline - bson_get_monotonic_time ()) / 1000, 1);
+   if (timeout_ms > 0 && timeout_ms < left_ms) {
+      return timeout_ms;
+   }
+
+   return (int32_t) BSON_MIN (left_ms, INT32_MAX);
 }
 
 
@@ -2105,8 +2928,14 @@ _mongoc_cluster_stream_for_optype (mongoc_cluster_t *cluster,
 
    BSON_ASSERT (cluster);
 
-   server_id =
-      mongoc_topology_select_server_id (topology, optype, read_prefs, error);
+   /* selection may re-scan servers, which can't share a connection that
+    * still owes a hedged read a reply */
+   if (topology->single_threaded) {
+      _mongoc_cluster_drain_orphans (cluster);
+   }
+
+   server_id = _mongoc_topology_select_server_id (
+      topology, optype, read_prefs, cluster->deadline, error);
 
    if (!server_id) {
       _mongoc_bson_init_with_transient_txn_error (cs, reply);
@@ -2115,8 +2944,8 @@ _mongoc_cluster_stream_for_optype (mongoc_cluster_t *cluster,
 
    if (!mongoc_cluster_check_interval (cluster, server_id)) {
       /* Server Selection Spec: try once more */
-      server_id =
-         mongoc_topology_select_server_id (topology, optype, read_prefs, error);
+      server_id = _mongoc_topology_select_server_id (
+         topology, optype, read_prefs, cluster->deadline, error);
 
       if (!server_id) {
          _mongoc_bson_init_with_transient_txn_error (cs, reply);
@@ -2446,7 +3275,6 @@ mongoc_cluster_legacy_rpc_sendv_to_server (
    int32_t max_msg_size;
    bool ret = false;
    int32_t compressor_id = 0;
-   char *output = NULL;
 
    ENTRY;
 
@@ -2464,6 +3292,11 @@ mongoc_cluster_legacy_rpc_sendv_to_server (
       GOTO (done);
    }
 
+   /* a hedged read's late reply would be taken for this message's */
+   if (!_mongoc_cluster_drain_orphan (cluster, server_stream, error)) {
+      GOTO (done);
+   }
+
    _mongoc_array_clear (&cluster->iov);
    compressor_id = mongoc_server_description_compressor_id (server_stream->sd);
 
@@ -2471,8 +3304,8 @@ mongoc_cluster_legacy_rpc_sendv_to_server (
    _mongoc_rpc_swab_to_le (rpc);
 
    if (compressor_id != -1) {
-      output = _mongoc_rpc_compress (cluster, compressor_id, rpc, error);
-      if (output == NULL) {
+      if (!_mongoc_cluster_compress (
+             cluster, server_id, compressor_id, rpc, error)) {
          GOTO (done);
       }
    }
@@ -2490,11 +3323,12 @@ mongoc_cluster_legacy_rpc_sendv_to_server (
       GOTO (done);
    }
 
-   if (!_mongoc_stream_writev_full (server_stream->stream,
-                                    cluster->iov.data,
-                                    cluster->iov.len,
-                                    cluster->sockettimeoutms,
-                                    error)) {
+   if (!_mongoc_stream_writev_full (
+          server_stream->stream,
+          cluster->iov.data,
+          cluster->iov.len,
+          _mongoc_cluster_socket_timeout_ms (cluster, cluster->deadline),
+          error)) {
       GOTO (done);
    }
 
@@ -2504,10 +3338,6 @@ mongoc_cluster_legacy_rpc_sendv_to_server (
 
 done:
 
-   if (compressor_id) {
-      bson_free (output);
-   }
-
    RETURN (ret);
 }
 
@@ -2568,7 +3398,11 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
     */
    pos = buffer->len;
    if (!_mongoc_buffer_append_from_stream (
-          buffer, server_stream->stream, 4, cluster->sockettimeoutms, error)) {
+          buffer,
+          server_stream->stream,
+          4,
+          _mongoc_cluster_socket_timeout_ms (cluster, cluster->deadline),
+          error)) {
       MONGOC_DEBUG (
          "Could not read 4 bytes, stream probably closed or timed out");
       mongoc_counter_protocol_ingress_error_inc ();
@@ -2599,11 +3433,12 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
    /*
     * Read the rest of the message from the stream.
     */
-   if (!_mongoc_buffer_append_from_stream (buffer,
-                                           server_stream->stream,
-                                           msg_len - 4,
-                                           cluster->sockettimeoutms,
-                                           error)) {
+   if (!_mongoc_buffer_append_from_stream (
+          buffer,
+          server_stream->stream,
+          msg_len - 4,
+          _mongoc_cluster_socket_timeout_ms (cluster, cluster->deadline),
+          error)) {
       mongoc_cluster_disconnect_node (
          cluster,
          server_id,
@@ -2675,44 +3510,199 @@ network_error_reply (bson_t *reply, mongoc_cmd_t *cmd)
 }
 
 
-static bool
-mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
-                          mongoc_cmd_t *cmd,
-                          bson_t *reply,
-                          bson_error_t *error)
+/* where the connection @server_stream uses records the reply it owes a
+ * hedged read that lost, or NULL if it is not a cluster or scanner node's */
+static mongoc_orphan_reply_t *
+_mongoc_cluster_orphan_slot (mongoc_cluster_t *cluster,
+                             const mongoc_server_stream_t *server_stream)
 {
-   mongoc_rpc_section_t section[2];
-   mongoc_buffer_t buffer;
-   bson_t reply_local; /* only statically initialized */
-   char *output = NULL;
-   mongoc_rpc_t rpc;
-   int32_t msg_len;
-   bool ok;
-   const mongoc_server_stream_t *server_stream;
+   mongoc_topology_t *topology = cluster->client->topology;
+   mongoc_topology_scanner_node_t *scanner_node;
+   mongoc_cluster_node_t *node;
+   uint32_t server_id = server_stream->sd->id;
 
-   server_stream = cmd->server_stream;
-   if (!cmd->command_name) {
-      bson_set_error (error,
-                      MONGOC_ERROR_COMMAND,
-                      MONGOC_ERROR_COMMAND_INVALID_ARG,
-                      "Empty command document");
-      _mongoc_bson_init_if_set (reply);
-      return false;
-   }
-   if (cluster->client->in_exhaust) {
+   /* both streams are open, so equal pointers are the same connection */
+   if (topology->single_threaded) {
+      scanner_node =
+         mongoc_topology_scanner_get_node (topology->scanner, server_id);
+      if (scanner_node && scanner_node->stream == server_stream->stream) {
+         return &scanner_node->orphan;
+      }
+   } else {
+      node =
+         (mongoc_cluster_node_t *) mongoc_set_get (cluster->nodes, server_id);
+      if (node && node->stream == server_stream->stream) {
+         return &node->orphan;
+      }
+   }
+
+   return NULL;
+}
+
+
+
+/* after a network or protocol error on @server_stream, disconnect the node
+ * whose connection it uses and mark the server Unknown. a connection that
+ * is no node's, like a cursor's prefetch connection, is left for its owner
+ * to close: the node's own connection is fine */
+static void
+_mongoc_cluster_disconnect_stream (mongoc_cluster_t *cluster,
+                                   const mongoc_server_stream_t *server_stream,
+                                   const bson_error_t *why)
+{
+   uint32_t server_id = server_stream->sd->id;
+
+   if (_mongoc_cluster_orphan_slot (cluster, server_stream)) {
+      mongoc_cluster_disconnect_node (cluster, server_id, true, why);
+   } else {
+      mongoc_topology_invalidate_server (
+         cluster->client->topology, server_id, why);
+   }
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_drain_orphan --
+ *
+ *       If a hedged read that lost still owes a reply on @server_stream's
+ *       connection, read and discard it, so the connection can be used
+ *       again. If the read opened a cursor, kill it under the read's
+ *       session.
+ *
+ * Returns:
+ *       true if successful or nothing was owed; otherwise false, @error is
+ *       set and the node is disconnected.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_drain_orphan (mongoc_cluster_t *cluster,
+                              const mongoc_server_stream_t *server_stream,
+                              bson_error_t *error)
+{
+   mongoc_orphan_reply_t *slot;
+   mongoc_orphan_reply_t orphan;
+   mongoc_cmd_t cmd;
+   bson_t reply_local; /* only statically initialized */
+   bson_iter_t iter;
+   uint32_t response_to;
+   uint32_t flags;
+   int64_t cursor_id = 0;
+   char *ns = NULL;
+   char *coll;
+   bool ret = false;
+
+   slot = _mongoc_cluster_orphan_slot (cluster, server_stream);
+   if (!slot || !slot->request_id) {
+      return true;
+   }
+
+   /* take it: the killCursors below is sent on the same connection */
+   orphan = *slot;
+   memset (slot, 0, sizeof *slot);
+
+   /* just enough of the read to receive its reply */
+   memset (&cmd, 0, sizeof cmd);
+   cmd.server_stream = server_stream;
+   cmd.db_name = orphan.db_name;
+   cmd.command_name = orphan.command_name;
+   cmd.deadline = cluster->deadline;
+
+   if (!_mongoc_cluster_recv_opmsg (
+          cluster, &cmd, &response_to, &flags, &reply_local, NULL, error)) {
+      GOTO (done);
+   }
+
+   if (response_to != orphan.request_id) {
       bson_set_error (error,
-                      MONGOC_ERROR_CLIENT,
-                      MONGOC_ERROR_CLIENT_IN_EXHAUST,
-                      "A cursor derived from this client is in exhaust.");
-      _mongoc_bson_init_if_set (reply);
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Expected a reply to request %u, got one to %u",
+                      orphan.request_id,
+                      response_to);
+      _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
+      GOTO (done);
+   }
+
+   /* the reply is only valid until the next read, copy what's needed */
+   if (bson_iter_init (&iter, &reply_local) &&
+       bson_iter_find_descendant (&iter, "cursor.id", &iter) &&
+       BSON_ITER_HOLDS_INT64 (&iter)) {
+      cursor_id = bson_iter_int64 (&iter);
+   }
+
+   if (cursor_id && bson_iter_init (&iter, &reply_local) &&
+       bson_iter_find_descendant (&iter, "cursor.ns", &iter) &&
+       BSON_ITER_HOLDS_UTF8 (&iter)) {
+      ns = bson_strdup (bson_iter_utf8 (&iter, NULL));
+   }
+
+   coll = ns ? strchr (ns, '.') : NULL;
+   if (coll) {
+      *coll++ = '\0';
+      _mongoc_client_killcursors_command (
+         cluster,
+         (mongoc_server_stream_t *) server_stream,
+         cursor_id,
+         ns,
+         coll,
+         NULL,
+         orphan.lsid);
+   }
+
+   ret = true;
+
+done:
+   bson_free (ns);
+   _mongoc_orphan_reply_clear (&orphan);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_send_opmsg --
+ *
+ *       Write @cmd to its server stream as an OP_MSG with @request_id,
+ *       compressing it if the server negotiated a compressor. Does not
+ *       wait for a reply, except one a hedged read that lost still owes
+ *       on the connection, which is read first.
+ *
+ * Returns:
+ *       true if successful; otherwise false, @error is set and @reply is
+ *       initialized. If the stream failed the node is disconnected, see
+ *       _mongoc_cluster_disconnect_stream.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_send_opmsg (mongoc_cluster_t *cluster,
+                            mongoc_cmd_t *cmd,
+                            uint32_t request_id,
+                            bson_t *reply,
+                            bson_error_t *error)
+{
+   mongoc_rpc_section_t section[2];
+   mongoc_rpc_t rpc;
+   bool ok;
+   const mongoc_server_stream_t *server_stream;
+
+   server_stream = cmd->server_stream;
+
+   if (!_mongoc_cluster_drain_orphan (cluster, server_stream, error)) {
+      network_error_reply (reply, cmd);
       return false;
    }
 
    _mongoc_array_clear (&cluster->iov);
-   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
 
    rpc.header.msg_len = 0;
-   rpc.header.request_id = ++cluster->request_id;
+   rpc.header.request_id = request_id;
    rpc.header.response_to = 0;
    rpc.header.opcode = MONGOC_OPCODE_MSG;
 
@@ -2722,19 +3712,25 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
       rpc.msg.flags = MONGOC_MSG_MORE_TO_COME;
    }
 
+   if (cmd->exhaust_allowed) {
+      rpc.msg.flags |= MONGOC_MSG_EXHAUST_ALLOWED;
+   }
+
    rpc.msg.n_sections = 1;
 
    section[0].payload_type = 0;
    section[0].payload.bson_document = bson_get_data (cmd->command);
    rpc.msg.sections[0] = section[0];
 
-   if (cmd->payload) {
+   if (cmd->payload || cmd->payload_iov) {
       section[1].payload_type = 1;
       section[1].payload.sequence.size = cmd->payload_size +
                                          strlen (cmd->payload_identifier) + 1 +
                                          sizeof (int32_t);
       section[1].payload.sequence.identifier = cmd->payload_identifier;
       section[1].payload.sequence.bson_documents = cmd->payload;
+      section[1].payload.sequence.iov = cmd->payload_iov;
+      section[1].payload.sequence.iovcnt = cmd->payload_iovcnt;
       rpc.msg.sections[1] = section[1];
       rpc.msg.n_sections++;
    }
@@ -2749,130 +3745,948 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
       TRACE (
          "Function '%s' is compressible: %d", cmd->command_name, compressor_id);
       if (compressor_id != -1) {
-         output = _mongoc_rpc_compress (cluster, compressor_id, &rpc, error);
-         if (output == NULL) {
+         if (!_mongoc_cluster_compress (cluster,
+                                        server_stream->sd->id,
+                                        compressor_id,
+                                        &rpc,
+                                        error)) {
             _mongoc_bson_init_if_set (reply);
-            _mongoc_buffer_destroy (&buffer);
             return false;
          }
       }
    }
-   ok = _mongoc_stream_writev_full (server_stream->stream,
-                                    (mongoc_iovec_t *) cluster->iov.data,
-                                    cluster->iov.len,
-                                    cluster->sockettimeoutms,
-                                    error);
+   ok = _mongoc_stream_writev_full (
+      server_stream->stream,
+      (mongoc_iovec_t *) cluster->iov.data,
+      cluster->iov.len,
+      _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline),
+      error);
    if (!ok) {
       /* add info about the command to writev_full's error message */
       RUN_CMD_ERR_DECORATE;
-      mongoc_cluster_disconnect_node (
-         cluster, server_stream->sd->id, true, error);
-      bson_free (output);
+      _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
       network_error_reply (reply, cmd);
-      _mongoc_buffer_destroy (&buffer);
       return false;
    }
 
-   /* If acknowledged, wait for a server response. Otherwise, exit early */
-   if (cmd->is_acknowledged) {
-      ok = _mongoc_buffer_append_from_stream (
-         &buffer, server_stream->stream, 4, cluster->sockettimeoutms, error);
-      if (!ok) {
-         RUN_CMD_ERR_DECORATE;
-         mongoc_cluster_disconnect_node (
-            cluster, server_stream->sd->id, true, error);
-         bson_free (output);
-         network_error_reply (reply, cmd);
-         _mongoc_buffer_destroy (&buffer);
-         return false;
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_recv_opmsg --
+ *
+ *       Read the next OP_MSG from @cmd's server stream into the cluster's
+ *       reply buffer, decompressing it if needed. @cmd is only used to
+ *       describe failures.
+ *
+ * Returns:
+ *       true if successful; @reply_local is statically initialized with
+ *       the reply's first section, valid until the next read, and
+ *       @response_to and @flags are set. Otherwise false, @error is set,
+ *       @reply is initialized, and the node is disconnected.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_recv_opmsg (mongoc_cluster_t *cluster,
+                            mongoc_cmd_t *cmd,
+                            uint32_t *response_to,
+                            uint32_t *flags,
+                            bson_t *reply_local,
+                            bson_t *reply,
+                            bson_error_t *error)
+{
+   mongoc_buffer_t *buffer = &cluster->reply_buffer;
+   mongoc_rpc_t rpc;
+   int32_t msg_len;
+   bool ok;
+   const mongoc_server_stream_t *server_stream;
+
+   server_stream = cmd->server_stream;
+   _mongoc_cluster_reset_buffer (buffer);
+
+   ok = _mongoc_buffer_append_from_stream (
+      buffer,
+      server_stream->stream,
+      4,
+      _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline),
+      error);
+   if (!ok) {
+      RUN_CMD_ERR_DECORATE;
+      _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
+      network_error_reply (reply, cmd);
+      return false;
+   }
+
+   BSON_ASSERT (buffer->len == 4);
+   memcpy (&msg_len, buffer->data, 4);
+   msg_len = BSON_UINT32_FROM_LE (msg_len);
+   if ((msg_len < 16) || (msg_len > server_stream->sd->max_msg_size)) {
+      RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+                   MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                   "Message size %d is not within expected range 16-%d bytes",
+                   msg_len,
+                   server_stream->sd->max_msg_size);
+      _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
+      network_error_reply (reply, cmd);
+      return false;
+   }
+
+   ok = _mongoc_buffer_append_from_stream (
+      buffer,
+      server_stream->stream,
+      (size_t) msg_len - 4,
+      _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline),
+      error);
+   if (!ok) {
+      RUN_CMD_ERR_DECORATE;
+      _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
+      network_error_reply (reply, cmd);
+      return false;
+   }
+
+   ok = _mongoc_rpc_scatter (&rpc, buffer->data, buffer->len);
+   if (!ok) {
+      RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+                   MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                   "Malformed message from server");
+      _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
+      network_error_reply (reply, cmd);
+      return false;
+   }
+   if (BSON_UINT32_FROM_LE (rpc.header.opcode) == MONGOC_OPCODE_COMPRESSED) {
+      size_t len = BSON_UINT32_FROM_LE (rpc.compressed.uncompressed_size) +
+                   sizeof (mongoc_rpc_header_t);
+
+      /* the request has been sent, so its compression buffer is free to
+       * hold the decompressed reply */
+      _mongoc_cluster_reset_buffer (&cluster->compression_buffer);
+      if (cluster->compression_buffer.datalen < len) {
+         cluster->compression_buffer.data =
+            (uint8_t *) cluster->compression_buffer.realloc_func (
+               cluster->compression_buffer.data,
+               len,
+               cluster->compression_buffer.realloc_data);
+         cluster->compression_buffer.datalen = len;
       }
 
-      BSON_ASSERT (buffer.len == 4);
-      memcpy (&msg_len, buffer.data, 4);
-      msg_len = BSON_UINT32_FROM_LE (msg_len);
-      if ((msg_len < 16) || (msg_len > server_stream->sd->max_msg_size)) {
-         RUN_CMD_ERR (
-            MONGOC_ERROR_PROTOCOL,
-            MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
-            "Message size %d is not within expected range 16-%d bytes",
-            msg_len,
-            server_stream->sd->max_msg_size);
-         mongoc_cluster_disconnect_node (
-            cluster, server_stream->sd->id, true, error);
-         bson_free (output);
+      if (!_mongoc_rpc_decompress (
+             &rpc, cluster->compression_buffer.data, len)) {
+         RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Could not decompress message from server");
+         _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
          network_error_reply (reply, cmd);
-         _mongoc_buffer_destroy (&buffer);
          return false;
       }
+   }
+   _mongoc_rpc_swab_from_le (&rpc);
 
-      ok = _mongoc_buffer_append_from_stream (&buffer,
-                                              server_stream->stream,
-                                              (size_t) msg_len - 4,
-                                              cluster->sockettimeoutms,
-                                              error);
-      if (!ok) {
-         RUN_CMD_ERR_DECORATE;
-         mongoc_cluster_disconnect_node (
-            cluster, server_stream->sd->id, true, error);
-         bson_free (output);
-         network_error_reply (reply, cmd);
-         _mongoc_buffer_destroy (&buffer);
-         return false;
+   if (rpc.header.opcode != MONGOC_OPCODE_MSG) {
+      RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+                   MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                   "Expected an OP_MSG reply, got opcode %d",
+                   rpc.header.opcode);
+      _mongoc_cluster_disconnect_stream (cluster, server_stream, error);
+      network_error_reply (reply, cmd);
+      return false;
+   }
+
+   *response_to = (uint32_t) rpc.header.response_to;
+   *flags = rpc.msg.flags;
+   memcpy (&msg_len, rpc.msg.sections[0].payload.bson_document, 4);
+   msg_len = BSON_UINT32_FROM_LE (msg_len);
+   bson_init_static (
+      reply_local, rpc.msg.sections[0].payload.bson_document, msg_len);
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_handle_opmsg_reply --
+ *
+ *       Apply a server reply to the topology and @cmd's session, check it
+ *       for a command error, and copy (or borrow) it into @reply.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_handle_opmsg_reply (mongoc_cluster_t *cluster,
+                                    mongoc_cmd_t *cmd,
+                                    const bson_t *reply_local,
+                                    bson_t *reply,
+                                    bson_error_t *error)
+{
+   bool ok;
+
+   _mongoc_topology_update_cluster_time (cluster->client->topology,
+                                         reply_local);
+   ok = _mongoc_cmd_check_ok (
+      reply_local, cluster->client->error_api_version, error);
+
+   if (cmd->session) {
+      _mongoc_client_session_handle_reply (
+         cmd->session, cmd->is_acknowledged, reply_local);
+   }
+
+   if (reply && cmd->borrow_reply) {
+      /* valid until the next command on this cluster */
+      bson_init_static (reply, bson_get_data (reply_local), reply_local->len);
+   } else if (reply) {
+      bson_copy_to (reply_local, reply);
+   }
+
+   return ok;
+}
+
+
+static bool
+mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
+                          mongoc_cmd_t *cmd,
+                          bson_t *reply,
+                          bson_error_t *error)
+{
+   bson_t reply_local; /* only statically initialized */
+   uint32_t request_id;
+   uint32_t response_to;
+   uint32_t flags;
+
+   if (!cmd->command_name) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Empty command document");
+      _mongoc_bson_init_if_set (reply);
+      return false;
+   }
+   if (cluster->client->in_exhaust) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CLIENT,
+                      MONGOC_ERROR_CLIENT_IN_EXHAUST,
+                      "A cursor derived from this client is in exhaust.");
+      _mongoc_bson_init_if_set (reply);
+      return false;
+   }
+
+   request_id = ++cluster->request_id;
+   if (!_mongoc_cluster_send_opmsg (cluster, cmd, request_id, reply, error)) {
+      return false;
+   }
+
+   /* If acknowledged, wait for a server response. Otherwise, exit early */
+   if (!cmd->is_acknowledged) {
+      _mongoc_bson_init_if_set (reply);
+      return true;
+   }
+
+   if (!_mongoc_cluster_recv_opmsg (
+          cluster, cmd, &response_to, &flags, &reply_local, reply, error)) {
+      return false;
+   }
+
+   /* the server only streams further replies if we allowed it */
+   cmd->more_to_come =
+      cmd->exhaust_allowed && (flags & MONGOC_MSG_MORE_TO_COME);
+
+   return _mongoc_cluster_handle_opmsg_reply (
+      cluster, cmd, &reply_local, reply, error);
+}
+
+
+/* true if @cmd is a read we may also send to a second server, should the
+ * first be slow to answer */
+static bool
+_mongoc_cluster_should_hedge (mongoc_cluster_t *cluster,
+                              const mongoc_cmd_t *cmd)
+{
+   const mongoc_server_stream_t *server_stream = cmd->server_stream;
+
+   return _mongoc_read_prefs_hedges (cmd->hedge_read_prefs) &&
+          (mongoc_read_prefs_get_mode (cmd->hedge_read_prefs) &
+           MONGOC_READ_SECONDARY) &&
+          server_stream->topology_type != MONGOC_TOPOLOGY_SINGLE &&
+          server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG &&
+          cmd->command_name && cmd->is_acknowledged &&
+          !cmd->exhaust_allowed && !cluster->client->in_exhaust &&
+          !_mongoc_client_session_in_txn (cmd->session);
+}
+
+
+/* how long to wait for @cmd's server before hedging: the read preference's
+ * percentile of the server's recent latency, or its fixed delay until the
+ * server has enough samples. -1 if neither applies. */
+static int64_t
+_mongoc_cluster_hedge_delay_usec (const mongoc_cmd_t *cmd)
+{
+   const mongoc_read_prefs_t *prefs = cmd->hedge_read_prefs;
+   double percentile = mongoc_read_prefs_get_hedge_percentile (prefs);
+   int32_t delay_ms = mongoc_read_prefs_get_hedge_delay_ms (prefs);
+   int64_t delay_usec = -1;
+
+   if (percentile > 0) {
+      delay_usec = _mongoc_server_description_latency_percentile (
+         cmd->server_stream->sd, percentile);
+   }
+
+   if (delay_usec < 0 && delay_ms > 0) {
+      delay_usec = (int64_t) delay_ms * 1000;
+   }
+
+   return delay_usec;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_run_opmsg_hedged --
+ *
+ *       Like mongoc_cluster_run_opmsg, for a read whose read preference
+ *       enables hedging. If @cmd's server has not answered after the hedge
+ *       delay, send the same command to the least loaded other suitable
+ *       server and take whichever reply arrives first. The connection
+ *       that lost stays open: the next command sent on it first reads
+ *       and discards the late reply and kills any cursor it opened.
+ *
+ *       A single-threaded client only hedges to servers it is already
+ *       connected to: connecting would scan, and the scan would reuse the
+ *       connection the read is pending on. For the same reason its
+ *       scanner closes a connection that still owes a reply, rather than
+ *       checking the server on it.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set. If the
+ *       second server answered, @cmd->hedge_server_id is set to its id.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_run_opmsg_hedged (mongoc_cluster_t *cluster,
+                                  mongoc_cmd_t *cmd,
+                                  bson_t *reply,
+                                  bson_error_t *error)
+{
+   mongoc_topology_t *topology = cluster->client->topology;
+   mongoc_topology_scanner_node_t *scanner_node;
+   mongoc_server_stream_t *hedge_stream = NULL;
+   mongoc_cmd_t hedge_cmd;
+   mongoc_cmd_t *winner = cmd;
+   mongoc_cmd_t *loser = NULL;
+   mongoc_stream_poll_t poller[2];
+   bson_t reply_local; /* only statically initialized */
+   bson_error_t hedge_error;
+   uint32_t response_to;
+   uint32_t flags;
+   uint32_t hedge_id;
+   uint32_t request_id;
+   uint32_t hedge_request_id;
+   uint32_t loser_request_id;
+   mongoc_orphan_reply_t *orphan;
+   int32_t timeout_ms;
+   int64_t delay_usec;
+   int64_t hedge_started = 0;
+   bool ret;
+
+   delay_usec = _mongoc_cluster_hedge_delay_usec (cmd);
+   if (delay_usec < 0) {
+      return mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
+   }
+
+   request_id = ++cluster->request_id;
+   if (!_mongoc_cluster_send_opmsg (cluster, cmd, request_id, reply, error)) {
+      return false;
+   }
+
+   poller[0].stream = cmd->server_stream->stream;
+   poller[0].events = POLLIN;
+   poller[0].revents = 0;
+
+   /* on a poll error, just wait for the first server as usual */
+   if (mongoc_stream_poll (
+          poller, 1, (int32_t) BSON_MAX (delay_usec / 1000, 1)) != 0) {
+      goto recv;
+   }
+
+   hedge_id = _mongoc_topology_select_hedge (
+      topology, cmd->hedge_read_prefs, cmd->server_stream->sd->id);
+
+   if (hedge_id && topology->single_threaded) {
+      scanner_node =
+         mongoc_topology_scanner_get_node (topology->scanner, hedge_id);
+      if (!scanner_node || !scanner_node->stream) {
+         hedge_id = 0;
       }
+   }
 
-      ok = _mongoc_rpc_scatter (&rpc, buffer.data, buffer.len);
-      if (!ok) {
-         RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+   if (!hedge_id) {
+      goto recv;
+   }
+
+   hedge_stream = mongoc_cluster_stream_for_server (
+      cluster, hedge_id, true, cmd->session, NULL, &hedge_error);
+   /* either connection must be able to hold the reply that loses */
+   if (!hedge_stream ||
+       hedge_stream->sd->max_wire_version < WIRE_VERSION_OP_MSG ||
+       !_mongoc_cluster_orphan_slot (cluster, cmd->server_stream) ||
+       !_mongoc_cluster_orphan_slot (cluster, hedge_stream)) {
+      goto recv;
+   }
+
+   /* the same document, including $readPreference, suits either server */
+   hedge_cmd = *cmd;
+   hedge_cmd.server_stream = hedge_stream;
+   hedge_request_id = ++cluster->request_id;
+   if (!_mongoc_cluster_send_opmsg (
+          cluster, &hedge_cmd, hedge_request_id, NULL, &hedge_error)) {
+      goto recv;
+   }
+
+   mongoc_counter_hedged_reads_inc ();
+   _mongoc_server_description_op_started (hedge_stream->sd);
+   hedge_started = bson_get_monotonic_time ();
+   loser = &hedge_cmd;
+   loser_request_id = hedge_request_id;
+
+   poller[1].stream = hedge_stream->stream;
+   poller[1].events = POLLIN;
+   poller[1].revents = 0;
+   poller[0].revents = 0;
+
+   /* a socketTimeoutMS of 0 means no timeout, not an immediate one */
+   timeout_ms = _mongoc_cluster_socket_timeout_ms (cluster, cmd->deadline);
+   if (mongoc_stream_poll (poller, 2, timeout_ms ? timeout_ms : -1) > 0 &&
+       !poller[0].revents && (poller[1].revents & POLLIN)) {
+      winner = &hedge_cmd;
+      loser = cmd;
+      loser_request_id = request_id;
+      cmd->hedge_server_id = hedge_id;
+      mongoc_counter_hedged_reads_won_inc ();
+   }
+
+   /* keep the loser's connection, and its server stream valid for the
+    * caller. _mongoc_cluster_drain_orphan reads the late reply later, with
+    * the read's lsid in case it must kill a cursor */
+   orphan = _mongoc_cluster_orphan_slot (cluster, loser->server_stream);
+   BSON_ASSERT (orphan && !orphan->request_id);
+   orphan->request_id = loser_request_id;
+   if (cmd->session) {
+      orphan->lsid = bson_copy (mongoc_client_session_get_lsid (cmd->session));
+   }
+   orphan->db_name = bson_strdup (cmd->db_name);
+   orphan->command_name = bson_strdup (cmd->command_name);
+
+recv:
+   if (_mongoc_cluster_recv_opmsg (
+          cluster, winner, &response_to, &flags, &reply_local, reply, error)) {
+      ret = _mongoc_cluster_handle_opmsg_reply (
+         cluster, winner, &reply_local, reply, error);
+   } else {
+      ret = false;
+   }
+
+   if (hedge_started) {
+      _mongoc_server_description_op_finished (
+         hedge_stream->sd, bson_get_monotonic_time () - hedge_started);
+   }
+
+   mongoc_server_stream_cleanup (hedge_stream);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_run_opmsg_exhaust_next --
+ *
+ *       Read the next reply the server streams back for @cmd, an OP_MSG
+ *       sent with exhaustAllowed whose last reply set moreToCome. Nothing
+ *       is sent to the server. @cmd->more_to_come is updated from the
+ *       new reply.
+ *
+ *       APM callbacks are not executed: there is no request to pair the
+ *       reply with.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       @reply is set and should ALWAYS be released with bson_destroy().
+ *       A network error disconnects the node.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_run_opmsg_exhaust_next (mongoc_cluster_t *cluster,
+                                       mongoc_cmd_t *cmd,
+                                       bson_t *reply,
+                                       bson_error_t *error)
+{
+   bson_t reply_local; /* only statically initialized */
+   uint32_t response_to;
+   uint32_t flags;
+   bool ret;
+
+   BSON_ASSERT (cmd->more_to_come);
+
+   cmd->more_to_come = false;
+
+   if (!_mongoc_cluster_recv_opmsg (
+          cluster, cmd, &response_to, &flags, &reply_local, reply, error)) {
+      return false;
+   }
+
+   cmd->more_to_come = !!(flags & MONGOC_MSG_MORE_TO_COME);
+   ret = _mongoc_cluster_handle_opmsg_reply (
+      cluster, cmd, &reply_local, reply, error);
+
+   handle_not_master_error (cluster, cmd->server_stream->sd->id, reply);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_send_opmsg_deferred --
+ *
+ *       Write @cmd as an OP_MSG without waiting for its reply, which is
+ *       read later with mongoc_cluster_recv_opmsg_deferred. More commands
+ *       may be sent on the same connection meanwhile; the server answers
+ *       them in order.
+ *
+ *       The APM started callback is executed now, the succeeded or failed
+ *       callback once the reply is read.
+ *
+ * Returns:
+ *       true if successful and @request_id is set; otherwise false,
+ *       @error is set and the failed callback has been executed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_send_opmsg_deferred (mongoc_cluster_t *cluster,
+                                    mongoc_cmd_t *cmd,
+                                    uint32_t *request_id,
+                                    bson_error_t *error)
+{
+   int64_t started = bson_get_monotonic_time ();
+   bson_t reply;
+
+   BSON_ASSERT (cmd->command_name);
+   BSON_ASSERT (cmd->is_acknowledged);
+
+   *request_id = ++cluster->request_id;
+   _mongoc_cluster_monitor_started (cluster, cmd, *request_id);
+
+   if (!_mongoc_cluster_send_opmsg (cluster, cmd, *request_id, &reply, error)) {
+      _mongoc_cluster_monitor_finished (
+         cluster, cmd, *request_id, started, false, &reply, error);
+      bson_destroy (&reply);
+      return false;
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_recv_opmsg_deferred --
+ *
+ *       Read the reply to the command sent with request id @request_id
+ *       at monotonic time @started by mongoc_cluster_send_opmsg_deferred.
+ *       It must be the next reply on @cmd's connection. Nothing is sent;
+ *       @cmd describes the command for APM and error reporting.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       @reply is set and should ALWAYS be released with bson_destroy().
+ *       A network error disconnects the node, or only marks the server
+ *       Unknown if @cmd's connection is not a node's.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_recv_opmsg_deferred (mongoc_cluster_t *cluster,
+                                    mongoc_cmd_t *cmd,
+                                    uint32_t request_id,
+                                    int64_t started,
+                                    bson_t *reply,
+                                    bson_error_t *error)
+{
+   bson_t reply_local; /* only statically initialized */
+   uint32_t response_to;
+   uint32_t flags;
+   bool ret;
+
+   BSON_ASSERT (reply);
+
+   if (!_mongoc_cluster_recv_opmsg (
+          cluster, cmd, &response_to, &flags, &reply_local, reply, error)) {
+      ret = false;
+   } else if (response_to != request_id) {
+      bson_set_error (error,
+                      MONGOC_ERROR_PROTOCOL,
                       MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
-                      "Malformed message from server");
-         bson_free (output);
-         network_error_reply (reply, cmd);
-         _mongoc_buffer_destroy (&buffer);
+                      "Expected a reply to request %u, got one to %u",
+                      request_id,
+                      response_to);
+      _mongoc_cluster_disconnect_stream (cluster, cmd->server_stream, error);
+      network_error_reply (reply, cmd);
+      ret = false;
+   } else {
+      ret = _mongoc_cluster_handle_opmsg_reply (
+         cluster, cmd, &reply_local, reply, error);
+      handle_not_master_error (cluster, cmd->server_stream->sd->id, reply);
+   }
+
+   _mongoc_cluster_monitor_finished (
+      cluster, cmd, request_id, started, ret, reply, ret ? NULL : error);
+
+   return ret;
+}
+
+
+/* the commands of one mongoc_cluster_run_opmsg_pipeline call */
+typedef struct _mongoc_cluster_pipeline_t {
+   mongoc_cluster_t *cluster;
+   mongoc_cmd_t **cmds;
+   size_t n_cmds;
+   bson_t *replies;
+   uint32_t *request_ids;
+   size_t *sizes;
+   /* commands written whose replies are not read yet */
+   bool *pending;
+   size_t n_pending;
+   size_t bytes_pending;
+   int64_t started;
+   bool ret;
+   bson_error_t *error;
+} mongoc_cluster_pipeline_t;
+
+
+/* report that command @i failed with @cmd_error, which is also returned
+ * from the pipeline if it is the first failure */
+static void
+_mongoc_cluster_pipeline_fail (mongoc_cluster_pipeline_t *pipeline,
+                               size_t i,
+                               const bson_error_t *cmd_error)
+{
+   _mongoc_cluster_monitor_finished (pipeline->cluster,
+                                     pipeline->cmds[i],
+                                     pipeline->request_ids[i],
+                                     pipeline->started,
+                                     false,
+                                     &pipeline->replies[i],
+                                     cmd_error);
+
+   if (pipeline->ret) {
+      pipeline->ret = false;
+      if (pipeline->error) {
+         memcpy (pipeline->error, cmd_error, sizeof (bson_error_t));
+      }
+   }
+}
+
+
+/* read the next reply, in whatever order the server sends them, and hand
+ * it to its command. returns false and sets @cmd_error if the connection
+ * failed */
+static bool
+_mongoc_cluster_pipeline_recv (mongoc_cluster_pipeline_t *pipeline,
+                               bson_error_t *cmd_error)
+{
+   mongoc_cluster_t *cluster = pipeline->cluster;
+   mongoc_cmd_t **cmds = pipeline->cmds;
+   uint32_t server_id = cmds[0]->server_stream->sd->id;
+   bson_t reply_local; /* only statically initialized */
+   uint32_t response_to;
+   uint32_t flags;
+   size_t found;
+   size_t i;
+
+   BSON_ASSERT (pipeline->n_pending);
+
+   for (i = 0; i < pipeline->n_cmds; i++) {
+      if (pipeline->pending[i]) {
+         break;
+      }
+   }
+
+   /* failures are reported against the oldest outstanding command */
+   if (!_mongoc_cluster_recv_opmsg (cluster,
+                                    cmds[i],
+                                    &response_to,
+                                    &flags,
+                                    &reply_local,
+                                    &pipeline->replies[i],
+                                    cmd_error)) {
+      pipeline->pending[i] = false;
+      pipeline->n_pending--;
+      _mongoc_cluster_pipeline_fail (pipeline, i, cmd_error);
+      return false;
+   }
+
+   for (found = 0; found < pipeline->n_cmds; found++) {
+      if (pipeline->pending[found] &&
+          pipeline->request_ids[found] == response_to) {
+         break;
+      }
+   }
+
+   if (found == pipeline->n_cmds) {
+      bson_set_error (cmd_error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Received reply to unknown request %u",
+                      response_to);
+      mongoc_cluster_disconnect_node (cluster, server_id, true, cmd_error);
+      return false;
+   }
+
+   pipeline->pending[found] = false;
+   pipeline->n_pending--;
+   pipeline->bytes_pending -= pipeline->sizes[found];
+
+   if (_mongoc_cluster_handle_opmsg_reply (cluster,
+                                           cmds[found],
+                                           &reply_local,
+                                           &pipeline->replies[found],
+                                           cmd_error)) {
+      _mongoc_cluster_monitor_finished (cluster,
+                                        cmds[found],
+                                        pipeline->request_ids[found],
+                                        pipeline->started,
+                                        true,
+                                        &pipeline->replies[found],
+                                        NULL);
+   } else {
+      _mongoc_cluster_pipeline_fail (pipeline, found, cmd_error);
+   }
+
+   handle_not_master_error (cluster, server_id, &pipeline->replies[found]);
+
+   return true;
+}
+
+
+/* before writing a command of @size bytes, read the replies that have
+ * arrived, and any more needed to stay within the limits on what is in
+ * flight. returns false and sets @cmd_error if the connection failed */
+static bool
+_mongoc_cluster_pipeline_make_room (mongoc_cluster_pipeline_t *pipeline,
+                                    size_t size,
+                                    bson_error_t *cmd_error)
+{
+   mongoc_stream_poll_t poller;
+
+   while (pipeline->n_pending) {
+      if (pipeline->n_pending < MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS &&
+          pipeline->bytes_pending + size <=
+             MONGOC_CLUSTER_PIPELINE_MAX_BYTES) {
+         poller.stream = pipeline->cmds[0]->server_stream->stream;
+         poller.events = POLLIN;
+         poller.revents = 0;
+
+         /* nothing to read yet, keep writing */
+         if (mongoc_stream_poll (&poller, 1, 0) <= 0 ||
+             !(poller.revents & POLLIN)) {
+            return true;
+         }
+      }
+
+      if (!_mongoc_cluster_pipeline_recv (pipeline, cmd_error)) {
          return false;
       }
-      if (BSON_UINT32_FROM_LE (rpc.header.opcode) == MONGOC_OPCODE_COMPRESSED) {
-         size_t len = BSON_UINT32_FROM_LE (rpc.compressed.uncompressed_size) +
-                      sizeof (mongoc_rpc_header_t);
+   }
 
-         output = bson_realloc (output, len);
-         if (!_mongoc_rpc_decompress (&rpc, (uint8_t *) output, len)) {
-            RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
-                         MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
-                         "Could not decompress message from server");
-            mongoc_cluster_disconnect_node (
-               cluster, server_stream->sd->id, true, error);
-            bson_free (output);
-            network_error_reply (reply, cmd);
-            _mongoc_buffer_destroy (&buffer);
-            return false;
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_run_opmsg_pipeline --
+ *
+ *       Run @n_cmds commands on one connection without waiting for each
+ *       reply before sending the next. Replies are read as they arrive,
+ *       between writes, and matched to commands by their responseTo. At
+ *       most MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS commands and
+ *       MONGOC_CLUSTER_PIPELINE_MAX_BYTES bytes are written ahead of the
+ *       replies; beyond that the next command waits for replies. All
+ *       commands must share the same server stream. If the server does
+ *       not support OP_MSG, the commands run one at a time.
+ *
+ *       APM callbacks are executed for each command.
+ *
+ * Returns:
+ *       true if every command succeeded. Otherwise false, and @error is
+ *       set from the first command that failed.
+ *
+ * Side effects:
+ *       Each of the @n_cmds documents in @replies is initialized and
+ *       should ALWAYS be released with bson_destroy(). A network error
+ *       disconnects the node and fails every command whose reply was
+ *       not yet read.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_run_opmsg_pipeline (mongoc_cluster_t *cluster,
+                                   mongoc_cmd_t **cmds,
+                                   size_t n_cmds,
+                                   bson_t *replies,
+                                   bson_error_t *error)
+{
+   const mongoc_server_stream_t *server_stream;
+   mongoc_cluster_pipeline_t pipeline;
+   size_t n_sent;
+   bson_error_t cmd_error;
+   bool network_failed = false;
+   bool ret = true;
+   size_t i;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (cmds || !n_cmds);
+   BSON_ASSERT (replies || !n_cmds);
+
+   if (!n_cmds) {
+      return true;
+   }
+
+   server_stream = cmds[0]->server_stream;
+   for (i = 1; i < n_cmds; i++) {
+      BSON_ASSERT (cmds[i]->server_stream == server_stream);
+   }
+
+   if (server_stream->sd->max_wire_version < WIRE_VERSION_OP_MSG ||
+       cluster->client->in_exhaust) {
+      for (i = 0; i < n_cmds; i++) {
+         if (!mongoc_cluster_run_command_monitored (
+                cluster, cmds[i], &replies[i], &cmd_error) &&
+             ret) {
+            ret = false;
+            if (error) {
+               memcpy (error, &cmd_error, sizeof (bson_error_t));
+            }
          }
       }
-      _mongoc_rpc_swab_from_le (&rpc);
 
-      memcpy (&msg_len, rpc.msg.sections[0].payload.bson_document, 4);
-      msg_len = BSON_UINT32_FROM_LE (msg_len);
-      bson_init_static (
-         &reply_local, rpc.msg.sections[0].payload.bson_document, msg_len);
+      return ret;
+   }
 
-      _mongoc_topology_update_cluster_time (cluster->client->topology,
-                                            &reply_local);
-      ok = _mongoc_cmd_check_ok (
-         &reply_local, cluster->client->error_api_version, error);
+   memset (&pipeline, 0, sizeof pipeline);
+   pipeline.cluster = cluster;
+   pipeline.cmds = cmds;
+   pipeline.n_cmds = n_cmds;
+   pipeline.replies = replies;
+   pipeline.request_ids = bson_malloc0 (n_cmds * sizeof (uint32_t));
+   pipeline.sizes = bson_malloc0 (n_cmds * sizeof (size_t));
+   pipeline.pending = bson_malloc0 (n_cmds * sizeof (bool));
+   pipeline.started = bson_get_monotonic_time ();
+   pipeline.ret = true;
+   pipeline.error = error;
+
+   for (n_sent = 0; n_sent < n_cmds; n_sent++) {
+      mongoc_cmd_t *cmd = cmds[n_sent];
+      size_t size = cmd->command ? cmd->command->len : 0;
+
+      size += (size_t) BSON_MAX (cmd->payload_size, 0);
+      if (!_mongoc_cluster_pipeline_make_room (&pipeline, size, &cmd_error)) {
+         network_failed = true;
+         break;
+      }
 
-      if (cmd->session) {
-         _mongoc_client_session_handle_reply (
-            cmd->session, cmd->is_acknowledged, &reply_local);
+      pipeline.request_ids[n_sent] = ++cluster->request_id;
+      _mongoc_cluster_monitor_started (
+         cluster, cmd, pipeline.request_ids[n_sent]);
+
+      if (!cmd->command_name) {
+         bson_set_error (&cmd_error,
+                         MONGOC_ERROR_COMMAND,
+                         MONGOC_ERROR_COMMAND_INVALID_ARG,
+                         "Empty command document");
+         bson_init (&replies[n_sent]);
+         _mongoc_cluster_pipeline_fail (&pipeline, n_sent, &cmd_error);
+         continue;
       }
 
-      if (reply) {
-         bson_copy_to (&reply_local, reply);
+      if (!_mongoc_cluster_send_opmsg (cluster,
+                                       cmd,
+                                       pipeline.request_ids[n_sent],
+                                       &replies[n_sent],
+                                       &cmd_error)) {
+         _mongoc_cluster_pipeline_fail (&pipeline, n_sent, &cmd_error);
+         if (cmd_error.domain == MONGOC_ERROR_STREAM) {
+            network_failed = true;
+            n_sent++;
+            break;
+         }
+
+         continue;
+      }
+
+      if (cmd->is_acknowledged) {
+         pipeline.pending[n_sent] = true;
+         pipeline.n_pending++;
+         pipeline.sizes[n_sent] = size;
+         pipeline.bytes_pending += size;
+      } else {
+         bson_init (&replies[n_sent]);
+         _mongoc_cluster_monitor_finished (cluster,
+                                           cmd,
+                                           pipeline.request_ids[n_sent],
+                                           pipeline.started,
+                                           true,
+                                           &replies[n_sent],
+                                           NULL);
       }
-   } else {
-      _mongoc_bson_init_if_set (reply);
    }
 
-   _mongoc_buffer_destroy (&buffer);
-   bson_free (output);
+   while (pipeline.n_pending && !network_failed) {
+      network_failed = !_mongoc_cluster_pipeline_recv (&pipeline, &cmd_error);
+   }
 
-   return ok;
+   /* the connection is gone: fail everything that was not answered */
+   for (i = 0; i < n_cmds; i++) {
+      if (i >= n_sent) {
+         pipeline.request_ids[i] = ++cluster->request_id;
+         _mongoc_cluster_monitor_started (
+            cluster, cmds[i], pipeline.request_ids[i]);
+      } else if (!pipeline.pending[i]) {
+         continue;
+      }
+
+      network_error_reply (&replies[i], cmds[i]);
+      _mongoc_cluster_pipeline_fail (&pipeline, i, &cmd_error);
+   }
+
+   _mongoc_topology_update_last_used (cluster->client->topology,
+                                      server_stream->sd->id);
+
+   bson_free (pipeline.request_ids);
+   bson_free (pipeline.sizes);
+   bson_free (pipeline.pending);
+
+   return pipeline.ret;
 }
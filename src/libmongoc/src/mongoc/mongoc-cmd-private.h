@@ -50,6 +50,10 @@ typedef struct _mongoc_cmd_t {
    const bson_t *command;
    const char *command_name;
    const uint8_t *payload;
+   /* if set instead of payload, the documents are sent from these buffers
+    * without being copied into one */
+   const mongoc_iovec_t *payload_iov;
+   size_t payload_iovcnt;
    int32_t payload_size;
    const char *payload_identifier;
    const mongoc_server_stream_t *server_stream;
@@ -57,6 +61,16 @@ typedef struct _mongoc_cmd_t {
    mongoc_client_session_t *session;
    bool is_acknowledged;
    bool is_txn_finish;
+   bool borrow_reply;
+   bool exhaust_allowed;
+   bool more_to_come; /* set if the server will stream more replies */
+   /* a read that may be hedged to a second server, see mongoc-cluster.c */
+   const mongoc_read_prefs_t *hedge_read_prefs;
+   /* set to the second server's id if a hedged read was answered by it */
+   uint32_t hedge_server_id;
+   /* the monotonic time in microseconds the operation must finish by, or 0;
+    * see _mongoc_cluster_begin_operation */
+   int64_t deadline;
 } mongoc_cmd_t;
 
 
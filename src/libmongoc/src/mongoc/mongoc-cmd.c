@@ -52,9 +52,17 @@ mongoc_cmd_parts_init (mongoc_cmd_parts_t *parts,
    parts->assembled.query_flags = MONGOC_QUERY_NONE;
    parts->assembled.payload_identifier = NULL;
    parts->assembled.payload = NULL;
+   parts->assembled.payload_iov = NULL;
+   parts->assembled.payload_iovcnt = 0;
    parts->assembled.session = NULL;
    parts->assembled.is_acknowledged = true;
    parts->assembled.is_txn_finish = false;
+   parts->assembled.borrow_reply = false;
+   parts->assembled.exhaust_allowed = false;
+   parts->assembled.more_to_come = false;
+   parts->assembled.hedge_read_prefs = NULL;
+   parts->assembled.hedge_server_id = 0;
+   parts->assembled.deadline = 0;
 }
 
 
@@ -179,7 +187,8 @@ mongoc_cmd_parts_append_opts (mongoc_cmd_parts_t *parts,
          parts->assembled.session = cs;
          continue;
       } else if (BSON_ITER_IS_KEY (iter, "serverId") ||
-                 BSON_ITER_IS_KEY (iter, "maxAwaitTimeMS")) {
+                 BSON_ITER_IS_KEY (iter, "maxAwaitTimeMS") ||
+                 BSON_ITER_IS_KEY (iter, "exhaust")) {
          continue;
       }
 
@@ -717,6 +726,35 @@ _is_retryable_write (const mongoc_cmd_parts_t *parts,
 }
 
 
+/* if the operation has a deadline, send maxTimeMS so the server gives up
+ * when the client would, less the round trip. the user's maxTimeMS, if any,
+ * is kept. only for commands that read or write data, not for handshakes,
+ * authentication, and the like. */
+static void
+_mongoc_cmd_parts_add_max_time_ms (mongoc_cmd_parts_t *parts,
+                                   const mongoc_server_stream_t *server_stream)
+{
+   int64_t max_time_ms;
+
+   if (!parts->assembled.deadline ||
+       !(parts->is_read_command || parts->is_write_command) ||
+       bson_has_field (parts->body, "maxTimeMS") ||
+       bson_has_field (&parts->extra, "maxTimeMS")) {
+      return;
+   }
+
+   max_time_ms =
+      (parts->assembled.deadline - bson_get_monotonic_time ()) / 1000;
+   if (server_stream->sd->round_trip_time_msec > 0) {
+      max_time_ms -= server_stream->sd->round_trip_time_msec;
+   }
+
+   _mongoc_cmd_parts_ensure_copied (parts);
+   bson_append_int64 (
+      &parts->assembled_body, "maxTimeMS", 9, BSON_MAX (max_time_ms, 1));
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -768,6 +806,7 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts,
    /* unused in OP_MSG: */
    parts->assembled.query_flags = parts->user_query_flags;
    parts->assembled.server_stream = server_stream;
+   parts->assembled.deadline = parts->client->cluster.deadline;
    cmd_name = parts->assembled.command_name =
       _mongoc_get_command_name (parts->assembled.command);
 
@@ -903,6 +942,10 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts,
          _mongoc_cmd_parts_add_write_concern (parts);
       }
 
+      if (!is_get_more) {
+         _mongoc_cmd_parts_add_max_time_ms (parts, server_stream);
+      }
+
       if (!_mongoc_client_session_append_txn (
              cs, &parts->assembled_body, error)) {
          GOTO (done);
@@ -24,6 +24,8 @@
 #include <bson.h>
 
 #include "mongoc-client.h"
+#include "mongoc-opts-private.h"
+#include "mongoc-write-command-private.h"
 
 BSON_BEGIN_DECLS
 
@@ -50,6 +52,13 @@ _mongoc_collection_new (mongoc_client_t *client,
                         const mongoc_read_concern_t *read_concern,
                         const mongoc_write_concern_t *write_concern);
 
+void
+_mongoc_collection_write_command_execute_idl (
+   mongoc_write_command_t *command,
+   const mongoc_collection_t *collection,
+   mongoc_crud_opts_t *crud,
+   mongoc_write_result_t *result);
+
 BSON_END_DECLS
 
 
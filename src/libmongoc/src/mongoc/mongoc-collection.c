@@ -35,6 +35,7 @@
 #include "mongoc-read-prefs-private.h"
 #include "mongoc-util-private.h"
 #include "mongoc-write-command-private.h"
+#include "mongoc-write-coalescer-private.h"
 #include "mongoc-opts-private.h"
 
 #undef MONGOC_LOG_DOMAIN
@@ -76,29 +77,30 @@ _mongoc_collection_write_command_execute (
 }
 
 
-static void
+void
 _mongoc_collection_write_command_execute_idl (
    mongoc_write_command_t *command,
    const mongoc_collection_t *collection,
    mongoc_crud_opts_t *crud,
    mongoc_write_result_t *result)
 {
+   mongoc_cluster_t *cluster = &collection->client->cluster;
    mongoc_server_stream_t *server_stream;
+   int64_t prev_deadline;
    bson_t reply;
 
    ENTRY;
 
-   server_stream =
-      mongoc_cluster_stream_for_writes (&collection->client->cluster,
-                                        crud->client_session,
-                                        &reply,
-                                        &result->error);
+   prev_deadline = _mongoc_cluster_begin_operation (cluster, crud->timeoutMS);
+
+   server_stream = mongoc_cluster_stream_for_writes (
+      cluster, crud->client_session, &reply, &result->error);
 
    if (!server_stream) {
       /* result->error and reply have been filled out */
       _mongoc_bson_array_copy_labels_to (&reply, &result->errorLabels);
       bson_destroy (&reply);
-      EXIT;
+      GOTO (done);
    }
 
    if (_mongoc_client_session_in_txn (crud->client_session) &&
@@ -108,7 +110,7 @@ _mongoc_collection_write_command_execute_idl (
                       MONGOC_ERROR_COMMAND_INVALID_ARG,
                       "Cannot set write concern after starting transaction");
       mongoc_server_stream_cleanup (server_stream);
-      EXIT;
+      GOTO (done);
    }
 
    if (!crud->writeConcern) {
@@ -127,6 +129,9 @@ _mongoc_collection_write_command_execute_idl (
 
    mongoc_server_stream_cleanup (server_stream);
 
+done:
+   _mongoc_cluster_end_operation (cluster, prev_deadline);
+
    EXIT;
 }
 
@@ -1687,6 +1692,8 @@ mongoc_collection_insert_bulk (mongoc_collection_t *collection,
       ++collection->client->cluster.operation_id,
       true);
 
+   /* the insert is executed before returning, don't copy the documents */
+   _mongoc_write_command_borrow_documents (&command);
    for (i = 0; i < n_documents; i++) {
       _mongoc_write_command_insert_append (&command, documents[i]);
    }
@@ -1743,6 +1750,28 @@ mongoc_collection_insert (mongoc_collection_t *collection,
 }
 
 
+/* an insert_one may join other threads' inserts if its client came from a
+ * pool with coalesceWritesMS, and nothing makes its command differ from
+ * theirs: no session, no options, and an acknowledged write concern. a
+ * document over the server's max BSON size is sent alone, since the error
+ * it gets is not one the others should share */
+static bool
+_mongoc_collection_can_coalesce (const mongoc_collection_t *collection,
+                                 const mongoc_insert_one_opts_t *opts,
+                                 const bson_t *document)
+{
+   mongoc_cluster_t *cluster = &collection->client->cluster;
+
+   return collection->client->write_coalescer && !opts->crud.client_session &&
+          !opts->crud.writeConcern && !opts->crud.timeoutMS &&
+          opts->bypass == MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT &&
+          bson_empty (&opts->extra) &&
+          mongoc_write_concern_is_acknowledged (collection->write_concern) &&
+          document->len <=
+             (uint32_t) mongoc_cluster_get_max_bson_obj_size (cluster);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1796,17 +1825,31 @@ mongoc_collection_insert_one (mongoc_collection_t *collection,
       GOTO (done);
    }
 
-   _mongoc_write_result_init (&result);
-   _mongoc_write_command_init_insert_idl (
-      &command,
-      document,
-      &insert_one_opts.extra,
-      ++collection->client->cluster.operation_id,
-      false);
+   if (_mongoc_collection_can_coalesce (
+          collection, &insert_one_opts, document)) {
+      _mongoc_write_coalescer_insert (collection->client->write_coalescer,
+                                      collection,
+                                      document,
+                                      &insert_one_opts.crud,
+                                      &result);
+   } else {
+      _mongoc_write_result_init (&result);
+      _mongoc_write_command_init_insert_idl (
+         &command,
+         NULL,
+         &insert_one_opts.extra,
+         ++collection->client->cluster.operation_id,
+         false);
 
-   command.flags.bypass_document_validation = insert_one_opts.bypass;
-   _mongoc_collection_write_command_execute_idl (
-      &command, collection, &insert_one_opts.crud, &result);
+      _mongoc_write_command_borrow_documents (&command);
+      _mongoc_write_command_insert_append (&command, document);
+
+      command.flags.bypass_document_validation = insert_one_opts.bypass;
+      _mongoc_collection_write_command_execute_idl (
+         &command, collection, &insert_one_opts.crud, &result);
+
+      _mongoc_write_command_destroy (&command);
+   }
 
    ret = MONGOC_WRITE_RESULT_COMPLETE (&result,
                                        collection->client->error_api_version,
@@ -1818,7 +1861,6 @@ mongoc_collection_insert_one (mongoc_collection_t *collection,
                                        "insertedCount");
 
    _mongoc_write_result_destroy (&result);
-   _mongoc_write_command_destroy (&command);
 
 done:
    _mongoc_insert_one_opts_cleanup (&insert_one_opts);
@@ -1887,6 +1929,8 @@ mongoc_collection_insert_many (mongoc_collection_t *collection,
       ++collection->client->cluster.operation_id,
       false);
 
+   _mongoc_write_command_borrow_documents (&command);
+
    command.flags.ordered = insert_many_opts.ordered;
    command.flags.bypass_document_validation = insert_many_opts.bypass;
 
@@ -2034,9 +2078,11 @@ _mongoc_collection_update_or_replace (
    bson_t *reply,
    bson_error_t *error)
 {
+   mongoc_cluster_t *cluster = &collection->client->cluster;
    mongoc_write_command_t command;
    mongoc_write_result_t result;
    mongoc_server_stream_t *server_stream = NULL;
+   int64_t prev_deadline;
    bool reply_initialized = false;
    bool ret = false;
 
@@ -2071,11 +2117,11 @@ _mongoc_collection_update_or_replace (
       command.flags.has_collation = true;
    }
 
-   server_stream =
-      mongoc_cluster_stream_for_writes (&collection->client->cluster,
-                                        update_opts->crud.client_session,
-                                        reply,
-                                        error);
+   prev_deadline =
+      _mongoc_cluster_begin_operation (cluster, update_opts->crud.timeoutMS);
+
+   server_stream = mongoc_cluster_stream_for_writes (
+      cluster, update_opts->crud.client_session, reply, error);
 
    if (!server_stream) {
       /* mongoc_cluster_stream_for_writes inits reply on error */
@@ -2142,6 +2188,7 @@ _mongoc_collection_update_or_replace (
                                        "upsertedId");
 
 done:
+   _mongoc_cluster_end_operation (cluster, prev_deadline);
    _mongoc_write_result_destroy (&result);
    mongoc_server_stream_cleanup (server_stream);
    _mongoc_write_command_destroy (&command);
@@ -3115,6 +3162,8 @@ mongoc_collection_create_bulk_operation_with_opts (
                                       wc);
 
    bulk->session = bulk_opts.client_session;
+   bulk->timeout_ms = bulk_opts.timeoutMS;
+   bulk->pipeline_depth = bulk_opts.pipelineDepth;
    if (err.domain) {
       /* _mongoc_bulk_opts_parse failed, above */
       memcpy (&bulk->result.error, &err, sizeof (bson_error_t));
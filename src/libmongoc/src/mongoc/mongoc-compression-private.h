@@ -23,6 +23,8 @@
 #endif
 #include <bson.h>
 
+#include "mongoc-iovec.h"
+
 
 /* Compressor IDs */
 #define MONGOC_COMPRESSOR_NOOP_ID 0
@@ -34,10 +36,33 @@
 #define MONGOC_COMPRESSOR_ZLIB_ID 2
 #define MONGOC_COMPRESSOR_ZLIB_STR "zlib"
 
+#define MONGOC_COMPRESSOR_ZSTD_ID 3
+#define MONGOC_COMPRESSOR_ZSTD_STR "zstd"
+
+/* Compressed messages per compression policy evaluation */
+#define MONGOC_COMPRESSION_POLICY_WINDOW 16
+
+/* Messages sent uncompressed to a server before compression is re-tried,
+ * once the policy has found it does not pay off */
+#define MONGOC_COMPRESSION_POLICY_BACKOFF 1024
+
 
 BSON_BEGIN_DECLS
 
 
+/* Per-server statistics that decide whether a message is worth compressing.
+ * Owned by the mongoc_cluster_t, so it is only accessed by one thread. */
+typedef struct _mongoc_compression_policy_t {
+   /* current evaluation window */
+   int64_t window_in;
+   int64_t window_out;
+   int32_t window_count;
+
+   /* messages left to send uncompressed */
+   int32_t backoff;
+} mongoc_compression_policy_t;
+
+
 size_t
 mongoc_compressor_max_compressed_length (int32_t compressor_id, size_t size);
 
@@ -65,6 +90,25 @@ mongoc_compress (int32_t compressor_id,
                  char *compressed,
                  size_t *compressed_len);
 
+bool
+mongoc_compress_iovec (int32_t compressor_id,
+                       int32_t compression_level,
+                       const mongoc_iovec_t *iov,
+                       size_t iovcnt,
+                       size_t skip,
+                       char *compressed,
+                       size_t *compressed_len);
+
+bool
+_mongoc_compression_policy_should_compress (
+   mongoc_compression_policy_t *policy, size_t size, int32_t threshold);
+
+void
+_mongoc_compression_policy_record (mongoc_compression_policy_t *policy,
+                                   size_t uncompressed_len,
+                                   size_t compressed_len,
+                                   int32_t min_savings_percent);
+
 BSON_END_DECLS
 
 #endif
@@ -28,6 +28,12 @@
 #ifdef MONGOC_ENABLE_COMPRESSION_SNAPPY
 #include <snappy-c.h>
 #endif
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+#include <zstd.h>
+#ifndef ZSTD_CLEVEL_DEFAULT
+#define ZSTD_CLEVEL_DEFAULT 3
+#endif
+#endif
 #endif
 
 size_t
@@ -49,6 +55,12 @@ mongoc_compressor_max_compressed_length (int32_t compressor_id, size_t len)
       break;
 #endif
 
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   case MONGOC_COMPRESSOR_ZSTD_ID:
+      return ZSTD_compressBound (len);
+      break;
+#endif
+
    case MONGOC_COMPRESSOR_NOOP_ID:
       return len;
       break;
@@ -72,6 +84,12 @@ mongoc_compressor_supported (const char *compressor)
    }
 #endif
 
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   if (!strcasecmp (compressor, MONGOC_COMPRESSOR_ZSTD_STR)) {
+      return true;
+   }
+#endif
+
    if (!strcasecmp (compressor, MONGOC_COMPRESSOR_NOOP_STR)) {
       return true;
    }
@@ -89,6 +107,9 @@ mongoc_compressor_id_to_name (int32_t compressor_id)
    case MONGOC_COMPRESSOR_ZLIB_ID:
       return MONGOC_COMPRESSOR_ZLIB_STR;
 
+   case MONGOC_COMPRESSOR_ZSTD_ID:
+      return MONGOC_COMPRESSOR_ZSTD_STR;
+
    case MONGOC_COMPRESSOR_NOOP_ID:
       return MONGOC_COMPRESSOR_NOOP_STR;
 
@@ -112,6 +133,12 @@ mongoc_compressor_name_to_id (const char *compressor)
    }
 #endif
 
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   if (strcasecmp (MONGOC_COMPRESSOR_ZSTD_STR, compressor) == 0) {
+      return MONGOC_COMPRESSOR_ZSTD_ID;
+   }
+#endif
+
    if (strcasecmp (MONGOC_COMPRESSOR_NOOP_STR, compressor) == 0) {
       return MONGOC_COMPRESSOR_NOOP_ID;
    }
@@ -164,6 +191,27 @@ mongoc_uncompress (int32_t compressor_id,
 #endif
       break;
    }
+
+   case MONGOC_COMPRESSOR_ZSTD_ID: {
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+      size_t ret;
+
+      ret = ZSTD_decompress (
+         uncompressed, *uncompressed_len, compressed, compressed_len);
+
+      if (ZSTD_isError (ret)) {
+         return false;
+      }
+
+      *uncompressed_len = ret;
+      return true;
+#else
+      MONGOC_WARNING ("Received zstd compressed opcode, but zstd "
+                      "compression is not compiled in");
+      return false;
+#endif
+      break;
+   }
    case MONGOC_COMPRESSOR_NOOP_ID:
       memcpy (uncompressed, compressed, compressed_len);
       *uncompressed_len = compressed_len;
@@ -214,6 +262,34 @@ mongoc_compress (int32_t compressor_id,
                     "compression is not compiled in");
       return false;
 #endif
+
+   case MONGOC_COMPRESSOR_ZSTD_ID: {
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+      size_t ret;
+
+      /* -1 selects zstd's own default, like zlib's Z_DEFAULT_COMPRESSION */
+      if (compression_level == -1) {
+         compression_level = ZSTD_CLEVEL_DEFAULT;
+      }
+
+      ret = ZSTD_compress (compressed,
+                           *compressed_len,
+                           uncompressed,
+                           uncompressed_len,
+                           compression_level);
+
+      if (ZSTD_isError (ret)) {
+         return false;
+      }
+
+      *compressed_len = ret;
+      return true;
+#else
+      MONGOC_ERROR ("Client attempting to use compress with zstd, but zstd "
+                    "compression is not compiled in");
+      return false;
+#endif
+   }
    case MONGOC_COMPRESSOR_NOOP_ID:
       memcpy (compressed, uncompressed, uncompressed_len);
       *compressed_len = uncompressed_len;
@@ -223,3 +299,307 @@ mongoc_compress (int32_t compressor_id,
       return false;
    }
 }
+
+
+/* Returns the next non-empty segment of @iov after the first @skip bytes.
+ * @n and @offset carry the position between calls, start both at zero. */
+static bool
+_mongoc_iovec_next_segment (const mongoc_iovec_t *iov,
+                            size_t iovcnt,
+                            size_t skip,
+                            size_t *n,
+                            size_t *offset,
+                            const char **segment,
+                            size_t *segment_len)
+{
+   size_t len;
+
+   for (; *n < iovcnt; (*n)++) {
+      len = iov[*n].iov_len;
+
+      if (*offset + len <= skip) {
+         *offset += len;
+         continue;
+      }
+
+      *segment = (const char *) iov[*n].iov_base;
+      *segment_len = len;
+
+      /* this segment straddles the skip boundary */
+      if (*offset < skip) {
+         *segment += skip - *offset;
+         *segment_len -= skip - *offset;
+      }
+
+      *offset += len;
+      (*n)++;
+      return true;
+   }
+
+   return false;
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_compress_iovec --
+ *
+ *       Compress the bytes of @iov, excluding the first @skip bytes, into
+ *       @compressed without first copying them into one contiguous
+ *       buffer. @compressed_len is the capacity of @compressed on input
+ *       and the compressed size on output; a capacity of at least
+ *       mongoc_compressor_max_compressed_length () is always sufficient.
+ *
+ *       zlib and zstd consume the segments one at a time through their
+ *       streaming APIs. snappy has no streaming C API, so its input is
+ *       still linearized into a temporary buffer.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_compress_iovec (int32_t compressor_id,
+                       int32_t compression_level,
+                       const mongoc_iovec_t *iov,
+                       size_t iovcnt,
+                       size_t skip,
+                       char *compressed,
+                       size_t *compressed_len)
+{
+   const char *segment;
+   size_t segment_len;
+   size_t n = 0;
+   size_t offset = 0;
+
+   TRACE ("Compressing iovec with '%s' (%d)",
+          mongoc_compressor_id_to_name (compressor_id),
+          compressor_id);
+
+   switch (compressor_id) {
+   case MONGOC_COMPRESSOR_SNAPPY_ID: {
+#ifdef MONGOC_ENABLE_COMPRESSION_SNAPPY
+      char *data;
+      size_t size = 0;
+      size_t i;
+      bool ok;
+
+      for (i = 0; i < iovcnt; i++) {
+         size += iov[i].iov_len;
+      }
+
+      BSON_ASSERT (size >= skip);
+      data = bson_malloc (size - skip);
+      size = 0;
+
+      while (_mongoc_iovec_next_segment (
+         iov, iovcnt, skip, &n, &offset, &segment, &segment_len)) {
+         memcpy (data + size, segment, segment_len);
+         size += segment_len;
+      }
+
+      ok = snappy_compress (data, size, compressed, compressed_len) ==
+           SNAPPY_OK;
+      bson_free (data);
+
+      return ok;
+#else
+      MONGOC_ERROR ("Client attempting to use compress with snappy, but snappy "
+                    "compression is not compiled in");
+      return false;
+#endif
+   }
+
+   case MONGOC_COMPRESSOR_ZLIB_ID: {
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+      z_stream strm;
+      int ret;
+
+      memset (&strm, 0, sizeof strm);
+      if (deflateInit (&strm, compression_level) != Z_OK) {
+         return false;
+      }
+
+      strm.next_out = (Bytef *) compressed;
+      strm.avail_out = (uInt) *compressed_len;
+
+      while (_mongoc_iovec_next_segment (
+         iov, iovcnt, skip, &n, &offset, &segment, &segment_len)) {
+         strm.next_in = (Bytef *) segment;
+         strm.avail_in = (uInt) segment_len;
+
+         while (strm.avail_in) {
+            ret = deflate (&strm, Z_NO_FLUSH);
+            if (ret != Z_OK || !strm.avail_out) {
+               deflateEnd (&strm);
+               return false;
+            }
+         }
+      }
+
+      ret = deflate (&strm, Z_FINISH);
+      *compressed_len = strm.total_out;
+      deflateEnd (&strm);
+
+      return ret == Z_STREAM_END;
+#else
+      MONGOC_ERROR ("Client attempting to use compress with zlib, but zlib "
+                    "compression is not compiled in");
+      return false;
+#endif
+   }
+
+   case MONGOC_COMPRESSOR_ZSTD_ID: {
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+      ZSTD_CStream *cstream;
+      ZSTD_inBuffer in;
+      ZSTD_outBuffer out;
+      size_t ret;
+      bool ok = false;
+
+      if (compression_level == -1) {
+         compression_level = ZSTD_CLEVEL_DEFAULT;
+      }
+
+      cstream = ZSTD_createCStream ();
+      if (!cstream ||
+          ZSTD_isError (ZSTD_initCStream (cstream, compression_level))) {
+         goto zstd_done;
+      }
+
+      out.dst = compressed;
+      out.size = *compressed_len;
+      out.pos = 0;
+
+      while (_mongoc_iovec_next_segment (
+         iov, iovcnt, skip, &n, &offset, &segment, &segment_len)) {
+         in.src = segment;
+         in.size = segment_len;
+         in.pos = 0;
+
+         while (in.pos < in.size) {
+            ret = ZSTD_compressStream (cstream, &out, &in);
+            if (ZSTD_isError (ret) || out.pos == out.size) {
+               goto zstd_done;
+            }
+         }
+      }
+
+      /* returns the number of bytes still to flush, zero when done */
+      do {
+         ret = ZSTD_endStream (cstream, &out);
+         if (ZSTD_isError (ret) || (ret && out.pos == out.size)) {
+            goto zstd_done;
+         }
+      } while (ret);
+
+      *compressed_len = out.pos;
+      ok = true;
+
+   zstd_done:
+      ZSTD_freeCStream (cstream);
+      return ok;
+#else
+      MONGOC_ERROR ("Client attempting to use compress with zstd, but zstd "
+                    "compression is not compiled in");
+      return false;
+#endif
+   }
+
+   case MONGOC_COMPRESSOR_NOOP_ID: {
+      size_t written = 0;
+
+      while (_mongoc_iovec_next_segment (
+         iov, iovcnt, skip, &n, &offset, &segment, &segment_len)) {
+         if (written + segment_len > *compressed_len) {
+            return false;
+         }
+
+         memcpy (compressed + written, segment, segment_len);
+         written += segment_len;
+      }
+
+      *compressed_len = written;
+      return true;
+   }
+
+   default:
+      return false;
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_compression_policy_should_compress --
+ *
+ *       Decide whether a message body of @size bytes should be compressed.
+ *       Messages smaller than @threshold are never compressed, and no
+ *       message is compressed while the policy is backing off.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_compression_policy_should_compress (
+   mongoc_compression_policy_t *policy, size_t size, int32_t threshold)
+{
+   if (threshold > 0 && size < (size_t) threshold) {
+      return false;
+   }
+
+   if (policy->backoff > 0) {
+      policy->backoff--;
+      return false;
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_compression_policy_record --
+ *
+ *       Account for one compressed message. Every
+ *       MONGOC_COMPRESSION_POLICY_WINDOW messages, if the bytes saved in
+ *       the window are less than @min_savings_percent of the input, stop
+ *       compressing for the next MONGOC_COMPRESSION_POLICY_BACKOFF
+ *       messages. A @min_savings_percent of zero never backs off.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_compression_policy_record (mongoc_compression_policy_t *policy,
+                                   size_t uncompressed_len,
+                                   size_t compressed_len,
+                                   int32_t min_savings_percent)
+{
+   int64_t saved;
+
+   if (min_savings_percent <= 0) {
+      return;
+   }
+
+   policy->window_in += (int64_t) uncompressed_len;
+   policy->window_out += (int64_t) compressed_len;
+
+   if (++policy->window_count < MONGOC_COMPRESSION_POLICY_WINDOW) {
+      return;
+   }
+
+   saved = policy->window_in - policy->window_out;
+   if (saved * 100 < policy->window_in * min_savings_percent) {
+      TRACE ("Compression saved %" PRId64 " of %" PRId64
+             " bytes, backing off",
+             saved,
+             policy->window_in);
+      policy->backoff = MONGOC_COMPRESSION_POLICY_BACKOFF;
+   }
+
+   policy->window_in = 0;
+   policy->window_out = 0;
+   policy->window_count = 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_CONNECTION_POOL_PRIVATE_H
+#define MONGOC_CONNECTION_POOL_PRIVATE_H
+
+#if !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-set-private.h"
+#include "mongoc-thread-private.h"
+
+BSON_BEGIN_DECLS
+
+struct _mongoc_cluster_node_t;
+struct _mongoc_topology_snapshot_t;
+
+/* Idle, authenticated connections shared by all clients of a
+ * mongoc_client_pool_t with sharedConnectionPool=true. A client checks a
+ * connection out for each operation and returns it when the operation's
+ * server stream is cleaned up, so idle clients hold no sockets. */
+typedef struct _mongoc_connection_pool_t {
+   mongoc_mutex_t mutex;
+   /* server id -> mongoc_array_t of idle nodes, most recently used last */
+   mongoc_set_t *idle;
+   size_t n_idle;
+   /* idle connections kept per server, the client pool's maxPoolSize */
+   uint32_t max_idle;
+   /* idle connections older than this are closed, 0 for no limit */
+   int64_t max_idle_time_usec;
+   /* when the topology snapshot the pool last swept was published */
+   int64_t swept_published;
+} mongoc_connection_pool_t;
+
+mongoc_connection_pool_t *
+_mongoc_connection_pool_new (uint32_t max_idle, int32_t max_idle_time_ms);
+
+void
+_mongoc_connection_pool_set_max_idle (mongoc_connection_pool_t *pool,
+                                      uint32_t max_idle);
+
+void
+_mongoc_connection_pool_destroy (mongoc_connection_pool_t *pool);
+
+struct _mongoc_cluster_node_t *
+_mongoc_connection_pool_checkout (mongoc_connection_pool_t *pool,
+                                  uint32_t server_id);
+
+void
+_mongoc_connection_pool_checkin (
+   mongoc_connection_pool_t *pool,
+   uint32_t server_id,
+   struct _mongoc_cluster_node_t *node,
+   const struct _mongoc_topology_snapshot_t *snapshot);
+
+size_t
+_mongoc_connection_pool_num_idle (mongoc_connection_pool_t *pool);
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_CONNECTION_POOL_PRIVATE_H */
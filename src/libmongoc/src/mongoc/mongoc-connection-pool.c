@@ -0,0 +1,294 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-array-private.h"
+#include "mongoc-cluster-private.h"
+#include "mongoc-connection-pool-private.h"
+
+
+static void
+_mongoc_connection_pool_idle_dtor (void *item, void *ctx)
+{
+   mongoc_array_t *nodes = (mongoc_array_t *) item;
+   size_t i;
+
+   for (i = 0; i < nodes->len; i++) {
+      _mongoc_cluster_node_destroy (
+         _mongoc_array_index (nodes, mongoc_cluster_node_t *, i));
+   }
+
+   _mongoc_array_destroy (nodes);
+   bson_free (nodes);
+}
+
+
+mongoc_connection_pool_t *
+_mongoc_connection_pool_new (uint32_t max_idle, int32_t max_idle_time_ms)
+{
+   mongoc_connection_pool_t *pool;
+
+   pool = (mongoc_connection_pool_t *) bson_malloc0 (sizeof *pool);
+   mongoc_mutex_init (&pool->mutex);
+   pool->idle = mongoc_set_new (8, _mongoc_connection_pool_idle_dtor, NULL);
+   pool->max_idle = BSON_MAX (1, max_idle);
+   pool->max_idle_time_usec = 1000 * (int64_t) BSON_MAX (0, max_idle_time_ms);
+
+   return pool;
+}
+
+
+/* takes effect as connections are checked in */
+void
+_mongoc_connection_pool_set_max_idle (mongoc_connection_pool_t *pool,
+                                      uint32_t max_idle)
+{
+   mongoc_mutex_lock (&pool->mutex);
+   pool->max_idle = BSON_MAX (1, max_idle);
+   mongoc_mutex_unlock (&pool->mutex);
+}
+
+
+void
+_mongoc_connection_pool_destroy (mongoc_connection_pool_t *pool)
+{
+   if (!pool) {
+      return;
+   }
+
+   mongoc_set_destroy (pool->idle);
+   mongoc_mutex_destroy (&pool->mutex);
+   bson_free (pool);
+}
+
+
+/* move the oldest of @nodes out to @expired while there are more than @keep
+ * or they have been idle longer than the pool allows. called locked; the
+ * caller closes the expired nodes once it has unlocked */
+static void
+_mongoc_connection_pool_prune (mongoc_connection_pool_t *pool,
+                               mongoc_array_t *nodes,
+                               size_t keep,
+                               mongoc_array_t *expired)
+{
+   mongoc_cluster_node_t *node;
+   int64_t now;
+   size_t n = 0;
+
+   now = bson_get_monotonic_time ();
+
+   while (n < nodes->len) {
+      node = _mongoc_array_index (nodes, mongoc_cluster_node_t *, n);
+      if (nodes->len - n <= keep && (!pool->max_idle_time_usec ||
+                                     now - node->idle_since <=
+                                        pool->max_idle_time_usec)) {
+         break;
+      }
+
+      _mongoc_array_append_val (expired, node);
+      n++;
+   }
+
+   if (n) {
+      memmove (nodes->data,
+               (mongoc_cluster_node_t **) nodes->data + n,
+               (nodes->len - n) * sizeof (mongoc_cluster_node_t *));
+      nodes->len -= n;
+      pool->n_idle -= n;
+   }
+}
+
+
+/* move the nodes of @nodes that predate the server's latest replacement or
+ * network error, scanner node timestamp @timestamp, out to @expired */
+static void
+_mongoc_connection_pool_prune_stale (mongoc_connection_pool_t *pool,
+                                     mongoc_array_t *nodes,
+                                     int64_t timestamp,
+                                     mongoc_array_t *expired)
+{
+   mongoc_cluster_node_t **items = (mongoc_cluster_node_t **) nodes->data;
+   size_t kept = 0;
+   size_t i;
+
+   for (i = 0; i < nodes->len; i++) {
+      if (items[i]->timestamp < timestamp) {
+         _mongoc_array_append_val (expired, items[i]);
+      } else {
+         items[kept++] = items[i];
+      }
+   }
+
+   pool->n_idle -= nodes->len - kept;
+   nodes->len = kept;
+}
+
+
+/* prune every server's idle connections, closing all those to servers no
+ * longer in @snapshot, and, if @snapshot is newer than the last sweep,
+ * those made before their server was replaced. called locked */
+static void
+_mongoc_connection_pool_sweep (
+   mongoc_connection_pool_t *pool,
+   const mongoc_topology_snapshot_t *snapshot,
+   mongoc_array_t *expired)
+{
+   mongoc_array_t *nodes;
+   uint32_t server_id;
+   int64_t timestamp;
+   bool changed;
+   size_t i;
+
+   changed = snapshot && snapshot->published > pool->swept_published;
+   if (changed) {
+      pool->swept_published = snapshot->published;
+   }
+
+   /* backwards, so removing an item doesn't move those not yet visited */
+   for (i = pool->idle->items_len; i > 0; i--) {
+      nodes = (mongoc_array_t *) mongoc_set_get_item_and_id (
+         pool->idle, (int) i - 1, &server_id);
+
+      timestamp = snapshot ? _mongoc_topology_snapshot_server_timestamp (
+                                snapshot, server_id)
+                           : 0;
+      if (changed && timestamp != -1) {
+         _mongoc_connection_pool_prune_stale (
+            pool, nodes, timestamp, expired);
+      }
+
+      _mongoc_connection_pool_prune (
+         pool, nodes, timestamp == -1 ? 0 : pool->max_idle, expired);
+
+      if (!nodes->len) {
+         mongoc_set_rm (pool->idle, server_id);
+      }
+   }
+}
+
+
+static void
+_mongoc_connection_pool_close (mongoc_array_t *expired)
+{
+   size_t i;
+
+   for (i = 0; i < expired->len; i++) {
+      _mongoc_cluster_node_destroy (
+         _mongoc_array_index (expired, mongoc_cluster_node_t *, i));
+   }
+
+   _mongoc_array_destroy (expired);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_connection_pool_checkout --
+ *
+ *       Take the most recently used idle connection to @server_id,
+ *       closing any that have been idle longer than maxIdleTimeMS. The
+ *       caller checks it is still current before using it.
+ *
+ * Returns:
+ *       A node owned by the caller, or NULL if none is idle.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_cluster_node_t *
+_mongoc_connection_pool_checkout (mongoc_connection_pool_t *pool,
+                                  uint32_t server_id)
+{
+   mongoc_array_t *nodes;
+   mongoc_array_t expired;
+   mongoc_cluster_node_t *node = NULL;
+
+   _mongoc_array_init (&expired, sizeof (mongoc_cluster_node_t *));
+
+   mongoc_mutex_lock (&pool->mutex);
+   nodes = (mongoc_array_t *) mongoc_set_get (pool->idle, server_id);
+   if (nodes) {
+      _mongoc_connection_pool_prune (pool, nodes, pool->max_idle, &expired);
+   }
+
+   if (nodes && nodes->len) {
+      node = _mongoc_array_index (nodes, mongoc_cluster_node_t *, --nodes->len);
+      pool->n_idle--;
+   }
+   mongoc_mutex_unlock (&pool->mutex);
+
+   _mongoc_connection_pool_close (&expired);
+
+   return node;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_connection_pool_checkin --
+ *
+ *       Return @node to the pool, then close idle connections across the
+ *       whole pool: beyond max_idle per server, the least recently used;
+ *       those idle longer than maxIdleTimeMS; and, going by @snapshot, the
+ *       topology's latest, those to servers that left the topology or
+ *       were replaced. @snapshot may be NULL to skip the latter.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_connection_pool_checkin (mongoc_connection_pool_t *pool,
+                                 uint32_t server_id,
+                                 mongoc_cluster_node_t *node,
+                                 const mongoc_topology_snapshot_t *snapshot)
+{
+   mongoc_array_t *nodes;
+   mongoc_array_t expired;
+
+   _mongoc_array_init (&expired, sizeof (mongoc_cluster_node_t *));
+   node->idle_since = bson_get_monotonic_time ();
+
+   mongoc_mutex_lock (&pool->mutex);
+   nodes = (mongoc_array_t *) mongoc_set_get (pool->idle, server_id);
+   if (!nodes) {
+      nodes = (mongoc_array_t *) bson_malloc (sizeof *nodes);
+      _mongoc_array_init (nodes, sizeof (mongoc_cluster_node_t *));
+      mongoc_set_add (pool->idle, server_id, nodes);
+   }
+
+   _mongoc_array_append_val (nodes, node);
+   pool->n_idle++;
+   _mongoc_connection_pool_sweep (pool, snapshot, &expired);
+   mongoc_mutex_unlock (&pool->mutex);
+
+   _mongoc_connection_pool_close (&expired);
+}
+
+
+/* for tests */
+size_t
+_mongoc_connection_pool_num_idle (mongoc_connection_pool_t *pool)
+{
+   size_t n_idle;
+
+   mongoc_mutex_lock (&pool->mutex);
+   n_idle = pool->n_idle;
+   mongoc_mutex_unlock (&pool->mutex);
+
+   return n_idle;
+}
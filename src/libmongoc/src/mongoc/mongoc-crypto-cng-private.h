@@ -64,6 +64,25 @@ mongoc_crypto_cng_sha256 (mongoc_crypto_t *crypto,
                           const size_t input_len,
                           unsigned char *hash_out);
 
+bool
+mongoc_crypto_cng_pbkdf2_sha1 (mongoc_crypto_t *crypto,
+                               const char *password,
+                               size_t password_len,
+                               const uint8_t *salt,
+                               size_t salt_len,
+                               uint32_t iterations,
+                               size_t output_len,
+                               unsigned char *output);
+
+bool
+mongoc_crypto_cng_pbkdf2_sha256 (mongoc_crypto_t *crypto,
+                                 const char *password,
+                                 size_t password_len,
+                                 const uint8_t *salt,
+                                 size_t salt_len,
+                                 uint32_t iterations,
+                                 size_t output_len,
+                                 unsigned char *output);
 
 BSON_END_DECLS
 
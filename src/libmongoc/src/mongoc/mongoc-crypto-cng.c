@@ -236,4 +236,78 @@ mongoc_crypto_cng_sha256 (mongoc_crypto_t *crypto,
       _sha256_hash_algo, NULL, 0, input, input_len, hash_out);
    return res;
 }
+
+static bool
+_mongoc_crypto_cng_pbkdf2 (BCRYPT_ALG_HANDLE algorithm,
+                           const char *password,
+                           size_t password_len,
+                           const uint8_t *salt,
+                           size_t salt_len,
+                           uint32_t iterations,
+                           size_t output_len,
+                           unsigned char *output)
+{
+   NTSTATUS status = STATUS_UNSUCCESSFUL;
+
+   if (!algorithm) {
+      return false;
+   }
+
+   status = BCryptDeriveKeyPBKDF2 (algorithm,
+                                   (PUCHAR) password,
+                                   (ULONG) password_len,
+                                   (PUCHAR) salt,
+                                   (ULONG) salt_len,
+                                   (ULONGLONG) iterations,
+                                   output,
+                                   (ULONG) output_len,
+                                   0);
+
+   if (!NT_SUCCESS (status)) {
+      MONGOC_ERROR ("BCryptDeriveKeyPBKDF2(): %x", status);
+      return false;
+   }
+
+   return true;
+}
+
+bool
+mongoc_crypto_cng_pbkdf2_sha1 (mongoc_crypto_t *crypto,
+                               const char *password,
+                               size_t password_len,
+                               const uint8_t *salt,
+                               size_t salt_len,
+                               uint32_t iterations,
+                               size_t output_len,
+                               unsigned char *output)
+{
+   return _mongoc_crypto_cng_pbkdf2 (_sha1_hmac_algo,
+                                     password,
+                                     password_len,
+                                     salt,
+                                     salt_len,
+                                     iterations,
+                                     output_len,
+                                     output);
+}
+
+bool
+mongoc_crypto_cng_pbkdf2_sha256 (mongoc_crypto_t *crypto,
+                                 const char *password,
+                                 size_t password_len,
+                                 const uint8_t *salt,
+                                 size_t salt_len,
+                                 uint32_t iterations,
+                                 size_t output_len,
+                                 unsigned char *output)
+{
+   return _mongoc_crypto_cng_pbkdf2 (_sha256_hmac_algo,
+                                     password,
+                                     password_len,
+                                     salt,
+                                     salt_len,
+                                     iterations,
+                                     output_len,
+                                     output);
+}
 #endif
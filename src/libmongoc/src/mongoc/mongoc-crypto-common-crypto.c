@@ -20,6 +20,7 @@
 #include "mongoc-crypto-common-crypto-private.h"
 #include <CommonCrypto/CommonHMAC.h>
 #include <CommonCrypto/CommonDigest.h>
+#include <CommonCrypto/CommonKeyDerivation.h>
 
 
 void
@@ -75,4 +76,46 @@ mongoc_crypto_common_crypto_sha256 (mongoc_crypto_t *crypto,
    return false;
 }
 
+bool
+mongoc_crypto_common_crypto_pbkdf2_sha1 (mongoc_crypto_t *crypto,
+                                         const char *password,
+                                         size_t password_len,
+                                         const uint8_t *salt,
+                                         size_t salt_len,
+                                         uint32_t iterations,
+                                         size_t output_len,
+                                         unsigned char *output)
+{
+   return kCCSuccess == CCKeyDerivationPBKDF (kCCPBKDF2,
+                                              password,
+                                              password_len,
+                                              salt,
+                                              salt_len,
+                                              kCCPRFHmacAlgSHA1,
+                                              iterations,
+                                              output,
+                                              output_len);
+}
+
+bool
+mongoc_crypto_common_crypto_pbkdf2_sha256 (mongoc_crypto_t *crypto,
+                                           const char *password,
+                                           size_t password_len,
+                                           const uint8_t *salt,
+                                           size_t salt_len,
+                                           uint32_t iterations,
+                                           size_t output_len,
+                                           unsigned char *output)
+{
+   return kCCSuccess == CCKeyDerivationPBKDF (kCCPBKDF2,
+                                              password,
+                                              password_len,
+                                              salt,
+                                              salt_len,
+                                              kCCPRFHmacAlgSHA256,
+                                              iterations,
+                                              output,
+                                              output_len);
+}
+
 #endif
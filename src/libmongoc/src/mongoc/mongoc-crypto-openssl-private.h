@@ -59,6 +59,26 @@ mongoc_crypto_openssl_sha256 (mongoc_crypto_t *crypto,
                               const size_t input_len,
                               unsigned char *hash_out);
 
+bool
+mongoc_crypto_openssl_pbkdf2_sha1 (mongoc_crypto_t *crypto,
+                                   const char *password,
+                                   size_t password_len,
+                                   const uint8_t *salt,
+                                   size_t salt_len,
+                                   uint32_t iterations,
+                                   size_t output_len,
+                                   unsigned char *output);
+
+bool
+mongoc_crypto_openssl_pbkdf2_sha256 (mongoc_crypto_t *crypto,
+                                     const char *password,
+                                     size_t password_len,
+                                     const uint8_t *salt,
+                                     size_t salt_len,
+                                     uint32_t iterations,
+                                     size_t output_len,
+                                     unsigned char *output);
+
 BSON_END_DECLS
 #endif /* MONGOC_CRYPTO_OPENSSL_PRIVATE_H */
 #endif /* MONGOC_ENABLE_CRYPTO_LIBCRYPTO */
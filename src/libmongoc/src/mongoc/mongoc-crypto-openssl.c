@@ -115,4 +115,70 @@ cleanup:
    return rval;
 }
 
+/* PKCS5_PBKDF2_HMAC keeps the HMAC key schedule across iterations, instead
+ * of rederiving it for each one */
+static bool
+_mongoc_crypto_openssl_pbkdf2 (const EVP_MD *md,
+                               const char *password,
+                               size_t password_len,
+                               const uint8_t *salt,
+                               size_t salt_len,
+                               uint32_t iterations,
+                               size_t output_len,
+                               unsigned char *output)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10000000L
+   return 1 == PKCS5_PBKDF2_HMAC (password,
+                                  (int) password_len,
+                                  salt,
+                                  (int) salt_len,
+                                  (int) iterations,
+                                  md,
+                                  (int) output_len,
+                                  output);
+#else
+   return false;
+#endif
+}
+
+bool
+mongoc_crypto_openssl_pbkdf2_sha1 (mongoc_crypto_t *crypto,
+                                   const char *password,
+                                   size_t password_len,
+                                   const uint8_t *salt,
+                                   size_t salt_len,
+                                   uint32_t iterations,
+                                   size_t output_len,
+                                   unsigned char *output)
+{
+   return _mongoc_crypto_openssl_pbkdf2 (EVP_sha1 (),
+                                         password,
+                                         password_len,
+                                         salt,
+                                         salt_len,
+                                         iterations,
+                                         output_len,
+                                         output);
+}
+
+bool
+mongoc_crypto_openssl_pbkdf2_sha256 (mongoc_crypto_t *crypto,
+                                     const char *password,
+                                     size_t password_len,
+                                     const uint8_t *salt,
+                                     size_t salt_len,
+                                     uint32_t iterations,
+                                     size_t output_len,
+                                     unsigned char *output)
+{
+   return _mongoc_crypto_openssl_pbkdf2 (EVP_sha256 (),
+                                         password,
+                                         password_len,
+                                         salt,
+                                         salt_len,
+                                         iterations,
+                                         output_len,
+                                         output);
+}
+
 #endif
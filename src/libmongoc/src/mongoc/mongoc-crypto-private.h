@@ -47,6 +47,15 @@ struct _mongoc_crypto_t {
                  const unsigned char *input,
                  const size_t input_len,
                  unsigned char *hash_out);
+   /* PBKDF2 with HMAC and the algorithm's hash */
+   bool (*pbkdf2) (mongoc_crypto_t *crypto,
+                   const char *password,
+                   size_t password_len,
+                   const uint8_t *salt,
+                   size_t salt_len,
+                   uint32_t iterations,
+                   size_t output_len,
+                   unsigned char *output);
    mongoc_crypto_hash_algorithm_t algorithm;
 };
 
@@ -68,6 +77,16 @@ mongoc_crypto_hash (mongoc_crypto_t *crypto,
                     const size_t input_len,
                     unsigned char *hash_out);
 
+bool
+mongoc_crypto_pbkdf2 (mongoc_crypto_t *crypto,
+                      const char *password,
+                      size_t password_len,
+                      const uint8_t *salt,
+                      size_t salt_len,
+                      uint32_t iterations,
+                      size_t output_len,
+                      unsigned char *output);
+
 BSON_END_DECLS
 #endif /* MONGOC_CRYPTO_PRIVATE_H */
 #endif /* MONGOC_ENABLE_CRYPTO */
@@ -34,31 +34,39 @@ mongoc_crypto_init (mongoc_crypto_t *crypto,
 {
    crypto->hmac = NULL;
    crypto->hash = NULL;
+   crypto->pbkdf2 = NULL;
    if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_1) {
 #ifdef MONGOC_ENABLE_CRYPTO_LIBCRYPTO
       crypto->hmac = mongoc_crypto_openssl_hmac_sha1;
       crypto->hash = mongoc_crypto_openssl_sha1;
+      crypto->pbkdf2 = mongoc_crypto_openssl_pbkdf2_sha1;
 #elif defined(MONGOC_ENABLE_CRYPTO_COMMON_CRYPTO)
       crypto->hmac = mongoc_crypto_common_crypto_hmac_sha1;
       crypto->hash = mongoc_crypto_common_crypto_sha1;
+      crypto->pbkdf2 = mongoc_crypto_common_crypto_pbkdf2_sha1;
 #elif defined(MONGOC_ENABLE_CRYPTO_CNG)
       crypto->hmac = mongoc_crypto_cng_hmac_sha1;
       crypto->hash = mongoc_crypto_cng_sha1;
+      crypto->pbkdf2 = mongoc_crypto_cng_pbkdf2_sha1;
 #endif
    } else if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_256) {
 #ifdef MONGOC_ENABLE_CRYPTO_LIBCRYPTO
       crypto->hmac = mongoc_crypto_openssl_hmac_sha256;
       crypto->hash = mongoc_crypto_openssl_sha256;
+      crypto->pbkdf2 = mongoc_crypto_openssl_pbkdf2_sha256;
 #elif defined(MONGOC_ENABLE_CRYPTO_COMMON_CRYPTO)
       crypto->hmac = mongoc_crypto_common_crypto_hmac_sha256;
       crypto->hash = mongoc_crypto_common_crypto_sha256;
+      crypto->pbkdf2 = mongoc_crypto_common_crypto_pbkdf2_sha256;
 #elif defined(MONGOC_ENABLE_CRYPTO_CNG)
       crypto->hmac = mongoc_crypto_cng_hmac_sha256;
       crypto->hash = mongoc_crypto_cng_sha256;
+      crypto->pbkdf2 = mongoc_crypto_cng_pbkdf2_sha256;
 #endif
    }
    BSON_ASSERT (crypto->hmac);
    BSON_ASSERT (crypto->hash);
+   BSON_ASSERT (crypto->pbkdf2);
    crypto->algorithm = algo;
 }
 
@@ -81,4 +89,26 @@ mongoc_crypto_hash (mongoc_crypto_t *crypto,
 {
    return crypto->hash (crypto, input, input_len, output);
 }
+
+/* returns false if the backend could not derive the key, in which case the
+ * caller may compute PBKDF2 itself with mongoc_crypto_hmac */
+bool
+mongoc_crypto_pbkdf2 (mongoc_crypto_t *crypto,
+                      const char *password,
+                      size_t password_len,
+                      const uint8_t *salt,
+                      size_t salt_len,
+                      uint32_t iterations,
+                      size_t output_len,
+                      unsigned char *output)
+{
+   return crypto->pbkdf2 (crypto,
+                          password,
+                          password_len,
+                          salt,
+                          salt_len,
+                          iterations,
+                          output_len,
+                          output);
+}
 #endif
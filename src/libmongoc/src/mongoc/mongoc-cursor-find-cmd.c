@@ -62,6 +62,11 @@ _get_next_batch (mongoc_cursor_t *cursor)
    if (!cursor->cursor_id) {
       return DONE;
    }
+   if (cursor->in_exhaust) {
+      /* the server is streaming batches, no need to ask for the next one */
+      _mongoc_cursor_response_exhaust_next (cursor, &data->response);
+      return IN_BATCH;
+   }
    _mongoc_cursor_prepare_getmore_command (cursor, &getmore_cmd);
    _mongoc_cursor_response_refresh (
       cursor, &getmore_cmd, NULL /* opts */, &data->response);
@@ -42,10 +42,12 @@ _prime (mongoc_cursor_t *cursor)
       return DONE;
    }
    /* find_getmore_killcursors spec:
-    * "The find command does not support the exhaust flag from OP_QUERY." */
+    * "The find command does not support the exhaust flag from OP_QUERY."
+    * Newer servers stream getMore replies over OP_MSG instead. */
    use_find_command =
       server_stream->sd->max_wire_version >= WIRE_VERSION_FIND_CMD &&
-      !_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST);
+      (!_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST) ||
+       _mongoc_cursor_use_exhaust_getmore (cursor, server_stream));
    mongoc_server_stream_cleanup (server_stream);
 
    /* set all mongoc_impl_t function pointers. */
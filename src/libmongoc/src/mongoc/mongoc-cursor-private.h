@@ -65,6 +65,10 @@ BSON_BEGIN_DECLS
 #define MONGOC_CURSOR_NO_CURSOR_TIMEOUT_LEN 15
 #define MONGOC_CURSOR_OPLOG_REPLAY "oplogReplay"
 #define MONGOC_CURSOR_OPLOG_REPLAY_LEN 11
+#define MONGOC_CURSOR_PREFETCH "prefetch"
+#define MONGOC_CURSOR_PREFETCH_LEN 8
+#define MONGOC_CURSOR_PREFETCH_MAX_BYTES "prefetchMaxBytes"
+#define MONGOC_CURSOR_PREFETCH_MAX_BYTES_LEN 16
 #define MONGOC_CURSOR_ORDERBY "orderby"
 #define MONGOC_CURSOR_ORDERBY_LEN 7
 #define MONGOC_CURSOR_PROJECTION "projection"
@@ -90,6 +94,9 @@ BSON_BEGIN_DECLS
 #define MONGOC_CURSOR_TAILABLE "tailable"
 #define MONGOC_CURSOR_TAILABLE_LEN 8
 
+/* default cap on the batches a prefetching cursor requests ahead */
+#define MONGOC_CURSOR_PREFETCH_MAX_BYTES_DEFAULT (32 * 1024 * 1024)
+
 typedef struct _mongoc_cursor_impl_t mongoc_cursor_impl_t;
 typedef enum { UNPRIMED, IN_BATCH, END_OF_BATCH, DONE } mongoc_cursor_state_t;
 typedef mongoc_cursor_state_t (*_mongoc_cursor_impl_transition_t) (
@@ -121,6 +128,7 @@ struct _mongoc_cursor_t {
    mongoc_client_t *client;
 
    uint32_t server_id;
+   bool server_id_hinted; /* set by the serverId option or set_hint */
    bool slave_ok;
 
    mongoc_cursor_state_t state;
@@ -135,6 +143,17 @@ struct _mongoc_cursor_t {
    bool explicit_session;
    mongoc_client_session_t *client_session;
 
+   /* the "timeoutMS" option: how long each batch may take, or 0 */
+   int64_t timeout_ms;
+
+   /* the "prefetch" option: how many getMores to send ahead of the
+    * application on a dedicated connection, or 0 */
+   int32_t prefetch_depth;
+   /* the "prefetchMaxBytes" option: a cap on the bytes requested ahead */
+   int64_t prefetch_max_bytes;
+   /* getMores in flight, see mongoc-cursor.c */
+   struct _mongoc_cursor_prefetch_t *prefetch;
+
    uint32_t count;
 
    char ns[140];
@@ -222,6 +241,12 @@ _mongoc_cursor_response_refresh (mongoc_cursor_t *cursor,
                                  const bson_t *command,
                                  const bson_t *opts,
                                  mongoc_cursor_response_t *response);
+void
+_mongoc_cursor_response_exhaust_next (mongoc_cursor_t *cursor,
+                                      mongoc_cursor_response_t *response);
+bool
+_mongoc_cursor_use_exhaust_getmore (
+   mongoc_cursor_t *cursor, const mongoc_server_stream_t *server_stream);
 bool
 _mongoc_cursor_start_reading_response (mongoc_cursor_t *cursor,
                                        mongoc_cursor_response_t *response);
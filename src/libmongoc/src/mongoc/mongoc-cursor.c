@@ -19,6 +19,7 @@
 #include "mongoc-cursor-private.h"
 #include "mongoc-client-private.h"
 #include "mongoc-client-session-private.h"
+#include "mongoc-cluster-private.h"
 #include "mongoc-counters-private.h"
 #include "mongoc-error.h"
 #include "mongoc-log.h"
@@ -27,6 +28,7 @@
 #include "mongoc-util-private.h"
 #include "mongoc-write-concern-private.h"
 #include "mongoc-read-prefs-private.h"
+#include "mongoc-opts-helpers-private.h"
 
 
 #undef MONGOC_LOG_DOMAIN
@@ -40,6 +42,9 @@ _translate_query_opt (const char *query_field,
                       const char **cmd_field,
                       int *len);
 
+static void
+_mongoc_cursor_prefetch_destroy (mongoc_cursor_t *cursor);
+
 
 bool
 _mongoc_cursor_set_opt_int64 (mongoc_cursor_t *cursor,
@@ -247,6 +252,7 @@ _mongoc_cursor_new_with_opts (mongoc_client_t *client,
    cursor = (mongoc_cursor_t *) bson_malloc0 (sizeof *cursor);
    cursor->client = client;
    cursor->state = UNPRIMED;
+   cursor->prefetch_max_bytes = MONGOC_CURSOR_PREFETCH_MAX_BYTES_DEFAULT;
 
    bson_init (&cursor->opts);
    bson_init (&cursor->error_doc);
@@ -294,8 +300,33 @@ _mongoc_cursor_new_with_opts (mongoc_client_t *client,
          (void) mongoc_cursor_set_hint (cursor, server_id);
       }
 
-      bson_copy_to_excluding_noinit (
-         opts, &cursor->opts, "serverId", "sessionId", NULL);
+      if (bson_iter_init_find (&iter, opts, "timeoutMS") &&
+          !_mongoc_convert_int64_positive (
+             client, &iter, &cursor->timeout_ms, &cursor->error)) {
+         GOTO (finish);
+      }
+
+      if (bson_iter_init_find (&iter, opts, MONGOC_CURSOR_PREFETCH) &&
+          !_mongoc_convert_int32_positive (
+             client, &iter, &cursor->prefetch_depth, &cursor->error)) {
+         GOTO (finish);
+      }
+
+      if (bson_iter_init_find (
+             &iter, opts, MONGOC_CURSOR_PREFETCH_MAX_BYTES) &&
+          !_mongoc_convert_int64_positive (
+             client, &iter, &cursor->prefetch_max_bytes, &cursor->error)) {
+         GOTO (finish);
+      }
+
+      bson_copy_to_excluding_noinit (opts,
+                                     &cursor->opts,
+                                     "serverId",
+                                     "sessionId",
+                                     "timeoutMS",
+                                     MONGOC_CURSOR_PREFETCH,
+                                     MONGOC_CURSOR_PREFETCH_MAX_BYTES,
+                                     NULL);
    }
 
    if (_mongoc_client_session_in_txn (cursor->client_session)) {
@@ -571,6 +602,9 @@ mongoc_cursor_destroy (mongoc_cursor_t *cursor)
       cursor->impl.destroy (&cursor->impl);
    }
 
+   /* close the prefetch connection before killing the cursor it reads */
+   _mongoc_cursor_prefetch_destroy (cursor);
+
    if (cursor->in_exhaust) {
       cursor->client->in_exhaust = false;
       if (cursor->state != DONE) {
@@ -884,6 +918,7 @@ _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
    mongoc_cmd_parts_t parts;
    const char *cmd_name;
    bool is_primary;
+   bool hedge;
    mongoc_read_prefs_t *prefs = NULL;
    char db[MONGOC_NAMESPACE_MAX];
    mongoc_session_opt_t *session_opts;
@@ -897,6 +932,9 @@ _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
    parts.is_read_command = true;
    parts.read_prefs = cursor->read_prefs;
    parts.assembled.operation_id = cursor->operation_id;
+   /* the command that opens the cursor may be hedged, unless a server was
+    * chosen for us */
+   hedge = !cursor->server_id_hinted && !cursor->cursor_id;
    server_stream = _mongoc_cursor_fetch_stream (cursor);
 
    if (!server_stream) {
@@ -993,9 +1031,29 @@ _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
       GOTO (done);
    }
 
+   /* let the server stream the remaining batches in reply to one getMore */
+   if (!strcmp (cmd_name, "getMore") &&
+       _mongoc_cursor_use_exhaust_getmore (cursor, server_stream)) {
+      parts.assembled.exhaust_allowed = true;
+   }
+
+   if (hedge) {
+      parts.assembled.hedge_read_prefs = cursor->read_prefs;
+   }
+
    ret = mongoc_cluster_run_command_monitored (
       cluster, &parts.assembled, reply, &cursor->error);
 
+   /* the cursor, if any, lives on the server that answered */
+   if (parts.assembled.hedge_server_id) {
+      cursor->server_id = parts.assembled.hedge_server_id;
+   }
+
+   if (ret && parts.assembled.more_to_come) {
+      cursor->in_exhaust = true;
+      cursor->client->in_exhaust = true;
+   }
+
    if (cursor->error.domain) {
       bson_destroy (&cursor->error_doc);
       bson_copy_to (reply, &cursor->error_doc);
@@ -1100,6 +1158,8 @@ _call_transition (mongoc_cursor_t *cursor)
 {
    mongoc_cursor_state_t state = cursor->state;
    _mongoc_cursor_impl_transition_t fn = NULL;
+   int64_t prev_deadline;
+
    switch (state) {
    case UNPRIMED:
       fn = cursor->impl.prime;
@@ -1118,7 +1178,11 @@ _call_transition (mongoc_cursor_t *cursor)
    if (!fn) {
       return DONE;
    }
+   /* each batch, including the first, gets the whole timeoutMS */
+   prev_deadline = _mongoc_cluster_begin_operation (&cursor->client->cluster,
+                                                    cursor->timeout_ms);
    state = fn (cursor);
+   _mongoc_cluster_end_operation (&cursor->client->cluster, prev_deadline);
    if (cursor->error.domain) {
       state = DONE;
    }
@@ -1263,6 +1327,8 @@ mongoc_cursor_clone (const mongoc_cursor_t *cursor)
    _clone->nslen = cursor->nslen;
    _clone->dblen = cursor->dblen;
    _clone->explicit_session = cursor->explicit_session;
+   _clone->prefetch_depth = cursor->prefetch_depth;
+   _clone->prefetch_max_bytes = cursor->prefetch_max_bytes;
 
    if (cursor->read_prefs) {
       _clone->read_prefs = mongoc_read_prefs_copy (cursor->read_prefs);
@@ -1400,6 +1466,7 @@ mongoc_cursor_set_hint (mongoc_cursor_t *cursor, uint32_t server_id)
    }
 
    cursor->server_id = server_id;
+   cursor->server_id_hinted = true;
 
    return true;
 }
@@ -1566,6 +1633,222 @@ _mongoc_cursor_response_read (mongoc_cursor_t *cursor,
    }
 }
 
+/* getMores a cursor with the "prefetch" option has sent ahead of the
+ * application on its own connection. the server answers them in order, so
+ * the replies are read one per batch, usually without waiting, from a FIFO
+ * of request ids. the connection is closed, discarding unread replies, once
+ * the cursor is exhausted or destroyed. */
+typedef struct _mongoc_cursor_prefetch_t {
+   mongoc_cluster_node_t *node;
+   mongoc_server_stream_t *server_stream;
+   uint32_t *request_ids;
+   int64_t *started;
+   int32_t head;
+   int32_t n_pending;
+   /* set if a getMore could not be sent, reported at the next batch */
+   bson_error_t error;
+} mongoc_cursor_prefetch_t;
+
+
+static void
+_mongoc_cursor_prefetch_destroy (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_prefetch_t *prefetch = cursor->prefetch;
+
+   if (!prefetch) {
+      return;
+   }
+
+   mongoc_server_stream_cleanup (prefetch->server_stream);
+   _mongoc_cluster_node_destroy (prefetch->node);
+   bson_free (prefetch->request_ids);
+   bson_free (prefetch->started);
+   bson_free (prefetch);
+
+   cursor->prefetch = NULL;
+}
+
+
+/* true if @cursor may send getMores ahead of the application. cursors with
+ * a limit compute each batchSize from the documents already returned, and
+ * tailable getMores may block awaiting data, so they don't prefetch */
+static bool
+_mongoc_cursor_prefetch_allowed (mongoc_cursor_t *cursor)
+{
+   return cursor->prefetch_depth > 0 && cursor->cursor_id &&
+          !cursor->in_exhaust && !cursor->error.domain &&
+          !mongoc_cursor_get_limit (cursor) &&
+          !_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_TAILABLE) &&
+          !_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST) &&
+          !_mongoc_client_session_in_txn (cursor->client_session);
+}
+
+
+/* open the dedicated connection to the cursor's server. returns NULL if it
+ * can't, or the server predates OP_MSG */
+static mongoc_cursor_prefetch_t *
+_mongoc_cursor_prefetch_new (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_prefetch_t *prefetch;
+   mongoc_cluster_node_t *node;
+   mongoc_server_stream_t *server_stream;
+   bson_error_t error;
+
+   node = _mongoc_cluster_node_connect (
+      &cursor->client->cluster, cursor->server_id, &error);
+   if (!node) {
+      MONGOC_DEBUG ("Not prefetching, could not connect: %s", error.message);
+      return NULL;
+   }
+
+   server_stream = NULL;
+   if (node->max_wire_version >= WIRE_VERSION_OP_MSG) {
+      server_stream = _mongoc_cluster_create_server_stream (
+         cursor->client->topology, cursor->server_id, node->stream, &error);
+   }
+
+   if (!server_stream) {
+      _mongoc_cluster_node_destroy (node);
+      return NULL;
+   }
+
+   prefetch = (mongoc_cursor_prefetch_t *) bson_malloc0 (sizeof *prefetch);
+   prefetch->node = node;
+   prefetch->server_stream = server_stream;
+   prefetch->request_ids = (uint32_t *) bson_malloc0 (
+      (size_t) cursor->prefetch_depth * sizeof (uint32_t));
+   prefetch->started = (int64_t *) bson_malloc0 (
+      (size_t) cursor->prefetch_depth * sizeof (int64_t));
+
+   return prefetch;
+}
+
+
+static bool
+_mongoc_cursor_prefetch_send (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_prefetch_t *prefetch = cursor->prefetch;
+   mongoc_cmd_parts_t parts;
+   bson_t getmore_cmd;
+   char db[MONGOC_NAMESPACE_MAX];
+   int32_t tail;
+   bool ret;
+
+   _mongoc_cursor_prepare_getmore_command (cursor, &getmore_cmd);
+   bson_strncpy (db, cursor->ns, cursor->dblen + 1);
+
+   mongoc_cmd_parts_init (
+      &parts, cursor->client, db, MONGOC_QUERY_NONE, &getmore_cmd);
+   parts.is_read_command = true;
+   parts.read_prefs = cursor->read_prefs;
+   parts.assembled.operation_id = cursor->operation_id;
+   if (cursor->client_session) {
+      mongoc_cmd_parts_set_session (&parts, cursor->client_session);
+   }
+
+   tail = (prefetch->head + prefetch->n_pending) % cursor->prefetch_depth;
+   prefetch->started[tail] = bson_get_monotonic_time ();
+
+   ret = mongoc_cmd_parts_assemble (
+            &parts, prefetch->server_stream, &prefetch->error) &&
+         mongoc_cluster_send_opmsg_deferred (&cursor->client->cluster,
+                                             &parts.assembled,
+                                             &prefetch->request_ids[tail],
+                                             &prefetch->error);
+   if (ret) {
+      prefetch->n_pending++;
+   }
+
+   mongoc_cmd_parts_cleanup (&parts);
+   bson_destroy (&getmore_cmd);
+
+   return ret;
+}
+
+
+/* called once a batch of @batch_len bytes is handed to the application:
+ * send getMores until "prefetch" are in flight or, estimating from this
+ * batch, more would exceed "prefetchMaxBytes". at least one is sent. */
+static void
+_mongoc_cursor_prefetch_fill (mongoc_cursor_t *cursor, uint32_t batch_len)
+{
+   mongoc_cursor_prefetch_t *prefetch;
+
+   if (!_mongoc_cursor_prefetch_allowed (cursor)) {
+      _mongoc_cursor_prefetch_destroy (cursor);
+      return;
+   }
+
+   if (!cursor->prefetch) {
+      cursor->prefetch = _mongoc_cursor_prefetch_new (cursor);
+      if (!cursor->prefetch) {
+         /* fall back to a getMore per batch */
+         cursor->prefetch_depth = 0;
+         return;
+      }
+   }
+
+   prefetch = cursor->prefetch;
+
+   while (!prefetch->error.domain &&
+          prefetch->n_pending < cursor->prefetch_depth &&
+          (!prefetch->n_pending ||
+           (int64_t) (prefetch->n_pending + 1) * batch_len <=
+              cursor->prefetch_max_bytes)) {
+      if (!_mongoc_cursor_prefetch_send (cursor)) {
+         break;
+      }
+   }
+}
+
+
+/* read the reply to the oldest getMore in flight */
+static bool
+_mongoc_cursor_prefetch_recv (mongoc_cursor_t *cursor, bson_t *reply)
+{
+   mongoc_cursor_prefetch_t *prefetch = cursor->prefetch;
+   mongoc_cmd_t cmd = {0};
+   char db[MONGOC_NAMESPACE_MAX];
+   bool ret;
+
+   if (!prefetch->n_pending) {
+      /* the getMore for this batch could not be sent */
+      memcpy (&cursor->error, &prefetch->error, sizeof (bson_error_t));
+      _mongoc_cursor_prefetch_destroy (cursor);
+      bson_init (reply);
+      return false;
+   }
+
+   bson_strncpy (db, cursor->ns, cursor->dblen + 1);
+   cmd.db_name = db;
+   cmd.command_name = "getMore";
+   cmd.server_stream = prefetch->server_stream;
+   cmd.operation_id = cursor->operation_id;
+   cmd.session = cursor->client_session;
+   cmd.is_acknowledged = true;
+   cmd.deadline = cursor->client->cluster.deadline;
+
+   ret = mongoc_cluster_recv_opmsg_deferred (
+      &cursor->client->cluster,
+      &cmd,
+      prefetch->request_ids[prefetch->head],
+      prefetch->started[prefetch->head],
+      reply,
+      &cursor->error);
+
+   prefetch->head = (prefetch->head + 1) % cursor->prefetch_depth;
+   prefetch->n_pending--;
+
+   if (!ret) {
+      bson_destroy (&cursor->error_doc);
+      bson_copy_to (reply, &cursor->error_doc);
+      _mongoc_cursor_prefetch_destroy (cursor);
+   }
+
+   return ret;
+}
+
+
 /* sets cursor error if could not get the next batch. */
 void
 _mongoc_cursor_response_refresh (mongoc_cursor_t *cursor,
@@ -1573,14 +1856,27 @@ _mongoc_cursor_response_refresh (mongoc_cursor_t *cursor,
                                  const bson_t *opts,
                                  mongoc_cursor_response_t *response)
 {
+   bool ret;
+
    ENTRY;
 
    bson_destroy (&response->reply);
 
+   /* a prefetched getMore stands in for @command, which is the same */
+   if (cursor->prefetch) {
+      ret = _mongoc_cursor_prefetch_recv (cursor, &response->reply);
+   } else {
+      ret = _mongoc_cursor_run_command (
+         cursor, command, opts, &response->reply);
+   }
+
    /* server replies to find / aggregate with {cursor: {id: N, firstBatch: []}},
     * to getMore command with {cursor: {id: N, nextBatch: []}}. */
-   if (_mongoc_cursor_run_command (cursor, command, opts, &response->reply) &&
-       _mongoc_cursor_start_reading_response (cursor, response)) {
+   if (ret && _mongoc_cursor_start_reading_response (cursor, response)) {
+      if (cursor->prefetch_depth) {
+         _mongoc_cursor_prefetch_fill (cursor, response->reply.len);
+      }
+
       return;
    }
    if (!cursor->error.domain) {
@@ -1593,6 +1889,76 @@ _mongoc_cursor_response_refresh (mongoc_cursor_t *cursor,
 }
 
 
+/* reads the next batch the server streams in reply to an exhaust getMore,
+ * without sending anything. sets cursor error if it could not. */
+void
+_mongoc_cursor_response_exhaust_next (mongoc_cursor_t *cursor,
+                                      mongoc_cursor_response_t *response)
+{
+   mongoc_server_stream_t *server_stream;
+   mongoc_cmd_t cmd = {0};
+   char db[MONGOC_NAMESPACE_MAX];
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (cursor->in_exhaust);
+
+   bson_destroy (&response->reply);
+
+   server_stream = _mongoc_cursor_fetch_stream (cursor);
+   if (!server_stream) {
+      bson_init (&response->reply);
+   } else {
+      bson_strncpy (db, cursor->ns, cursor->dblen + 1);
+      cmd.db_name = db;
+      cmd.command_name = "getMore";
+      cmd.server_stream = server_stream;
+      cmd.operation_id = cursor->operation_id;
+      cmd.session = cursor->client_session;
+      cmd.is_acknowledged = true;
+      cmd.exhaust_allowed = true;
+      cmd.more_to_come = true;
+
+      ret = mongoc_cluster_run_opmsg_exhaust_next (&cursor->client->cluster,
+                                                   &cmd,
+                                                   &response->reply,
+                                                   &cursor->error);
+      mongoc_server_stream_cleanup (server_stream);
+   }
+
+   if (!ret || !cmd.more_to_come) {
+      /* the stream is finished, or the connection is gone */
+      cursor->in_exhaust = false;
+      cursor->client->in_exhaust = false;
+   }
+
+   if (ret && _mongoc_cursor_start_reading_response (cursor, response)) {
+      EXIT;
+   }
+
+   if (!cursor->error.domain) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply to getMore command.");
+   }
+
+   EXIT;
+}
+
+
+/* true if a find command cursor should stream its getMore replies with the
+ * OP_MSG exhaustAllowed flag instead of sending a getMore per batch. */
+bool
+_mongoc_cursor_use_exhaust_getmore (mongoc_cursor_t *cursor,
+                                    const mongoc_server_stream_t *server_stream)
+{
+   return _mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST) &&
+          server_stream->sd->max_wire_version >= WIRE_VERSION_EXHAUST_GETMORE;
+}
+
+
 void
 _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t *cursor,
                                         bson_t *command)
@@ -27,11 +27,22 @@
 #include <openssl/err.h>
 
 #include "mongoc-ssl.h"
+#include "mongoc-array-private.h"
+#include "mongoc-thread-private.h"
 
 
 BSON_BEGIN_DECLS
 
 
+/* client-side TLS sessions by "host:port", to resume instead of running a
+ * full handshake. shared by a topology's connections and monitors */
+typedef struct _mongoc_openssl_session_cache_t {
+   mongoc_mutex_t mutex;
+   /* mongoc_openssl_session_entry_t */
+   mongoc_array_t entries;
+} mongoc_openssl_session_cache_t;
+
+
 bool
 _mongoc_openssl_check_cert (SSL *ssl,
                             const char *host,
@@ -45,6 +56,22 @@ _mongoc_openssl_init (void);
 void
 _mongoc_openssl_cleanup (void);
 
+mongoc_openssl_session_cache_t *
+_mongoc_openssl_session_cache_new (void);
+
+void
+_mongoc_openssl_session_cache_destroy (mongoc_openssl_session_cache_t *cache);
+
+bool
+_mongoc_openssl_session_cache_apply (mongoc_openssl_session_cache_t *cache,
+                                     const char *host,
+                                     SSL *ssl);
+
+void
+_mongoc_openssl_session_cache_put (mongoc_openssl_session_cache_t *cache,
+                                   const char *host,
+                                   SSL_SESSION *session);
+
 
 BSON_END_DECLS
 
@@ -594,6 +594,140 @@ _mongoc_openssl_extract_subject (const char *filename, const char *passphrase)
    return str;
 }
 
+
+typedef struct {
+   char *host;
+   SSL_SESSION *session;
+} mongoc_openssl_session_entry_t;
+
+
+mongoc_openssl_session_cache_t *
+_mongoc_openssl_session_cache_new (void)
+{
+   mongoc_openssl_session_cache_t *cache;
+
+   cache = (mongoc_openssl_session_cache_t *) bson_malloc0 (sizeof *cache);
+   mongoc_mutex_init (&cache->mutex);
+   _mongoc_array_init (&cache->entries,
+                       sizeof (mongoc_openssl_session_entry_t));
+
+   return cache;
+}
+
+
+void
+_mongoc_openssl_session_cache_destroy (mongoc_openssl_session_cache_t *cache)
+{
+   mongoc_openssl_session_entry_t *entry;
+   size_t i;
+
+   if (!cache) {
+      return;
+   }
+
+   for (i = 0; i < cache->entries.len; i++) {
+      entry = &_mongoc_array_index (
+         &cache->entries, mongoc_openssl_session_entry_t, i);
+      bson_free (entry->host);
+      SSL_SESSION_free (entry->session);
+   }
+
+   _mongoc_array_destroy (&cache->entries);
+   mongoc_mutex_destroy (&cache->mutex);
+   bson_free (cache);
+}
+
+
+static mongoc_openssl_session_entry_t *
+_mongoc_openssl_session_cache_find (mongoc_openssl_session_cache_t *cache,
+                                    const char *host)
+{
+   mongoc_openssl_session_entry_t *entry;
+   size_t i;
+
+   for (i = 0; i < cache->entries.len; i++) {
+      entry = &_mongoc_array_index (
+         &cache->entries, mongoc_openssl_session_entry_t, i);
+      if (!strcmp (entry->host, host)) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_openssl_session_cache_apply --
+ *
+ *       Set the last session cached for @host on @ssl, before its
+ *       handshake, so the handshake resumes it if the server agrees.
+ *
+ * Returns:
+ *       true if a session was set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_openssl_session_cache_apply (mongoc_openssl_session_cache_t *cache,
+                                     const char *host,
+                                     SSL *ssl)
+{
+   mongoc_openssl_session_entry_t *entry;
+   bool ret = false;
+
+   mongoc_mutex_lock (&cache->mutex);
+   entry = _mongoc_openssl_session_cache_find (cache, host);
+   if (entry) {
+      /* takes its own reference */
+      ret = SSL_set_session (ssl, entry->session) == 1;
+   }
+   mongoc_mutex_unlock (&cache->mutex);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_openssl_session_cache_put --
+ *
+ *       Cache @session for @host, replacing any older one. The cache takes
+ *       ownership of the caller's reference to @session.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_openssl_session_cache_put (mongoc_openssl_session_cache_t *cache,
+                                   const char *host,
+                                   SSL_SESSION *session)
+{
+   mongoc_openssl_session_entry_t *entry;
+   mongoc_openssl_session_entry_t new_entry;
+   SSL_SESSION *old = NULL;
+
+   mongoc_mutex_lock (&cache->mutex);
+   entry = _mongoc_openssl_session_cache_find (cache, host);
+   if (entry) {
+      old = entry->session;
+      entry->session = session;
+   } else {
+      new_entry.host = bson_strdup (host);
+      new_entry.session = session;
+      _mongoc_array_append_val (&cache->entries, new_entry);
+   }
+   mongoc_mutex_unlock (&cache->mutex);
+
+   if (old) {
+      SSL_SESSION_free (old);
+   }
+}
+
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 #ifdef _WIN32
 
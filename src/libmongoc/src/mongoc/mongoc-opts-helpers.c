@@ -105,6 +105,29 @@ _mongoc_convert_int64_positive (mongoc_client_t *client,
    return true;
 }
 
+bool
+_mongoc_convert_int32_positive (mongoc_client_t *client,
+                                const bson_iter_t *iter,
+                                int32_t *num,
+                                bson_error_t *error)
+{
+   int32_t i;
+
+   if (!_mongoc_convert_int32_t (client, iter, &i, error)) {
+      return false;
+   }
+
+   if (i <= 0) {
+      CONVERSION_ERR ("Invalid field \"%s\" in opts, should be greater than 0,"
+                      " not %d",
+                      bson_iter_key (iter),
+                      i);
+   }
+
+   *num = i;
+   return true;
+}
+
 bool
 _mongoc_convert_int32_t (mongoc_client_t *client,
                          const bson_iter_t *iter,
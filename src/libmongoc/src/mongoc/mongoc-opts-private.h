@@ -20,6 +20,7 @@ typedef struct _mongoc_crud_opts_t {
    bool write_concern_owned;
    mongoc_client_session_t *client_session;
    bson_validate_flags_t validate;
+   int64_t timeoutMS;
 } mongoc_crud_opts_t;
 
 typedef struct _mongoc_update_opts_t {
@@ -76,6 +77,8 @@ typedef struct _mongoc_bulk_opts_t {
    bool write_concern_owned;
    bool ordered;
    mongoc_client_session_t *client_session;
+   int64_t timeoutMS;
+   int32_t pipelineDepth;
    bson_t extra;
 } mongoc_bulk_opts_t;
 
@@ -139,6 +142,7 @@ typedef struct _mongoc_read_write_opts_t {
    mongoc_client_session_t *client_session;
    bson_t collation;
    uint32_t serverId;
+   int64_t timeoutMS;
    bson_t extra;
 } mongoc_read_write_opts_t;
 
@@ -27,6 +27,7 @@ _mongoc_insert_one_opts_parse (
    mongoc_insert_one_opts->crud.write_concern_owned = false;
    mongoc_insert_one_opts->crud.client_session = NULL;
    mongoc_insert_one_opts->crud.validate = _mongoc_default_insert_vflags;
+   mongoc_insert_one_opts->crud.timeoutMS = 0;
    mongoc_insert_one_opts->bypass =
       MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT;
    bson_init (&mongoc_insert_one_opts->extra);
@@ -73,6 +74,15 @@ _mongoc_insert_one_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_insert_one_opts->crud.timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else if (!strcmp (bson_iter_key (&iter), "bypassDocumentValidation")) {
          if (!_mongoc_convert_mongoc_write_bypass_document_validation_t (
                client,
@@ -122,6 +132,7 @@ _mongoc_insert_many_opts_parse (
    mongoc_insert_many_opts->crud.write_concern_owned = false;
    mongoc_insert_many_opts->crud.client_session = NULL;
    mongoc_insert_many_opts->crud.validate = _mongoc_default_insert_vflags;
+   mongoc_insert_many_opts->crud.timeoutMS = 0;
    mongoc_insert_many_opts->ordered = true;
    mongoc_insert_many_opts->bypass =
       MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT;
@@ -169,6 +180,15 @@ _mongoc_insert_many_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_insert_many_opts->crud.timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else if (!strcmp (bson_iter_key (&iter), "ordered")) {
          if (!_mongoc_convert_bool (
                client,
@@ -227,6 +247,7 @@ _mongoc_delete_one_opts_parse (
    mongoc_delete_one_opts->crud.write_concern_owned = false;
    mongoc_delete_one_opts->crud.client_session = NULL;
    mongoc_delete_one_opts->crud.validate = BSON_VALIDATE_NONE;
+   mongoc_delete_one_opts->crud.timeoutMS = 0;
    bson_init (&mongoc_delete_one_opts->collation);
    bson_init (&mongoc_delete_one_opts->extra);
 
@@ -272,6 +293,15 @@ _mongoc_delete_one_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_delete_one_opts->crud.timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else if (!strcmp (bson_iter_key (&iter), "collation")) {
          if (!_mongoc_convert_document (
                client,
@@ -322,6 +352,7 @@ _mongoc_delete_many_opts_parse (
    mongoc_delete_many_opts->crud.write_concern_owned = false;
    mongoc_delete_many_opts->crud.client_session = NULL;
    mongoc_delete_many_opts->crud.validate = BSON_VALIDATE_NONE;
+   mongoc_delete_many_opts->crud.timeoutMS = 0;
    bson_init (&mongoc_delete_many_opts->collation);
    bson_init (&mongoc_delete_many_opts->extra);
 
@@ -367,6 +398,15 @@ _mongoc_delete_many_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_delete_many_opts->crud.timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else if (!strcmp (bson_iter_key (&iter), "collation")) {
          if (!_mongoc_convert_document (
                client,
@@ -417,6 +457,7 @@ _mongoc_update_one_opts_parse (
    mongoc_update_one_opts->update.crud.write_concern_owned = false;
    mongoc_update_one_opts->update.crud.client_session = NULL;
    mongoc_update_one_opts->update.crud.validate = _mongoc_default_update_vflags;
+   mongoc_update_one_opts->update.crud.timeoutMS = 0;
    mongoc_update_one_opts->update.bypass =
       MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT;
    bson_init (&mongoc_update_one_opts->update.collation);
@@ -466,6 +507,15 @@ _mongoc_update_one_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_update_one_opts->update.crud.timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else if (!strcmp (bson_iter_key (&iter), "bypassDocumentValidation")) {
          if (!_mongoc_convert_mongoc_write_bypass_document_validation_t (
                client,
@@ -544,6 +594,7 @@ _mongoc_update_many_opts_parse (
    mongoc_update_many_opts->update.crud.write_concern_owned = false;
    mongoc_update_many_opts->update.crud.client_session = NULL;
    mongoc_update_many_opts->update.crud.validate = _mongoc_default_update_vflags;
+   mongoc_update_many_opts->update.crud.timeoutMS = 0;
    mongoc_update_many_opts->update.bypass =
       MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT;
    bson_init (&mongoc_update_many_opts->update.collation);
@@ -593,6 +644,15 @@ _mongoc_update_many_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_update_many_opts->update.crud.timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else if (!strcmp (bson_iter_key (&iter), "bypassDocumentValidation")) {
          if (!_mongoc_convert_mongoc_write_bypass_document_validation_t (
                client,
@@ -671,6 +731,7 @@ _mongoc_replace_one_opts_parse (
    mongoc_replace_one_opts->update.crud.write_concern_owned = false;
    mongoc_replace_one_opts->update.crud.client_session = NULL;
    mongoc_replace_one_opts->update.crud.validate = _mongoc_default_replace_vflags;
+   mongoc_replace_one_opts->update.crud.timeoutMS = 0;
    mongoc_replace_one_opts->update.bypass =
       MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT;
    bson_init (&mongoc_replace_one_opts->update.collation);
@@ -719,6 +780,15 @@ _mongoc_replace_one_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_replace_one_opts->update.crud.timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else if (!strcmp (bson_iter_key (&iter), "bypassDocumentValidation")) {
          if (!_mongoc_convert_mongoc_write_bypass_document_validation_t (
                client,
@@ -787,6 +857,8 @@ _mongoc_bulk_opts_parse (
    mongoc_bulk_opts->write_concern_owned = false;
    mongoc_bulk_opts->ordered = true;
    mongoc_bulk_opts->client_session = NULL;
+   mongoc_bulk_opts->timeoutMS = 0;
+   mongoc_bulk_opts->pipelineDepth = 1;
    bson_init (&mongoc_bulk_opts->extra);
 
    if (!opts) {
@@ -831,6 +903,24 @@ _mongoc_bulk_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_bulk_opts->timeoutMS,
+               error)) {
+            return false;
+         }
+      }
+      else if (!strcmp (bson_iter_key (&iter), "pipelineDepth")) {
+         if (!_mongoc_convert_int32_positive (
+               client,
+               &iter,
+               &mongoc_bulk_opts->pipelineDepth,
+               error)) {
+            return false;
+         }
+      }
       else {
          bson_set_error (error,
                          MONGOC_ERROR_COMMAND,
@@ -1441,6 +1531,7 @@ _mongoc_read_write_opts_parse (
    mongoc_read_write_opts->client_session = NULL;
    bson_init (&mongoc_read_write_opts->collation);
    mongoc_read_write_opts->serverId = 0;
+   mongoc_read_write_opts->timeoutMS = 0;
    bson_init (&mongoc_read_write_opts->extra);
 
    if (!opts) {
@@ -1503,6 +1594,15 @@ _mongoc_read_write_opts_parse (
             return false;
          }
       }
+      else if (!strcmp (bson_iter_key (&iter), "timeoutMS")) {
+         if (!_mongoc_convert_int64_positive (
+               client,
+               &iter,
+               &mongoc_read_write_opts->timeoutMS,
+               error)) {
+            return false;
+         }
+      }
       else {
          /* unrecognized values are copied to "extra" */
          if (!BSON_APPEND_VALUE (
@@ -33,6 +33,8 @@ struct _mongoc_read_prefs_t {
    mongoc_read_mode_t mode;
    bson_t tags;
    int64_t max_staleness_seconds;
+   int32_t hedge_delay_ms;
+   double hedge_percentile;
 };
 
 
@@ -51,6 +53,9 @@ typedef struct _mongoc_assemble_query_result_t {
 const char *
 _mongoc_read_mode_as_str (mongoc_read_mode_t mode);
 
+bool
+_mongoc_read_prefs_hedges (const mongoc_read_prefs_t *read_prefs);
+
 void
 assemble_query (const mongoc_read_prefs_t *read_prefs,
                 const mongoc_server_stream_t *server_stream,
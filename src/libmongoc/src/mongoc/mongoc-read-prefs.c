@@ -117,17 +117,57 @@ mongoc_read_prefs_set_max_staleness_seconds (mongoc_read_prefs_t *read_prefs,
 }
 
 
+int32_t
+mongoc_read_prefs_get_hedge_delay_ms (const mongoc_read_prefs_t *read_prefs)
+{
+   BSON_ASSERT (read_prefs);
+
+   return read_prefs->hedge_delay_ms;
+}
+
+
+void
+mongoc_read_prefs_set_hedge_delay_ms (mongoc_read_prefs_t *read_prefs,
+                                      int32_t hedge_delay_ms)
+{
+   BSON_ASSERT (read_prefs);
+
+   read_prefs->hedge_delay_ms = hedge_delay_ms;
+}
+
+
+double
+mongoc_read_prefs_get_hedge_percentile (const mongoc_read_prefs_t *read_prefs)
+{
+   BSON_ASSERT (read_prefs);
+
+   return read_prefs->hedge_percentile;
+}
+
+
+void
+mongoc_read_prefs_set_hedge_percentile (mongoc_read_prefs_t *read_prefs,
+                                        double hedge_percentile)
+{
+   BSON_ASSERT (read_prefs);
+
+   read_prefs->hedge_percentile = hedge_percentile;
+}
+
+
 bool
 mongoc_read_prefs_is_valid (const mongoc_read_prefs_t *read_prefs)
 {
    BSON_ASSERT (read_prefs);
 
    /*
-    * Tags or maxStalenessSeconds are not supported with PRIMARY mode.
+    * Tags, maxStalenessSeconds, or hedging are not supported with PRIMARY
+    * mode.
     */
    if (read_prefs->mode == MONGOC_READ_PRIMARY) {
       if (!bson_empty (&read_prefs->tags) ||
-          read_prefs->max_staleness_seconds != MONGOC_NO_MAX_STALENESS) {
+          read_prefs->max_staleness_seconds != MONGOC_NO_MAX_STALENESS ||
+          _mongoc_read_prefs_hedges (read_prefs)) {
          return false;
       }
    }
@@ -137,6 +177,11 @@ mongoc_read_prefs_is_valid (const mongoc_read_prefs_t *read_prefs)
       return false;
    }
 
+   if (read_prefs->hedge_delay_ms < 0 || read_prefs->hedge_percentile < 0 ||
+       read_prefs->hedge_percentile >= 100) {
+      return false;
+   }
+
    return true;
 }
 
@@ -161,12 +206,24 @@ mongoc_read_prefs_copy (const mongoc_read_prefs_t *read_prefs)
       bson_destroy (&ret->tags);
       bson_copy_to (&read_prefs->tags, &ret->tags);
       ret->max_staleness_seconds = read_prefs->max_staleness_seconds;
+      ret->hedge_delay_ms = read_prefs->hedge_delay_ms;
+      ret->hedge_percentile = read_prefs->hedge_percentile;
    }
 
    return ret;
 }
 
 
+/* true if reads with @read_prefs may be sent to a second server when the
+ * first is slow to answer */
+bool
+_mongoc_read_prefs_hedges (const mongoc_read_prefs_t *read_prefs)
+{
+   return read_prefs &&
+          (read_prefs->hedge_delay_ms > 0 || read_prefs->hedge_percentile > 0);
+}
+
+
 const char *
 _mongoc_read_mode_as_str (mongoc_read_mode_t mode)
 {
@@ -68,6 +68,16 @@ mongoc_read_prefs_get_max_staleness_seconds (
 MONGOC_EXPORT (void)
 mongoc_read_prefs_set_max_staleness_seconds (mongoc_read_prefs_t *read_prefs,
                                              int64_t max_staleness_seconds);
+MONGOC_EXPORT (int32_t)
+mongoc_read_prefs_get_hedge_delay_ms (const mongoc_read_prefs_t *read_prefs);
+MONGOC_EXPORT (void)
+mongoc_read_prefs_set_hedge_delay_ms (mongoc_read_prefs_t *read_prefs,
+                                      int32_t hedge_delay_ms);
+MONGOC_EXPORT (double)
+mongoc_read_prefs_get_hedge_percentile (const mongoc_read_prefs_t *read_prefs);
+MONGOC_EXPORT (void)
+mongoc_read_prefs_set_hedge_percentile (mongoc_read_prefs_t *read_prefs,
+                                        double hedge_percentile);
 MONGOC_EXPORT (bool)
 mongoc_read_prefs_is_valid (const mongoc_read_prefs_t *read_prefs);
 
@@ -34,6 +34,22 @@ struct _mongoc_cluster_t;
 
 BSON_BEGIN_DECLS
 
+/**
+ * mongoc_op_msg_flags_t:
+ * @MONGOC_MSG_CHECKSUM_PRESENT: The message ends with 4 bytes containing a
+ * CRC-32C checksum.
+ * @MONGOC_MSG_MORE_TO_COME: If set to 0, wait for a server response. If set to
+ * 1, do not expect a server response.
+ * @MONGOC_MSG_EXHAUST_ALLOWED: If set, allows multiple replies to this request
+ * using the moreToCome bit.
+ */
+typedef enum {
+   MONGOC_MSG_NONE = 0,
+   MONGOC_MSG_CHECKSUM_PRESENT = 1 << 0,
+   MONGOC_MSG_MORE_TO_COME = 1 << 1,
+   MONGOC_MSG_EXHAUST_ALLOWED = 1 << 16,
+} mongoc_op_msg_flags_t;
+
 typedef struct _mongoc_rpc_section_t {
    uint8_t payload_type;
    union {
@@ -45,6 +61,9 @@ typedef struct _mongoc_rpc_section_t {
          uint32_t size_le;
          const char *identifier;
          const uint8_t *bson_documents;
+         /* if set, the documents are gathered from iov instead */
+         const mongoc_iovec_t *iov;
+         size_t iovcnt;
       } sequence;
    } payload;
 } mongoc_rpc_section_t;
@@ -174,7 +193,7 @@ _mongoc_cmd_check_ok_no_wce (const bson_t *doc,
 bool
 _mongoc_rpc_decompress (mongoc_rpc_t *rpc_le, uint8_t *buf, size_t buflen);
 
-char *
+bool
 _mongoc_rpc_compress (struct _mongoc_cluster_t *cluster,
                       int32_t compressor_id,
                       mongoc_rpc_t *rpc_le,
@@ -125,6 +125,19 @@
                strlen (rpc->_name[_i].payload.sequence.identifier) + 1;       \
             header->msg_len += (int32_t) iov.iov_len;                         \
             _mongoc_array_append_val (array, iov);                            \
+            if (rpc->_name[_i].payload.sequence.iov) {                        \
+               size_t _j;                                                     \
+               BSON_ASSERT (rpc->_name[_i].payload.sequence.iovcnt);          \
+               for (_j = 0;                                                   \
+                    _j + 1 < rpc->_name[_i].payload.sequence.iovcnt;          \
+                    _j++) {                                                   \
+                  iov = rpc->_name[_i].payload.sequence.iov[_j];              \
+                  header->msg_len += (int32_t) iov.iov_len;                   \
+                  _mongoc_array_append_val (array, iov);                      \
+               }                                                              \
+               iov = rpc->_name[_i].payload.sequence.iov[_j];                 \
+               break;                                                         \
+            }                                                                 \
             iov.iov_base =                                                    \
                (void *) rpc->_name[_i].payload.sequence.bson_documents;       \
             iov.iov_len =                                                     \
@@ -357,6 +370,9 @@
             printf ("  Identifier: %s\n",                                   \
                     rpc->_name[_i].payload.sequence.identifier);            \
             printf ("  Size: %d\n", max);                                   \
+            if (!rpc->_name[_i].payload.sequence.bson_documents) {          \
+               continue;                                                    \
+            }                                                               \
             __r = bson_reader_new_from_data (                               \
                rpc->_name[_i].payload.sequence.bson_documents, max);        \
             while ((__b = bson_reader_read (__r, &__eof))) {                \
@@ -539,6 +555,8 @@
          section->payload.sequence.identifier = (const char *) section_buf; \
          section_buf += strlen ((const char *) section_buf) + 1;            \
          section->payload.sequence.bson_documents = section_buf;            \
+         section->payload.sequence.iov = NULL;                              \
+         section->payload.sequence.iovcnt = 0;                              \
       }                                                                     \
       buf += __l;                                                           \
       buflen -= __l;                                                        \
@@ -834,36 +852,38 @@ _mongoc_rpc_decompress (mongoc_rpc_t *rpc_le, uint8_t *buf, size_t buflen)
  *       compressed opcode based on the provided compressor_id.
  *       The in-place updated rpc struct remains little endian.
  *
+ *       The message body is compressed straight from cluster->iov into
+ *       cluster->compression_buffer, which is reused across messages, so
+ *       the uncompressed message is never linearized.
+ *
  * Side effects:
- *       Overwrites the RPC, and clears and overwrites the cluster buffer
- *       with the compressed results.
+ *       Overwrites the RPC, and clears and overwrites the cluster iovec
+ *       with the compressed results. The compressed message is valid
+ *       until the next call on @cluster.
  *
  *--------------------------------------------------------------------------
  */
 
-char *
+bool
 _mongoc_rpc_compress (struct _mongoc_cluster_t *cluster,
                       int32_t compressor_id,
                       mongoc_rpc_t *rpc_le,
                       bson_error_t *error)
 {
-   char *output;
-   size_t output_length = 0;
-   size_t allocate = BSON_UINT32_FROM_LE (rpc_le->header.msg_len) - 16;
-   char *data;
-   int size;
+   mongoc_buffer_t *buffer = &cluster->compression_buffer;
+   size_t size = BSON_UINT32_FROM_LE (rpc_le->header.msg_len) - 16;
+   size_t output_length;
    int32_t compression_level = -1;
 
    if (compressor_id == MONGOC_COMPRESSOR_ZLIB_ID) {
       compression_level = mongoc_uri_get_option_as_int32 (
          cluster->uri, MONGOC_URI_ZLIBCOMPRESSIONLEVEL, -1);
+   } else if (compressor_id == MONGOC_COMPRESSOR_ZSTD_ID) {
+      compression_level = mongoc_uri_get_option_as_int32 (
+         cluster->uri, MONGOC_URI_ZSTDCOMPRESSIONLEVEL, -1);
    }
 
-   BSON_ASSERT (allocate > 0);
-   data = bson_malloc0 (allocate);
-   size = _mongoc_cluster_buffer_iovec (
-      cluster->iov.data, cluster->iov.len, 16, data);
-   BSON_ASSERT (size);
+   BSON_ASSERT (size > 0);
 
    output_length =
       mongoc_compressor_max_compressed_length (compressor_id, size);
@@ -873,45 +893,47 @@ _mongoc_rpc_compress (struct _mongoc_cluster_t *cluster,
                       MONGOC_ERROR_COMMAND_INVALID_ARG,
                       "Could not determine compression bounds for %s",
                       mongoc_compressor_id_to_name (compressor_id));
-      bson_free (data);
-      return NULL;
+      return false;
    }
 
-   output = (char *) bson_malloc0 (output_length);
-   if (mongoc_compress (compressor_id,
-                        compression_level,
-                        data,
-                        size,
-                        output,
-                        &output_length)) {
-      rpc_le->header.msg_len = 0;
-      rpc_le->compressed.original_opcode =
-         BSON_UINT32_FROM_LE (rpc_le->header.opcode);
-      rpc_le->header.opcode = MONGOC_OPCODE_COMPRESSED;
-      rpc_le->header.request_id =
-         BSON_UINT32_FROM_LE (rpc_le->header.request_id);
-      rpc_le->header.response_to =
-         BSON_UINT32_FROM_LE (rpc_le->header.response_to);
-
-      rpc_le->compressed.uncompressed_size = size;
-      rpc_le->compressed.compressor_id = compressor_id;
-      rpc_le->compressed.compressed_message = (const uint8_t *) output;
-      rpc_le->compressed.compressed_message_len = output_length;
-      bson_free (data);
-
-
-      _mongoc_array_destroy (&cluster->iov);
-      _mongoc_array_init (&cluster->iov, sizeof (mongoc_iovec_t));
-      _mongoc_rpc_gather (rpc_le, &cluster->iov);
-      _mongoc_rpc_swab_to_le (rpc_le);
-      return output;
-   } else {
+   if (buffer->datalen < output_length) {
+      buffer->data = (uint8_t *) buffer->realloc_func (
+         buffer->data, output_length, buffer->realloc_data);
+      buffer->datalen = output_length;
+   }
+
+   if (!mongoc_compress_iovec (compressor_id,
+                               compression_level,
+                               (mongoc_iovec_t *) cluster->iov.data,
+                               cluster->iov.len,
+                               16,
+                               (char *) buffer->data,
+                               &output_length)) {
       MONGOC_WARNING ("Could not compress data with %s",
                       mongoc_compressor_id_to_name (compressor_id));
+      return false;
    }
-   bson_free (data);
-   bson_free (output);
-   return NULL;
+
+   buffer->len = output_length;
+
+   rpc_le->header.msg_len = 0;
+   rpc_le->compressed.original_opcode =
+      BSON_UINT32_FROM_LE (rpc_le->header.opcode);
+   rpc_le->header.opcode = MONGOC_OPCODE_COMPRESSED;
+   rpc_le->header.request_id = BSON_UINT32_FROM_LE (rpc_le->header.request_id);
+   rpc_le->header.response_to =
+      BSON_UINT32_FROM_LE (rpc_le->header.response_to);
+
+   rpc_le->compressed.uncompressed_size = size;
+   rpc_le->compressed.compressor_id = compressor_id;
+   rpc_le->compressed.compressed_message = buffer->data;
+   rpc_le->compressed.compressed_message_len = output_length;
+
+   _mongoc_array_clear (&cluster->iov);
+   _mongoc_rpc_gather (rpc_le, &cluster->iov);
+   _mongoc_rpc_swab_to_le (rpc_le);
+
+   return true;
 }
 
 /*
@@ -1000,11 +1022,21 @@ _mongoc_rpc_scatter_reply_header_only (mongoc_rpc_t *rpc,
 bool
 _mongoc_rpc_get_first_document (mongoc_rpc_t *rpc, bson_t *reply)
 {
+   int32_t len;
+
    if (rpc->header.opcode == MONGOC_OPCODE_REPLY &&
        _mongoc_rpc_reply_get_first (&rpc->reply, reply)) {
       return true;
    }
 
+   if (rpc->header.opcode == MONGOC_OPCODE_MSG && rpc->msg.n_sections > 0 &&
+       rpc->msg.sections[0].payload_type == 0) {
+      memcpy (&len, rpc->msg.sections[0].payload.bson_document, 4);
+      len = BSON_UINT32_FROM_LE (len);
+      return bson_init_static (
+         reply, rpc->msg.sections[0].payload.bson_document, (size_t) len);
+   }
+
    return false;
 }
 
@@ -411,6 +411,19 @@ _mongoc_scram_salt_password (mongoc_scram_t *scram,
    int k;
    uint8_t *output = scram->salted_password;
 
+   /* Hi() is PBKDF2 with one block of output. backends' own PBKDF2 reuse
+    * the HMAC key schedule for every iteration, unlike the loop below */
+   if (mongoc_crypto_pbkdf2 (&scram->crypto,
+                             password,
+                             password_len,
+                             salt,
+                             salt_len,
+                             iterations,
+                             (size_t) _scram_hash_size (scram),
+                             output)) {
+      return;
+   }
+
    memcpy (start_key, salt, salt_len);
 
    start_key[salt_len] = 0;
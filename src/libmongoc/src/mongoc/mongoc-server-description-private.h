@@ -43,6 +43,28 @@ typedef enum {
    MONGOC_SERVER_DESCRIPTION_TYPES,
 } mongoc_server_description_type_t;
 
+#define MONGOC_SERVER_LOAD_SAMPLES 64
+
+/* load signals for one server, used to balance reads and mongos traffic
+ * within the latency window. Shared by every copy of the server's
+ * description, so operations on all clients in a pool feed one set of
+ * counters, and updated without the topology mutex. */
+typedef struct _mongoc_server_load_t {
+   volatile int32_t refcount;
+   /* commands sent and not yet answered */
+   volatile int32_t in_flight;
+   /* moving average of command round trips, -1 before the first sample */
+   volatile int64_t latency_ewma_usec;
+   volatile int64_t last_sample_usec;
+   /* ring of recent command round trips, for latency percentiles */
+   volatile int32_t n_samples;
+   volatile int64_t samples_usec[MONGOC_SERVER_LOAD_SAMPLES];
+} mongoc_server_load_t;
+
+/* a server that has not been sampled this long is judged by its heartbeat
+ * round trip again, so one slow reply does not starve it forever */
+#define MONGOC_SERVER_LOAD_STALE_USEC (10 * 1000 * 1000)
+
 struct _mongoc_server_description_t {
    uint32_t id;
    mongoc_host_list_t host;
@@ -78,6 +100,8 @@ struct _mongoc_server_description_t {
    int64_t last_write_date_ms;
 
    bson_t compressors;
+
+   mongoc_server_load_t *load;
 };
 
 void
@@ -122,6 +146,21 @@ mongoc_server_description_handle_ismaster (mongoc_server_description_t *sd,
                                            int64_t rtt_msec,
                                            const bson_error_t *error /* IN */);
 
+void
+_mongoc_server_description_op_started (
+   const mongoc_server_description_t *sd);
+
+void
+_mongoc_server_description_op_finished (
+   const mongoc_server_description_t *sd, int64_t duration_usec);
+
+int64_t
+_mongoc_server_description_load_cost (const mongoc_server_description_t *sd);
+
+int64_t
+_mongoc_server_description_latency_percentile (
+   const mongoc_server_description_t *sd, double percentile);
+
 void
 mongoc_server_description_filter_stale (mongoc_server_description_t **sds,
                                         size_t sds_len,
@@ -15,6 +15,7 @@
  */
 
 #include "mongoc-config.h"
+#include "mongoc-atomic-private.h"
 #include "mongoc-host-list.h"
 #include "mongoc-host-list-private.h"
 #include "mongoc-read-prefs.h"
@@ -47,6 +48,10 @@ mongoc_server_description_cleanup (mongoc_server_description_t *sd)
    bson_destroy (&sd->arbiters);
    bson_destroy (&sd->tags);
    bson_destroy (&sd->compressors);
+
+   if (sd->load && bson_atomic_int_add (&sd->load->refcount, -1) == 0) {
+      bson_free (sd->load);
+   }
 }
 
 /* Reset fields inside this sd, but keep same id, host information, and RTT,
@@ -127,6 +132,9 @@ mongoc_server_description_init (mongoc_server_description_t *sd,
    }
 
    sd->connection_address = sd->host.host_and_port;
+   sd->load = (mongoc_server_load_t *) bson_malloc0 (sizeof *sd->load);
+   sd->load->refcount = 1;
+   sd->load->latency_ewma_usec = -1;
    bson_init (&sd->last_is_master);
    bson_init (&sd->hosts);
    bson_init (&sd->passives);
@@ -463,6 +471,152 @@ mongoc_server_description_update_rtt (mongoc_server_description_t *server,
 }
 
 
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_server_description_op_started --
+ * _mongoc_server_description_op_finished --
+ *
+ *       Count a command in flight to @sd's server, and when it completes
+ *       fold its round trip into the server's moving average latency.
+ *       The updates are atomic, so callers need not hold the topology
+ *       mutex.
+ *
+ *-------------------------------------------------------------------------
+ */
+void
+_mongoc_server_description_op_started (const mongoc_server_description_t *sd)
+{
+   if (sd->load) {
+      bson_atomic_int_add (&sd->load->in_flight, 1);
+   }
+}
+
+
+void
+_mongoc_server_description_op_finished (const mongoc_server_description_t *sd,
+                                        int64_t duration_usec)
+{
+   mongoc_server_load_t *load = sd->load;
+   int64_t old;
+   int64_t ewma;
+   uint32_t i;
+
+   if (!load) {
+      return;
+   }
+
+   bson_atomic_int_add (&load->in_flight, -1);
+
+   i = (uint32_t) bson_atomic_int_add (&load->n_samples, 1) - 1u;
+   _mongoc_atomic_int64_store (
+      &load->samples_usec[i % MONGOC_SERVER_LOAD_SAMPLES], duration_usec);
+
+   /* fold the sample in with compare-and-swap, so concurrent samples are
+    * not lost */
+   do {
+      old = _mongoc_atomic_int64_get (&load->latency_ewma_usec);
+      if (old == -1) {
+         ewma = duration_usec;
+      } else {
+         ewma = (int64_t) (ALPHA * duration_usec + (1 - ALPHA) * old);
+      }
+   } while (!_mongoc_atomic_int64_cas (&load->latency_ewma_usec, old, ewma));
+
+   _mongoc_atomic_int64_store (&load->last_sample_usec,
+                               bson_get_monotonic_time ());
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_server_description_load_cost --
+ *
+ *       The expected cost of sending one more command to @sd's server:
+ *       its average latency scaled by the commands already queued there.
+ *       Before any command completes, or once the average is stale, the
+ *       heartbeat round trip stands in for the latency.
+ *
+ *-------------------------------------------------------------------------
+ */
+int64_t
+_mongoc_server_description_load_cost (const mongoc_server_description_t *sd)
+{
+   int64_t latency_usec;
+   int32_t in_flight;
+
+   if (!sd->load) {
+      return 0;
+   }
+
+   latency_usec = _mongoc_atomic_int64_get (&sd->load->latency_ewma_usec);
+   if (latency_usec < 0 ||
+       bson_get_monotonic_time () -
+             _mongoc_atomic_int64_get (&sd->load->last_sample_usec) >
+          MONGOC_SERVER_LOAD_STALE_USEC) {
+      latency_usec = BSON_MAX (sd->round_trip_time_msec, 0) * 1000;
+   }
+
+   in_flight = BSON_MAX (sd->load->in_flight, 0);
+
+   return (in_flight + 1) * BSON_MAX (latency_usec, 1);
+}
+
+
+static int
+_mongoc_server_description_cmp_usec (const void *a, const void *b)
+{
+   int64_t x = *(const int64_t *) a;
+   int64_t y = *(const int64_t *) b;
+
+   return x < y ? -1 : x > y;
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_server_description_latency_percentile --
+ *
+ *       The @percentile (0 to 100) of the round trips of the last
+ *       MONGOC_SERVER_LOAD_SAMPLES commands sent to @sd's server.
+ *
+ * Returns:
+ *       Microseconds, or -1 if too few commands have completed to say.
+ *
+ *-------------------------------------------------------------------------
+ */
+int64_t
+_mongoc_server_description_latency_percentile (
+   const mongoc_server_description_t *sd, double percentile)
+{
+   int64_t samples[MONGOC_SERVER_LOAD_SAMPLES];
+   uint32_t n;
+   uint32_t i;
+
+   if (!sd->load) {
+      return -1;
+   }
+
+   n = (uint32_t) sd->load->n_samples;
+   if (n < MONGOC_SERVER_LOAD_SAMPLES / 4) {
+      return -1;
+   }
+
+   n = BSON_MIN (n, MONGOC_SERVER_LOAD_SAMPLES);
+   for (i = 0; i < n; i++) {
+      samples[i] = _mongoc_atomic_int64_get (&sd->load->samples_usec[i]);
+   }
+
+   qsort (samples, n, sizeof (int64_t), _mongoc_server_description_cmp_usec);
+
+   i = (uint32_t) (percentile * n / 100.0);
+
+   return samples[BSON_MIN (i, n - 1)];
+}
+
+
 static void
 _mongoc_server_description_set_error (mongoc_server_description_t *sd,
                                       const bson_error_t *error)
@@ -721,6 +875,10 @@ mongoc_server_description_new_copy (
    copy->round_trip_time_msec = -1;
 
    copy->connection_address = copy->host.host_and_port;
+   copy->load = description->load;
+   if (copy->load) {
+      bson_atomic_int_add (&copy->load->refcount, 1);
+   }
    bson_init (&copy->last_is_master);
    bson_init (&copy->hosts);
    bson_init (&copy->passives);
@@ -33,9 +33,20 @@ BSON_BEGIN_DECLS
 
 typedef struct _mongoc_server_stream_t {
    mongoc_topology_description_type_t topology_type;
-   mongoc_server_description_t *sd; /* owned */
-   bson_t cluster_time;             /* owned */
+   mongoc_server_description_t *sd; /* owned, unless snapshot is set */
+   /* owned, or a view of shared_cluster_time's document */
+   bson_t cluster_time;
    mongoc_stream_t *stream;         /* borrowed */
+   /* if set, the stream's connection was checked out of a shared pool and
+    * is returned to it when the last server stream using it is cleaned up */
+   struct _mongoc_cluster_t *cluster;
+   /* the leased node's lease generation, so a node that replaced it at the
+    * same address after a disconnect is not mistaken for it */
+   uint64_t lease_generation;
+   /* if set, a reference on the topology snapshot that sd belongs to */
+   struct _mongoc_topology_snapshot_t *snapshot;
+   /* if set, a reference on the clusterTime that cluster_time views */
+   struct _mongoc_topology_cluster_time_t *shared_cluster_time;
 } mongoc_server_stream_t;
 
 
@@ -44,6 +55,13 @@ mongoc_server_stream_new (const mongoc_topology_description_t *td,
                           mongoc_server_description_t *sd,
                           mongoc_stream_t *stream);
 
+mongoc_server_stream_t *
+_mongoc_server_stream_new_from_snapshot (
+   struct _mongoc_topology_snapshot_t *snapshot,
+   struct _mongoc_topology_cluster_time_t *cluster_time,
+   mongoc_server_description_t *sd,
+   mongoc_stream_t *stream);
+
 int32_t
 mongoc_server_stream_max_bson_obj_size (mongoc_server_stream_t *server_stream);
 
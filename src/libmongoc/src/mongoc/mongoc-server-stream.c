@@ -17,6 +17,7 @@
 
 #include "mongoc-cluster-private.h"
 #include "mongoc-server-stream-private.h"
+#include "mongoc-topology-private.h"
 #include "mongoc-util-private.h"
 
 #undef MONGOC_LOG_DOMAIN
@@ -37,6 +38,46 @@ mongoc_server_stream_new (const mongoc_topology_description_t *td,
    bson_copy_to (&td->cluster_time, &server_stream->cluster_time);
    server_stream->sd = sd;         /* becomes owned */
    server_stream->stream = stream; /* merely borrowed */
+   server_stream->cluster = NULL;
+   server_stream->lease_generation = 0;
+   server_stream->snapshot = NULL;
+   server_stream->shared_cluster_time = NULL;
+
+   return server_stream;
+}
+
+
+/* like mongoc_server_stream_new, but @sd is borrowed from @snapshot and the
+ * cluster time from @cluster_time, which may be NULL. their references
+ * become owned, nothing is copied */
+mongoc_server_stream_t *
+_mongoc_server_stream_new_from_snapshot (
+   mongoc_topology_snapshot_t *snapshot,
+   mongoc_topology_cluster_time_t *cluster_time,
+   mongoc_server_description_t *sd,
+   mongoc_stream_t *stream)
+{
+   mongoc_server_stream_t *server_stream;
+
+   BSON_ASSERT (sd);
+   BSON_ASSERT (stream);
+
+   server_stream = bson_malloc (sizeof (mongoc_server_stream_t));
+   server_stream->topology_type = snapshot->description.type;
+   if (cluster_time) {
+      BSON_ASSERT (bson_init_static (&server_stream->cluster_time,
+                                     bson_get_data (&cluster_time->doc),
+                                     cluster_time->doc.len));
+   } else {
+      bson_init (&server_stream->cluster_time);
+   }
+
+   server_stream->sd = sd;
+   server_stream->stream = stream;
+   server_stream->cluster = NULL;
+   server_stream->lease_generation = 0;
+   server_stream->snapshot = snapshot;
+   server_stream->shared_cluster_time = cluster_time;
 
    return server_stream;
 }
@@ -45,8 +86,20 @@ void
 mongoc_server_stream_cleanup (mongoc_server_stream_t *server_stream)
 {
    if (server_stream) {
-      mongoc_server_description_destroy (server_stream->sd);
+      if (server_stream->cluster) {
+         _mongoc_cluster_release_server_stream (server_stream->cluster,
+                                                server_stream);
+      }
+
+      if (server_stream->snapshot) {
+         _mongoc_topology_snapshot_release (server_stream->snapshot);
+      } else {
+         mongoc_server_description_destroy (server_stream->sd);
+      }
+
       bson_destroy (&server_stream->cluster_time);
+      _mongoc_topology_cluster_time_release (
+         server_stream->shared_cluster_time);
       bson_free (server_stream);
    }
 }
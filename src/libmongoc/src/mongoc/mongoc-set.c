@@ -71,8 +71,8 @@ mongoc_set_add (mongoc_set_t *set, uint32_t id, void *item)
    }
 }
 
-void
-mongoc_set_rm (mongoc_set_t *set, uint32_t id)
+static void
+_mongoc_set_rm (mongoc_set_t *set, uint32_t id, bool destroy)
 {
    mongoc_set_item_t *ptr;
    mongoc_set_item_t key;
@@ -84,7 +84,7 @@ mongoc_set_rm (mongoc_set_t *set, uint32_t id)
       &key, set->items, set->items_len, sizeof (key), mongoc_set_id_cmp);
 
    if (ptr) {
-      if (set->dtor) {
+      if (destroy && set->dtor) {
          set->dtor (ptr->item, set->dtor_ctx);
       }
 
@@ -100,6 +100,19 @@ mongoc_set_rm (mongoc_set_t *set, uint32_t id)
    }
 }
 
+void
+mongoc_set_rm (mongoc_set_t *set, uint32_t id)
+{
+   _mongoc_set_rm (set, id, true /* destroy */);
+}
+
+/* remove the item without calling the set's dtor on it */
+void
+mongoc_set_steal (mongoc_set_t *set, uint32_t id)
+{
+   _mongoc_set_rm (set, id, false /* destroy */);
+}
+
 void *
 mongoc_set_get (mongoc_set_t *set, uint32_t id)
 {
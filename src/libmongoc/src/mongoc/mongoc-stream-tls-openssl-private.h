@@ -24,6 +24,9 @@
 #ifdef MONGOC_ENABLE_SSL_OPENSSL
 #include <bson.h>
 
+#include "mongoc-openssl-private.h"
+#include "mongoc-stream.h"
+
 BSON_BEGIN_DECLS
 
 
@@ -36,9 +39,27 @@ typedef struct {
    BIO *bio;
    BIO_METHOD *meth;
    SSL_CTX *ctx;
+   /* if set, new sessions are cached under session_host */
+   mongoc_openssl_session_cache_t *session_cache;
+   char *session_host;
+   /* if set, the SSL reads and writes the socket directly instead of going
+    * through the BIO shim, and ktls_send is set once the kernel encrypts
+    * outgoing records */
+   bool socket_bio;
+   bool ktls_send;
 } mongoc_stream_tls_openssl_t;
 
 
+void
+_mongoc_stream_tls_openssl_set_session_cache (
+   mongoc_stream_t *stream,
+   mongoc_openssl_session_cache_t *cache,
+   const char *host);
+
+bool
+_mongoc_stream_tls_openssl_enable_ktls (mongoc_stream_t *stream);
+
+
 BSON_END_DECLS
 
 #endif /* MONGOC_ENABLE_SSL_OPENSSL */
@@ -35,6 +35,8 @@
 #include "mongoc-stream-tls-openssl-bio-private.h"
 #include "mongoc-stream-tls-openssl-private.h"
 #include "mongoc-openssl-private.h"
+#include "mongoc-socket-private.h"
+#include "mongoc-stream-socket.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-log.h"
 #include "mongoc-error.h"
@@ -45,6 +47,12 @@
 
 #define MONGOC_STREAM_TLS_OPENSSL_BUFFER_SIZE 4096
 
+/* kernel TLS needs Linux and an OpenSSL 3.0+ built with KTLS support */
+#if defined(__linux__) && defined(SSL_OP_ENABLE_KTLS) && \
+   !defined(OPENSSL_NO_KTLS)
+#define MONGOC_STREAM_TLS_OPENSSL_KTLS 1
+#endif
+
 #if OPENSSL_VERSION_NUMBER < 0x10100000L || defined(LIBRESSL_VERSION_NUMBER)
 static void
 BIO_meth_free (BIO_METHOD *meth)
@@ -93,6 +101,7 @@ _mongoc_stream_tls_openssl_destroy (mongoc_stream_t *stream)
    SSL_CTX_free (openssl->ctx);
    openssl->ctx = NULL;
 
+   bson_free (openssl->session_host);
    bson_free (openssl);
    bson_free (stream);
 
@@ -187,6 +196,55 @@ _mongoc_stream_tls_openssl_flush (mongoc_stream_t *stream)
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_stream_tls_openssl_wait --
+ *
+ *       With a socket BIO, OpenSSL sees the non-blocking socket directly
+ *       and asks to be retried. Poll the socket for the event the SSL is
+ *       waiting for, as the BIO shim does for us otherwise.
+ *
+ * Returns:
+ *       true if the SSL call can be retried, false if @expire passed or
+ *       the poll failed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_stream_tls_openssl_wait (mongoc_stream_tls_t *tls, int64_t expire)
+{
+   mongoc_stream_tls_openssl_t *openssl =
+      (mongoc_stream_tls_openssl_t *) tls->ctx;
+   mongoc_stream_poll_t poller;
+   int32_t timeout_msec = -1;
+   int64_t now;
+
+   if (expire) {
+      now = bson_get_monotonic_time ();
+
+      if ((expire - now) < 0) {
+         mongoc_counter_streams_timeout_inc ();
+#ifdef _WIN32
+         errno = WSAETIMEDOUT;
+#else
+         errno = ETIMEDOUT;
+#endif
+         return false;
+      }
+
+      timeout_msec = (int32_t) ((expire - now) / 1000L);
+   }
+
+   poller.stream = tls->base_stream;
+   poller.events = BIO_should_read (openssl->bio) ? POLLIN : POLLOUT;
+   poller.revents = 0;
+
+   return mongoc_stream_poll (&poller, 1, timeout_msec) > 0;
+}
+
+
 static ssize_t
 _mongoc_stream_tls_openssl_write (mongoc_stream_tls_t *tls,
                                   char *buf,
@@ -209,6 +267,15 @@ _mongoc_stream_tls_openssl_write (mongoc_stream_tls_t *tls,
 
    ret = BIO_write (openssl->bio, buf, buf_len);
 
+   while (ret <= 0 && openssl->socket_bio &&
+          BIO_should_retry (openssl->bio)) {
+      if (!_mongoc_stream_tls_openssl_wait (tls, expire)) {
+         break;
+      }
+
+      ret = BIO_write (openssl->bio, buf, buf_len);
+   }
+
    if (ret <= 0) {
       return ret;
    }
@@ -257,6 +324,8 @@ _mongoc_stream_tls_openssl_writev (mongoc_stream_t *stream,
                                    int32_t timeout_msec)
 {
    mongoc_stream_tls_t *tls = (mongoc_stream_tls_t *) stream;
+   mongoc_stream_tls_openssl_t *openssl =
+      (mongoc_stream_tls_openssl_t *) tls->ctx;
    char buf[MONGOC_STREAM_TLS_OPENSSL_BUFFER_SIZE];
    ssize_t ret = 0;
    ssize_t child_ret;
@@ -286,6 +355,12 @@ _mongoc_stream_tls_openssl_writev (mongoc_stream_t *stream,
    BSON_ASSERT (iovcnt);
    ENTRY;
 
+   if (openssl->ktls_send) {
+      /* the kernel encrypts, write the iovec to the socket as-is */
+      RETURN (
+         mongoc_stream_writev (tls->base_stream, iov, iovcnt, timeout_msec));
+   }
+
    tls->timeout_msec = timeout_msec;
 
    for (i = 0; i < iovcnt; i++) {
@@ -436,6 +511,15 @@ _mongoc_stream_tls_openssl_readv (mongoc_stream_t *stream,
                               (char *) iov[i].iov_base + iov_pos,
                               (int) (iov[i].iov_len - iov_pos));
 
+         if (read_ret <= 0 && openssl->socket_bio &&
+             BIO_should_retry (openssl->bio)) {
+            if (!_mongoc_stream_tls_openssl_wait (tls, expire)) {
+               RETURN (-1);
+            }
+
+            continue;
+         }
+
          /* https://www.openssl.org/docs/crypto/BIO_should_retry.html:
           *
           * If BIO_should_retry() returns false then the precise "error
@@ -560,6 +644,19 @@ mongoc_stream_tls_openssl_handshake (mongoc_stream_t *stream,
    if (BIO_do_handshake (openssl->bio) == 1) {
       if (_mongoc_openssl_check_cert (
              ssl, host, tls->ssl_opts.allow_invalid_hostname)) {
+         mongoc_counter_tls_handshakes_inc ();
+         if (SSL_session_reused (ssl)) {
+            mongoc_counter_tls_handshakes_resumed_inc ();
+         }
+
+#ifdef MONGOC_STREAM_TLS_OPENSSL_KTLS
+         if (openssl->socket_bio && BIO_get_ktls_send (SSL_get_wbio (ssl))) {
+            TRACE ("%s", "kernel TLS enabled for sending");
+            openssl->ktls_send = true;
+            mongoc_counter_tls_ktls_inc ();
+         }
+#endif
+
          RETURN (true);
       }
 
@@ -617,6 +714,130 @@ _mongoc_stream_tls_openssl_sni (SSL *ssl, int *ad, void *arg)
    return SSL_TLSEXT_ERR_OK;
 }
 
+/* OpenSSL calls this when the server issues a session, during the handshake
+ * or, with TLS 1.3, after it. returning 1 keeps the reference to @session */
+static int
+_mongoc_stream_tls_openssl_new_session (SSL *ssl, SSL_SESSION *session)
+{
+   mongoc_stream_tls_openssl_t *openssl;
+
+   openssl = (mongoc_stream_tls_openssl_t *) SSL_get_app_data (ssl);
+   if (!openssl || !openssl->session_cache) {
+      return 0;
+   }
+
+   _mongoc_openssl_session_cache_put (
+      openssl->session_cache, openssl->session_host, session);
+
+   return 1;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_stream_tls_openssl_set_session_cache --
+ *
+ *       Resume the session @cache holds for @host, if any, in the client
+ *       @stream's handshake, and cache sessions the server issues. Call
+ *       before the handshake. @cache must outlive @stream.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_stream_tls_openssl_set_session_cache (
+   mongoc_stream_t *stream,
+   mongoc_openssl_session_cache_t *cache,
+   const char *host)
+{
+   mongoc_stream_tls_t *tls = (mongoc_stream_tls_t *) stream;
+   mongoc_stream_tls_openssl_t *openssl =
+      (mongoc_stream_tls_openssl_t *) tls->ctx;
+   SSL *ssl;
+
+   BSON_ASSERT (cache);
+   BSON_ASSERT (host);
+
+   BIO_get_ssl (openssl->bio, &ssl);
+
+   openssl->session_cache = cache;
+   bson_free (openssl->session_host);
+   openssl->session_host = bson_strdup (host);
+
+   /* each stream has its own SSL_CTX, keep sessions in @cache instead */
+   SSL_set_app_data (ssl, openssl);
+   SSL_CTX_set_session_cache_mode (
+      openssl->ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+   SSL_CTX_sess_set_new_cb (openssl->ctx,
+                            _mongoc_stream_tls_openssl_new_session);
+
+   if (_mongoc_openssl_session_cache_apply (cache, host, ssl)) {
+      TRACE ("resuming TLS session with %s", host);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_stream_tls_openssl_enable_ktls --
+ *
+ *       Let the client @stream's SSL use the socket directly so OpenSSL
+ *       can hand record encryption to the kernel after the handshake.
+ *       Writes then go to the socket without a userspace copy. Reads
+ *       still go through SSL_read, which handles the control records the
+ *       kernel passes up. If the kernel refuses kTLS, OpenSSL encrypts as
+ *       usual over the same socket. Call before the handshake.
+ *
+ * Returns:
+ *       false if kTLS is not supported for @stream, which is unchanged.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_stream_tls_openssl_enable_ktls (mongoc_stream_t *stream)
+{
+#ifdef MONGOC_STREAM_TLS_OPENSSL_KTLS
+   mongoc_stream_tls_t *tls = (mongoc_stream_tls_t *) stream;
+   mongoc_stream_tls_openssl_t *openssl =
+      (mongoc_stream_tls_openssl_t *) tls->ctx;
+   mongoc_socket_t *sock;
+   SSL *ssl;
+   BIO *bio;
+
+   if (tls->base_stream->type != MONGOC_STREAM_SOCKET) {
+      return false;
+   }
+
+   sock = mongoc_stream_socket_get_socket (
+      (mongoc_stream_socket_t *) tls->base_stream);
+
+   bio = BIO_new_socket (sock->sd, BIO_NOCLOSE);
+   if (!bio) {
+      return false;
+   }
+
+   BIO_get_ssl (openssl->bio, &ssl);
+
+   /* the SSL owns @bio, the BIO shim stays in the chain unused */
+   SSL_set_bio (ssl, bio, bio);
+   SSL_set_options (ssl, SSL_OP_ENABLE_KTLS);
+
+   /* the socket may be closed before the SSL is freed, never send
+    * close_notify on a descriptor that could have been reused */
+   SSL_set_quiet_shutdown (ssl, 1);
+
+   openssl->socket_bio = true;
+
+   return true;
+#else
+   return false;
+#endif
+}
+
+
 static bool
 _mongoc_stream_tls_openssl_timed_out (mongoc_stream_t *stream)
 {
@@ -87,6 +87,14 @@ mongoc_topology_description_select (mongoc_topology_description_t *description,
                                     const mongoc_read_prefs_t *read_pref,
                                     int64_t local_threshold_ms);
 
+mongoc_server_description_t *
+_mongoc_topology_description_select_seeded (
+   mongoc_topology_description_t *description,
+   mongoc_ss_optype_t optype,
+   const mongoc_read_prefs_t *read_pref,
+   int64_t local_threshold_ms,
+   unsigned int *rand_seed);
+
 mongoc_server_description_t *
 mongoc_topology_description_server_by_id (
    mongoc_topology_description_t *description,
@@ -129,7 +137,7 @@ mongoc_topology_description_add_server (mongoc_topology_description_t *topology,
                                         const char *server,
                                         uint32_t *id /* OUT */);
 
-void
+bool
 mongoc_topology_description_update_cluster_time (
    mongoc_topology_description_t *td, const bson_t *reply);
 
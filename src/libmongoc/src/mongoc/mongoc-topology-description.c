@@ -768,7 +768,9 @@ mongoc_topology_description_has_data_node (mongoc_topology_description_t *td)
  * mongoc_topology_description_select --
  *
  *      Return a server description of a node that is appropriate for
- *      the given read preference and operation type.
+ *      the given read preference and operation type. Among suitable
+ *      servers in the latency window, prefer the less loaded of two
+ *      chosen at random (see _mongoc_server_description_load_cost).
  *
  *      NOTE: this method simply attempts to select a server from the
  *      current topology, it does not retry or trigger topology checks.
@@ -790,10 +792,40 @@ mongoc_topology_description_select (mongoc_topology_description_t *topology,
                                     mongoc_ss_optype_t optype,
                                     const mongoc_read_prefs_t *read_pref,
                                     int64_t local_threshold_ms)
+{
+   return _mongoc_topology_description_select_seeded (topology,
+                                                      optype,
+                                                      read_pref,
+                                                      local_threshold_ms,
+                                                      &topology->rand_seed);
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_description_select_seeded --
+ *
+ *      Like mongoc_topology_description_select, but draw the random choice
+ *      among suitable servers from @rand_seed instead of @topology's seed,
+ *      so that @topology is not modified. Used to select from a snapshot
+ *      that other threads are reading.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+mongoc_server_description_t *
+_mongoc_topology_description_select_seeded (
+   mongoc_topology_description_t *topology,
+   mongoc_ss_optype_t optype,
+   const mongoc_read_prefs_t *read_pref,
+   int64_t local_threshold_ms,
+   unsigned int *rand_seed)
 {
    mongoc_array_t suitable_servers;
    mongoc_server_description_t *sd = NULL;
-   int rand_n;
+   mongoc_server_description_t *other;
+   size_t i, j;
 
    ENTRY;
 
@@ -814,11 +846,29 @@ mongoc_topology_description_select (mongoc_topology_description_t *topology,
 
    mongoc_topology_description_suitable_servers (
       &suitable_servers, optype, topology, read_pref, local_threshold_ms);
-   if (suitable_servers.len != 0) {
-      rand_n = _mongoc_rand_simple (&topology->rand_seed);
-      sd = _mongoc_array_index (&suitable_servers,
-                                mongoc_server_description_t *,
-                                rand_n % suitable_servers.len);
+   if (suitable_servers.len == 1) {
+      sd = _mongoc_array_index (
+         &suitable_servers, mongoc_server_description_t *, 0);
+   } else if (suitable_servers.len > 1) {
+      /* power of two choices: of two distinct random candidates, take the
+       * one with less expected load. this avoids a slow or busy server
+       * without herding every client onto the single least loaded one. */
+      i = (size_t) _mongoc_rand_simple (rand_seed) % suitable_servers.len;
+      j = (size_t) _mongoc_rand_simple (rand_seed) %
+          (suitable_servers.len - 1);
+      if (j >= i) {
+         j++;
+      }
+
+      sd = _mongoc_array_index (
+         &suitable_servers, mongoc_server_description_t *, i);
+      other = _mongoc_array_index (
+         &suitable_servers, mongoc_server_description_t *, j);
+
+      if (_mongoc_server_description_load_cost (other) <
+          _mongoc_server_description_load_cost (sd)) {
+         sd = other;
+      }
    }
 
    _mongoc_array_destroy (&suitable_servers);
@@ -1213,10 +1263,12 @@ mongoc_topology_description_add_server (mongoc_topology_description_t *topology,
  *  include both the timestamp and the increment of the BsonTimestamp in the
  *  comparison). The signature field does not participate in the comparison.
  *
+ *  Returns true if @td's clusterTime was advanced.
+ *
  *--------------------------------------------------------------------------
  */
 
-void
+bool
 mongoc_topology_description_update_cluster_time (
    mongoc_topology_description_t *td, const bson_t *reply)
 {
@@ -1227,13 +1279,13 @@ mongoc_topology_description_update_cluster_time (
    bson_t cluster_time;
 
    if (!reply || !bson_iter_init_find (&iter, reply, "$clusterTime")) {
-      return;
+      return false;
    }
 
    if (!BSON_ITER_HOLDS_DOCUMENT (&iter) ||
        !bson_iter_recurse (&iter, &child)) {
       MONGOC_ERROR ("Can't parse $clusterTime");
-      return;
+      return false;
    }
 
    bson_iter_document (&iter, &size, &data);
@@ -1243,7 +1295,10 @@ mongoc_topology_description_update_cluster_time (
        _mongoc_cluster_time_greater (&cluster_time, &td->cluster_time)) {
       bson_destroy (&td->cluster_time);
       bson_copy_to (&cluster_time, &td->cluster_time);
+      return true;
    }
+
+   return false;
 }
 
 
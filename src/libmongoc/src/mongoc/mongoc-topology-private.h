@@ -17,12 +17,14 @@
 #ifndef MONGOC_TOPOLOGY_PRIVATE_H
 #define MONGOC_TOPOLOGY_PRIVATE_H
 
+#include "mongoc-array-private.h"
 #include "mongoc-topology-scanner-private.h"
 #include "mongoc-server-description-private.h"
 #include "mongoc-topology-description-private.h"
 #include "mongoc-thread-private.h"
 #include "mongoc-uri.h"
 #include "mongoc-client-session-private.h"
+#include "mongoc-scram-private.h"
 
 #define MONGOC_TOPOLOGY_MIN_HEARTBEAT_FREQUENCY_MS 500
 #define MONGOC_TOPOLOGY_SOCKET_CHECK_INTERVAL_MS 5000
@@ -39,6 +41,36 @@ typedef enum {
    MONGOC_TOPOLOGY_SCANNER_SINGLE_THREADED,
 } mongoc_topology_scanner_state_t;
 
+/* an immutable copy of a pooled topology's description. operations read
+ * the latest one without any lock; the SDAM updater replaces it, under the
+ * topology mutex, whenever the description changes. it has no clusterTime,
+ * which advances with nearly every reply and is shared separately */
+typedef struct _mongoc_topology_snapshot_t {
+   volatile int32_t refcount;
+   mongoc_topology_description_t description;
+   /* scanner node timestamps, parallel to description.servers's items */
+   int64_t *timestamps;
+   /* monotonic time the snapshot was published */
+   int64_t published;
+} mongoc_topology_snapshot_t;
+
+/* an immutable copy of a pooled topology's clusterTime, which server
+ * streams borrow to gossip */
+typedef struct _mongoc_topology_cluster_time_t {
+   volatile int32_t refcount;
+   bson_t doc;
+} mongoc_topology_cluster_time_t;
+
+/* threads loading the latest snapshot or clusterTime spread over this many
+ * counters, each on its own cache line */
+#define MONGOC_TOPOLOGY_READER_SLOTS 16
+
+typedef struct {
+   /* threads between loading a shared pointer and taking a reference */
+   volatile int32_t n;
+   char pad[64 - sizeof (int32_t)];
+} mongoc_topology_reader_slot_t;
+
 typedef struct _mongoc_topology_t {
    mongoc_topology_description_t description;
    mongoc_uri_t *uri;
@@ -63,7 +95,28 @@ typedef struct _mongoc_topology_t {
    bool single_threaded;
    bool stale;
 
+   /* the highest clusterTime seen, as (timestamp << 32) | increment, or 0.
+    * set under the mutex and read without it */
+   volatile int64_t cluster_time;
+
    mongoc_server_session_t *session_pool;
+
+   /* SCRAM secrets from the last authentication by any of the topology's
+    * clients, so each connection need not derive them again */
+   mongoc_scram_cache_t *scram_cache;
+   /* description.session_timeout_minutes as of the latest snapshot, which
+    * clients read without the mutex, if not single-threaded */
+   volatile int32_t session_timeout_minutes;
+
+   /* the latest snapshot of description and of its clusterTime, if not
+    * single-threaded. replaced under the mutex, read with no lock */
+   mongoc_topology_snapshot_t *volatile snapshot;
+   mongoc_topology_cluster_time_t *volatile shared_cluster_time;
+   mongoc_topology_reader_slot_t readers[MONGOC_TOPOLOGY_READER_SLOTS];
+   /* replaced snapshots and clusterTimes the topology still holds a
+    * reference on, since a reader may have loaded them but not yet taken
+    * its own. guarded by the mutex */
+   mongoc_array_t retired;
 } mongoc_topology_t;
 
 mongoc_topology_t *
@@ -91,12 +144,24 @@ mongoc_topology_select (mongoc_topology_t *topology,
                         const mongoc_read_prefs_t *read_prefs,
                         bson_error_t *error);
 
+uint32_t
+_mongoc_topology_select_hedge (mongoc_topology_t *topology,
+                               const mongoc_read_prefs_t *read_prefs,
+                               uint32_t server_id);
+
 uint32_t
 mongoc_topology_select_server_id (mongoc_topology_t *topology,
                                   mongoc_ss_optype_t optype,
                                   const mongoc_read_prefs_t *read_prefs,
                                   bson_error_t *error);
 
+uint32_t
+_mongoc_topology_select_server_id (mongoc_topology_t *topology,
+                                   mongoc_ss_optype_t optype,
+                                   const mongoc_read_prefs_t *read_prefs,
+                                   int64_t deadline,
+                                   bson_error_t *error);
+
 mongoc_server_description_t *
 mongoc_topology_server_by_id (mongoc_topology_t *topology,
                               uint32_t id,
@@ -136,14 +201,28 @@ void
 _mongoc_topology_update_cluster_time (mongoc_topology_t *topology,
                                       const bson_t *reply);
 
-mongoc_server_session_t *
+bool
 _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
+                                     mongoc_server_session_t **server_session,
                                      bson_error_t *error);
 
 void
 _mongoc_topology_push_server_session (mongoc_topology_t *topology,
                                       mongoc_server_session_t *server_session);
 
+int64_t
+_mongoc_topology_session_timeout_minutes (mongoc_topology_t *topology);
+
+#ifdef MONGOC_ENABLE_CRYPTO
+void
+_mongoc_topology_apply_scram_cache (mongoc_topology_t *topology,
+                                    mongoc_scram_t *scram);
+
+void
+_mongoc_topology_update_scram_cache (mongoc_topology_t *topology,
+                                     mongoc_scram_t *scram);
+#endif
+
 bool
 _mongoc_topology_end_sessions_cmd (mongoc_topology_t *topology, bson_t *cmd);
 
@@ -154,4 +233,22 @@ const bson_t *
 _mongoc_topology_get_ismaster (mongoc_topology_t *topology);
 void
 _mongoc_topology_request_scan (mongoc_topology_t *topology);
+
+void
+_mongoc_topology_publish_snapshot (mongoc_topology_t *topology);
+
+mongoc_topology_snapshot_t *
+_mongoc_topology_snapshot_acquire (
+   mongoc_topology_t *topology, mongoc_topology_cluster_time_t **cluster_time);
+
+void
+_mongoc_topology_snapshot_release (mongoc_topology_snapshot_t *snapshot);
+
+void
+_mongoc_topology_cluster_time_release (
+   mongoc_topology_cluster_time_t *cluster_time);
+
+int64_t
+_mongoc_topology_snapshot_server_timestamp (
+   const mongoc_topology_snapshot_t *snapshot, uint32_t id);
 #endif
@@ -34,6 +34,10 @@
 #include "mongoc-ssl.h"
 #endif
 
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+#include "mongoc-openssl-private.h"
+#endif
+
 BSON_BEGIN_DECLS
 
 typedef void (*mongoc_topology_scanner_setup_err_cb_t) (
@@ -49,6 +53,19 @@ typedef void (*mongoc_topology_scanner_cb_t) (
 struct mongoc_topology_scanner;
 struct mongoc_topology_scanner_node;
 
+/* the reply a hedged read that lost still owes on a connection. it is read
+ * before the connection is used again or returned, and any cursor it opened
+ * is killed under the read's session */
+typedef struct _mongoc_orphan_reply_t {
+   /* the read's request id, 0 if none */
+   uint32_t request_id;
+   /* the read's lsid, or NULL */
+   bson_t *lsid;
+   /* to describe errors reading the reply */
+   char *db_name;
+   char *command_name;
+} mongoc_orphan_reply_t;
+
 typedef struct mongoc_topology_scanner_node {
    uint32_t id;
    /* after scanning, this is set to the successful stream if one exists. */
@@ -67,6 +84,10 @@ typedef struct mongoc_topology_scanner_node {
    bool retired;
    bson_error_t last_error;
 
+   /* like mongoc_cluster_node_t's, for single-threaded clients' hedged
+    * reads */
+   mongoc_orphan_reply_t orphan;
+
    /* the hostname for a node may resolve to multiple DNS results.
     * dns_results has the full list of DNS results, ordered by host preference.
     * successful_dns_result is the most recent successful DNS result.
@@ -104,6 +125,12 @@ typedef struct mongoc_topology_scanner {
    mongoc_ssl_opt_t *ssl_opts;
 #endif
 
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+   /* TLS sessions to resume, for monitors and the topology's clients, if
+    * the sslSessionCache URI option is set */
+   mongoc_openssl_session_cache_t *tls_session_cache;
+#endif
+
    mongoc_apm_callbacks_t apm_callbacks;
    void *apm_context;
    int64_t dns_cache_timeout_ms;
@@ -140,6 +167,9 @@ void
 mongoc_topology_scanner_node_disconnect (mongoc_topology_scanner_node_t *node,
                                          bool failed);
 
+void
+_mongoc_orphan_reply_clear (mongoc_orphan_reply_t *orphan);
+
 void
 mongoc_topology_scanner_node_destroy (mongoc_topology_scanner_node_t *node,
                                       bool failed);
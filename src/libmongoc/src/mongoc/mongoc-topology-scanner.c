@@ -31,6 +31,10 @@
 #include "mongoc-stream-tls.h"
 #endif
 
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+#include "mongoc-stream-tls-openssl-private.h"
+#endif
+
 #include "mongoc-counters-private.h"
 #include "utlist.h"
 #include "mongoc-topology-private.h"
@@ -205,6 +209,7 @@ _begin_ismaster_cmd (mongoc_topology_scanner_node_t *node,
                          node->host.host,
                          "admin",
                          &cmd,
+                         MONGOC_OPCODE_QUERY,
                          &_async_handler,
                          node,
                          ts->connect_timeout_msec);
@@ -241,6 +246,13 @@ mongoc_topology_scanner_new (
    /* may be overridden for testing. */
    ts->dns_cache_timeout_ms = DNS_CACHE_TIMEOUT_MS;
 
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+   if (uri &&
+       mongoc_uri_get_option_as_bool (uri, MONGOC_URI_SSLSESSIONCACHE, false)) {
+      ts->tls_session_cache = _mongoc_openssl_session_cache_new ();
+   }
+#endif
+
    return ts;
 }
 
@@ -282,6 +294,10 @@ mongoc_topology_scanner_destroy (mongoc_topology_scanner_t *ts)
    /* This field can be set by a mongoc_client */
    bson_free ((char *) ts->appname);
 
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+   _mongoc_openssl_session_cache_destroy (ts->tls_session_cache);
+#endif
+
    bson_free (ts);
 }
 
@@ -349,12 +365,24 @@ mongoc_topology_scanner_node_disconnect (mongoc_topology_scanner_node_t *node,
       }
 
       node->stream = NULL;
+      _mongoc_orphan_reply_clear (&node->orphan);
       memset (
          &node->sasl_supported_mechs, 0, sizeof (node->sasl_supported_mechs));
       node->negotiated_sasl_supported_mechs = false;
    }
 }
 
+/* forget a hedged read's late reply, once it was read or its connection
+ * closed */
+void
+_mongoc_orphan_reply_clear (mongoc_orphan_reply_t *orphan)
+{
+   bson_destroy (orphan->lsid);
+   bson_free (orphan->db_name);
+   bson_free (orphan->command_name);
+   memset (orphan, 0, sizeof *orphan);
+}
+
 void
 mongoc_topology_scanner_node_destroy (mongoc_topology_scanner_node_t *node,
                                       bool failed)
@@ -583,6 +611,14 @@ _mongoc_topology_scanner_node_setup_stream_for_tls (
          mongoc_stream_destroy (stream);
          return NULL;
       } else {
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+         if (node->ts->tls_session_cache) {
+            _mongoc_stream_tls_openssl_set_session_cache (
+               tls_stream,
+               node->ts->tls_session_cache,
+               node->host.host_and_port);
+         }
+#endif
          return tls_stream;
       }
    }
@@ -776,6 +812,12 @@ mongoc_topology_scanner_node_setup (mongoc_topology_scanner_node_t *node,
 
    _mongoc_topology_scanner_monitor_heartbeat_started (node->ts, &node->host);
 
+   /* a hedged read's late reply is due on the stream, which a check of the
+    * server can't share: reconnect */
+   if (node->stream && node->orphan.request_id) {
+      mongoc_topology_scanner_node_disconnect (node, false);
+   }
+
    /* if there is already a working stream, push it back to be re-scanned. */
    if (node->stream) {
       _begin_ismaster_cmd (
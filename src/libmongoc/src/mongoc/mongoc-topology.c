@@ -21,6 +21,7 @@
 
 #include "mongoc-error.h"
 #include "mongoc-log.h"
+#include "mongoc-atomic-private.h"
 #include "mongoc-topology-private.h"
 #include "mongoc-topology-description-apm-private.h"
 #include "mongoc-client-private.h"
@@ -30,9 +31,18 @@
 
 #include "utlist.h"
 
+/* a replaced snapshot or clusterTime awaiting _mongoc_topology_reclaim */
+typedef struct {
+   void *item;
+   void (*release) (void *item);
+} mongoc_topology_retired_t;
+
 static void
 _mongoc_topology_background_thread_stop (mongoc_topology_t *topology);
 
+static void
+_mongoc_topology_reclaim (mongoc_topology_t *topology, bool force);
+
 static bool
 _mongoc_topology_reconcile_add_nodes (mongoc_server_description_t *sd,
                                       mongoc_topology_t *topology)
@@ -123,6 +133,8 @@ _mongoc_topology_scanner_setup_err_cb (uint32_t id,
                                                 NULL /* ismaster reply */,
                                                 -1 /* rtt_msec */,
                                                 error);
+
+   _mongoc_topology_publish_snapshot (topology);
 }
 
 
@@ -180,6 +192,7 @@ _mongoc_topology_scanner_cb (uint32_t id,
       mongoc_cond_broadcast (&topology->cond_client);
    }
 
+   _mongoc_topology_publish_snapshot (topology);
    mongoc_mutex_unlock (&topology->mutex);
 }
 
@@ -279,6 +292,7 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
                                    topology->connect_timeout_msec);
 
    mongoc_mutex_init (&topology->mutex);
+   _mongoc_array_init (&topology->retired, sizeof (mongoc_topology_retired_t));
    mongoc_cond_init (&topology->cond_client);
    mongoc_cond_init (&topology->cond_server);
 
@@ -330,6 +344,7 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
 
    if (!topology_valid) {
       /* add no nodes */
+      _mongoc_topology_publish_snapshot (topology);
       return topology;
    }
 
@@ -341,6 +356,8 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
       hl = hl->next;
    }
 
+   _mongoc_topology_publish_snapshot (topology);
+
    return topology;
 }
 /*
@@ -404,6 +421,11 @@ mongoc_topology_destroy (mongoc_topology_t *topology)
    _mongoc_topology_description_monitor_closed (&topology->description);
 
    mongoc_uri_destroy (topology->uri);
+   _mongoc_topology_snapshot_release (topology->snapshot);
+   _mongoc_topology_cluster_time_release (topology->shared_cluster_time);
+   /* the background thread is stopped and no client is left to read */
+   _mongoc_topology_reclaim (topology, true);
+   _mongoc_array_destroy (&topology->retired);
    mongoc_topology_description_destroy (&topology->description);
    mongoc_topology_scanner_destroy (topology->scanner);
 
@@ -413,6 +435,12 @@ mongoc_topology_destroy (mongoc_topology_t *topology)
       _mongoc_server_session_destroy (ss);
    }
 
+#ifdef MONGOC_ENABLE_CRYPTO
+   if (topology->scram_cache) {
+      _mongoc_scram_cache_destroy (topology->scram_cache);
+   }
+#endif
+
    mongoc_cond_destroy (&topology->cond_client);
    mongoc_cond_destroy (&topology->cond_server);
    mongoc_mutex_destroy (&topology->mutex);
@@ -444,6 +472,9 @@ mongoc_topology_scan_once (mongoc_topology_t *topology, bool obey_cooldown)
    mongoc_topology_reconcile (topology);
    mongoc_topology_scanner_start (topology->scanner, obey_cooldown);
 
+   /* starting the scan may have reconnected scanner nodes */
+   _mongoc_topology_publish_snapshot (topology);
+
    /* scanning locks and unlocks the mutex itself until the scan is done */
    mongoc_mutex_unlock (&topology->mutex);
    mongoc_topology_scanner_work (topology->scanner);
@@ -557,6 +588,461 @@ _mongoc_server_selection_error (const char *msg,
    }
 }
 
+/* the reader counter for the calling thread. threads' stacks are far
+ * apart, so hashing a stack address spreads them over the slots */
+static volatile int32_t *
+_mongoc_topology_reader_slot (mongoc_topology_t *topology)
+{
+   uint32_t h;
+
+   h = (uint32_t) ((uintptr_t) &topology >> 12) * 2654435761u;
+
+   return &topology->readers[(h >> 16) % MONGOC_TOPOLOGY_READER_SLOTS].n;
+}
+
+
+static void
+_mongoc_topology_retire (mongoc_topology_t *topology,
+                         void *item,
+                         void (*release) (void *))
+{
+   mongoc_topology_retired_t retired;
+
+   if (item) {
+      retired.item = item;
+      retired.release = release;
+      _mongoc_array_append_val (&topology->retired, retired);
+   }
+}
+
+
+/* drop the topology's references on replaced snapshots and clusterTimes,
+ * once no reader can be about to take a reference on one: readers that
+ * start now load the new pointers. if a reader is in the way, try again at
+ * the next publish rather than wait. called with the mutex locked */
+static void
+_mongoc_topology_reclaim (mongoc_topology_t *topology, bool force)
+{
+   mongoc_topology_retired_t *retired;
+   size_t i;
+
+   if (!topology->retired.len) {
+      return;
+   }
+
+   for (i = 0; !force && i < MONGOC_TOPOLOGY_READER_SLOTS; i++) {
+      if (bson_atomic_int_add (&topology->readers[i].n, 0)) {
+         return;
+      }
+   }
+
+   retired = (mongoc_topology_retired_t *) topology->retired.data;
+   for (i = 0; i < topology->retired.len; i++) {
+      retired[i].release (retired[i].item);
+   }
+
+   topology->retired.len = 0;
+}
+
+
+static void
+_mongoc_topology_snapshot_release_item (void *item)
+{
+   _mongoc_topology_snapshot_release ((mongoc_topology_snapshot_t *) item);
+}
+
+
+static void
+_mongoc_topology_cluster_time_release_item (void *item)
+{
+   _mongoc_topology_cluster_time_release (
+      (mongoc_topology_cluster_time_t *) item);
+}
+
+
+/* make description.cluster_time, which ismaster replies also advance,
+ * available to server streams made from a snapshot */
+static void
+_mongoc_topology_share_cluster_time (mongoc_topology_t *topology)
+{
+   mongoc_topology_cluster_time_t *cluster_time;
+   mongoc_topology_cluster_time_t *old;
+
+   /* only publishers replace it, so it can be read unguarded */
+   old = topology->shared_cluster_time;
+   if (topology->single_threaded ||
+       (old ? bson_equal (&topology->description.cluster_time, &old->doc)
+            : bson_empty (&topology->description.cluster_time))) {
+      return;
+   }
+
+   cluster_time = (mongoc_topology_cluster_time_t *) bson_malloc (
+      sizeof *cluster_time);
+   cluster_time->refcount = 1;
+   bson_copy_to (&topology->description.cluster_time, &cluster_time->doc);
+
+   old = (mongoc_topology_cluster_time_t *) _mongoc_atomic_ptr_exchange (
+      (void *volatile *) &topology->shared_cluster_time, cluster_time);
+   _mongoc_topology_retire (
+      topology, old, _mongoc_topology_cluster_time_release_item);
+   _mongoc_topology_reclaim (topology, false);
+}
+
+
+static bool
+_mongoc_topology_server_changed (const mongoc_server_description_t *old,
+                                 const mongoc_server_description_t *sd)
+{
+   /* round trip times and staleness inputs change with every heartbeat and
+    * are checked against the snapshot's age instead */
+   return old->type != sd->type || old->has_is_master != sd->has_is_master ||
+          old->error.code != sd->error.code ||
+          old->min_wire_version != sd->min_wire_version ||
+          old->max_wire_version != sd->max_wire_version ||
+          old->max_msg_size != sd->max_msg_size ||
+          old->max_bson_obj_size != sd->max_bson_obj_size ||
+          old->max_write_batch_size != sd->max_write_batch_size ||
+          old->session_timeout_minutes != sd->session_timeout_minutes ||
+          old->set_version != sd->set_version ||
+          !bson_oid_equal (&old->election_id, &sd->election_id) ||
+          !!old->set_name != !!sd->set_name ||
+          (sd->set_name && strcmp (old->set_name, sd->set_name)) ||
+          !!old->me != !!sd->me || (sd->me && strcmp (old->me, sd->me)) ||
+          !!old->current_primary != !!sd->current_primary ||
+          (sd->current_primary &&
+           strcmp (old->current_primary, sd->current_primary)) ||
+          !bson_equal (&old->hosts, &sd->hosts) ||
+          !bson_equal (&old->passives, &sd->passives) ||
+          !bson_equal (&old->arbiters, &sd->arbiters) ||
+          !bson_equal (&old->tags, &sd->tags) ||
+          !bson_equal (&old->compressors, &sd->compressors);
+}
+
+
+/* whether @snapshot still describes @topology well enough for operations:
+ * nothing they use has changed, and its round trip times and staleness
+ * figures are no older than one heartbeat */
+static bool
+_mongoc_topology_snapshot_is_current (
+   mongoc_topology_t *topology, const mongoc_topology_snapshot_t *snapshot)
+{
+   const mongoc_topology_description_t *td = &topology->description;
+   const mongoc_topology_description_t *old = &snapshot->description;
+   mongoc_topology_scanner_node_t *node;
+   size_t i;
+
+   if (bson_get_monotonic_time () - snapshot->published >=
+       td->heartbeat_msec * 1000) {
+      return false;
+   }
+
+   if (old->type != td->type || old->stale != td->stale ||
+       old->max_set_version != td->max_set_version ||
+       old->session_timeout_minutes != td->session_timeout_minutes ||
+       old->compatibility_error.code != td->compatibility_error.code ||
+       !bson_oid_equal (&old->max_election_id, &td->max_election_id) ||
+       !!old->set_name != !!td->set_name ||
+       (td->set_name && strcmp (old->set_name, td->set_name)) ||
+       old->servers->items_len != td->servers->items_len) {
+      return false;
+   }
+
+   for (i = 0; i < td->servers->items_len; i++) {
+      if (old->servers->items[i].id != td->servers->items[i].id ||
+          _mongoc_topology_server_changed (
+             (mongoc_server_description_t *) old->servers->items[i].item,
+             (mongoc_server_description_t *) td->servers->items[i].item)) {
+         return false;
+      }
+
+      node = mongoc_topology_scanner_get_node (topology->scanner,
+                                               td->servers->items[i].id);
+      if (snapshot->timestamps[i] != (node ? node->timestamp : -1)) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_publish_snapshot --
+ *
+ *       Replace a pooled topology's snapshot with a copy of its current
+ *       description, unless nothing operations use has changed. Call
+ *       after every change to the description.
+ *
+ *       NOTE: this method expects @topology's mutex to be locked on entry,
+ *       which serializes publishers.
+ *
+ *-------------------------------------------------------------------------
+ */
+void
+_mongoc_topology_publish_snapshot (mongoc_topology_t *topology)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_topology_snapshot_t *old;
+   mongoc_topology_scanner_node_t *node;
+   mongoc_set_t *servers;
+   size_t i;
+
+   if (topology->single_threaded) {
+      return;
+   }
+
+   topology->session_timeout_minutes =
+      (int32_t) topology->description.session_timeout_minutes;
+   _mongoc_topology_share_cluster_time (topology);
+
+   /* only publishers replace the snapshot, so it can be read unguarded */
+   if (topology->snapshot &&
+       _mongoc_topology_snapshot_is_current (topology, topology->snapshot)) {
+      return;
+   }
+
+   snapshot = (mongoc_topology_snapshot_t *) bson_malloc0 (sizeof *snapshot);
+   snapshot->refcount = 1;
+   _mongoc_topology_description_copy_to (&topology->description,
+                                         &snapshot->description);
+   bson_reinit (&snapshot->description.cluster_time);
+   snapshot->published = bson_get_monotonic_time ();
+
+   servers = snapshot->description.servers;
+   snapshot->timestamps =
+      (int64_t *) bson_malloc0 ((servers->items_len + 1) * sizeof (int64_t));
+   for (i = 0; i < servers->items_len; i++) {
+      node = mongoc_topology_scanner_get_node (topology->scanner,
+                                               servers->items[i].id);
+      snapshot->timestamps[i] = node ? node->timestamp : -1;
+   }
+
+   old = (mongoc_topology_snapshot_t *) _mongoc_atomic_ptr_exchange (
+      (void *volatile *) &topology->snapshot, snapshot);
+   _mongoc_topology_retire (
+      topology, old, _mongoc_topology_snapshot_release_item);
+   _mongoc_topology_reclaim (topology, false);
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_snapshot_acquire --
+ *
+ *       Take a reference on a pooled topology's latest snapshot and, if
+ *       @cluster_time is not NULL, on its latest clusterTime, without any
+ *       lock. Replaced snapshots are freed once no reader can be between
+ *       loading the pointer and taking its reference, which the reader
+ *       counters show; see _mongoc_topology_reclaim.
+ *
+ * Returns:
+ *       A snapshot to release with _mongoc_topology_snapshot_release, or
+ *       NULL if @topology is single-threaded. @cluster_time is set to a
+ *       clusterTime to release with _mongoc_topology_cluster_time_release,
+ *       or NULL if there is none yet.
+ *
+ *-------------------------------------------------------------------------
+ */
+mongoc_topology_snapshot_t *
+_mongoc_topology_snapshot_acquire (
+   mongoc_topology_t *topology, mongoc_topology_cluster_time_t **cluster_time)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_topology_cluster_time_t *shared = NULL;
+   volatile int32_t *readers;
+
+   if (cluster_time) {
+      *cluster_time = NULL;
+   }
+
+   if (topology->single_threaded) {
+      return NULL;
+   }
+
+   readers = _mongoc_topology_reader_slot (topology);
+   bson_atomic_int_add (readers, 1);
+
+   snapshot = (mongoc_topology_snapshot_t *) _mongoc_atomic_ptr_get (
+      (void *volatile *) &topology->snapshot);
+   if (snapshot) {
+      bson_atomic_int_add (&snapshot->refcount, 1);
+   }
+
+   if (snapshot && cluster_time) {
+      shared = (mongoc_topology_cluster_time_t *) _mongoc_atomic_ptr_get (
+         (void *volatile *) &topology->shared_cluster_time);
+      if (shared) {
+         bson_atomic_int_add (&shared->refcount, 1);
+      }
+
+      *cluster_time = shared;
+   }
+
+   bson_atomic_int_add (readers, -1);
+
+   return snapshot;
+}
+
+
+void
+_mongoc_topology_snapshot_release (mongoc_topology_snapshot_t *snapshot)
+{
+   if (!snapshot || bson_atomic_int_add (&snapshot->refcount, -1) > 0) {
+      return;
+   }
+
+   mongoc_topology_description_destroy (&snapshot->description);
+   bson_free (snapshot->timestamps);
+   bson_free (snapshot);
+}
+
+
+void
+_mongoc_topology_cluster_time_release (
+   mongoc_topology_cluster_time_t *cluster_time)
+{
+   if (!cluster_time ||
+       bson_atomic_int_add (&cluster_time->refcount, -1) > 0) {
+      return;
+   }
+
+   bson_destroy (&cluster_time->doc);
+   bson_free (cluster_time);
+}
+
+
+/* the scanner node timestamp for server @id when @snapshot was published,
+ * like mongoc_topology_server_timestamp */
+int64_t
+_mongoc_topology_snapshot_server_timestamp (
+   const mongoc_topology_snapshot_t *snapshot, uint32_t id)
+{
+   const mongoc_set_t *servers = snapshot->description.servers;
+   size_t i;
+
+   for (i = 0; i < servers->items_len; i++) {
+      if (servers->items[i].id == id) {
+         return snapshot->timestamps[i];
+      }
+   }
+
+   return -1;
+}
+
+
+/* select from the latest snapshot, or return 0 to fall back to selecting
+ * under the mutex, which waits for a suitable server or reports errors */
+static uint32_t
+_mongoc_topology_select_from_snapshot (mongoc_topology_t *topology,
+                                       mongoc_ss_optype_t optype,
+                                       const mongoc_read_prefs_t *read_prefs)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_server_description_t *sd;
+   unsigned int rand_seed;
+   uint32_t server_id = 0;
+
+   snapshot = _mongoc_topology_snapshot_acquire (topology, NULL);
+   if (!snapshot) {
+      return 0;
+   }
+
+   if (mongoc_topology_compatible (&snapshot->description, read_prefs, NULL)) {
+      /* other threads read the snapshot, so don't use its seed */
+      rand_seed = (unsigned int) bson_get_monotonic_time ();
+      sd = _mongoc_topology_description_select_seeded (
+         &snapshot->description,
+         optype,
+         read_prefs,
+         topology->local_threshold_msec,
+         &rand_seed);
+
+      if (sd) {
+         server_id = sd->id;
+      }
+   }
+
+   _mongoc_topology_snapshot_release (snapshot);
+
+   return server_id;
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_select_hedge --
+ *
+ *       Choose a second server for a read with @read_prefs that has been
+ *       sent to @server_id and not yet answered: the least loaded other
+ *       server that is suitable for the read and speaks OP_MSG. Never
+ *       scans or waits.
+ *
+ *       NOTE: if single-threaded, the caller must not hold the mutex.
+ *
+ * Returns:
+ *       A server id, or 0 if there is no other suitable server.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+uint32_t
+_mongoc_topology_select_hedge (mongoc_topology_t *topology,
+                               const mongoc_read_prefs_t *read_prefs,
+                               uint32_t server_id)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_topology_description_t *td;
+   mongoc_array_t suitable;
+   mongoc_server_description_t *sd;
+   mongoc_server_description_t *best = NULL;
+   uint32_t hedge_id = 0;
+   size_t i;
+
+   snapshot = _mongoc_topology_snapshot_acquire (topology, NULL);
+   if (snapshot) {
+      td = &snapshot->description;
+   } else {
+      mongoc_mutex_lock (&topology->mutex);
+      td = &topology->description;
+   }
+
+   _mongoc_array_init (&suitable, sizeof (mongoc_server_description_t *));
+   mongoc_topology_description_suitable_servers (
+      &suitable, MONGOC_SS_READ, td, read_prefs, topology->local_threshold_msec);
+
+   for (i = 0; i < suitable.len; i++) {
+      sd = _mongoc_array_index (&suitable, mongoc_server_description_t *, i);
+      if (sd->id == server_id ||
+          sd->max_wire_version < WIRE_VERSION_OP_MSG) {
+         continue;
+      }
+
+      if (!best || _mongoc_server_description_load_cost (sd) <
+                      _mongoc_server_description_load_cost (best)) {
+         best = sd;
+      }
+   }
+
+   if (best) {
+      hedge_id = best->id;
+   }
+
+   _mongoc_array_destroy (&suitable);
+
+   if (snapshot) {
+      _mongoc_topology_snapshot_release (snapshot);
+   } else {
+      mongoc_mutex_unlock (&topology->mutex);
+   }
+
+   return hedge_id;
+}
+
+
 /*
  *-------------------------------------------------------------------------
  *
@@ -620,7 +1106,31 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
                                   const mongoc_read_prefs_t *read_prefs,
                                   bson_error_t *error)
 {
-   static const char *timeout_msg =
+   return _mongoc_topology_select_server_id (
+      topology, optype, read_prefs, 0 /* no deadline */, error);
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_select_server_id --
+ *
+ *       Like mongoc_topology_select_server_id, for an operation that must
+ *       finish by @deadline, the monotonic time in microseconds, or 0. If
+ *       the deadline is sooner, selection gives up then instead of after
+ *       serverSelectionTimeoutMS.
+ *
+ *-------------------------------------------------------------------------
+ */
+uint32_t
+_mongoc_topology_select_server_id (mongoc_topology_t *topology,
+                                   mongoc_ss_optype_t optype,
+                                   const mongoc_read_prefs_t *read_prefs,
+                                   int64_t deadline,
+                                   bson_error_t *error)
+{
+   const char *timeout_msg =
       "No suitable servers found: `serverSelectionTimeoutMS` expired";
 
    mongoc_topology_scanner_t *ts;
@@ -644,6 +1154,13 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
    BSON_ASSERT (topology);
    ts = topology->scanner;
 
+   /* if pooled, first try the latest snapshot, without locking */
+   server_id = _mongoc_topology_select_from_snapshot (
+      topology, optype, read_prefs);
+   if (server_id) {
+      return server_id;
+   }
+
    mongoc_mutex_lock (&topology->mutex);
    /* It isn't strictly necessary to lock here, because if the topology
     * is invalid, it will never become valid. Lock anyway for consistency. */
@@ -664,6 +1181,10 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
    loop_start = loop_end = bson_get_monotonic_time ();
    expire_at =
       loop_start + ((int64_t) topology->server_selection_timeout_msec * 1000);
+   if (deadline && deadline < expire_at) {
+      expire_at = deadline;
+      timeout_msg = "No suitable servers found: `timeoutMS` expired";
+   }
 
    if (topology->single_threaded) {
       _mongoc_topology_description_monitor_opening (&topology->description);
@@ -685,8 +1206,10 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
             if (scan_ready > expire_at && !try_once) {
                /* selection timeout will expire before min heartbeat passes */
                _mongoc_server_selection_error (
-                  "No suitable servers found: "
-                  "`serverselectiontimeoutms` timed out",
+                  expire_at == deadline
+                     ? timeout_msg
+                     : "No suitable servers found: "
+                       "`serverselectiontimeoutms` timed out",
                   &scanner_error,
                   error);
 
@@ -821,7 +1344,9 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
  *      NOTE: this method returns a copy of the original server
  *      description. Callers must own and clean up this copy.
  *
- *      NOTE: this method locks and unlocks @topology's mutex.
+ *      NOTE: if pooled, this method reads the latest snapshot of the
+ *      topology description without locking; otherwise it locks and
+ *      unlocks @topology's mutex.
  *
  * Returns:
  *      A mongoc_server_description_t, or NULL.
@@ -837,8 +1362,20 @@ mongoc_topology_server_by_id (mongoc_topology_t *topology,
                               uint32_t id,
                               bson_error_t *error)
 {
+   mongoc_topology_snapshot_t *snapshot;
    mongoc_server_description_t *sd;
 
+   snapshot = _mongoc_topology_snapshot_acquire (topology, NULL);
+   if (snapshot) {
+      sd = mongoc_server_description_new_copy (
+         mongoc_topology_description_server_by_id (
+            &snapshot->description, id, error));
+
+      _mongoc_topology_snapshot_release (snapshot);
+
+      return sd;
+   }
+
    mongoc_mutex_lock (&topology->mutex);
 
    sd = mongoc_server_description_new_copy (
@@ -937,6 +1474,7 @@ mongoc_topology_invalidate_server (mongoc_topology_t *topology,
    mongoc_mutex_lock (&topology->mutex);
    mongoc_topology_description_invalidate_server (
       &topology->description, id, error);
+   _mongoc_topology_publish_snapshot (topology);
    mongoc_mutex_unlock (&topology->mutex);
 }
 
@@ -971,6 +1509,8 @@ _mongoc_topology_update_from_handshake (mongoc_topology_t *topology,
    has_server = _mongoc_topology_update_no_lock (
       sd->id, &sd->last_is_master, sd->round_trip_time_msec, topology, NULL);
 
+   _mongoc_topology_publish_snapshot (topology);
+
    /* if pooled, wake threads waiting in mongoc_topology_server_by_id */
    mongoc_cond_broadcast (&topology->cond_client);
    mongoc_mutex_unlock (&topology->mutex);
@@ -1014,7 +1554,8 @@ _mongoc_topology_update_last_used (mongoc_topology_t *topology,
  *      Return the topology's scanner's timestamp for the given server,
  *      or -1 if there is no scanner node for the given server.
  *
- *      NOTE: this method uses @topology's mutex.
+ *      NOTE: if pooled, this method reads the latest snapshot of the
+ *      topology description; otherwise it uses @topology's mutex.
  *
  * Returns:
  *      Timestamp, or -1
@@ -1025,8 +1566,17 @@ int64_t
 mongoc_topology_server_timestamp (mongoc_topology_t *topology, uint32_t id)
 {
    mongoc_topology_scanner_node_t *node;
+   mongoc_topology_snapshot_t *snapshot;
    int64_t timestamp = -1;
 
+   snapshot = _mongoc_topology_snapshot_acquire (topology, NULL);
+   if (snapshot) {
+      timestamp = _mongoc_topology_snapshot_server_timestamp (snapshot, id);
+      _mongoc_topology_snapshot_release (snapshot);
+
+      return timestamp;
+   }
+
    mongoc_mutex_lock (&topology->mutex);
 
    node = mongoc_topology_scanner_get_node (topology->scanner, id);
@@ -1288,6 +1838,10 @@ _mongoc_topology_set_appname (mongoc_topology_t *topology, const char *appname)
  *       any seen before, update the topology's clusterTime. See the Driver
  *       Sessions Spec.
  *
+ *       Called for every reply; it only locks the topology's mutex if the
+ *       reply's clusterTime is later than the last one seen, or can't be
+ *       parsed quickly.
+ *
  *--------------------------------------------------------------------------
  */
 
@@ -1295,28 +1849,144 @@ void
 _mongoc_topology_update_cluster_time (mongoc_topology_t *topology,
                                       const bson_t *reply)
 {
+   bson_iter_t iter;
+   bson_iter_t child;
+   uint32_t timestamp;
+   uint32_t increment;
+   uint64_t seen;
+
+   if (!reply || !bson_iter_init_find (&iter, reply, "$clusterTime")) {
+      return;
+   }
+
+   /* the reply's clusterTime is not later than one a thread already saw.
+    * reading an older value than the latest only sends us to the mutex */
+   if (bson_iter_recurse (&iter, &child) &&
+       bson_iter_find (&child, "clusterTime") &&
+       BSON_ITER_HOLDS_TIMESTAMP (&child)) {
+      bson_iter_timestamp (&child, &timestamp, &increment);
+      seen = (uint64_t) _mongoc_atomic_int64_get (&topology->cluster_time);
+      if (seen && (((uint64_t) timestamp << 32) | increment) <= seen) {
+         return;
+      }
+   }
+
    mongoc_mutex_lock (&topology->mutex);
-   mongoc_topology_description_update_cluster_time (&topology->description,
-                                                    reply);
-   _mongoc_topology_scanner_set_cluster_time (
-      topology->scanner, &topology->description.cluster_time);
+   if (mongoc_topology_description_update_cluster_time (
+          &topology->description, reply)) {
+      _mongoc_topology_scanner_set_cluster_time (
+         topology->scanner, &topology->description.cluster_time);
+      _mongoc_topology_share_cluster_time (topology);
+
+      if (_mongoc_parse_cluster_time (
+             &topology->description.cluster_time, &timestamp, &increment)) {
+         _mongoc_atomic_int64_set (
+            &topology->cluster_time,
+            (int64_t) (((uint64_t) timestamp << 32) | increment));
+      }
+   }
    mongoc_mutex_unlock (&topology->mutex);
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_session_timeout_minutes --
+ *
+ *       Internal function. The logicalSessionTimeoutMinutes of the
+ *       deployment, or MONGOC_NO_SESSIONS if it is unknown. Does not lock
+ *       the topology's mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int64_t
+_mongoc_topology_session_timeout_minutes (mongoc_topology_t *topology)
+{
+   int32_t timeout;
+
+   if (topology->single_threaded) {
+      return topology->description.session_timeout_minutes;
+   }
+
+   timeout = topology->session_timeout_minutes;
+   bson_memory_barrier ();
+
+   return timeout;
+}
+
+
+#ifdef MONGOC_ENABLE_CRYPTO
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_apply_scram_cache --
+ *
+ *       Internal function. Give @scram a copy of the SCRAM secrets cached
+ *       by the topology's clients, if any.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_topology_apply_scram_cache (mongoc_topology_t *topology,
+                                    mongoc_scram_t *scram)
+{
+   mongoc_mutex_lock (&topology->mutex);
+   if (topology->scram_cache) {
+      _mongoc_scram_set_cache (scram, topology->scram_cache);
+   }
+   mongoc_mutex_unlock (&topology->mutex);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_update_scram_cache --
+ *
+ *       Internal function. Cache the SCRAM secrets @scram used to
+ *       authenticate successfully, for the topology's other connections.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_topology_update_scram_cache (mongoc_topology_t *topology,
+                                     mongoc_scram_t *scram)
+{
+   mongoc_scram_cache_t *cache;
+
+   cache = _mongoc_scram_get_cache (scram);
+
+   mongoc_mutex_lock (&topology->mutex);
+   if (topology->scram_cache) {
+      _mongoc_scram_cache_destroy (topology->scram_cache);
+   }
+
+   topology->scram_cache = cache;
+   mongoc_mutex_unlock (&topology->mutex);
+}
+#endif
+
+
 /*
  *--------------------------------------------------------------------------
  *
  * _mongoc_topology_pop_server_session --
  *
- *       Internal function. Get a server session from the pool or create
- *       one. On error, return NULL and fill out @error.
+ *       Internal function. Take the most recently used server session from
+ *       the pool. On success, set @server_session to the session, or to
+ *       NULL if the pool is empty. On error, return false and fill out
+ *       @error.
  *
  *--------------------------------------------------------------------------
  */
 
-mongoc_server_session_t *
+bool
 _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
+                                     mongoc_server_session_t **server_session,
                                      bson_error_t *error)
 {
    int64_t timeout;
@@ -1325,6 +1995,8 @@ _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
 
    ENTRY;
 
+   *server_session = NULL;
+
    mongoc_mutex_lock (&topology->mutex);
 
    td = &topology->description;
@@ -1336,7 +2008,7 @@ _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
          mongoc_mutex_unlock (&topology->mutex);
          if (!mongoc_topology_select_server_id (
                 topology, MONGOC_SS_READ, NULL, error)) {
-            RETURN (NULL);
+            RETURN (false);
          }
 
          mongoc_mutex_lock (&topology->mutex);
@@ -1349,7 +2021,7 @@ _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
                          MONGOC_ERROR_CLIENT,
                          MONGOC_ERROR_CLIENT_SESSION_FAILURE,
                          "Server does not support sessions");
-         RETURN (NULL);
+         RETURN (false);
       }
    }
 
@@ -1366,11 +2038,9 @@ _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
 
    mongoc_mutex_unlock (&topology->mutex);
 
-   if (!ss) {
-      ss = _mongoc_server_session_new (error);
-   }
+   *server_session = ss;
 
-   RETURN (ss);
+   RETURN (true);
 }
 
 /*
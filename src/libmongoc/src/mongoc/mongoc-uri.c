@@ -683,11 +683,16 @@ mongoc_uri_bson_append_or_replace_key (bson_t *options,
 bool
 mongoc_uri_option_is_int32 (const char *key)
 {
-   return !strcasecmp (key, MONGOC_URI_CONNECTTIMEOUTMS) ||
+   return !strcasecmp (key, MONGOC_URI_COALESCEMAXBATCHSIZE) ||
+          !strcasecmp (key, MONGOC_URI_COALESCEWRITESMS) ||
+          !strcasecmp (key, MONGOC_URI_COMPRESSIONMINSAVINGSPERCENT) ||
+          !strcasecmp (key, MONGOC_URI_COMPRESSIONTHRESHOLDBYTES) ||
+          !strcasecmp (key, MONGOC_URI_CONNECTTIMEOUTMS) ||
           !strcasecmp (key, MONGOC_URI_HEARTBEATFREQUENCYMS) ||
           !strcasecmp (key, MONGOC_URI_SERVERSELECTIONTIMEOUTMS) ||
           !strcasecmp (key, MONGOC_URI_SOCKETCHECKINTERVALMS) ||
           !strcasecmp (key, MONGOC_URI_SOCKETTIMEOUTMS) ||
+          !strcasecmp (key, MONGOC_URI_TIMEOUTMS) ||
           !strcasecmp (key, MONGOC_URI_LOCALTHRESHOLDMS) ||
           !strcasecmp (key, MONGOC_URI_MAXPOOLSIZE) ||
           !strcasecmp (key, MONGOC_URI_MAXSTALENESSSECONDS) ||
@@ -696,7 +701,8 @@ mongoc_uri_option_is_int32 (const char *key)
           !strcasecmp (key, MONGOC_URI_WAITQUEUEMULTIPLE) ||
           !strcasecmp (key, MONGOC_URI_WAITQUEUETIMEOUTMS) ||
           !strcasecmp (key, MONGOC_URI_WTIMEOUTMS) ||
-          !strcasecmp (key, MONGOC_URI_ZLIBCOMPRESSIONLEVEL);
+          !strcasecmp (key, MONGOC_URI_ZLIBCOMPRESSIONLEVEL) ||
+          !strcasecmp (key, MONGOC_URI_ZSTDCOMPRESSIONLEVEL);
 }
 
 bool
@@ -707,10 +713,13 @@ mongoc_uri_option_is_bool (const char *key)
           !strcasecmp (key, MONGOC_URI_RETRYWRITES) ||
           !strcasecmp (key, MONGOC_URI_SAFE) ||
           !strcasecmp (key, MONGOC_URI_SERVERSELECTIONTRYONCE) ||
+          !strcasecmp (key, MONGOC_URI_SHAREDCONNECTIONPOOL) ||
           !strcasecmp (key, MONGOC_URI_SLAVEOK) ||
           !strcasecmp (key, MONGOC_URI_SSL) ||
           !strcasecmp (key, MONGOC_URI_SSLALLOWINVALIDCERTIFICATES) ||
-          !strcasecmp (key, MONGOC_URI_SSLALLOWINVALIDHOSTNAMES);
+          !strcasecmp (key, MONGOC_URI_SSLALLOWINVALIDHOSTNAMES) ||
+          !strcasecmp (key, MONGOC_URI_SSLKTLS) ||
+          !strcasecmp (key, MONGOC_URI_SSLSESSIONCACHE);
 }
 
 bool
@@ -2106,6 +2115,29 @@ mongoc_uri_set_option_as_int32 (mongoc_uri_t *uri,
       return false;
    }
 
+   if (!bson_strcasecmp (option, MONGOC_URI_COMPRESSIONMINSAVINGSPERCENT) &&
+       (value < 0 || value > 100)) {
+      MONGOC_WARNING (
+         "Invalid \"%s\" of %d: must be between 0 and 100", option, value);
+      return false;
+   }
+
+   if (!bson_strcasecmp (option, MONGOC_URI_COMPRESSIONTHRESHOLDBYTES) &&
+       value < 0) {
+      MONGOC_WARNING (
+         "Invalid \"%s\" of %d: must be non-negative", option, value);
+      return false;
+   }
+
+   /* zstd levels are from 1 through 22 (best compression), -1 is default */
+   if (!bson_strcasecmp (option, MONGOC_URI_ZSTDCOMPRESSIONLEVEL) &&
+       (value < -1 || value == 0 || value > 22)) {
+      MONGOC_WARNING ("Invalid \"%s\" of %d: must be -1 or between 1 and 22",
+                      option,
+                      value);
+      return false;
+   }
+
    return _mongoc_uri_set_option_as_int32 (uri, option, value);
 }
 
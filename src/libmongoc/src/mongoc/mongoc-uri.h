@@ -40,7 +40,11 @@
 #define MONGOC_URI_AUTHMECHANISMPROPERTIES "authmechanismproperties"
 #define MONGOC_URI_AUTHSOURCE "authsource"
 #define MONGOC_URI_CANONICALIZEHOSTNAME "canonicalizehostname"
+#define MONGOC_URI_COALESCEMAXBATCHSIZE "coalescemaxbatchsize"
+#define MONGOC_URI_COALESCEWRITESMS "coalescewritesms"
 #define MONGOC_URI_CONNECTTIMEOUTMS "connecttimeoutms"
+#define MONGOC_URI_COMPRESSIONMINSAVINGSPERCENT "compressionminsavingspercent"
+#define MONGOC_URI_COMPRESSIONTHRESHOLDBYTES "compressionthresholdbytes"
 #define MONGOC_URI_COMPRESSORS "compressors"
 #define MONGOC_URI_GSSAPISERVICENAME "gssapiservicename"
 #define MONGOC_URI_HEARTBEATFREQUENCYMS "heartbeatfrequencyms"
@@ -58,6 +62,7 @@
 #define MONGOC_URI_SAFE "safe"
 #define MONGOC_URI_SERVERSELECTIONTIMEOUTMS "serverselectiontimeoutms"
 #define MONGOC_URI_SERVERSELECTIONTRYONCE "serverselectiontryonce"
+#define MONGOC_URI_SHAREDCONNECTIONPOOL "sharedconnectionpool"
 #define MONGOC_URI_SLAVEOK "slaveok"
 #define MONGOC_URI_SOCKETCHECKINTERVALMS "socketcheckintervalms"
 #define MONGOC_URI_SOCKETTIMEOUTMS "sockettimeoutms"
@@ -68,11 +73,15 @@
 #define MONGOC_URI_SSLCERTIFICATEAUTHORITYFILE "sslcertificateauthorityfile"
 #define MONGOC_URI_SSLALLOWINVALIDCERTIFICATES "sslallowinvalidcertificates"
 #define MONGOC_URI_SSLALLOWINVALIDHOSTNAMES "sslallowinvalidhostnames"
+#define MONGOC_URI_SSLKTLS "sslktls"
+#define MONGOC_URI_SSLSESSIONCACHE "sslsessioncache"
+#define MONGOC_URI_TIMEOUTMS "timeoutms"
 #define MONGOC_URI_W "w"
 #define MONGOC_URI_WAITQUEUEMULTIPLE "waitqueuemultiple"
 #define MONGOC_URI_WAITQUEUETIMEOUTMS "waitqueuetimeoutms"
 #define MONGOC_URI_WTIMEOUTMS "wtimeoutms"
 #define MONGOC_URI_ZLIBCOMPRESSIONLEVEL "zlibcompressionlevel"
+#define MONGOC_URI_ZSTDCOMPRESSIONLEVEL "zstdcompressionlevel"
 
 BSON_BEGIN_DECLS
 
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MONGOC_WRITE_COALESCER_PRIVATE_H
+#define MONGOC_WRITE_COALESCER_PRIVATE_H
+
+#if !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-collection.h"
+#include "mongoc-opts-private.h"
+#include "mongoc-write-command-private.h"
+
+BSON_BEGIN_DECLS
+
+/* Single-document inserts that the clients of a mongoc_client_pool_t with
+ * coalesceWritesMS make at about the same time, to the same namespace with
+ * the same write concern, are sent together as one unordered "insert". The
+ * first thread to arrive leads the group: it waits up to the linger time for
+ * others to join, or until the group is full or the next document would
+ * not fit in one message with the others, sends the group's documents
+ * with its own client, and hands each thread its part of the result. */
+typedef struct _mongoc_write_coalescer_t mongoc_write_coalescer_t;
+
+mongoc_write_coalescer_t *
+_mongoc_write_coalescer_new (int32_t linger_ms, int32_t max_batch_size);
+
+void
+_mongoc_write_coalescer_destroy (mongoc_write_coalescer_t *coalescer);
+
+void
+_mongoc_write_coalescer_insert (mongoc_write_coalescer_t *coalescer,
+                                mongoc_collection_t *collection,
+                                const bson_t *document,
+                                mongoc_crud_opts_t *crud,
+                                mongoc_write_result_t *result);
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_WRITE_COALESCER_PRIVATE_H */
@@ -0,0 +1,380 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-array-private.h"
+#include "mongoc-client-private.h"
+#include "mongoc-collection-private.h"
+#include "mongoc-thread-private.h"
+#include "mongoc-trace-private.h"
+#include "mongoc-write-coalescer-private.h"
+#include "mongoc-write-concern-private.h"
+
+
+typedef struct {
+   const bson_t *document; /* borrowed, the caller waits for the result */
+   mongoc_write_result_t result;
+} mongoc_coalesced_write_t;
+
+typedef struct _mongoc_write_group_t {
+   char *ns;
+   bson_t write_concern;
+   mongoc_array_t writes; /* mongoc_coalesced_write_t */
+   uint32_t bytes;        /* the writes' documents' total size */
+   bool open;             /* still taking writes */
+   bool done;             /* each write's result is ready */
+   uint32_t refs;         /* threads yet to take their result */
+   mongoc_cond_t cond;
+   struct _mongoc_write_group_t *next;
+} mongoc_write_group_t;
+
+struct _mongoc_write_coalescer_t {
+   mongoc_mutex_t mutex;
+   mongoc_write_group_t *open_groups;
+   int32_t linger_ms;
+   int32_t max_batch_size;
+};
+
+
+mongoc_write_coalescer_t *
+_mongoc_write_coalescer_new (int32_t linger_ms, int32_t max_batch_size)
+{
+   mongoc_write_coalescer_t *coalescer;
+
+   coalescer = (mongoc_write_coalescer_t *) bson_malloc0 (sizeof *coalescer);
+   mongoc_mutex_init (&coalescer->mutex);
+   coalescer->linger_ms = linger_ms;
+   coalescer->max_batch_size = max_batch_size;
+
+   return coalescer;
+}
+
+
+void
+_mongoc_write_coalescer_destroy (mongoc_write_coalescer_t *coalescer)
+{
+   if (!coalescer) {
+      return;
+   }
+
+   /* groups live only while their threads wait in
+    * _mongoc_write_coalescer_insert, and the pool outlives its clients */
+   BSON_ASSERT (!coalescer->open_groups);
+   mongoc_mutex_destroy (&coalescer->mutex);
+   bson_free (coalescer);
+}
+
+
+static mongoc_write_group_t *
+_mongoc_write_group_new (const char *ns, const bson_t *write_concern)
+{
+   mongoc_write_group_t *group;
+
+   group = (mongoc_write_group_t *) bson_malloc0 (sizeof *group);
+   group->ns = bson_strdup (ns);
+   bson_copy_to (write_concern, &group->write_concern);
+   _mongoc_array_init (&group->writes, sizeof (mongoc_coalesced_write_t));
+   group->open = true;
+   mongoc_cond_init (&group->cond);
+
+   return group;
+}
+
+
+static void
+_mongoc_write_group_destroy (mongoc_write_group_t *group)
+{
+   bson_free (group->ns);
+   bson_destroy (&group->write_concern);
+   _mongoc_array_destroy (&group->writes);
+   mongoc_cond_destroy (&group->cond);
+   bson_free (group);
+}
+
+
+/* stop taking writes. the coalescer's mutex is locked */
+static void
+_mongoc_write_group_close (mongoc_write_coalescer_t *coalescer,
+                           mongoc_write_group_t *group)
+{
+   mongoc_write_group_t **link;
+
+   if (!group->open) {
+      return;
+   }
+
+   for (link = &coalescer->open_groups; *link; link = &(*link)->next) {
+      if (*link == group) {
+         *link = group->next;
+         break;
+      }
+   }
+
+   group->open = false;
+   group->next = NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_group_split --
+ *
+ *       Give each write of @group the result it would have had if it were
+ *       sent alone: inserted, or failed with the write error that names
+ *       its index. Errors that concern the whole command, and write
+ *       concern errors, go to every write.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_write_group_split (mongoc_write_group_t *group,
+                           const mongoc_write_result_t *batch)
+{
+   mongoc_coalesced_write_t *writes;
+   mongoc_write_result_t *result;
+   bson_iter_t iter;
+   bson_iter_t err_iter;
+   bson_t write_error;
+   int32_t idx;
+   size_t i;
+
+   writes = (mongoc_coalesced_write_t *) group->writes.data;
+
+   for (i = 0; i < group->writes.len; i++) {
+      result = &writes[i].result;
+      _mongoc_write_result_init (result);
+      result->failed = batch->failed && batch->error.code;
+      result->must_stop = batch->must_stop;
+      memcpy (&result->error, &batch->error, sizeof result->error);
+      result->nInserted = batch->error.code ? 0 : 1;
+      result->n_writeConcernErrors = batch->n_writeConcernErrors;
+      bson_concat (&result->writeConcernErrors, &batch->writeConcernErrors);
+      bson_concat (&result->errorLabels, &batch->errorLabels);
+   }
+
+   /* like [{"index": 3, "code": 11000, "errmsg": "duplicate"}, ...] */
+   if (!bson_iter_init (&iter, &batch->writeErrors)) {
+      return;
+   }
+
+   while (bson_iter_next (&iter)) {
+      if (!BSON_ITER_HOLDS_DOCUMENT (&iter) ||
+          !bson_iter_recurse (&iter, &err_iter) ||
+          !bson_iter_find (&err_iter, "index") ||
+          !BSON_ITER_HOLDS_INT32 (&err_iter)) {
+         continue;
+      }
+
+      idx = bson_iter_int32 (&err_iter);
+      if (idx < 0 || (size_t) idx >= group->writes.len) {
+         continue;
+      }
+
+      result = &writes[idx].result;
+      result->failed = true;
+      result->nInserted = 0;
+
+      /* the write's own index is 0 */
+      bson_append_document_begin (&result->writeErrors, "0", 1, &write_error);
+      BSON_APPEND_INT32 (&write_error, "index", 0);
+      bson_iter_recurse (&iter, &err_iter);
+      while (bson_iter_next (&err_iter)) {
+         if (!BSON_ITER_IS_KEY (&err_iter, "index")) {
+            BSON_APPEND_VALUE (&write_error,
+                               bson_iter_key (&err_iter),
+                               bson_iter_value (&err_iter));
+         }
+      }
+
+      bson_append_document_end (&result->writeErrors, &write_error);
+   }
+}
+
+
+/* send the group's documents in one unordered insert */
+static void
+_mongoc_write_group_send (mongoc_write_group_t *group,
+                          mongoc_collection_t *collection,
+                          mongoc_crud_opts_t *crud)
+{
+   mongoc_coalesced_write_t *writes;
+   mongoc_write_command_t command;
+   mongoc_write_result_t batch;
+   mongoc_bulk_write_flags_t flags = MONGOC_BULK_WRITE_FLAGS_INIT;
+   size_t i;
+
+   ENTRY;
+
+   writes = (mongoc_coalesced_write_t *) group->writes.data;
+   flags.ordered = false;
+
+   _mongoc_write_result_init (&batch);
+   _mongoc_write_command_init_insert (
+      &command,
+      NULL,
+      NULL,
+      flags,
+      ++collection->client->cluster.operation_id,
+      false);
+
+   _mongoc_write_command_borrow_documents (&command);
+   for (i = 0; i < group->writes.len; i++) {
+      _mongoc_write_command_insert_append (&command, writes[i].document);
+   }
+
+   _mongoc_collection_write_command_execute_idl (
+      &command, collection, crud, &batch);
+
+   _mongoc_write_group_split (group, &batch);
+
+   _mongoc_write_command_destroy (&command);
+   _mongoc_write_result_destroy (&batch);
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_coalescer_insert --
+ *
+ *       Insert @document into @collection along with the documents other
+ *       threads insert into the same namespace with the same write concern
+ *       at about the same time. Blocks until the group is sent, then
+ *       initializes @result with this document's part of the outcome, as
+ *       if it had been inserted alone.
+ *
+ *       @collection uses its own write concern and @crud has no session.
+ *       @document is no larger than the server's max BSON size.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_write_coalescer_insert (mongoc_write_coalescer_t *coalescer,
+                                mongoc_collection_t *collection,
+                                const bson_t *document,
+                                mongoc_crud_opts_t *crud,
+                                mongoc_write_result_t *result)
+{
+   mongoc_write_group_t *group;
+   mongoc_coalesced_write_t write = {0};
+   mongoc_write_result_t *mine;
+   mongoc_cluster_t *cluster;
+   const bson_t *write_concern;
+   uint32_t max_bytes;
+   int64_t expire_at;
+   int64_t remaining_ms;
+   size_t idx;
+   bool leader;
+   bool last;
+
+   ENTRY;
+
+   write_concern = _mongoc_write_concern_get_bson (collection->write_concern);
+   write.document = document;
+
+   /* a group's documents and its command fit in one message */
+   cluster = &collection->client->cluster;
+   max_bytes = (uint32_t) (mongoc_cluster_get_max_msg_size (cluster) -
+                           mongoc_cluster_get_max_bson_obj_size (cluster));
+
+   mongoc_mutex_lock (&coalescer->mutex);
+
+   for (group = coalescer->open_groups; group; group = group->next) {
+      if (!strcmp (group->ns, collection->ns) &&
+          bson_equal (&group->write_concern, write_concern)) {
+         break;
+      }
+   }
+
+   if (group && group->bytes + document->len > max_bytes) {
+      /* send the group now, this document starts another */
+      _mongoc_write_group_close (coalescer, group);
+      mongoc_cond_broadcast (&group->cond);
+      group = NULL;
+   }
+
+   leader = !group;
+   if (leader) {
+      group = _mongoc_write_group_new (collection->ns, write_concern);
+      group->next = coalescer->open_groups;
+      coalescer->open_groups = group;
+   }
+
+   idx = group->writes.len;
+   _mongoc_array_append_val (&group->writes, write);
+   group->bytes += document->len;
+   group->refs++;
+
+   if (group->writes.len >= (size_t) coalescer->max_batch_size) {
+      _mongoc_write_group_close (coalescer, group);
+      mongoc_cond_broadcast (&group->cond);
+   }
+
+   if (leader) {
+      expire_at = bson_get_monotonic_time () + coalescer->linger_ms * 1000;
+      while (group->open) {
+         remaining_ms = (expire_at - bson_get_monotonic_time ()) / 1000;
+         if (remaining_ms <= 0) {
+            break;
+         }
+
+         mongoc_cond_timedwait (
+            &group->cond, &coalescer->mutex, remaining_ms);
+      }
+
+      _mongoc_write_group_close (coalescer, group);
+      mongoc_mutex_unlock (&coalescer->mutex);
+
+      /* the group is closed, no other thread touches its writes */
+      _mongoc_write_group_send (group, collection, crud);
+
+      mongoc_mutex_lock (&coalescer->mutex);
+      group->done = true;
+      mongoc_cond_broadcast (&group->cond);
+   } else {
+      while (!group->done) {
+         mongoc_cond_wait (&group->cond, &coalescer->mutex);
+      }
+   }
+
+   /* copy this write's result, a bson_t can't be moved with memcpy */
+   mine = &_mongoc_array_index (&group->writes, mongoc_coalesced_write_t, idx)
+              .result;
+   _mongoc_write_result_init (result);
+   result->nInserted = mine->nInserted;
+   result->failed = mine->failed;
+   result->must_stop = mine->must_stop;
+   memcpy (&result->error, &mine->error, sizeof result->error);
+   result->n_writeConcernErrors = mine->n_writeConcernErrors;
+   bson_concat (&result->writeErrors, &mine->writeErrors);
+   bson_concat (&result->writeConcernErrors, &mine->writeConcernErrors);
+   bson_concat (&result->errorLabels, &mine->errorLabels);
+   _mongoc_write_result_destroy (mine);
+
+   last = (--group->refs == 0);
+   mongoc_mutex_unlock (&coalescer->mutex);
+
+   if (last) {
+      _mongoc_write_group_destroy (group);
+   }
+
+   EXIT;
+}
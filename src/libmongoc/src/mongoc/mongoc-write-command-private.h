@@ -28,6 +28,7 @@
 #include "mongoc-write-concern.h"
 #include "mongoc-server-stream-private.h"
 #include "mongoc-buffer-private.h"
+#include "mongoc-array-private.h"
 
 
 BSON_BEGIN_DECLS
@@ -55,10 +56,29 @@ struct _mongoc_bulk_write_flags_t {
 };
 
 
+/* a caller's document an insert command sends without copying, see
+ * _mongoc_write_command_borrow_documents */
+typedef struct {
+   const uint8_t *data;
+   /* the length on the wire, including any generated "_id" */
+   uint32_t len;
+   /* if the document has no "_id", a new length and "_id" element are
+    * sent from payload at offset before the rest of data */
+   uint32_t prefix_offset;
+   uint32_t prefix_len;
+} mongoc_write_command_doc_t;
+
+
 typedef struct {
    int type;
    mongoc_buffer_t payload;
+   /* set if inserted documents are referenced in docs, with payload only
+    * holding generated "_id" prefixes */
+   bool borrow_documents;
+   mongoc_array_t docs;
    uint32_t n_documents;
+   /* unordered OP_MSG batches to send before reading their replies */
+   uint32_t pipeline_depth;
    mongoc_bulk_write_flags_t flags;
    int64_t operation_id;
    bson_t cmd_opts;
@@ -151,6 +171,8 @@ _mongoc_write_command_init_update_idl (mongoc_write_command_t *command,
                                        const bson_t *opts,
                                        int64_t operation_id);
 void
+_mongoc_write_command_borrow_documents (mongoc_write_command_t *command);
+void
 _mongoc_write_command_insert_append (mongoc_write_command_t *command,
                                      const bson_t *document);
 void
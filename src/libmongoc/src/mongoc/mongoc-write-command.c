@@ -66,6 +66,137 @@ _mongoc_command_type_to_field_name (int command_type)
    return gCommandFields[command_type];
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_command_borrow_documents --
+ *
+ *       Reference the documents later passed to
+ *       _mongoc_write_command_insert_append instead of copying them. The
+ *       documents must not be modified or freed until the command is
+ *       destroyed, so this is only for inserts executed before the
+ *       caller's function returns. Call before appending documents.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_write_command_borrow_documents (mongoc_write_command_t *command)
+{
+   BSON_ASSERT (command->type == MONGOC_WRITE_COMMAND_INSERT);
+   BSON_ASSERT (!command->n_documents);
+
+   command->borrow_documents = true;
+   _mongoc_array_init (&command->docs, sizeof (mongoc_write_command_doc_t));
+}
+
+
+static void
+_mongoc_write_command_insert_borrow (mongoc_write_command_t *command,
+                                     const bson_t *document)
+{
+   mongoc_write_command_doc_t doc;
+   bson_iter_t iter;
+   bson_oid_t oid;
+   uint8_t prefix[4 + 1 + 4 + 12];
+   uint32_t len_le;
+
+   doc.data = bson_get_data (document);
+   doc.len = document->len;
+   doc.prefix_offset = 0;
+   doc.prefix_len = 0;
+
+   if (!bson_iter_init_find (&iter, document, "_id")) {
+      /* the new length word and an "_id" element, followed on the wire by
+       * the caller's document after its own length word */
+      bson_oid_init (&oid, NULL);
+      doc.len = document->len + (uint32_t) sizeof prefix - 4;
+      len_le = BSON_UINT32_TO_LE (doc.len);
+      memcpy (prefix, &len_le, 4);
+      prefix[4] = (uint8_t) BSON_TYPE_OID;
+      memcpy (prefix + 5, "_id", 4);
+      memcpy (prefix + 9, oid.bytes, 12);
+
+      doc.prefix_offset = (uint32_t) command->payload.len;
+      doc.prefix_len = (uint32_t) sizeof prefix;
+      _mongoc_buffer_append (&command->payload, prefix, sizeof prefix);
+   }
+
+   _mongoc_array_append_val (&command->docs, doc);
+}
+
+
+/* append the iovecs for borrowed documents [first, last) to iov */
+static void
+_mongoc_write_command_borrowed_iov (mongoc_write_command_t *command,
+                                    uint32_t first,
+                                    uint32_t last,
+                                    mongoc_array_t *iov)
+{
+   mongoc_write_command_doc_t *doc;
+   mongoc_iovec_t v;
+   uint32_t i;
+
+   for (i = first; i < last; i++) {
+      doc = &((mongoc_write_command_doc_t *) command->docs.data)[i];
+
+      if (doc->prefix_len) {
+         v.iov_base = (void *) (command->payload.data + doc->prefix_offset);
+         v.iov_len = doc->prefix_len;
+         _mongoc_array_append_val (iov, v);
+
+         v.iov_base = (void *) (doc->data + 4);
+         v.iov_len = doc->len - doc->prefix_len;
+      } else {
+         v.iov_base = (void *) doc->data;
+         v.iov_len = doc->len;
+      }
+
+      _mongoc_array_append_val (iov, v);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_command_flatten --
+ *
+ *       Copy borrowed documents into payload, for the OP_QUERY and legacy
+ *       opcode paths that read it as one buffer.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_write_command_flatten (mongoc_write_command_t *command)
+{
+   mongoc_buffer_t payload;
+   mongoc_array_t iov;
+   mongoc_iovec_t *v;
+   size_t i;
+
+   if (!command->borrow_documents) {
+      return;
+   }
+
+   _mongoc_array_init (&iov, sizeof (mongoc_iovec_t));
+   _mongoc_write_command_borrowed_iov (
+      command, 0, (uint32_t) command->docs.len, &iov);
+
+   _mongoc_buffer_init (&payload, NULL, 0, NULL, NULL);
+   for (i = 0; i < iov.len; i++) {
+      v = &_mongoc_array_index (&iov, mongoc_iovec_t, i);
+      _mongoc_buffer_append (&payload, (uint8_t *) v->iov_base, v->iov_len);
+   }
+
+   _mongoc_array_destroy (&iov);
+   _mongoc_buffer_destroy (&command->payload);
+   command->payload = payload;
+   command->borrow_documents = false;
+}
+
+
 void
 _mongoc_write_command_insert_append (mongoc_write_command_t *command,
                                      const bson_t *document)
@@ -81,11 +212,13 @@ _mongoc_write_command_insert_append (mongoc_write_command_t *command,
    BSON_ASSERT (document);
    BSON_ASSERT (document->len >= 5);
 
-   /*
-    * If the document does not contain an "_id" field, we need to generate
-    * a new oid for "_id".
-    */
-   if (!bson_iter_init_find (&iter, document, "_id")) {
+   if (command->borrow_documents) {
+      _mongoc_write_command_insert_borrow (command, document);
+   } else if (!bson_iter_init_find (&iter, document, "_id")) {
+      /*
+       * If the document does not contain an "_id" field, we need to generate
+       * a new oid for "_id".
+       */
       bson_init (&tmp);
       bson_oid_init (&oid, NULL);
       BSON_APPEND_OID (&tmp, "_id", &oid);
@@ -183,7 +316,10 @@ _mongoc_write_command_init_bulk (mongoc_write_command_t *command,
    }
 
    _mongoc_buffer_init (&command->payload, NULL, 0, NULL, NULL);
+   command->borrow_documents = false;
+   memset (&command->docs, 0, sizeof command->docs);
    command->n_documents = 0;
+   command->pipeline_depth = 1;
 
    EXIT;
 }
@@ -430,6 +566,85 @@ _mongoc_write_command_will_overflow (uint32_t len_so_far,
 }
 
 
+/* a batch queued by _mongoc_write_opmsg to be pipelined */
+typedef struct {
+   mongoc_cmd_t cmd;
+   /* borrowed documents: the batch's range in the wave's iovec array */
+   size_t iov_first;
+   uint32_t index_offset;
+} mongoc_write_batch_t;
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_opmsg_pipeline --
+ *
+ *       Send the queued @batches back to back on one connection, then
+ *       merge their replies into @result in index order. @batches and
+ *       @payload_iov are cleared.
+ *
+ * Returns:
+ *       true if every batch succeeded, otherwise false and @error is set
+ *       from the first batch that failed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_write_opmsg_pipeline (mongoc_write_command_t *command,
+                              mongoc_client_t *client,
+                              mongoc_array_t *batches,
+                              mongoc_array_t *payload_iov,
+                              mongoc_write_result_t *result,
+                              bson_error_t *error)
+{
+   mongoc_write_batch_t *batch;
+   mongoc_cmd_t **cmds;
+   bson_t *replies;
+   bool ret;
+   size_t i;
+
+   cmds = bson_malloc (batches->len * sizeof (mongoc_cmd_t *));
+   replies = bson_malloc (batches->len * sizeof (bson_t));
+
+   for (i = 0; i < batches->len; i++) {
+      batch = &_mongoc_array_index (batches, mongoc_write_batch_t, i);
+      if (command->borrow_documents) {
+         /* the iovec array may have moved while batches were queued */
+         batch->cmd.payload_iov =
+            (mongoc_iovec_t *) payload_iov->data + batch->iov_first;
+      }
+
+      cmds[i] = &batch->cmd;
+   }
+
+   ret = mongoc_cluster_run_opmsg_pipeline (
+      &client->cluster, cmds, batches->len, replies, error);
+
+   if (!ret) {
+      result->failed = true;
+      result->must_stop = true;
+   }
+
+   for (i = 0; i < batches->len; i++) {
+      batch = &_mongoc_array_index (batches, mongoc_write_batch_t, i);
+      _mongoc_write_result_merge (
+         result, command, &replies[i], batch->index_offset);
+      bson_destroy (&replies[i]);
+   }
+
+   bson_free (cmds);
+   bson_free (replies);
+   _mongoc_array_clear (batches);
+   if (command->borrow_documents) {
+      _mongoc_array_clear (payload_iov);
+   }
+
+   return ret;
+}
+
+
 static void
 _mongoc_write_opmsg (mongoc_write_command_t *command,
                      mongoc_client_t *client,
@@ -453,6 +668,16 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
    uint32_t header;
    uint32_t payload_batch_size = 0;
    uint32_t payload_total_offset = 0;
+   uint32_t payload_len;
+   uint32_t batch_first_doc = 0;
+   uint32_t next_doc = 0;
+   mongoc_write_command_doc_t *docs;
+   mongoc_array_t payload_iov;
+   size_t iov_first = 0;
+   bool pipeline;
+   mongoc_array_t batches;
+   mongoc_write_batch_t batch;
+   size_t queued_bytes = 0;
    bool ship_it = false;
    int document_count = 0;
    int32_t len;
@@ -527,13 +752,48 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
    header =
       26 + parts.assembled.command->len + gCommandFieldLens[command->type] + 1;
 
+   /* borrowed documents are sent from their own buffers, offsets below are
+    * into their concatenation on the wire */
+   /* unordered batches may be sent before earlier ones are acknowledged.
+    * a retryable write needs a txnNumber per batch, and a transaction must
+    * start with its first command, so those are sent one at a time */
+   pipeline = command->pipeline_depth > 1 && !command->flags.ordered &&
+              parts.assembled.is_acknowledged && !parts.is_retryable_write &&
+              !_mongoc_client_session_in_txn (cs);
+   if (pipeline) {
+      _mongoc_array_init (&batches, sizeof (mongoc_write_batch_t));
+   }
+
+   docs = (mongoc_write_command_doc_t *) command->docs.data;
+   payload_len = (uint32_t) command->payload.len;
+   if (command->borrow_documents) {
+      _mongoc_array_init (&payload_iov, sizeof (mongoc_iovec_t));
+      payload_len = 0;
+      for (next_doc = 0; next_doc < command->docs.len; next_doc++) {
+         payload_len += docs[next_doc].len;
+      }
+
+      next_doc = 0;
+   }
+
    do {
-      memcpy (&len,
-              command->payload.data + payload_batch_size + payload_total_offset,
-              4);
-      len = BSON_UINT32_FROM_LE (len);
+      if (command->borrow_documents) {
+         len = (int32_t) docs[next_doc].len;
+      } else {
+         memcpy (
+            &len,
+            command->payload.data + payload_batch_size + payload_total_offset,
+            4);
+         len = BSON_UINT32_FROM_LE (len);
+      }
 
       if (len > max_bson_obj_size + BSON_OBJECT_ALLOWANCE) {
+         if (pipeline && batches.len) {
+            /* send what was queued before this document */
+            ret = _mongoc_write_opmsg_pipeline (
+               command, client, &batches, &payload_iov, result, error);
+         }
+
          /* Quit if the document is too large */
          _mongoc_write_command_too_large_error (
             error, index_offset, len, max_bson_obj_size);
@@ -543,13 +803,14 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
       } else if ((payload_batch_size + header) + len <= max_msg_size) {
          /* The current batch is still under max batch size in bytes */
          payload_batch_size += len;
+         next_doc++;
 
          /* If this document filled the maximum document count */
          if (++document_count == max_document_count) {
             ship_it = true;
             /* If this document is the last document we have */
          } else if (payload_batch_size + payload_total_offset ==
-                    command->payload.len) {
+                    payload_len) {
             ship_it = true;
          } else {
             ship_it = false;
@@ -562,12 +823,58 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
          bool is_retryable = parts.is_retryable_write;
          mongoc_write_err_type_t error_type;
 
-         /* Seek past the document offset we have already sent */
-         parts.assembled.payload = command->payload.data + payload_total_offset;
+         if (command->borrow_documents) {
+            if (!pipeline) {
+               _mongoc_array_clear (&payload_iov);
+            }
+
+            iov_first = payload_iov.len;
+            _mongoc_write_command_borrowed_iov (
+               command, batch_first_doc, next_doc, &payload_iov);
+            batch_first_doc = next_doc;
+            parts.assembled.payload_iov =
+               (mongoc_iovec_t *) payload_iov.data + iov_first;
+            parts.assembled.payload_iovcnt = payload_iov.len - iov_first;
+         } else {
+            /* Seek past the document offset we have already sent */
+            parts.assembled.payload =
+               command->payload.data + payload_total_offset;
+         }
          /* Only send the documents up to this size */
          parts.assembled.payload_size = payload_batch_size;
          parts.assembled.payload_identifier = gCommandFields[command->type];
 
+         if (pipeline) {
+            batch.cmd = parts.assembled;
+            batch.iov_first = iov_first;
+            batch.index_offset = index_offset;
+            _mongoc_array_append_val (&batches, batch);
+            queued_bytes += header + payload_batch_size;
+
+            payload_total_offset += payload_batch_size;
+            payload_batch_size = 0;
+            index_offset += document_count;
+            document_count = 0;
+
+            /* the cluster writes no more than this ahead of the replies,
+             * so queueing more only delays the first batch. large batches
+             * are in effect sent one at a time */
+            if (batches.len == command->pipeline_depth ||
+                queued_bytes >= MONGOC_CLUSTER_PIPELINE_MAX_BYTES ||
+                payload_total_offset == payload_len) {
+               ret = _mongoc_write_opmsg_pipeline (
+                  command, client, &batches, &payload_iov, result, error);
+               queued_bytes = 0;
+
+               /* e.g. the connection failed, don't send the rest on it */
+               if (result->must_stop) {
+                  break;
+               }
+            }
+
+            continue;
+         }
+
          /* increment the transaction number for the first attempt of each
           * retryable write command */
          if (is_retryable) {
@@ -628,11 +935,19 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
          bson_destroy (&reply);
       }
       /* While we have more documents to write */
-   } while (payload_total_offset < command->payload.len);
+   } while (payload_total_offset < payload_len);
 
    bson_destroy (&cmd);
    mongoc_cmd_parts_cleanup (&parts);
 
+   if (command->borrow_documents) {
+      _mongoc_array_destroy (&payload_iov);
+   }
+
+   if (pipeline) {
+      _mongoc_array_destroy (&batches);
+   }
+
    if (retry_server_stream) {
       mongoc_server_stream_cleanup (retry_server_stream);
    }
@@ -956,7 +1271,7 @@ _mongoc_write_command_execute_idl (mongoc_write_command_t *command,
       EXIT;
    }
 
-   if (command->payload.len == 0) {
+   if (!command->n_documents) {
       _empty_error (command, &result->error);
       EXIT;
    }
@@ -973,6 +1288,8 @@ _mongoc_write_command_execute_idl (mongoc_write_command_t *command,
                            result,
                            &result->error);
    } else {
+      _mongoc_write_command_flatten (command);
+
       if (mongoc_write_concern_is_acknowledged (crud->writeConcern)) {
          _mongoc_write_opquery (command,
                                 client,
@@ -1007,6 +1324,7 @@ _mongoc_write_command_destroy (mongoc_write_command_t *command)
    if (command) {
       bson_destroy (&command->cmd_opts);
       _mongoc_buffer_destroy (&command->payload);
+      _mongoc_array_destroy (&command->docs);
    }
 
    EXIT;
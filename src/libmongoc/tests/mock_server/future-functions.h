@@ -56,6 +56,33 @@ future_client_command_with_opts (
 );
 
 
+future_t *
+future_client_command_with_opts_borrowed (
+
+   mongoc_client_ptr client,
+   const_char_ptr db_name,
+   const_bson_ptr command,
+   const_mongoc_read_prefs_ptr read_prefs,
+   const_bson_ptr opts,
+   bson_ptr reply,
+   bson_error_ptr error
+);
+
+
+future_t *
+future_client_command_batch_with_opts (
+
+   mongoc_client_ptr client,
+   const_char_ptr db_name,
+   const_bson_ptr_ptr commands,
+   size_t n_commands,
+   const_mongoc_read_prefs_ptr read_prefs,
+   const_bson_ptr opts,
+   bson_ptr replies,
+   bson_error_ptr error
+);
+
+
 future_t *
 future_client_read_command_with_opts (
 
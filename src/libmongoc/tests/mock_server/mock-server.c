@@ -81,6 +81,7 @@ typedef struct {
    uint16_t client_port;
    mongoc_opcode_t request_opcode;
    mongoc_query_flags_t query_flags;
+   mongoc_op_msg_flags_t opmsg_flags;
    int32_t response_to;
 } reply_t;
 
@@ -94,6 +95,7 @@ worker_thread (void *data);
 static void
 _mock_server_reply_with_stream (mock_server_t *server,
                                 reply_t *reply,
+                                int32_t *last_more_to_come_id,
                                 mongoc_stream_t *client);
 
 void
@@ -1655,6 +1657,8 @@ worker_thread (void *data)
    ssize_t i;
    autoresponder_handle_t handle;
    reply_t *reply;
+   /* id of the last OP_MSG reply sent with moreToCome, or 0 */
+   int32_t last_more_to_come_id = 0;
 
 #ifdef MONGOC_ENABLE_SSL
    bool ssl;
@@ -1754,7 +1758,8 @@ again:
 
    reply = q_get (replies, 10);
    if (reply) {
-      _mock_server_reply_with_stream (server, reply, client_stream);
+      _mock_server_reply_with_stream (
+         server, reply, &last_more_to_come_id, client_stream);
       _reply_destroy (reply);
    }
 
@@ -1784,13 +1789,12 @@ failure:
 }
 
 
-/* enqueue server reply for this connection's worker thread to send to client */
-void
-mock_server_reply_multi (request_t *request,
-                         mongoc_reply_flags_t flags,
-                         const bson_t *docs,
-                         int n_docs,
-                         int64_t cursor_id)
+static reply_t *
+_reply_new (request_t *request,
+            mongoc_reply_flags_t flags,
+            const bson_t *docs,
+            int n_docs,
+            int64_t cursor_id)
 {
    reply_t *reply;
    int i;
@@ -1813,6 +1817,52 @@ mock_server_reply_multi (request_t *request,
    reply->query_flags = (mongoc_query_flags_t) request->request_rpc.query.flags;
    reply->response_to = request->request_rpc.header.request_id;
 
+   return reply;
+}
+
+
+/* enqueue server reply for this connection's worker thread to send to client */
+void
+mock_server_reply_multi (request_t *request,
+                         mongoc_reply_flags_t flags,
+                         const bson_t *docs,
+                         int n_docs,
+                         int64_t cursor_id)
+{
+   q_put (request->replies,
+          _reply_new (request, flags, docs, n_docs, cursor_id));
+}
+
+
+/*--------------------------------------------------------------------------
+ *
+ * mock_server_replies_opmsg --
+ *
+ *       Respond to a client OP_MSG request with the given OP_MSG flags.
+ *       To emulate an exhaust cursor, reply to a request sent with
+ *       exhaustAllowed several times with MONGOC_MSG_MORE_TO_COME, then
+ *       once without it; each reply responds to the one before it.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       Sends an OP_MSG to the client.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mock_server_replies_opmsg (request_t *request,
+                           mongoc_op_msg_flags_t flags,
+                           const bson_t *doc)
+{
+   reply_t *reply;
+
+   BSON_ASSERT (request->opcode == MONGOC_OPCODE_MSG);
+
+   reply = _reply_new (request, MONGOC_REPLY_NONE, doc, 1, 0);
+   reply->opmsg_flags = flags;
    q_put (request->replies, reply);
 }
 
@@ -1820,6 +1870,7 @@ mock_server_reply_multi (request_t *request,
 static void
 _mock_server_reply_with_stream (mock_server_t *server,
                                 reply_t *reply,
+                                int32_t *last_more_to_come_id,
                                 mongoc_stream_t *client)
 {
    char *doc_json;
@@ -1888,7 +1939,17 @@ _mock_server_reply_with_stream (mock_server_t *server,
    r.header.response_to = reply->response_to;
 
    if (is_op_msg) {
+      /* each reply in an exhaust stream responds to the one before it */
+      if (*last_more_to_come_id) {
+         r.header.response_to = *last_more_to_come_id;
+      }
+
+      *last_more_to_come_id = (reply->opmsg_flags & MONGOC_MSG_MORE_TO_COME)
+                                 ? r.header.request_id
+                                 : 0;
+
       r.header.opcode = MONGOC_OPCODE_MSG;
+      r.msg.flags = reply->opmsg_flags;
       r.msg.n_sections = 1;
       /* we don't yet implement payload type 1, a document stream */
       r.msg.sections[0].payload_type = 0;
@@ -80,6 +80,34 @@ request_new (const mongoc_buffer_t *buffer,
       return NULL;
    }
 
+   request->compressor_id = -1;
+
+   if (BSON_UINT32_FROM_LE (request->request_rpc.header.opcode) ==
+       MONGOC_OPCODE_COMPRESSED) {
+      size_t len =
+         BSON_UINT32_FROM_LE (
+            request->request_rpc.compressed.uncompressed_size) +
+         sizeof (mongoc_rpc_header_t);
+
+      request->compressor_id =
+         request->request_rpc.compressed.compressor_id;
+
+      /* the decompressed rpc points into the new buffer, swap it in */
+      data = (uint8_t *) bson_malloc0 (len);
+      if (!_mongoc_rpc_decompress (&request->request_rpc, data, len)) {
+         MONGOC_WARNING (
+            "%s():%d: %s", BSON_FUNC, __LINE__, "Failed to decompress");
+         bson_free (data);
+         bson_free (request->data);
+         bson_free (request);
+         return NULL;
+      }
+
+      bson_free (request->data);
+      request->data = data;
+      request->data_len = len;
+   }
+
    _mongoc_rpc_swab_from_le (&request->request_rpc);
 
    request->opcode = (mongoc_opcode_t) request->request_rpc.header.opcode;
@@ -90,6 +118,7 @@ request_new (const mongoc_buffer_t *buffer,
 
    switch (request->opcode) {
    case MONGOC_OPCODE_COMPRESSED:
+      /* decompressed above, so the opcode is the inner message's */
       break;
    case MONGOC_OPCODE_QUERY:
       request_from_query (request, &request->request_rpc);
@@ -32,6 +32,7 @@ typedef struct _request_t {
    size_t data_len;
    mongoc_rpc_t request_rpc;
    mongoc_opcode_t opcode; /* copied from rpc for convenience */
+   int32_t compressor_id;  /* -1 unless the client sent OP_COMPRESSED */
    struct _mock_server_t *server;
    mongoc_stream_t *client;
    uint16_t client_port;
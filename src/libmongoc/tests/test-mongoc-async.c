@@ -5,6 +5,7 @@
 #include "mongoc-async-private.h"
 #include "mongoc-async-cmd-private.h"
 #include "TestSuite.h"
+#include "test-conveniences.h"
 #include "mock_server/mock-server.h"
 #include "mock_server/future-functions.h"
 #include "mongoc-errno-private.h"
@@ -153,6 +154,7 @@ test_ismaster_impl (bool with_ssl)
                             setup_ctx,
                             "admin",
                             &q,
+                            MONGOC_OPCODE_QUERY,
                             &test_ismaster_helper,
                             (void *) &results[i],
                             TIMEOUT);
@@ -287,6 +289,7 @@ test_large_ismaster (void *ctx)
                          NULL,
                          "admin",
                          &q,
+                         MONGOC_OPCODE_QUERY,
                          &test_large_ismaster_helper,
                          NULL,
                          TIMEOUT);
@@ -345,6 +348,7 @@ test_ismaster_delay ()
                          NULL, /* setup ctx. */
                          "admin",
                          &ismaster_cmd,
+                         MONGOC_OPCODE_QUERY,
                          &test_ismaster_delay_callback,
                          &stream_with_result,
                          TIMEOUT);
@@ -362,6 +366,279 @@ test_ismaster_delay ()
    mock_server_destroy (server);
 }
 
+
+typedef struct {
+   int n_calls;
+   bool succeeded;
+   bson_t reply;
+   bson_error_t error;
+} async_result_t;
+
+
+static void
+_async_result_init (async_result_t *result)
+{
+   memset (result, 0, sizeof *result);
+   bson_init (&result->reply);
+}
+
+
+static void
+_async_result_cb (const bson_t *reply, const bson_error_t *error, void *ctx)
+{
+   async_result_t *result = (async_result_t *) ctx;
+
+   result->n_calls++;
+   result->succeeded = !error;
+   if (error) {
+      memcpy (&result->error, error, sizeof result->error);
+   }
+
+   bson_destroy (&result->reply);
+   bson_copy_to (reply, &result->reply);
+}
+
+
+/* poll the client's sockets once, as an application's event loop would */
+static size_t
+_async_pump (mongoc_client_t *client)
+{
+   struct pollfd fds[NSERVERS];
+   size_t n;
+   int32_t timeout_msec;
+   int r;
+
+   n = mongoc_client_async_get_pollfds (client, fds, NSERVERS);
+   ASSERT_CMPSIZE_T (n, <=, (size_t) NSERVERS);
+   timeout_msec = mongoc_client_async_get_timeout_msec (client);
+
+   if (n) {
+#ifdef _WIN32
+      r = WSAPoll (fds, (ULONG) n, timeout_msec);
+#else
+      r = poll (fds, n, timeout_msec);
+#endif
+      ASSERT_CMPINT (r, >=, 0);
+   }
+
+   return mongoc_client_async_perform (client, fds, n);
+}
+
+
+static void
+_async_drain (mongoc_client_t *client)
+{
+   while (_async_pump (client)) {
+   }
+}
+
+
+static void
+test_client_async_command_op_msg (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   async_result_t result;
+   bson_error_t error;
+   request_t *request;
+   uint16_t port = 0;
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   _async_result_init (&result);
+
+   /* no commands in flight */
+   ASSERT_CMPINT (mongoc_client_async_get_timeout_msec (client), ==, -1);
+   ASSERT_CMPSIZE_T (mongoc_client_async_perform (client, NULL, 0), ==, 0);
+
+   for (i = 0; i < 2; i++) {
+      ASSERT_OR_PRINT (mongoc_client_async_command (client,
+                                                    "db",
+                                                    tmp_bson ("{'ping': 1}"),
+                                                    NULL,
+                                                    _async_result_cb,
+                                                    &result,
+                                                    &error),
+                       error);
+
+      ASSERT_CMPINT (mongoc_client_async_get_timeout_msec (client), >, 0);
+
+      /* the command is written and now waits for its reply */
+      ASSERT_CMPSIZE_T (_async_pump (client), ==, 1);
+      ASSERT_CMPINT (result.n_calls, ==, i);
+
+      request = mock_server_receives_msg (
+         server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1, '$db': 'db'}"));
+
+      if (i == 0) {
+         port = request_get_client_port (request);
+      } else {
+         /* the idle connection was reused */
+         ASSERT_CMPUINT16 (request_get_client_port (request), ==, port);
+      }
+
+      mock_server_replies_simple (request, "{'ok': 1, 'n': 42}");
+      request_destroy (request);
+
+      _async_drain (client);
+      ASSERT_CMPINT (result.n_calls, ==, i + 1);
+      BSON_ASSERT (result.succeeded);
+      ASSERT_MATCH (&result.reply, "{'ok': 1, 'n': 42}");
+   }
+
+   bson_destroy (&result.reply);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_client_async_command_op_query (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   async_result_t result;
+   bson_error_t error;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG - 1);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   _async_result_init (&result);
+
+   ASSERT_OR_PRINT (mongoc_client_async_command (client,
+                                                 "db",
+                                                 tmp_bson ("{'ping': 1}"),
+                                                 NULL,
+                                                 _async_result_cb,
+                                                 &result,
+                                                 &error),
+                    error);
+
+   ASSERT_CMPSIZE_T (_async_pump (client), ==, 1);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK, "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 0, 'code': 2, 'errmsg': 'x'}");
+   request_destroy (request);
+
+   _async_drain (client);
+   ASSERT_CMPINT (result.n_calls, ==, 1);
+   BSON_ASSERT (!result.succeeded);
+   ASSERT_ERROR_CONTAINS (result.error, MONGOC_ERROR_QUERY, 2, "x");
+   ASSERT_MATCH (&result.reply, "{'ok': 0, 'code': 2}");
+
+   bson_destroy (&result.reply);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_client_async_command_hangup (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   async_result_t result;
+   bson_error_t error;
+   request_t *request;
+   uint16_t port;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   _async_result_init (&result);
+
+   ASSERT_OR_PRINT (mongoc_client_async_command (client,
+                                                 "db",
+                                                 tmp_bson ("{'ping': 1}"),
+                                                 NULL,
+                                                 _async_result_cb,
+                                                 &result,
+                                                 &error),
+                    error);
+
+   ASSERT_CMPSIZE_T (_async_pump (client), ==, 1);
+   request = mock_server_receives_msg (
+      server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+   port = request_get_client_port (request);
+   mock_server_hangs_up (request);
+   request_destroy (request);
+
+   _async_drain (client);
+   ASSERT_CMPINT (result.n_calls, ==, 1);
+   BSON_ASSERT (!result.succeeded);
+   ASSERT_CMPUINT32 (result.error.domain, ==, (uint32_t) MONGOC_ERROR_STREAM);
+   BSON_ASSERT (bson_empty (&result.reply));
+
+   /* the failed connection is not reused */
+   ASSERT_OR_PRINT (mongoc_client_async_command (client,
+                                                 "db",
+                                                 tmp_bson ("{'ping': 1}"),
+                                                 NULL,
+                                                 _async_result_cb,
+                                                 &result,
+                                                 &error),
+                    error);
+
+   ASSERT_CMPSIZE_T (_async_pump (client), ==, 1);
+   request = mock_server_receives_msg (
+      server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+   BSON_ASSERT (request_get_client_port (request) != port);
+   mock_server_replies_simple (request, "{'ok': 1}");
+   request_destroy (request);
+
+   _async_drain (client);
+   ASSERT_CMPINT (result.n_calls, ==, 2);
+   BSON_ASSERT (result.succeeded);
+
+   bson_destroy (&result.reply);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_client_async_command_destroy (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   async_result_t result;
+   bson_error_t error;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   _async_result_init (&result);
+
+   ASSERT_OR_PRINT (mongoc_client_async_command (client,
+                                                 "db",
+                                                 tmp_bson ("{'ping': 1}"),
+                                                 NULL,
+                                                 _async_result_cb,
+                                                 &result,
+                                                 &error),
+                    error);
+
+   ASSERT_CMPSIZE_T (_async_pump (client), ==, 1);
+   request = mock_server_receives_msg (
+      server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+
+   /* the callback runs once, with an error, for each pending command */
+   mongoc_client_destroy (client);
+   ASSERT_CMPINT (result.n_calls, ==, 1);
+   ASSERT_ERROR_CONTAINS (result.error,
+                          MONGOC_ERROR_CLIENT,
+                          MONGOC_ERROR_CLIENT_NOT_READY,
+                          "Client destroyed");
+
+   request_destroy (request);
+   bson_destroy (&result.reply);
+   mock_server_destroy (server);
+}
+
 void
 test_async_install (TestSuite *suite)
 {
@@ -379,4 +656,16 @@ test_async_install (TestSuite *suite)
                       test_framework_skip_if_not_single);
 #endif
    TestSuite_AddMockServerTest (suite, "/Async/delay", test_ismaster_delay);
+   TestSuite_AddMockServerTest (suite,
+                                "/Async/client_command/op_msg",
+                                test_client_async_command_op_msg);
+   TestSuite_AddMockServerTest (suite,
+                                "/Async/client_command/op_query",
+                                test_client_async_command_op_query);
+   TestSuite_AddMockServerTest (suite,
+                                "/Async/client_command/hangup",
+                                test_client_async_command_hangup);
+   TestSuite_AddMockServerTest (suite,
+                                "/Async/client_command/destroy",
+                                test_client_async_command_destroy);
 }
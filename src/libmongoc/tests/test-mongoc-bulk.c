@@ -4503,6 +4503,336 @@ test_bulk_no_client (void)
    bson_destroy (&reply);
 }
 
+
+/* with pipelineDepth 2, an unordered bulk sends the second batch before the
+ * first batch's reply arrives, and merges the replies in batch order */
+static void
+test_bulk_pipeline (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   int i;
+   future_t *future;
+   request_t *first;
+   request_t *second;
+   request_t *third;
+   bson_t reply;
+   bson_error_t error;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 2}",
+                              WIRE_VERSION_OP_MSG);
+
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   /* a depth below 1 is rejected */
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'pipelineDepth': 0}"));
+   BSON_ASSERT (!mongoc_bulk_operation_execute (bulk, &reply, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "pipelineDepth");
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': false, 'pipelineDepth': 2}"));
+
+   for (i = 0; i < 5; i++) {
+      BSON_ASSERT (mongoc_bulk_operation_insert_with_opts (
+         bulk, tmp_bson ("{'_id': %d}", i), NULL, &error));
+   }
+
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   /* both batches of the first wave are sent before either reply */
+   first = mock_server_receives_msg (server,
+                                     MONGOC_MSG_NONE,
+                                     tmp_bson ("{'insert': 'collection'}"),
+                                     tmp_bson ("{'_id': 0}"),
+                                     tmp_bson ("{'_id': 1}"));
+   second = mock_server_receives_msg (server,
+                                      MONGOC_MSG_NONE,
+                                      tmp_bson ("{'insert': 'collection'}"),
+                                      tmp_bson ("{'_id': 2}"),
+                                      tmp_bson ("{'_id': 3}"));
+
+   mock_server_replies_simple (first, "{'ok': 1, 'n': 2}");
+   mock_server_replies_simple (
+      second,
+      "{'ok': 1, 'n': 1,"
+      " 'writeErrors': [{'index': 0, 'code': 11000, 'errmsg': 'dupe'}]}");
+
+   third = mock_server_receives_msg (server,
+                                     MONGOC_MSG_NONE,
+                                     tmp_bson ("{'insert': 'collection'}"),
+                                     tmp_bson ("{'_id': 4}"));
+   mock_server_replies_simple (third, "{'ok': 1, 'n': 1}");
+
+   BSON_ASSERT (!future_get_uint32_t (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe");
+
+   /* the write error's index is relative to the whole bulk */
+   ASSERT_MATCH (&reply,
+                 "{'nInserted': 4,"
+                 " 'writeErrors': [{'index': 2, 'code': 11000}]}");
+
+   request_destroy (first);
+   request_destroy (second);
+   request_destroy (third);
+   future_destroy (future);
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+/* a pipelined batch that fails stops the bulk write, batches not yet sent
+ * are not sent */
+static void
+test_bulk_pipeline_stop (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   int i;
+   future_t *future;
+   request_t *first;
+   request_t *second;
+   bson_t reply;
+   bson_error_t error;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 2}",
+                              WIRE_VERSION_OP_MSG);
+
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': false, 'pipelineDepth': 2}"));
+
+   for (i = 0; i < 5; i++) {
+      BSON_ASSERT (mongoc_bulk_operation_insert_with_opts (
+         bulk, tmp_bson ("{'_id': %d}", i), NULL, &error));
+   }
+
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   first = mock_server_receives_msg (server,
+                                     MONGOC_MSG_NONE,
+                                     tmp_bson ("{'insert': 'collection'}"),
+                                     tmp_bson ("{'_id': 0}"),
+                                     tmp_bson ("{'_id': 1}"));
+   second = mock_server_receives_msg (server,
+                                      MONGOC_MSG_NONE,
+                                      tmp_bson ("{'insert': 'collection'}"),
+                                      tmp_bson ("{'_id': 2}"),
+                                      tmp_bson ("{'_id': 3}"));
+
+   mock_server_replies_simple (first,
+                               "{'ok': 0, 'code': 8000, 'errmsg': 'failed'}");
+   mock_server_replies_simple (second, "{'ok': 1, 'n': 2}");
+
+   BSON_ASSERT (!future_get_uint32_t (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_QUERY, 8000, "failed");
+   ASSERT_MATCH (&reply, "{'nInserted': 2}");
+
+   /* the third batch is not sent */
+   mock_server_set_request_timeout_msec (server, 100);
+   BSON_ASSERT (!mock_server_receives_request (server));
+   mock_server_set_request_timeout_msec (server, get_future_timeout_ms ());
+
+   request_destroy (first);
+   request_destroy (second);
+   future_destroy (future);
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+typedef struct {
+   bson_string_t *batches; /* the size of each insert, like "2,1," */
+   int n_errors;
+   bson_t last_error_reply;
+} auto_flush_test_t;
+
+
+/* reply to inserts, with a duplicate key error for {_id: 4} */
+static bool
+_auto_flush_responder (request_t *request, void *data)
+{
+   auto_flush_test_t *test = (auto_flush_test_t *) data;
+   const bson_t *doc;
+   bson_iter_t iter;
+   int n = (int) request->docs.len - 1;
+   char *reply_json = NULL;
+   int i;
+
+   if (!request->command_name ||
+       strcmp (request->command_name, "insert") != 0) {
+      return false;
+   }
+
+   bson_string_append_printf (test->batches, "%d,", n);
+
+   for (i = 1; i <= n; i++) {
+      doc = request_get_doc (request, i);
+      if (bson_iter_init_find (&iter, doc, "_id") &&
+          bson_iter_as_int64 (&iter) == 4) {
+         reply_json = bson_strdup_printf (
+            "{'ok': 1, 'n': %d, 'writeErrors': [{'index': %d,"
+            " 'code': 11000, 'errmsg': 'dupe'}]}",
+            n - 1,
+            i - 1);
+      }
+   }
+
+   if (!reply_json) {
+      reply_json = bson_strdup_printf ("{'ok': 1, 'n': %d}", n);
+   }
+
+   mock_server_replies_simple (request, reply_json);
+   request_destroy (request);
+   bson_free (reply_json);
+
+   return true;
+}
+
+
+static void
+_auto_flush_error_cb (const bson_t *reply,
+                      const bson_error_t *error,
+                      void *context)
+{
+   auto_flush_test_t *test = (auto_flush_test_t *) context;
+
+   ASSERT_ERROR_CONTAINS ((*error), MONGOC_ERROR_COMMAND, 11000, "dupe");
+   test->n_errors++;
+   bson_destroy (&test->last_error_reply);
+   bson_copy_to (reply, &test->last_error_reply);
+}
+
+
+/* a bulk with auto flush sends operations as batches fill up, reports
+ * errors as they come, and keeps no per-operation results if asked */
+static void
+_test_bulk_auto_flush (bool ordered)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   auto_flush_test_t test;
+   bson_t reply;
+   bson_error_t error;
+   uint32_t r;
+   int i;
+
+   test.batches = bson_string_new (NULL);
+   test.n_errors = 0;
+   bson_init (&test.last_error_reply);
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 2}",
+                              WIRE_VERSION_OP_MSG);
+   mock_server_autoresponds (server, _auto_flush_responder, &test, NULL);
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': %s}", ordered ? "true" : "false"));
+
+   /* each {_id: n} is 14 bytes, so the first flush comes at the third
+    * document; then the server's maxWriteBatchSize of 2 is known */
+   mongoc_bulk_operation_set_auto_flush (bulk, 40, true /* counts_only */);
+   mongoc_bulk_operation_set_error_callback (
+      bulk, _auto_flush_error_cb, &test);
+
+   for (i = 0; i < 7; i++) {
+      if (!mongoc_bulk_operation_insert_with_opts (
+             bulk, tmp_bson ("{'_id': %d}", i), NULL, &error)) {
+         break;
+      }
+   }
+
+   ASSERT_CMPINT (test.n_errors, ==, 1);
+   ASSERT_MATCH (&test.last_error_reply,
+                 "{'writeErrors': [{'index': 4, 'code': 11000}]}");
+
+   if (ordered) {
+      /* the ordered bulk stops at the error */
+      ASSERT_CMPINT (i, ==, 5);
+      ASSERT_ERROR_CONTAINS (error,
+                             MONGOC_ERROR_COMMAND,
+                             MONGOC_ERROR_COMMAND_INVALID_ARG,
+                             "Bulk operation stopped after an error: dupe");
+      ASSERT_CMPSTR (test.batches->str, "2,1,2,");
+   } else {
+      ASSERT_CMPINT (i, ==, 7);
+      ASSERT_CMPSTR (test.batches->str, "2,1,2,2,");
+   }
+
+   /* nothing is left to send, the reply has only the counts */
+   r = mongoc_bulk_operation_execute (bulk, &reply, &error);
+   BSON_ASSERT (!r);
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe");
+   ASSERT_MATCH (&reply,
+                 "{'nInserted': %d, 'writeErrors': {'$empty': true}}",
+                 ordered ? 4 : 6);
+
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+   bson_destroy (&test.last_error_reply);
+   bson_string_free (test.batches, true);
+}
+
+
+static void
+test_bulk_auto_flush_ordered (void)
+{
+   _test_bulk_auto_flush (true);
+}
+
+
+static void
+test_bulk_auto_flush_unordered (void)
+{
+   _test_bulk_auto_flush (false);
+}
+
+
 void
 test_bulk_install (TestSuite *suite)
 {
@@ -4803,4 +5133,14 @@ test_bulk_install (TestSuite *suite)
                   test_bulk_update_one_error_message);
    TestSuite_Add (suite, "/BulkOperation/opts/parse", test_bulk_opts_parse);
    TestSuite_Add (suite, "/BulkOperation/no_client", test_bulk_no_client);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/pipeline", test_bulk_pipeline);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/pipeline/stop", test_bulk_pipeline_stop);
+   TestSuite_AddMockServerTest (suite,
+                                "/BulkOperation/auto_flush/ordered",
+                                test_bulk_auto_flush_ordered);
+   TestSuite_AddMockServerTest (suite,
+                                "/BulkOperation/auto_flush/unordered",
+                                test_bulk_auto_flush_unordered);
 }
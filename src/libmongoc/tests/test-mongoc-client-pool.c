@@ -5,6 +5,9 @@
 
 #include "TestSuite.h"
 #include "test-libmongoc.h"
+#include "test-conveniences.h"
+#include "mock_server/future-functions.h"
+#include "mock_server/mock-server.h"
 
 
 static void
@@ -282,6 +285,836 @@ test_mongoc_client_pool_handshake (void)
    mongoc_client_pool_destroy (pool);
 }
 
+static mongoc_client_pool_t *
+_shared_connections_pool_new (mock_server_t *server)
+{
+   mongoc_client_pool_t *pool;
+   mongoc_uri_t *uri;
+
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_bool (uri, MONGOC_URI_SHAREDCONNECTIONPOOL, true);
+   pool = mongoc_client_pool_new (uri);
+   mongoc_uri_destroy (uri);
+
+   return pool;
+}
+
+
+/* run "ping" with client, return the port of the connection it used */
+static uint16_t
+_shared_connections_ping (mock_server_t *server, mongoc_client_t *client)
+{
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   uint16_t port;
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   port = request_get_client_port (request);
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   return port;
+}
+
+
+static void
+test_mongoc_client_pool_shared_connections (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client_a;
+   mongoc_client_t *client_b;
+   future_t *future_a;
+   future_t *future_b;
+   request_t *request_a;
+   request_t *request_b;
+   bson_error_t error;
+   uint16_t port;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   pool = _shared_connections_pool_new (server);
+   client_a = mongoc_client_pool_pop (pool);
+   client_b = mongoc_client_pool_pop (pool);
+
+   /* the connection goes back to the pool after each operation */
+   port = _shared_connections_ping (server, client_a);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 1);
+
+   /* and another client reuses it */
+   ASSERT_CMPUINT16 (_shared_connections_ping (server, client_b), ==, port);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 1);
+
+   /* concurrent operations check out separate connections */
+   future_a = future_client_command_simple (
+      client_a, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request_a = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   future_b = future_client_command_simple (
+      client_b, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request_b = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+
+   ASSERT_CMPUINT16 (request_get_client_port (request_a), ==, port);
+   BSON_ASSERT (request_get_client_port (request_b) != port);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 0);
+
+   mock_server_replies_ok_and_destroys (request_a);
+   mock_server_replies_ok_and_destroys (request_b);
+   BSON_ASSERT (future_get_bool (future_a));
+   BSON_ASSERT (future_get_bool (future_b));
+   future_destroy (future_a);
+   future_destroy (future_b);
+
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 2);
+
+   mongoc_client_pool_push (pool, client_a);
+   mongoc_client_pool_push (pool, client_b);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_mongoc_client_pool_shared_connections_hangup (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   uint16_t port;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   pool = _shared_connections_pool_new (server);
+   client = mongoc_client_pool_pop (pool);
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   port = request_get_client_port (request);
+   mock_server_hangs_up (request);
+   request_destroy (request);
+   BSON_ASSERT (!future_get_bool (future));
+   future_destroy (future);
+
+   /* the broken connection is not returned to the pool */
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 0);
+   BSON_ASSERT (_shared_connections_ping (server, client) != port);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 1);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_mongoc_client_pool_shared_connections_max_idle (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client_a;
+   mongoc_client_t *client_b;
+   future_t *future_a;
+   future_t *future_b;
+   request_t *request_a;
+   request_t *request_b;
+   bson_error_t error;
+   uint16_t port;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_bool (uri, MONGOC_URI_SHAREDCONNECTIONPOOL, true);
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_MAXPOOLSIZE, 2);
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_MAXIDLETIMEMS, 100);
+   pool = mongoc_client_pool_new (uri);
+   mongoc_uri_destroy (uri);
+   client_a = mongoc_client_pool_pop (pool);
+   client_b = mongoc_client_pool_pop (pool);
+
+   future_a = future_client_command_simple (
+      client_a, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request_a = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   future_b = future_client_command_simple (
+      client_b, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request_b = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_ok_and_destroys (request_a);
+   mock_server_replies_ok_and_destroys (request_b);
+   BSON_ASSERT (future_get_bool (future_a));
+   BSON_ASSERT (future_get_bool (future_b));
+   future_destroy (future_a);
+   future_destroy (future_b);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 2);
+
+   /* lowering maxPoolSize closes the extra idle connection */
+   mongoc_client_pool_max_size (pool, 1);
+   port = _shared_connections_ping (server, client_a);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 1);
+
+   /* a connection idle longer than maxIdleTimeMS is closed, not reused */
+   _mongoc_usleep (200 * 1000);
+   BSON_ASSERT (_shared_connections_ping (server, client_a) != port);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 1);
+
+   mongoc_client_pool_push (pool, client_a);
+   mongoc_client_pool_push (pool, client_b);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+#define SWEEP_MONGOS_ISMASTER                               \
+   "{'ok': 1, 'ismaster': true, 'msg': 'isdbgrid',"         \
+   " 'minWireVersion': 0, 'maxWireVersion': %d}"
+
+/* a pool sharing connections to two mongoses, server ids 1 and 2 */
+static mongoc_client_pool_t *
+_shared_connections_sweep_pool_new (mock_server_t *servers[2],
+                                    const char *options)
+{
+   mongoc_client_pool_t *pool;
+   mongoc_uri_t *uri;
+   char *uri_str;
+   int i;
+
+   for (i = 0; i < 2; i++) {
+      servers[i] = mock_server_new ();
+      mock_server_auto_ismaster (
+         servers[i], SWEEP_MONGOS_ISMASTER, WIRE_VERSION_OP_MSG);
+      mock_server_run (servers[i]);
+   }
+
+   uri_str = bson_strdup_printf (
+      "mongodb://localhost:%hu,localhost:%hu/?sharedConnectionPool=true&%s",
+      mock_server_get_port (servers[0]),
+      mock_server_get_port (servers[1]),
+      options);
+   uri = mongoc_uri_new (uri_str);
+   pool = mongoc_client_pool_new (uri);
+   mongoc_uri_destroy (uri);
+   bson_free (uri_str);
+
+   return pool;
+}
+
+
+static bool
+_shared_connections_mongoses_discovered (mongoc_client_t *client)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_server_description_t *sd;
+   bool discovered = true;
+   uint32_t id;
+
+   snapshot = _mongoc_topology_snapshot_acquire (client->topology, NULL);
+   for (id = 1; id <= 2; id++) {
+      sd = mongoc_topology_description_server_by_id (
+         &snapshot->description, id, NULL);
+      discovered = discovered && sd && sd->type == MONGOC_SERVER_MONGOS;
+   }
+
+   _mongoc_topology_snapshot_release (snapshot);
+
+   return discovered;
+}
+
+
+/* run "ping" with client on the server with id server_id */
+static void
+_shared_connections_ping_server (mock_server_t *server,
+                                 mongoc_client_t *client,
+                                 uint32_t server_id)
+{
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+
+   future = future_client_command_with_opts (
+      client,
+      "admin",
+      tmp_bson ("{'ping': 1}"),
+      NULL,
+      tmp_bson ("{'serverId': %d}", server_id),
+      NULL,
+      &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+}
+
+
+/* maxIdleTimeMS applies to every server's idle connections, not only those
+ * to the server of the connection checked in or out */
+static void
+test_mongoc_client_pool_shared_connections_sweep_idle (void)
+{
+   mock_server_t *servers[2];
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+
+   pool = _shared_connections_sweep_pool_new (servers, "maxIdleTimeMS=100");
+   client = mongoc_client_pool_pop (pool);
+   WAIT_UNTIL (_shared_connections_mongoses_discovered (client));
+
+   _shared_connections_ping_server (servers[0], client, 1);
+   _shared_connections_ping_server (servers[1], client, 2);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 2);
+
+   /* the connection to the second server is closed when the first's is
+    * checked in */
+   _mongoc_usleep (200 * 1000);
+   _shared_connections_ping_server (servers[0], client, 1);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 1);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (servers[0]);
+   mock_server_destroy (servers[1]);
+}
+
+
+/* idle connections to a server that left the topology are closed */
+static void
+test_mongoc_client_pool_shared_connections_sweep_removed (void)
+{
+   mock_server_t *servers[2];
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+
+   pool =
+      _shared_connections_sweep_pool_new (servers, "heartbeatFrequencyMS=500");
+   client = mongoc_client_pool_pop (pool);
+   WAIT_UNTIL (_shared_connections_mongoses_discovered (client));
+
+   _shared_connections_ping_server (servers[0], client, 1);
+   _shared_connections_ping_server (servers[1], client, 2);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 2);
+
+   /* a sharded topology removes a server that is not a mongos */
+   mock_server_auto_ismaster (servers[1],
+                              "{'ok': 1, 'ismaster': true,"
+                              " 'minWireVersion': 0, 'maxWireVersion': %d}",
+                              WIRE_VERSION_OP_MSG);
+   WAIT_UNTIL (mongoc_topology_server_timestamp (client->topology, 2) == -1);
+
+   _shared_connections_ping_server (servers[0], client, 1);
+   ASSERT_CMPSIZE_T (_mongoc_client_pool_num_idle_connections (pool), ==, 1);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (servers[0]);
+   mock_server_destroy (servers[1]);
+}
+
+
+static void
+test_mongoc_client_pool_pop_with_timeout (void)
+{
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_uri_t *uri;
+   int64_t start;
+
+   uri = mongoc_uri_new ("mongodb://127.0.0.1/?maxpoolsize=1");
+   pool = mongoc_client_pool_new (uri);
+   client = mongoc_client_pool_pop_with_timeout (pool, 0);
+   BSON_ASSERT (client);
+
+   /* a zero timeout does not wait */
+   BSON_ASSERT (!mongoc_client_pool_pop_with_timeout (pool, 0));
+
+   start = bson_get_monotonic_time ();
+   BSON_ASSERT (!mongoc_client_pool_pop_with_timeout (pool, 50));
+   ASSERT_CMPINT64 (bson_get_monotonic_time () - start, >=, 50 * 1000);
+   ASSERT_CMPUINT32 (_mongoc_client_pool_num_waiters (pool), ==, 0);
+
+   mongoc_client_pool_push (pool, client);
+   BSON_ASSERT (client == mongoc_client_pool_pop_with_timeout (pool, 50));
+   mongoc_client_pool_push (pool, client);
+
+   mongoc_uri_destroy (uri);
+   mongoc_client_pool_destroy (pool);
+}
+
+
+static void
+test_mongoc_client_pool_wait_queue_timeout (void)
+{
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_uri_t *uri;
+
+   uri = mongoc_uri_new (
+      "mongodb://127.0.0.1/?maxpoolsize=1&waitqueuetimeoutms=10");
+   pool = mongoc_client_pool_new (uri);
+   client = mongoc_client_pool_pop (pool);
+   BSON_ASSERT (client);
+   BSON_ASSERT (!mongoc_client_pool_pop (pool));
+   mongoc_client_pool_push (pool, client);
+
+   mongoc_uri_destroy (uri);
+   mongoc_client_pool_destroy (pool);
+}
+
+
+typedef struct {
+   mongoc_client_pool_t *pool;
+   mongoc_mutex_t mutex;
+   int order[3];
+   int n_served;
+} waiters_test_t;
+
+typedef struct {
+   waiters_test_t *test;
+   int id;
+} waiter_thread_t;
+
+
+static void *
+_pop_and_push_worker (void *data)
+{
+   waiter_thread_t *waiter = (waiter_thread_t *) data;
+   waiters_test_t *test = waiter->test;
+   mongoc_client_t *client;
+
+   client = mongoc_client_pool_pop (test->pool);
+   BSON_ASSERT (client);
+
+   mongoc_mutex_lock (&test->mutex);
+   test->order[test->n_served++] = waiter->id;
+   mongoc_mutex_unlock (&test->mutex);
+
+   mongoc_client_pool_push (test->pool, client);
+
+   return NULL;
+}
+
+
+/* threads blocked in pop are served in the order they arrived */
+static void
+test_mongoc_client_pool_fifo_waiters (void)
+{
+   mongoc_uri_t *uri;
+   mongoc_client_t *client;
+   waiters_test_t test = {0};
+   waiter_thread_t waiters[3];
+   mongoc_thread_t threads[3];
+   int i;
+
+   uri = mongoc_uri_new ("mongodb://127.0.0.1/?maxpoolsize=1");
+   test.pool = mongoc_client_pool_new (uri);
+   mongoc_mutex_init (&test.mutex);
+   client = mongoc_client_pool_pop (test.pool);
+
+   for (i = 0; i < 3; i++) {
+      waiters[i].test = &test;
+      waiters[i].id = i;
+      BSON_ASSERT (!mongoc_thread_create (
+         &threads[i], &_pop_and_push_worker, &waiters[i]));
+      /* start the next thread only once this one is queued */
+      WAIT_UNTIL (_mongoc_client_pool_num_waiters (test.pool) ==
+                  (uint32_t) i + 1);
+   }
+
+   /* try_pop does not jump the queue */
+   BSON_ASSERT (!mongoc_client_pool_try_pop (test.pool));
+
+   mongoc_client_pool_push (test.pool, client);
+
+   for (i = 0; i < 3; i++) {
+      mongoc_thread_join (threads[i]);
+   }
+
+   ASSERT_CMPINT (test.n_served, ==, 3);
+   for (i = 0; i < 3; i++) {
+      ASSERT_CMPINT (test.order[i], ==, i);
+   }
+
+   ASSERT_CMPSIZE_T (mongoc_client_pool_get_size (test.pool), ==, (size_t) 1);
+
+   mongoc_mutex_destroy (&test.mutex);
+   mongoc_client_pool_destroy (test.pool);
+   mongoc_uri_destroy (uri);
+}
+
+
+/* raising maxPoolSize lets waiting threads create clients */
+static void
+test_mongoc_client_pool_max_size_wakes_waiters (void)
+{
+   mongoc_uri_t *uri;
+   mongoc_client_t *client;
+   waiters_test_t test = {0};
+   waiter_thread_t waiter;
+   mongoc_thread_t thread;
+
+   uri = mongoc_uri_new ("mongodb://127.0.0.1/?maxpoolsize=1");
+   test.pool = mongoc_client_pool_new (uri);
+   mongoc_mutex_init (&test.mutex);
+   client = mongoc_client_pool_pop (test.pool);
+
+   waiter.test = &test;
+   waiter.id = 0;
+   BSON_ASSERT (
+      !mongoc_thread_create (&thread, &_pop_and_push_worker, &waiter));
+   WAIT_UNTIL (_mongoc_client_pool_num_waiters (test.pool) == 1);
+
+   mongoc_client_pool_max_size (test.pool, 2);
+   mongoc_thread_join (thread);
+
+   ASSERT_CMPINT (test.n_served, ==, 1);
+   ASSERT_CMPSIZE_T (mongoc_client_pool_get_size (test.pool), ==, (size_t) 2);
+
+   mongoc_client_pool_push (test.pool, client);
+   mongoc_mutex_destroy (&test.mutex);
+   mongoc_client_pool_destroy (test.pool);
+   mongoc_uri_destroy (uri);
+}
+
+
+/* concurrent insert_one calls from clients of a pool with coalesceWritesMS
+ * are sent as one unordered insert, and each caller gets its own result */
+static void
+test_mongoc_client_pool_coalesce_writes (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *clients[3];
+   mongoc_collection_t *collections[3];
+   future_t *futures[3];
+   bson_t replies[3];
+   bson_error_t errors[3];
+   request_t *request;
+   bson_iter_t iter;
+   char *reply_json;
+   int dupe_idx = -1;
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   /* linger long enough that only the batch size closes the group */
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_COALESCEWRITESMS, 60000);
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_COALESCEMAXBATCHSIZE, 3);
+   pool = mongoc_client_pool_new (uri);
+
+   for (i = 0; i < 3; i++) {
+      clients[i] = mongoc_client_pool_pop (pool);
+      collections[i] =
+         mongoc_client_get_collection (clients[i], "db", "collection");
+      futures[i] = future_collection_insert_one (collections[i],
+                                                 tmp_bson ("{'_id': %d}", i),
+                                                 NULL,
+                                                 &replies[i],
+                                                 &errors[i]);
+   }
+
+   /* the three documents come in one command, in the order the threads
+    * joined the group */
+   request = mock_server_receives_request (server);
+   ASSERT_CMPSTR (request->command_name, "insert");
+   ASSERT_MATCH (request_get_doc (request, 0),
+                 "{'insert': 'collection', 'ordered': false}");
+   ASSERT_CMPSIZE_T (request->docs.len, ==, (size_t) 4);
+   for (i = 0; i < 3; i++) {
+      BSON_ASSERT (
+         bson_iter_init_find (&iter, request_get_doc (request, i + 1), "_id"));
+      if (bson_iter_int32 (&iter) == 1) {
+         dupe_idx = i;
+      }
+   }
+
+   BSON_ASSERT (dupe_idx >= 0);
+   reply_json = bson_strdup_printf ("{'ok': 1, 'n': 2, 'writeErrors': [{"
+                                    "'index': %d, 'code': 11000,"
+                                    " 'errmsg': 'dupe'}]}",
+                                    dupe_idx);
+   mock_server_replies_simple (request, reply_json);
+   request_destroy (request);
+   bson_free (reply_json);
+
+   for (i = 0; i < 3; i++) {
+      if (i == 1) {
+         BSON_ASSERT (!future_get_bool (futures[i]));
+         ASSERT_ERROR_CONTAINS (
+            errors[i], MONGOC_ERROR_COLLECTION, 11000, "dupe");
+         ASSERT_MATCH (&replies[i],
+                       "{'insertedCount': 0,"
+                       " 'writeErrors': [{'index': 0, 'code': 11000}]}");
+      } else {
+         ASSERT_OR_PRINT (future_get_bool (futures[i]), errors[i]);
+         ASSERT_MATCH (
+            &replies[i],
+            "{'insertedCount': 1, 'writeErrors': {'$exists': false}}");
+      }
+
+      bson_destroy (&replies[i]);
+      future_destroy (futures[i]);
+   }
+
+   /* an insert with options is sent alone, at once */
+   futures[0] = future_collection_insert_one (
+      collections[0],
+      tmp_bson ("{'_id': 3}"),
+      tmp_bson ("{'bypassDocumentValidation': true}"),
+      NULL,
+      &errors[0]);
+   request = mock_server_receives_msg (server,
+                                       0,
+                                       tmp_bson ("{'insert': 'collection'}"),
+                                       tmp_bson ("{'_id': 3}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   request_destroy (request);
+   ASSERT_OR_PRINT (future_get_bool (futures[0]), errors[0]);
+   future_destroy (futures[0]);
+
+   for (i = 0; i < 3; i++) {
+      mongoc_collection_destroy (collections[i]);
+      mongoc_client_pool_push (pool, clients[i]);
+   }
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+
+/* return the _id of the request's n-th document */
+static int32_t
+_request_doc_id (request_t *request, int n)
+{
+   bson_iter_t iter;
+
+   BSON_ASSERT (
+      bson_iter_init_find (&iter, request_get_doc (request, n + 1), "_id"));
+
+   return bson_iter_int32 (&iter);
+}
+
+
+/* a document over the max BSON size is sent alone and its error is its own,
+ * and a group is sent once the next document would not fit in one message */
+static void
+test_mongoc_client_pool_coalesce_writes_sizes (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *clients[3];
+   mongoc_collection_t *collections[3];
+   future_t *futures[3];
+   bson_error_t errors[3];
+   request_t *request;
+   char big[381];
+   char oversized[601];
+   int first;
+   int i;
+
+   memset (big, 'a', sizeof big - 1);
+   big[sizeof big - 1] = '\0';
+   memset (oversized, 'a', sizeof oversized - 1);
+   oversized[sizeof oversized - 1] = '\0';
+
+   /* groups hold at most 1200 - 500 bytes of documents */
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxBsonObjectSize': 500,"
+                              " 'maxMessageSizeBytes': 1200}",
+                              WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_COALESCEWRITESMS, 60000);
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_COALESCEMAXBATCHSIZE, 2);
+   pool = mongoc_client_pool_new (uri);
+
+   for (i = 0; i < 3; i++) {
+      clients[i] = mongoc_client_pool_pop (pool);
+      collections[i] =
+         mongoc_client_get_collection (clients[i], "db", "collection");
+
+      /* connect, so the client knows the server's max sizes */
+      futures[i] = future_client_command_simple (
+         clients[i], "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, NULL);
+      request = mock_server_receives_msg (
+         server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+      mock_server_replies_ok_and_destroys (request);
+      BSON_ASSERT (future_get_bool (futures[i]));
+      future_destroy (futures[i]);
+   }
+
+   futures[0] = future_collection_insert_one (
+      collections[0], tmp_bson ("{'_id': 0}"), NULL, NULL, &errors[0]);
+   futures[1] = future_collection_insert_one (
+      collections[1],
+      tmp_bson ("{'_id': 1, 's': '%s'}", oversized),
+      NULL,
+      NULL,
+      &errors[1]);
+
+   /* the oversized document does not join the group */
+   request = mock_server_receives_request (server);
+   ASSERT_CMPSIZE_T (request->docs.len, ==, (size_t) 2);
+   ASSERT_CMPINT (_request_doc_id (request, 0), ==, 1);
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'n': 0, 'writeErrors': [{"
+                               "'index': 0, 'code': 10334,"
+                               " 'errmsg': 'too large'}]}");
+   request_destroy (request);
+   BSON_ASSERT (!future_get_bool (futures[1]));
+   ASSERT_ERROR_CONTAINS (
+      errors[1], MONGOC_ERROR_COLLECTION, 10334, "too large");
+   future_destroy (futures[1]);
+
+   /* the group is still open and takes the next small document */
+   futures[1] = future_collection_insert_one (
+      collections[1], tmp_bson ("{'_id': 2}"), NULL, NULL, &errors[1]);
+   request = mock_server_receives_request (server);
+   ASSERT_CMPSIZE_T (request->docs.len, ==, (size_t) 3);
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 2}");
+   request_destroy (request);
+   for (i = 0; i < 2; i++) {
+      ASSERT_OR_PRINT (future_get_bool (futures[i]), errors[i]);
+      future_destroy (futures[i]);
+   }
+
+   /* two big documents don't fit in one message: the first is sent alone,
+    * the second starts a group */
+   for (i = 0; i < 2; i++) {
+      futures[i] =
+         future_collection_insert_one (collections[i],
+                                       tmp_bson ("{'_id': %d, 's': '%s'}",
+                                                 i + 3,
+                                                 big),
+                                       NULL,
+                                       NULL,
+                                       &errors[i]);
+   }
+
+   request = mock_server_receives_request (server);
+   ASSERT_CMPSIZE_T (request->docs.len, ==, (size_t) 2);
+   first = _request_doc_id (request, 0) - 3;
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   request_destroy (request);
+   ASSERT_OR_PRINT (future_get_bool (futures[first]), errors[first]);
+   future_destroy (futures[first]);
+
+   futures[2] = future_collection_insert_one (
+      collections[2], tmp_bson ("{'_id': 5}"), NULL, NULL, &errors[2]);
+   request = mock_server_receives_request (server);
+   ASSERT_CMPSIZE_T (request->docs.len, ==, (size_t) 3);
+   ASSERT_CMPINT (_request_doc_id (request, 0), ==, 4 - first);
+   ASSERT_CMPINT (_request_doc_id (request, 1), ==, 5);
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 2}");
+   request_destroy (request);
+   for (i = 0; i < 3; i++) {
+      if (i != first) {
+         ASSERT_OR_PRINT (future_get_bool (futures[i]), errors[i]);
+         future_destroy (futures[i]);
+      }
+   }
+
+   for (i = 0; i < 3; i++) {
+      mongoc_collection_destroy (collections[i]);
+      mongoc_client_pool_push (pool, clients[i]);
+   }
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+
+typedef struct {
+   mongoc_client_pool_t *pool;
+   mongoc_mutex_t mutex;
+   mongoc_client_t *in_use[8];
+} contention_test_t;
+
+
+static void *
+_contention_worker (void *data)
+{
+   contention_test_t *test = (contention_test_t *) data;
+   mongoc_client_t *client;
+   int i;
+   int j;
+
+   for (i = 0; i < 2000; i++) {
+      client = (i % 2) ? mongoc_client_pool_pop (test->pool)
+                       : mongoc_client_pool_try_pop (test->pool);
+      if (!client) {
+         continue;
+      }
+
+      /* no other thread may hold this client */
+      mongoc_mutex_lock (&test->mutex);
+      for (j = 0; j < 8; j++) {
+         BSON_ASSERT (test->in_use[j] != client);
+      }
+      for (j = 0; test->in_use[j]; j++) {
+      }
+      test->in_use[j] = client;
+      mongoc_mutex_unlock (&test->mutex);
+
+      mongoc_mutex_lock (&test->mutex);
+      test->in_use[j] = NULL;
+      mongoc_mutex_unlock (&test->mutex);
+
+      mongoc_client_pool_push (test->pool, client);
+   }
+
+   return NULL;
+}
+
+
+/* more threads than clients popping and pushing, mostly without the pool's
+ * mutex: every client is held by one thread at a time and none is lost */
+static void
+test_mongoc_client_pool_contention (void)
+{
+   mongoc_uri_t *uri;
+   contention_test_t test = {0};
+   mongoc_thread_t threads[8];
+   int i;
+
+   uri = mongoc_uri_new ("mongodb://127.0.0.1/?maxpoolsize=4");
+   test.pool = mongoc_client_pool_new (uri);
+   mongoc_mutex_init (&test.mutex);
+
+   for (i = 0; i < 8; i++) {
+      BSON_ASSERT (
+         !mongoc_thread_create (&threads[i], &_contention_worker, &test));
+   }
+
+   for (i = 0; i < 8; i++) {
+      mongoc_thread_join (threads[i]);
+   }
+
+   ASSERT_CMPSIZE_T (mongoc_client_pool_get_size (test.pool), <=, (size_t) 4);
+   ASSERT_CMPSIZE_T (mongoc_client_pool_num_pushed (test.pool),
+                     ==,
+                     mongoc_client_pool_get_size (test.pool));
+   ASSERT_CMPUINT32 (_mongoc_client_pool_num_waiters (test.pool), ==, 0);
+
+   mongoc_mutex_destroy (&test.mutex);
+   mongoc_client_pool_destroy (test.pool);
+   mongoc_uri_destroy (uri);
+}
+
+
 void
 test_client_pool_install (TestSuite *suite)
 {
@@ -298,9 +1131,48 @@ test_client_pool_install (TestSuite *suite)
       suite, "/ClientPool/set_max_size", test_mongoc_client_pool_set_max_size);
    TestSuite_Add (
       suite, "/ClientPool/set_min_size", test_mongoc_client_pool_set_min_size);
+   TestSuite_Add (suite,
+                  "/ClientPool/pop_with_timeout",
+                  test_mongoc_client_pool_pop_with_timeout);
+   TestSuite_Add (suite,
+                  "/ClientPool/wait_queue_timeout",
+                  test_mongoc_client_pool_wait_queue_timeout);
+   TestSuite_Add (suite,
+                  "/ClientPool/fifo_waiters",
+                  test_mongoc_client_pool_fifo_waiters);
+   TestSuite_Add (suite,
+                  "/ClientPool/max_size_wakes_waiters",
+                  test_mongoc_client_pool_max_size_wakes_waiters);
+   TestSuite_Add (
+      suite, "/ClientPool/contention", test_mongoc_client_pool_contention);
 
    TestSuite_Add (
       suite, "/ClientPool/handshake", test_mongoc_client_pool_handshake);
+   TestSuite_AddMockServerTest (suite,
+                                "/ClientPool/shared_connections",
+                                test_mongoc_client_pool_shared_connections);
+   TestSuite_AddMockServerTest (
+      suite,
+      "/ClientPool/shared_connections/hangup",
+      test_mongoc_client_pool_shared_connections_hangup);
+   TestSuite_AddMockServerTest (
+      suite,
+      "/ClientPool/shared_connections/max_idle",
+      test_mongoc_client_pool_shared_connections_max_idle);
+   TestSuite_AddMockServerTest (
+      suite,
+      "/ClientPool/shared_connections/sweep/idle",
+      test_mongoc_client_pool_shared_connections_sweep_idle);
+   TestSuite_AddMockServerTest (
+      suite,
+      "/ClientPool/shared_connections/sweep/removed",
+      test_mongoc_client_pool_shared_connections_sweep_removed);
+   TestSuite_AddMockServerTest (suite,
+                                "/ClientPool/coalesce_writes",
+                                test_mongoc_client_pool_coalesce_writes);
+   TestSuite_AddMockServerTest (suite,
+                                "/ClientPool/coalesce_writes/sizes",
+                                test_mongoc_client_pool_coalesce_writes_sizes);
 
 #ifndef MONGOC_ENABLE_SSL
    TestSuite_Add (
@@ -177,7 +177,7 @@ _test_session_pool_timeout (bool pooled)
     * get a session, set last_used_date more than 29 minutes ago and return to
     * the pool. it's timed out & freed.
     */
-   BSON_ASSERT (!client->topology->session_pool);
+   BSON_ASSERT (!client->session_cache);
    s = mongoc_client_start_session (client, NULL, &error);
    ASSERT_OR_PRINT (s, error);
    bson_copy_to (mongoc_client_session_get_lsid (s), &lsid);
@@ -186,7 +186,7 @@ _test_session_pool_timeout (bool pooled)
       (bson_get_monotonic_time () - almost_timeout_usec - 100);
 
    mongoc_client_session_destroy (s);
-   BSON_ASSERT (!client->topology->session_pool);
+   BSON_ASSERT (!client->session_cache);
 
    /*
     * get a new session, set last_used_date so it has one second left to live,
@@ -202,15 +202,15 @@ _test_session_pool_timeout (bool pooled)
       (bson_get_monotonic_time () + 1000 * 1000 - almost_timeout_usec);
 
    mongoc_client_session_destroy (s);
-   BSON_ASSERT (client->topology->session_pool);
-   ASSERT_SESSIONS_MATCH (&lsid, &client->topology->session_pool->lsid);
+   BSON_ASSERT (client->session_cache);
+   ASSERT_SESSIONS_MATCH (&lsid, &client->session_cache->lsid);
 
    _mongoc_usleep (1500 * 1000);
 
    /* getting a new client session must start a new server session */
    s = mongoc_client_start_session (client, NULL, &error);
    ASSERT_SESSIONS_DIFFER (&lsid, mongoc_client_session_get_lsid (s));
-   BSON_ASSERT (!client->topology->session_pool);
+   BSON_ASSERT (!client->session_cache);
    mongoc_client_session_destroy (s);
 
    if (pooled) {
@@ -254,7 +254,7 @@ _test_session_pool_reap (bool pooled)
    bson_error_t error;
    bson_t lsid_a, lsid_b;
    int64_t almost_timeout_usec;
-   mongoc_server_session_t *session_pool;
+   mongoc_server_session_t *session_cache;
 
    almost_timeout_usec =
       (test_framework_session_timeout_minutes () - 1) * 60 * 1000 * 1000;
@@ -286,7 +286,7 @@ _test_session_pool_reap (bool pooled)
       (bson_get_monotonic_time () + 1000 * 1000 - almost_timeout_usec);
 
    mongoc_client_session_destroy (a);
-   BSON_ASSERT (client->topology->session_pool); /* session is pooled */
+   BSON_ASSERT (client->session_cache); /* session is pooled */
 
    _mongoc_usleep (1500 * 1000);
 
@@ -295,12 +295,12 @@ _test_session_pool_reap (bool pooled)
     */
    b->server_session->last_used_usec = bson_get_monotonic_time ();
    mongoc_client_session_destroy (b);
-   BSON_ASSERT (client->topology->session_pool);
-   ASSERT_SESSIONS_MATCH (&lsid_b, &client->topology->session_pool->lsid);
+   BSON_ASSERT (client->session_cache);
+   ASSERT_SESSIONS_MATCH (&lsid_b, &client->session_cache->lsid);
    /* session B is the only session in the pool */
-   session_pool = client->topology->session_pool;
-   BSON_ASSERT (session_pool == session_pool->prev);
-   BSON_ASSERT (session_pool == session_pool->next);
+   session_cache = client->session_cache;
+   BSON_ASSERT (session_cache == session_cache->prev);
+   BSON_ASSERT (session_cache == session_cache->next);
 
    if (pooled) {
       mongoc_client_pool_push (pool, client);
@@ -501,6 +501,78 @@ test_mock_end_sessions_pooled (void)
    _test_mock_end_sessions (true);
 }
 
+/* implicit sessions reuse the server session the client ended last, without
+ * the topology's pool, and new lsids come from a reserve generated in bulk */
+static void
+_test_mock_session_cache (bool pooled)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool = NULL;
+   mongoc_client_t *client;
+   bson_error_t error;
+   bson_t first_lsid;
+   bson_t lsid;
+   future_t *future;
+   request_t *request;
+   int i;
+
+   server = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+
+   if (pooled) {
+      pool = mongoc_client_pool_new (mock_server_get_uri (server));
+      client = mongoc_client_pool_pop (pool);
+   } else {
+      client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   }
+
+   for (i = 0; i < 3; i++) {
+      future = future_client_command_simple (
+         client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+      request = mock_server_receives_msg (
+         server, 0, tmp_bson ("{'ping': 1, 'lsid': {'$exists': true}}"));
+      bson_lookup_doc (request_get_doc (request, 0), "lsid", &lsid);
+      if (i == 0) {
+         bson_copy_to (&lsid, &first_lsid);
+      } else {
+         ASSERT_SESSIONS_MATCH (&first_lsid, &lsid);
+      }
+
+      mock_server_replies_ok_and_destroys (request);
+      ASSERT_OR_PRINT (future_get_bool (future), error);
+      future_destroy (future);
+   }
+
+   BSON_ASSERT (!client->topology->session_pool);
+   ASSERT_CMPUINT32 (client->n_cached_sessions, ==, (uint32_t) 1);
+   ASSERT_SESSIONS_MATCH (&first_lsid, &client->session_cache->lsid);
+   ASSERT_CMPUINT32 (
+      client->lsid_reserve.n, ==, (uint32_t) MONGOC_LSID_RESERVE_SIZE - 1);
+
+   if (pooled) {
+      mongoc_client_pool_push (pool, client);
+      mongoc_client_pool_destroy (pool);
+   } else {
+      mongoc_client_destroy (client);
+   }
+
+   bson_destroy (&first_lsid);
+   mock_server_destroy (server);
+}
+
+static void
+test_mock_session_cache_single (void)
+{
+   _test_mock_session_cache (false);
+}
+
+static void
+test_mock_session_cache_pooled (void)
+{
+   _test_mock_session_cache (true);
+}
+
 typedef struct {
    int started_calls;
    int succeeded_calls;
@@ -1150,7 +1222,7 @@ check_session_returned (session_test_t *test, const bson_t *lsid)
    bool found;
 
    found = false;
-   CDL_FOREACH (test->session_client->topology->session_pool, ss)
+   CDL_FOREACH (test->session_client->session_cache, ss)
    {
       if (match_bson_with_ctx (&ss->lsid, lsid, false, &ctx)) {
          found = true;
@@ -1158,6 +1230,17 @@ check_session_returned (session_test_t *test, const bson_t *lsid)
       }
    }
 
+   /* or the client's cache overflowed to the topology's pool */
+   if (!found) {
+      CDL_FOREACH (test->session_client->topology->session_pool, ss)
+      {
+         if (match_bson_with_ctx (&ss->lsid, lsid, false, &ctx)) {
+            found = true;
+            break;
+         }
+      }
+   }
+
    if (!found) {
       fprintf (stderr,
                "server session %s not returned to pool\n",
@@ -1422,9 +1505,8 @@ lsid_test (session_test_fn_t test_fn)
    test_fn (test);
    check_success (test);
    mongoc_collection_drop_with_opts (test->session_collection, NULL, NULL);
-   BSON_ASSERT (test->client->topology->session_pool);
-   ASSERT_CMPINT64 (
-      test->client->topology->session_pool->last_used_usec, >=, start);
+   BSON_ASSERT (test->client->session_cache);
+   ASSERT_CMPINT64 (test->client->session_cache->last_used_usec, >=, start);
    session_test_destroy (test);
    bson_destroy (&cluster_time);
 }
@@ -2067,12 +2149,12 @@ test_find_indexes (session_test_t *test)
 }
 
 
-#define ASSERT_POOL_SIZE(_topology, _expected_size)             \
-   do {                                                         \
-      const mongoc_server_session_t *_tmp;                      \
-      int _n_sessions;                                          \
-      CDL_COUNT ((_topology)->session_pool, _tmp, _n_sessions); \
-      ASSERT_CMPINT (_n_sessions, ==, (int) (_expected_size));  \
+#define ASSERT_POOL_SIZE(_client, _expected_size)              \
+   do {                                                        \
+      const mongoc_server_session_t *_tmp;                     \
+      int _n_sessions;                                         \
+      CDL_COUNT ((_client)->session_cache, _tmp, _n_sessions); \
+      ASSERT_CMPINT (_n_sessions, ==, (int) (_expected_size)); \
    } while (0)
 
 
@@ -2080,7 +2162,7 @@ static void
 test_cursor_implicit_session (void *ctx)
 {
    session_test_t *test;
-   mongoc_topology_t *topology;
+   mongoc_client_t *client;
    mongoc_cursor_t *cursor;
    const bson_t *doc;
    mongoc_client_session_t *cs;
@@ -2089,7 +2171,7 @@ test_cursor_implicit_session (void *ctx)
 
    test = session_test_new (CORRECT_CLIENT, NOT_CAUSAL);
    test->expect_explicit_lsid = false;
-   topology = test->client->topology;
+   client = test->client;
    cs = mongoc_client_start_session (test->client, NULL, &error);
    ASSERT_OR_PRINT (cs, error);
 
@@ -2106,13 +2188,13 @@ test_cursor_implicit_session (void *ctx)
    BSON_ASSERT (cursor->client_session);
    BSON_ASSERT (!cursor->explicit_session);
    bson_copy_to (&cursor->client_session->server_session->lsid, &find_lsid);
-   ASSERT_POOL_SIZE (topology, 0);
+   ASSERT_POOL_SIZE (client, 0);
    ASSERT_SESSIONS_MATCH (&test->sent_lsid, &find_lsid);
 
    /* push a new server session into the pool */
    mongoc_client_session_destroy (cs);
-   ASSERT_POOL_SIZE (topology, 1);
-   ASSERT_SESSIONS_DIFFER (&find_lsid, &topology->session_pool->lsid);
+   ASSERT_POOL_SIZE (client, 1);
+   ASSERT_SESSIONS_DIFFER (&find_lsid, &client->session_cache->lsid);
 
    /* "getMore" uses the same lsid as "find" did */
    bson_reinit (&test->sent_lsid);
@@ -2122,7 +2204,7 @@ test_cursor_implicit_session (void *ctx)
 
    /* lsid returned after last batch, doesn't wait for mongoc_cursor_destroy */
    check_session_returned (test, &find_lsid);
-   ASSERT_POOL_SIZE (topology, 2);
+   ASSERT_POOL_SIZE (client, 2);
 
    bson_destroy (&find_lsid);
    mongoc_cursor_destroy (cursor);
@@ -2134,7 +2216,7 @@ static void
 test_change_stream_implicit_session (void *ctx)
 {
    session_test_t *test;
-   mongoc_topology_t *topology;
+   mongoc_client_t *client;
    mongoc_client_session_t *cs;
    bson_error_t error;
    mongoc_change_stream_t *change_stream;
@@ -2144,20 +2226,20 @@ test_change_stream_implicit_session (void *ctx)
 
    test = session_test_new (CORRECT_CLIENT, NOT_CAUSAL);
    test->expect_explicit_lsid = false;
-   topology = test->client->topology;
+   client = test->client;
    cs = mongoc_client_start_session (test->client, NULL, &error);
    ASSERT_OR_PRINT (cs, error);
    change_stream =
       mongoc_collection_watch (test->session_collection, &pipeline, NULL);
    bson_destroy (&pipeline);
    bson_copy_to (&test->sent_lsid, &aggregate_lsid);
-   ASSERT_POOL_SIZE (topology, 0);
+   ASSERT_POOL_SIZE (client, 0);
    BSON_ASSERT (change_stream->implicit_session);
 
    /* push a new server session into the pool */
    mongoc_client_session_destroy (cs);
-   ASSERT_POOL_SIZE (topology, 1);
-   ASSERT_SESSIONS_DIFFER (&aggregate_lsid, &topology->session_pool->lsid);
+   ASSERT_POOL_SIZE (client, 1);
+   ASSERT_SESSIONS_DIFFER (&aggregate_lsid, &client->session_cache->lsid);
 
    /* "getMore" uses the same lsid as "aggregate" did */
    bson_reinit (&test->sent_lsid);
@@ -2496,6 +2578,14 @@ test_session_install (TestSuite *suite)
                                 "/Session/end/mock/pooled",
                                 test_mock_end_sessions_pooled,
                                 test_framework_skip_if_no_crypto);
+   TestSuite_AddMockServerTest (suite,
+                                "/Session/cache/mock/single",
+                                test_mock_session_cache_single,
+                                test_framework_skip_if_no_crypto);
+   TestSuite_AddMockServerTest (suite,
+                                "/Session/cache/mock/pooled",
+                                test_mock_session_cache_pooled,
+                                test_framework_skip_if_no_crypto);
    TestSuite_AddFull (suite,
                       "/Session/end/single",
                       test_end_sessions_single,
@@ -5,6 +5,7 @@
 #include <mongoc-read-concern-private.h>
 
 #include "mongoc-client-private.h"
+#include "mongoc-cluster-private.h"
 #include "mongoc-cursor-private.h"
 #include "mongoc-util-private.h"
 
@@ -530,7 +531,7 @@ test_mongoc_client_authenticate_cached (bool pooled)
    }
 
    /* screw up the cache */
-   memcpy (client->cluster.scram_cache->client_key, "foo", 3);
+   memcpy (client->topology->scram_cache->client_key, "foo", 3);
    cursor = mongoc_collection_find_with_opts (collection, &insert, NULL, NULL);
    capture_logs (true);
    r = mongoc_cursor_next (cursor, &doc);
@@ -1548,6 +1549,247 @@ test_command_with_opts_op_msg (void)
 }
 
 
+static void
+test_command_with_opts_borrowed (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_buffer_t *buffer;
+   bson_t reply;
+   const uint8_t *first_data;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+
+   server = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   buffer = &client->cluster.reply_buffer;
+
+   future = future_client_command_with_opts_borrowed (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &reply, &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   request_destroy (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   /* the reply points into the client's receive buffer, not a copy */
+   ASSERT_MATCH (&reply, "{'ok': 1, 'n': 1}");
+   first_data = bson_get_data (&reply);
+   ASSERT (first_data > buffer->data);
+   ASSERT (first_data + reply.len <= buffer->data + buffer->len);
+   bson_destroy (&reply);
+
+   /* the next command reuses the same buffer */
+   future = future_client_command_with_opts_borrowed (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &reply, &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 2}");
+   request_destroy (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   ASSERT_MATCH (&reply, "{'ok': 1, 'n': 2}");
+   ASSERT (bson_get_data (&reply) == first_data);
+   bson_destroy (&reply);
+
+   /* a plain command still copies the reply */
+   future = future_client_command_with_opts (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &reply, &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 3}");
+   request_destroy (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   ASSERT_MATCH (&reply, "{'ok': 1, 'n': 3}");
+   ASSERT (bson_get_data (&reply) != first_data);
+   bson_destroy (&reply);
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_command_batch_pipelined (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   const bson_t *commands[3];
+   bson_t replies[3];
+   request_t *requests[3];
+   bson_error_t error;
+   future_t *future;
+   int i;
+
+   server = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+
+   commands[0] = tmp_bson ("{'find': 'a'}");
+   commands[1] = tmp_bson ("{'find': 'b'}");
+   commands[2] = tmp_bson ("{'find': 'c'}");
+   future = future_client_command_batch_with_opts (
+      client, "db", commands, 3, NULL, NULL, replies, &error);
+
+   /* all requests arrive before any reply is sent */
+   requests[0] =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'find': 'a'}"));
+   requests[1] =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'find': 'b'}"));
+   requests[2] =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'find': 'c'}"));
+
+   /* replies are matched by responseTo, not by arrival order */
+   mock_server_replies_simple (requests[2], "{'ok': 1, 'n': 2}");
+   mock_server_replies_simple (requests[0], "{'ok': 1, 'n': 0}");
+   mock_server_replies_simple (requests[1], "{'ok': 1, 'n': 1}");
+
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   for (i = 0; i < 3; i++) {
+      ASSERT_CMPINT32 (bson_lookup_int32 (&replies[i], "n"), ==, i);
+      bson_destroy (&replies[i]);
+      request_destroy (requests[i]);
+   }
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* no more than MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS commands are written
+ * ahead of their replies */
+static void
+test_command_batch_in_flight_limit (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   const bson_t *commands[MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS + 1];
+   bson_t replies[MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS + 1];
+   request_t *requests[MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS + 1];
+   bson_error_t error;
+   future_t *future;
+   int n = MONGOC_CLUSTER_PIPELINE_MAX_COMMANDS + 1;
+   int i;
+
+   server = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+
+   for (i = 0; i < n; i++) {
+      commands[i] = tmp_bson ("{'ping': %d}", i);
+   }
+
+   future = future_client_command_batch_with_opts (
+      client, "db", commands, (size_t) n, NULL, NULL, replies, &error);
+
+   for (i = 0; i < n - 1; i++) {
+      requests[i] = mock_server_receives_msg (
+         server, 0, tmp_bson ("{'ping': %d}", i));
+   }
+
+   /* the last command waits for a reply */
+   mock_server_set_request_timeout_msec (server, 100);
+   ASSERT (!mock_server_receives_request (server));
+   mock_server_set_request_timeout_msec (server, get_future_timeout_ms ());
+
+   mock_server_replies_ok_and_destroys (requests[0]);
+   requests[n - 1] = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'ping': %d}", n - 1));
+
+   for (i = 1; i < n; i++) {
+      mock_server_replies_ok_and_destroys (requests[i]);
+   }
+
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   for (i = 0; i < n; i++) {
+      bson_destroy (&replies[i]);
+   }
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_command_batch_error (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   const bson_t *commands[2];
+   bson_t replies[2];
+   request_t *request;
+   bson_error_t error;
+   future_t *future;
+
+   server = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+
+   /* a command error fails only its own command */
+   commands[0] = tmp_bson ("{'find': 'a'}");
+   commands[1] = tmp_bson ("{'find': 'b'}");
+   future = future_client_command_batch_with_opts (
+      client, "db", commands, 2, NULL, NULL, replies, &error);
+
+   request =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'find': 'a'}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 0, 'code': 2, 'errmsg': 'bad'}");
+   request_destroy (request);
+   request =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'find': 'b'}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   request_destroy (request);
+
+   ASSERT (!future_get_bool (future));
+   future_destroy (future);
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_QUERY, 2, "bad");
+   ASSERT_MATCH (&replies[0], "{'ok': 0, 'code': 2}");
+   ASSERT_MATCH (&replies[1], "{'ok': 1, 'n': 1}");
+   bson_destroy (&replies[0]);
+   bson_destroy (&replies[1]);
+
+   /* a network error fails every command without a reply */
+   future = future_client_command_batch_with_opts (
+      client, "db", commands, 2, NULL, NULL, replies, &error);
+
+   request =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'find': 'a'}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 0}");
+   request_destroy (request);
+   request =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'find': 'b'}"));
+   mock_server_hangs_up (request);
+   request_destroy (request);
+
+   ASSERT (!future_get_bool (future));
+   future_destroy (future);
+   ASSERT_CMPINT (error.domain, ==, MONGOC_ERROR_STREAM);
+   ASSERT_MATCH (&replies[0], "{'ok': 1, 'n': 0}");
+   ASSERT (bson_empty (&replies[1]));
+   bson_destroy (&replies[0]);
+   bson_destroy (&replies[1]);
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_command_empty (void)
 {
@@ -3376,6 +3618,158 @@ test_null_error_pointer_pooled (void *ctx)
    _test_null_error_pointer (true);
 }
 
+static int64_t
+_max_time_ms_for (mongoc_client_t *client,
+                  mock_server_t *server,
+                  const char *opts_json)
+{
+   future_t *future;
+   request_t *request;
+   bson_iter_t iter;
+   bson_error_t error;
+   int64_t max_time_ms;
+
+   future = future_client_read_command_with_opts (client,
+                                                  "db",
+                                                  tmp_bson ("{'count': 'c'}"),
+                                                  NULL,
+                                                  tmp_bson (opts_json),
+                                                  NULL,
+                                                  &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'count': 'c'}"));
+   if (bson_iter_init_find (
+          &iter, request_get_doc (request, 0), "maxTimeMS")) {
+      max_time_ms = bson_iter_as_int64 (&iter);
+   } else {
+      max_time_ms = -1;
+   }
+
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   return max_time_ms;
+}
+
+
+/* timeoutMS is sent to the server as maxTimeMS */
+static void
+test_timeout_ms_max_time_ms (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_t *client;
+   int64_t max_time_ms;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   client = mongoc_client_new_from_uri (uri);
+
+   /* no timeoutMS, no maxTimeMS */
+   ASSERT_CMPINT64 (_max_time_ms_for (client, server, "{}"), ==, (int64_t) -1);
+
+   max_time_ms = _max_time_ms_for (client, server, "{'timeoutMS': 1000}");
+   ASSERT_CMPINT64 (max_time_ms, >, (int64_t) 0);
+   ASSERT_CMPINT64 (max_time_ms, <=, (int64_t) 1000);
+
+   /* the user's own maxTimeMS is left alone */
+   max_time_ms =
+      _max_time_ms_for (client, server, "{'timeoutMS': 1000, 'maxTimeMS': 5}");
+   ASSERT_CMPINT64 (max_time_ms, ==, (int64_t) 5);
+
+   mongoc_client_destroy (client);
+
+   /* the URI option applies to every operation, and an operation's own
+    * timeoutMS overrides it */
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_TIMEOUTMS, 60000);
+   client = mongoc_client_new_from_uri (uri);
+
+   max_time_ms = _max_time_ms_for (client, server, "{}");
+   ASSERT_CMPINT64 (max_time_ms, >, (int64_t) 50000);
+   ASSERT_CMPINT64 (max_time_ms, <=, (int64_t) 60000);
+
+   max_time_ms = _max_time_ms_for (client, server, "{'timeoutMS': 1000}");
+   ASSERT_CMPINT64 (max_time_ms, >, (int64_t) 0);
+   ASSERT_CMPINT64 (max_time_ms, <=, (int64_t) 1000);
+
+   mongoc_client_destroy (client);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+
+/* timeoutMS cuts short the wait for a reply, well before socketTimeoutMS */
+static void
+test_timeout_ms_expires (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   int64_t start;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+
+   start = bson_get_monotonic_time ();
+   future = future_client_read_command_with_opts (client,
+                                                  "db",
+                                                  tmp_bson ("{'ping': 1}"),
+                                                  NULL,
+                                                  tmp_bson ("{'timeoutMS': 99}"),
+                                                  NULL,
+                                                  &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+
+   /* never reply */
+   BSON_ASSERT (!future_get_bool (future));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_STREAM,
+                          MONGOC_ERROR_STREAM_SOCKET,
+                          "socket error or timeout");
+   ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, (int64_t) 5000000);
+
+   request_destroy (request);
+   future_destroy (future);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* timeoutMS cuts short server selection, well before
+ * serverSelectionTimeoutMS */
+static void
+test_timeout_ms_server_selection (void)
+{
+   mongoc_client_t *client;
+   bson_error_t error;
+   int64_t start;
+
+   client = mongoc_client_new (
+      "mongodb://127.0.0.1:1/?serverSelectionTryOnce=false");
+
+   start = bson_get_monotonic_time ();
+   BSON_ASSERT (!mongoc_client_read_command_with_opts (
+      client,
+      "db",
+      tmp_bson ("{'ping': 1}"),
+      NULL,
+      tmp_bson ("{'timeoutMS': 100}"),
+      NULL,
+      &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_SERVER_SELECTION,
+                          MONGOC_ERROR_SERVER_SELECTION_FAILURE,
+                          "`timeoutMS` expired");
+   ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, (int64_t) 5000000);
+
+   mongoc_client_destroy (client);
+}
+
+
 #ifdef MONGOC_ENABLE_SSL
 static void
 test_set_ssl_opts (void)
@@ -3490,6 +3884,16 @@ test_client_install (TestSuite *suite)
       suite, "/Client/command_with_opts", test_command_with_opts);
    TestSuite_AddMockServerTest (
       suite, "/Client/command_with_opts/op_msg", test_command_with_opts_op_msg);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/command_with_opts/borrowed",
+                                test_command_with_opts_borrowed);
+   TestSuite_AddMockServerTest (
+      suite, "/Client/command_batch/pipelined", test_command_batch_pipelined);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/command_batch/in_flight_limit",
+                                test_command_batch_in_flight_limit);
+   TestSuite_AddMockServerTest (
+      suite, "/Client/command_batch/error", test_command_batch_error);
    TestSuite_AddMockServerTest (
       suite, "/Client/command_with_opts/read", test_read_command_with_opts);
    TestSuite_AddLive (suite, "/Client/command/empty", test_command_empty);
@@ -3643,4 +4047,11 @@ test_client_install (TestSuite *suite)
                       NULL,
                       NULL,
                       test_framework_skip_if_slow);
+   TestSuite_AddMockServerTest (
+      suite, "/Client/timeout_ms/max_time_ms", test_timeout_ms_max_time_ms);
+   TestSuite_AddMockServerTest (
+      suite, "/Client/timeout_ms/expires", test_timeout_ms_expires);
+   TestSuite_Add (suite,
+                  "/Client/timeout_ms/server_selection",
+                  test_timeout_ms_server_selection);
 }
@@ -2,6 +2,7 @@
 #include <mongoc.h>
 
 #include "mongoc-client-private.h"
+#include "mongoc-compression-private.h"
 #include "mongoc-uri-private.h"
 
 #include "mock_server/mock-server.h"
@@ -1553,6 +1554,406 @@ test_advanced_cluster_time_not_sent_to_standalone (void)
    mock_server_destroy (server);
 }
 
+static void
+_test_compression_round_trip (const char *compressor, const char *uri_opts)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   char *ismaster;
+   char *uri_str;
+   char *big;
+   bson_t doc = BSON_INITIALIZER;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+
+   ismaster = bson_strdup_printf ("{'ok': 1.0,"
+                                  " 'ismaster': true,"
+                                  " 'minWireVersion': 0,"
+                                  " 'maxWireVersion': %d,"
+                                  " 'compression': ['%s']}",
+                                  WIRE_VERSION_OP_MSG,
+                                  compressor);
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server, ismaster);
+   mock_server_run (server);
+
+   uri_str = bson_strdup_printf ("mongodb://%s/?compressors=%s%s",
+                                 mock_server_get_host_and_port (server),
+                                 compressor,
+                                 uri_opts);
+   uri = mongoc_uri_new (uri_str);
+   client = mongoc_client_new_from_uri (uri);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   /* a repetitive payload so every codec actually shrinks the message */
+   big = bson_malloc (4096 + 1);
+   memset (big, 'a', 4096);
+   big[4096] = '\0';
+   BSON_APPEND_UTF8 (&doc, "big", big);
+
+   future = future_collection_insert_one (
+      collection, &doc, NULL, NULL, &error);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'insert': 'coll'}"), &doc);
+   ASSERT_CMPINT32 (
+      request->compressor_id, ==, mongoc_compressor_name_to_id (compressor));
+   ASSERT_CMPSIZE_T (request->data_len, >, (size_t) 4096);
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+   request_destroy (request);
+
+   /* commands are compressed too, not just write payloads */
+   future = future_client_command_simple (
+      client, "db", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request =
+      mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   ASSERT_CMPINT32 (
+      request->compressor_id, ==, mongoc_compressor_name_to_id (compressor));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   bson_free (big);
+   bson_destroy (&doc);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mongoc_uri_destroy (uri);
+   bson_free (uri_str);
+   bson_free (ismaster);
+   mock_server_destroy (server);
+}
+
+
+#ifdef MONGOC_ENABLE_COMPRESSION_SNAPPY
+static void
+test_compression_round_trip_snappy (void)
+{
+   _test_compression_round_trip ("snappy", "");
+}
+#endif
+
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+static void
+test_compression_round_trip_zlib (void)
+{
+   _test_compression_round_trip ("zlib", "&zlibCompressionLevel=9");
+}
+#endif
+
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+static void
+test_compression_round_trip_zstd (void)
+{
+   _test_compression_round_trip ("zstd", "&zstdCompressionLevel=19");
+}
+#endif
+
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+static int32_t
+_insert_and_get_compressor (mock_server_t *server,
+                            mongoc_collection_t *collection,
+                            const bson_t *doc)
+{
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   int32_t compressor_id;
+
+   future =
+      future_collection_insert_one (collection, doc, NULL, NULL, &error);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'insert': 'coll'}"), doc);
+   compressor_id = request->compressor_id;
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+   request_destroy (request);
+
+   return compressor_id;
+}
+
+
+static mock_server_t *
+_compression_policy_server_new (const char *uri_opts,
+                                mongoc_client_t **client,
+                                mongoc_collection_t **collection)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   char *uri_str;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'compression': ['zlib']}",
+                              WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+
+   uri_str = bson_strdup_printf ("mongodb://%s/?compressors=zlib%s",
+                                 mock_server_get_host_and_port (server),
+                                 uri_opts);
+   uri = mongoc_uri_new (uri_str);
+   *client = mongoc_client_new_from_uri (uri);
+   *collection = mongoc_client_get_collection (*client, "db", "coll");
+
+   mongoc_uri_destroy (uri);
+   bson_free (uri_str);
+
+   return server;
+}
+
+
+static void
+test_compression_policy_threshold (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   char big[2048];
+   bson_t doc = BSON_INITIALIZER;
+
+   server = _compression_policy_server_new (
+      "&compressionThresholdBytes=1000", &client, &collection);
+
+   /* a tiny insert is sent uncompressed */
+   ASSERT_CMPINT32 (_insert_and_get_compressor (
+                       server, collection, tmp_bson ("{'_id': 1}")),
+                    ==,
+                    -1);
+
+   memset (big, 'a', sizeof big - 1);
+   big[sizeof big - 1] = '\0';
+   BSON_APPEND_UTF8 (&doc, "big", big);
+   ASSERT_CMPINT32 (_insert_and_get_compressor (server, collection, &doc),
+                    ==,
+                    MONGOC_COMPRESSOR_ZLIB_ID);
+
+   bson_destroy (&doc);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_compression_policy_backoff (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   uint8_t noise[2048];
+   char big[2048];
+   bson_t doc;
+   uint32_t seed = 1;
+   int i;
+   size_t j;
+
+   server = _compression_policy_server_new (
+      "&compressionMinSavingsPercent=50", &client, &collection);
+
+   /* incompressible payloads: each is compressed until the window ends */
+   for (i = 0; i < MONGOC_COMPRESSION_POLICY_WINDOW; i++) {
+      for (j = 0; j < sizeof noise; j++) {
+         seed = seed * 1103515245u + 12345u;
+         noise[j] = (uint8_t) (seed >> 16);
+      }
+
+      bson_init (&doc);
+      BSON_APPEND_INT32 (&doc, "_id", i);
+      BSON_APPEND_BINARY (
+         &doc, "noise", BSON_SUBTYPE_BINARY, noise, sizeof noise);
+      ASSERT_CMPINT32 (_insert_and_get_compressor (server, collection, &doc),
+                       ==,
+                       MONGOC_COMPRESSOR_ZLIB_ID);
+      bson_destroy (&doc);
+   }
+
+   /* the policy has backed off, even a compressible payload is sent as is */
+   memset (big, 'a', sizeof big - 1);
+   big[sizeof big - 1] = '\0';
+   bson_init (&doc);
+   BSON_APPEND_UTF8 (&doc, "big", big);
+   ASSERT_CMPINT32 (
+      _insert_and_get_compressor (server, collection, &doc), ==, -1);
+   bson_destroy (&doc);
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+#endif
+
+
+#ifdef MONGOC_ENABLE_CRYPTO
+typedef struct {
+   /* reply to speculativeAuthenticate, else the server doesn't support it */
+   bool accept;
+   int n_speculative;
+} speculative_auth_test_t;
+
+
+static bool
+_speculative_auth_ismaster (request_t *request, void *data)
+{
+   speculative_auth_test_t *test;
+   const bson_t *cmd;
+   bson_iter_t iter;
+   bson_t first_step;
+   bson_t reply;
+   bson_t speculative_reply;
+   const uint8_t *payload;
+   uint32_t payload_len;
+   bson_subtype_t subtype;
+   char *nonce;
+   char *server_first;
+
+   if (!request->is_command ||
+       strcasecmp (request->command_name, "ismaster") != 0) {
+      return false;
+   }
+
+   test = (speculative_auth_test_t *) data;
+   cmd = request_get_doc (request, 0);
+
+   bson_copy_to (tmp_bson ("{'ok': 1, 'ismaster': true,"
+                           " 'minWireVersion': 0, 'maxWireVersion': %d}",
+                           WIRE_VERSION_OP_MSG),
+                 &reply);
+
+   /* the topology scanner's ismaster doesn't authenticate */
+   if (bson_iter_init_find (&iter, cmd, "speculativeAuthenticate")) {
+      test->n_speculative++;
+      bson_iter_bson (&iter, &first_step);
+      ASSERT_MATCH (&first_step,
+                    "{'saslStart': 1, 'mechanism': 'SCRAM-SHA-256',"
+                    " 'db': 'admin'}");
+
+      if (test->accept) {
+         BSON_ASSERT (bson_iter_init_find (&iter, &first_step, "payload"));
+         bson_iter_binary (&iter, &subtype, &payload_len, &payload);
+
+         /* client-first is "n,,n=user,r=<nonce>" */
+         nonce = strstr ((const char *) payload, ",r=");
+         BSON_ASSERT (nonce);
+         nonce = bson_strndup (
+            nonce + 3, payload_len - (nonce + 3 - (const char *) payload));
+         /* SCRAM-SHA-256 takes a 28-byte salt */
+         server_first = bson_strdup_printf (
+            "r=%sMOCK,s=AAECAwQFBgcICQoLDA0ODxAREhMUFRYXGBkaGw==,i=4096",
+            nonce);
+
+         bson_init (&speculative_reply);
+         BSON_APPEND_INT32 (&speculative_reply, "conversationId", 1);
+         BSON_APPEND_BOOL (&speculative_reply, "done", false);
+         bson_append_binary (&speculative_reply,
+                             "payload",
+                             7,
+                             BSON_SUBTYPE_BINARY,
+                             (const uint8_t *) server_first,
+                             (uint32_t) strlen (server_first));
+         BSON_APPEND_DOCUMENT (
+            &reply, "speculativeAuthenticate", &speculative_reply);
+
+         bson_destroy (&speculative_reply);
+         bson_free (server_first);
+         bson_free (nonce);
+      }
+
+      bson_destroy (&first_step);
+   }
+
+   mock_server_reply_multi (request, MONGOC_REPLY_NONE, &reply, 1, 0);
+
+   bson_destroy (&reply);
+   request_destroy (request);
+
+   return true;
+}
+
+
+static void
+_test_speculative_auth_scram (bool accept)
+{
+   speculative_auth_test_t test = {0};
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   future_t *future;
+   request_t *request;
+
+   test.accept = accept;
+   server = mock_server_new ();
+   mock_server_autoresponds (server, _speculative_auth_ismaster, &test, NULL);
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_username (uri, "user");
+   mongoc_uri_set_password (uri, "password");
+   mongoc_uri_set_auth_mechanism (uri, "SCRAM-SHA-256");
+   pool = mongoc_client_pool_new (uri);
+   client = mongoc_client_pool_pop (pool);
+   /* suppress the auth failure logs from pooled clients. */
+   capture_logs (true);
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, NULL);
+
+   if (accept) {
+      /* continue from the reply embedded in the handshake */
+      request = mock_server_receives_msg (
+         server,
+         MONGOC_QUERY_NONE,
+         tmp_bson ("{'saslContinue': 1, 'conversationId': 1}"));
+   } else {
+      request = mock_server_receives_msg (
+         server,
+         MONGOC_QUERY_NONE,
+         tmp_bson ("{'saslStart': 1, 'mechanism': 'SCRAM-SHA-256'}"));
+   }
+
+   /* we're not actually going to auth, just hang up. */
+   mock_server_hangs_up (request);
+   BSON_ASSERT (!future_get_bool (future));
+   ASSERT_CMPINT (test.n_speculative, ==, 1);
+
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   capture_logs (false);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_speculative_auth_scram (void)
+{
+   _test_speculative_auth_scram (true);
+}
+
+
+static void
+test_speculative_auth_scram_fallback (void)
+{
+   _test_speculative_auth_scram (false);
+}
+#endif
+
+
 void
 test_cluster_install (TestSuite *suite)
 {
@@ -1688,4 +2089,32 @@ test_cluster_install (TestSuite *suite)
    TestSuite_AddMockServerTest (suite,
                                 "/Cluster/command_error/op_query",
                                 test_cluster_command_error_op_query);
+#ifdef MONGOC_ENABLE_CRYPTO
+   TestSuite_AddMockServerTest (
+      suite, "/Cluster/speculative_auth/scram", test_speculative_auth_scram);
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/speculative_auth/scram/fallback",
+                                test_speculative_auth_scram_fallback);
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_SNAPPY
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/compression/round_trip/snappy",
+                                test_compression_round_trip_snappy);
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/compression/round_trip/zlib",
+                                test_compression_round_trip_zlib);
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/compression/policy/threshold",
+                                test_compression_policy_threshold);
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/compression/policy/backoff",
+                                test_compression_policy_backoff);
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/compression/round_trip/zstd",
+                                test_compression_round_trip_zstd);
+#endif
 }
@@ -2233,6 +2233,229 @@ test_find_error_is_alive (void)
 }
 
 
+#define PREFETCH_GETMORE \
+   "{'getMore': {'$numberLong': '123'}, 'collection': 'test'}"
+
+static request_t *
+_receives_prefetch_getmore (mock_server_t *server)
+{
+   return mock_server_receives_msg (
+      server, MONGOC_MSG_NONE, tmp_bson (PREFETCH_GETMORE));
+}
+
+static void
+_replies_next_batch (request_t *request, int64_t cursor_id, int n)
+{
+   char *reply;
+
+   reply = bson_strdup_printf ("{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '%" PRId64 "'},"
+                               "   'ns': 'db.test',"
+                               "   'nextBatch': [{'_id': %d}]}}",
+                               cursor_id,
+                               n);
+   mock_server_replies_simple (request, reply);
+   bson_free (reply);
+}
+
+/* the cursor sends getMores as soon as it returns a batch, before the
+ * application asks for the next one */
+static void
+test_cursor_prefetch (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   request_t *getmores[3];
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "test");
+   cursor = mongoc_collection_find_with_opts (
+      collection,
+      tmp_bson ("{}"),
+      tmp_bson ("{'batchSize': 1, 'prefetch': 2}"),
+      NULL);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_NONE,
+      tmp_bson ("{'find': 'test', 'batchSize': 1,"
+                " 'prefetch': {'$exists': false}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '123'},"
+                               "   'ns': 'db.test',"
+                               "   'firstBatch': [{'_id': 1}]}}");
+   request_destroy (request);
+
+   /* two getMores are in flight while the application holds the first
+    * batch */
+   getmores[0] = _receives_prefetch_getmore (server);
+   getmores[1] = _receives_prefetch_getmore (server);
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'_id': 1}");
+   future_destroy (future);
+
+   _replies_next_batch (getmores[0], 123, 2);
+   _replies_next_batch (getmores[1], 0, 3);
+
+   /* taking the second batch sends a third getMore */
+   ASSERT (mongoc_cursor_next (cursor, &doc));
+   ASSERT_MATCH (doc, "{'_id': 2}");
+   getmores[2] = _receives_prefetch_getmore (server);
+
+   /* the last batch was already requested, the third getMore's reply is
+    * discarded with the prefetch connection */
+   ASSERT (mongoc_cursor_next (cursor, &doc));
+   ASSERT_MATCH (doc, "{'_id': 3}");
+   ASSERT (!cursor->prefetch);
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   request_destroy (getmores[0]);
+   request_destroy (getmores[1]);
+   request_destroy (getmores[2]);
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+/* "prefetchMaxBytes" limits the getMores in flight, but one is always sent */
+static void
+test_cursor_prefetch_max_bytes (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "test");
+   cursor = mongoc_collection_find_with_opts (
+      collection,
+      tmp_bson ("{}"),
+      tmp_bson ("{'prefetch': 3, 'prefetchMaxBytes': 1}"),
+      NULL);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_NONE,
+      tmp_bson ("{'find': 'test', 'prefetchMaxBytes': {'$exists': false}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '123'},"
+                               "   'ns': 'db.test',"
+                               "   'firstBatch': [{'_id': 1}]}}");
+   request_destroy (request);
+
+   request = _receives_prefetch_getmore (server);
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'_id': 1}");
+   future_destroy (future);
+
+   mock_server_set_request_timeout_msec (server, 100);
+   ASSERT (!mock_server_receives_request (server));
+
+   _replies_next_batch (request, 0, 2);
+   request_destroy (request);
+   ASSERT (mongoc_cursor_next (cursor, &doc));
+   ASSERT_MATCH (doc, "{'_id': 2}");
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* a network error on the prefetch connection closes only that connection,
+ * the client's own connection to the server is still used */
+static void
+test_cursor_prefetch_hangup (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   uint16_t client_port;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "test");
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), tmp_bson ("{'prefetch': 1}"), NULL);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server, MONGOC_MSG_NONE, tmp_bson ("{'find': 'test'}"));
+   client_port = request_get_client_port (request);
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '123'},"
+                               "   'ns': 'db.test',"
+                               "   'firstBatch': [{'_id': 1}]}}");
+   request_destroy (request);
+
+   request = _receives_prefetch_getmore (server);
+   ASSERT_CMPINT (request_get_client_port (request), !=, client_port);
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+
+   mock_server_hangs_up (request);
+   request_destroy (request);
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+   ASSERT (mongoc_cursor_error (cursor, &error));
+   ASSERT_CMPINT (error.domain, ==, MONGOC_ERROR_STREAM);
+   ASSERT (!cursor->prefetch);
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (
+      server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+   ASSERT_CMPINT (request_get_client_port (request), ==, client_port);
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   future = future_cursor_destroy (cursor);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_NONE,
+      tmp_bson ("{'killCursors': 'test',"
+                " 'cursors': [{'$numberLong': '123'}]}"));
+   ASSERT_CMPINT (request_get_client_port (request), ==, client_port);
+   mock_server_replies_ok_and_destroys (request);
+   future_wait (future);
+   future_destroy (future);
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
 void
 test_cursor_install (TestSuite *suite)
 {
@@ -2328,4 +2551,10 @@ test_cursor_install (TestSuite *suite)
       suite, "/Cursor/error_document/command", test_error_document_command);
    TestSuite_AddLive (
       suite, "/Cursor/find_error/is_alive", test_find_error_is_alive);
+   TestSuite_AddMockServerTest (
+      suite, "/Cursor/prefetch", test_cursor_prefetch);
+   TestSuite_AddMockServerTest (
+      suite, "/Cursor/prefetch/max_bytes", test_cursor_prefetch_max_bytes);
+   TestSuite_AddMockServerTest (
+      suite, "/Cursor/prefetch/hangup", test_cursor_prefetch_hangup);
 }
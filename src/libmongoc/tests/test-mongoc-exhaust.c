@@ -538,6 +538,158 @@ test_exhaust_server_err_2nd_batch_pooled (void)
    _mock_test_exhaust (true, SECOND_BATCH, SERVER_ERROR);
 }
 
+static void
+_mock_test_exhaust_op_msg (bool pooled, bool destroy_mid_stream)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool = NULL;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   uint32_t server_id;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_EXHAUST_GETMORE);
+   mock_server_run (server);
+
+   if (pooled) {
+      pool = mongoc_client_pool_new (mock_server_get_uri (server));
+      client = mongoc_client_pool_pop (pool);
+   } else {
+      client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   }
+
+   collection = mongoc_client_get_collection (client, "db", "test");
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), tmp_bson ("{'exhaust': true}"), NULL);
+
+   /* the find command itself is an ordinary round trip */
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_NONE,
+      tmp_bson ("{'find': 'test', 'exhaust': {'$exists': false}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '123'},"
+                               "   'ns': 'db.test',"
+                               "   'firstBatch': [{'a': 1}]}}");
+   request_destroy (request);
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'a': 1}");
+   future_destroy (future);
+
+   /* one getMore allows the server to stream the remaining batches */
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_EXHAUST_ALLOWED,
+      tmp_bson ("{'getMore': {'$numberLong': '123'}, 'collection': 'test'}"));
+   mock_server_replies_opmsg (request,
+                              MONGOC_MSG_MORE_TO_COME,
+                              tmp_bson ("{'ok': 1, 'cursor': {"
+                                        "   'id': {'$numberLong': '123'},"
+                                        "   'ns': 'db.test',"
+                                        "   'nextBatch': [{'a': 2}]}}"));
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'a': 2}");
+   future_destroy (future);
+   ASSERT (cursor->in_exhaust);
+   ASSERT (client->in_exhaust);
+
+   server_id = mongoc_cursor_get_hint (cursor);
+
+   if (destroy_mid_stream) {
+      /* the only way to stop the stream is to close the connection */
+      mongoc_cursor_destroy (cursor);
+      ASSERT (!client->in_exhaust);
+      ASSERT (!mongoc_cluster_stream_for_server (&client->cluster,
+                                                 server_id,
+                                                 false /* don't reconnect */,
+                                                 NULL,
+                                                 NULL,
+                                                 &error));
+      request_destroy (request);
+      goto done;
+   }
+
+   /* the next batches arrive without the driver sending anything */
+   future = future_cursor_next (cursor, &doc);
+   mock_server_replies_opmsg (request,
+                              MONGOC_MSG_MORE_TO_COME,
+                              tmp_bson ("{'ok': 1, 'cursor': {"
+                                        "   'id': {'$numberLong': '123'},"
+                                        "   'ns': 'db.test',"
+                                        "   'nextBatch': [{'a': 3}]}}"));
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'a': 3}");
+   future_destroy (future);
+
+   future = future_cursor_next (cursor, &doc);
+   mock_server_replies_opmsg (request,
+                              MONGOC_MSG_NONE,
+                              tmp_bson ("{'ok': 1, 'cursor': {"
+                                        "   'id': {'$numberLong': '0'},"
+                                        "   'ns': 'db.test',"
+                                        "   'nextBatch': [{'a': 4}]}}"));
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'a': 4}");
+   future_destroy (future);
+   request_destroy (request);
+
+   ASSERT (!cursor->in_exhaust);
+   ASSERT (!client->in_exhaust);
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   /* no getMore was sent while the server was streaming */
+   mock_server_set_request_timeout_msec (server, 100);
+   ASSERT (!mock_server_receives_request (server));
+
+   /* the connection is usable again */
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   mongoc_cursor_destroy (cursor);
+
+done:
+   mongoc_collection_destroy (collection);
+
+   if (pooled) {
+      mongoc_client_pool_push (pool, client);
+      mongoc_client_pool_destroy (pool);
+   } else {
+      mongoc_client_destroy (client);
+   }
+
+   mock_server_destroy (server);
+}
+
+static void
+test_exhaust_op_msg_single (void)
+{
+   _mock_test_exhaust_op_msg (false, false);
+}
+
+static void
+test_exhaust_op_msg_pooled (void)
+{
+   _mock_test_exhaust_op_msg (true, false);
+}
+
+static void
+test_exhaust_op_msg_destroy (void)
+{
+   _mock_test_exhaust_op_msg (false, true);
+}
+
 void
 test_exhaust_install (TestSuite *suite)
 {
@@ -594,4 +746,13 @@ test_exhaust_install (TestSuite *suite)
       suite,
       "/Client/exhaust_cursor/err/server/2nd_batch/pooled",
       test_exhaust_server_err_2nd_batch_pooled);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/exhaust_cursor/op_msg/single",
+                                test_exhaust_op_msg_single);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/exhaust_cursor/op_msg/pooled",
+                                test_exhaust_op_msg_pooled);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/exhaust_cursor/op_msg/destroy",
+                                test_exhaust_op_msg_destroy);
 }
@@ -680,6 +680,10 @@ test_handshake_platform_config ()
 #ifdef MONGOC_TRACE
    BSON_ASSERT (_get_bit (config_str, MONGOC_MD_FLAG_TRACE));
 #endif
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   BSON_ASSERT (_get_bit (config_str, MONGOC_MD_FLAG_ENABLE_COMPRESSION_ZSTD));
+#endif
    /* any excess bits should all be zero. */
    for (i = LAST_MONGOC_MD_FLAG; i < total_bits; i++) {
       BSON_ASSERT (!_get_bit (config_str, i));
@@ -1046,6 +1046,331 @@ test_aggregate_inherits_read_prefs (void)
 }
 
 
+static void
+test_hedge_valid (void)
+{
+   mongoc_read_prefs_t *prefs;
+
+   prefs = mongoc_read_prefs_new (MONGOC_READ_NEAREST);
+   ASSERT_CMPINT32 (mongoc_read_prefs_get_hedge_delay_ms (prefs), ==, 0);
+   BSON_ASSERT (mongoc_read_prefs_get_hedge_percentile (prefs) == 0);
+
+   mongoc_read_prefs_set_hedge_delay_ms (prefs, 10);
+   mongoc_read_prefs_set_hedge_percentile (prefs, 99.9);
+   BSON_ASSERT (mongoc_read_prefs_is_valid (prefs));
+
+   mongoc_read_prefs_set_hedge_percentile (prefs, 100);
+   BSON_ASSERT (!mongoc_read_prefs_is_valid (prefs));
+   mongoc_read_prefs_set_hedge_percentile (prefs, 0);
+   mongoc_read_prefs_set_hedge_delay_ms (prefs, -1);
+   BSON_ASSERT (!mongoc_read_prefs_is_valid (prefs));
+
+   /* hedging needs a second server, so the primary mode can't use it */
+   mongoc_read_prefs_set_hedge_delay_ms (prefs, 10);
+   mongoc_read_prefs_set_mode (prefs, MONGOC_READ_PRIMARY);
+   BSON_ASSERT (!mongoc_read_prefs_is_valid (prefs));
+
+   mongoc_read_prefs_destroy (prefs);
+}
+
+
+static uint32_t
+_server_id_for_port (mongoc_client_t *client, uint16_t port)
+{
+   mongoc_server_description_t **sds;
+   size_t n;
+   size_t i;
+   uint32_t server_id = 0;
+
+   sds = mongoc_client_get_server_descriptions (client, &n);
+   for (i = 0; i < n; i++) {
+      if (mongoc_server_description_host (sds[i])->port == port) {
+         server_id = mongoc_server_description_id (sds[i]);
+      }
+   }
+
+   mongoc_server_descriptions_destroy_all (sds, n);
+   ASSERT (server_id);
+
+   return server_id;
+}
+
+
+/* the killCursors for a hedged read's losing cursor carries the read's
+ * lsid */
+static void
+_assert_kills_orphan (request_t *slow, request_t *kill)
+{
+   bson_t lsid;
+   bson_t kill_lsid;
+
+   ASSERT_CMPINT (
+      request_get_server_port (kill), ==, request_get_server_port (slow));
+   bson_lookup_doc (request_get_doc (slow, 0), "lsid", &lsid);
+   bson_lookup_doc (request_get_doc (kill, 0), "lsid", &kill_lsid);
+   BSON_ASSERT (match_bson (&kill_lsid, &lsid, false));
+}
+
+
+/* a find that one secondary is slow to answer is sent to the other, which
+ * then owns the cursor */
+static void
+test_hedge_find (void)
+{
+   mock_rs_t *rs;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_read_prefs_t *prefs;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *slow;
+   request_t *request;
+   uint16_t hedge_port;
+   uint32_t slow_id;
+   bson_error_t error;
+
+   /* one primary, two secondaries */
+   rs = mock_rs_with_autoismaster (WIRE_VERSION_OP_MSG, true, 2, 0);
+   mock_rs_run (rs);
+
+   client = mongoc_client_new_from_uri (mock_rs_get_uri (rs));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   prefs = mongoc_read_prefs_new (MONGOC_READ_SECONDARY);
+   mongoc_read_prefs_set_hedge_delay_ms (prefs, 10);
+
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), NULL, prefs);
+   future = future_cursor_next (cursor, &doc);
+
+   slow = mock_rs_receives_msg (rs, 0, tmp_bson ("{'find': 'collection'}"));
+   BSON_ASSERT (mock_rs_request_is_to_secondary (rs, slow));
+
+   /* no reply, so after 10ms the same find goes to the other secondary */
+   request = mock_rs_receives_msg (
+      rs,
+      0,
+      tmp_bson ("{'find': 'collection',"
+                " '$readPreference': {'mode': 'secondary'}}"));
+   BSON_ASSERT (mock_rs_request_is_to_secondary (rs, request));
+   hedge_port = request_get_server_port (request);
+   ASSERT_CMPINT (hedge_port, !=, request_get_server_port (slow));
+
+   mock_server_replies_simple (request,
+                               "{'ok': 1,"
+                               " 'cursor': {"
+                               "    'id': {'$numberLong': '123'},"
+                               "    'ns': 'db.collection',"
+                               "    'firstBatch': [{'_id': 1}]}}");
+
+   BSON_ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'_id': 1}");
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the getMore goes to the server that answered */
+   future = future_cursor_next (cursor, &doc);
+   request = mock_rs_receives_msg (
+      rs, 0, tmp_bson ("{'getMore': {'$numberLong': '123'}}"));
+   ASSERT_CMPINT (request_get_server_port (request), ==, hedge_port);
+   mock_server_replies_simple (request,
+                               "{'ok': 1,"
+                               " 'cursor': {"
+                               "    'id': 0,"
+                               "    'ns': 'db.collection',"
+                               "    'nextBatch': []}}");
+
+   BSON_ASSERT (!future_get_bool (future));
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the slow server's connection stays open: its late reply is read
+    * before the next command, and the cursor it opened is killed */
+   mock_server_replies_simple (slow,
+                               "{'ok': 1,"
+                               " 'cursor': {"
+                               "    'id': {'$numberLong': '456'},"
+                               "    'ns': 'db.collection',"
+                               "    'firstBatch': []}}");
+
+   slow_id = _server_id_for_port (client, request_get_server_port (slow));
+
+   future = future_client_command_with_opts (client,
+                                             "admin",
+                                             tmp_bson ("{'ping': 1}"),
+                                             NULL,
+                                             tmp_bson ("{'serverId': %d}",
+                                                       (int) slow_id),
+                                             NULL,
+                                             &error);
+   request = mock_rs_receives_msg (
+      rs,
+      0,
+      tmp_bson ("{'killCursors': 'collection',"
+                " 'cursors': [{'$numberLong': '456'}]}"));
+   _assert_kills_orphan (slow, request);
+   mock_server_replies_ok_and_destroys (request);
+
+   request = mock_rs_receives_msg (rs, 0, tmp_bson ("{'ping': 1}"));
+   ASSERT_CMPINT (
+      request_get_server_port (request), ==, request_get_server_port (slow));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+
+   future_destroy (future);
+   request_destroy (slow);
+   mongoc_cursor_destroy (cursor);
+   mongoc_read_prefs_destroy (prefs);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_rs_destroy (rs);
+}
+
+
+/* run a find that the other secondary answers first, and return the slow
+ * secondary's request, which it has not answered yet */
+static request_t *
+_hedge_find_loses (mock_rs_t *rs, mongoc_collection_t *collection)
+{
+   mongoc_read_prefs_t *prefs;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *slow;
+   request_t *request;
+
+   prefs = mongoc_read_prefs_new (MONGOC_READ_SECONDARY);
+   mongoc_read_prefs_set_hedge_delay_ms (prefs, 10);
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), NULL, prefs);
+   future = future_cursor_next (cursor, &doc);
+
+   slow = mock_rs_receives_msg (rs, 0, tmp_bson ("{'find': 'collection'}"));
+   request = mock_rs_receives_msg (rs, 0, tmp_bson ("{'find': 'collection'}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1,"
+                               " 'cursor': {"
+                               "    'id': 0,"
+                               "    'ns': 'db.collection',"
+                               "    'firstBatch': [{'_id': 1}]}}");
+
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_cursor_destroy (cursor);
+   mongoc_read_prefs_destroy (prefs);
+
+   mock_server_replies_simple (slow,
+                               "{'ok': 1,"
+                               " 'cursor': {"
+                               "    'id': {'$numberLong': '456'},"
+                               "    'ns': 'db.collection',"
+                               "    'firstBatch': []}}");
+
+   return slow;
+}
+
+
+/* an exhaust cursor on a 3.6 server sends OP_QUERY, which must not take a
+ * hedged read's late reply for its own */
+static void
+test_hedge_exhaust (void)
+{
+   mock_rs_t *rs;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *slow;
+   request_t *request;
+   uint32_t slow_id;
+   bson_error_t error;
+
+   rs = mock_rs_with_autoismaster (WIRE_VERSION_OP_MSG, true, 2, 0);
+   mock_rs_run (rs);
+
+   client = mongoc_client_new_from_uri (mock_rs_get_uri (rs));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   slow = _hedge_find_loses (rs, collection);
+
+   slow_id = _server_id_for_port (client, request_get_server_port (slow));
+   cursor = mongoc_collection_find_with_opts (
+      collection,
+      tmp_bson ("{}"),
+      tmp_bson ("{'exhaust': true, 'serverId': %d}", (int) slow_id),
+      NULL);
+   future = future_cursor_next (cursor, &doc);
+
+   /* the late reply is read, and its cursor killed, before the OP_QUERY */
+   request = mock_rs_receives_msg (
+      rs,
+      0,
+      tmp_bson ("{'killCursors': 'collection',"
+                " 'cursors': [{'$numberLong': '456'}]}"));
+   _assert_kills_orphan (slow, request);
+   mock_server_replies_ok_and_destroys (request);
+
+   request = mock_rs_receives_request (rs);
+   ASSERT_CMPINT (request->opcode, ==, MONGOC_OPCODE_QUERY);
+   BSON_ASSERT (request_matches_flags (
+      request, MONGOC_QUERY_SLAVE_OK | MONGOC_QUERY_EXHAUST));
+   ASSERT_CMPINT (
+      request_get_server_port (request), ==, request_get_server_port (slow));
+   mock_rs_replies (request, 0, 0, 0, 1, "{'_id': 2}");
+
+   BSON_ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'_id': 2}");
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   future_destroy (future);
+   request_destroy (request);
+   request_destroy (slow);
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_rs_destroy (rs);
+}
+
+
+/* a client destroyed with a hedged read's reply still due kills the
+ * losing cursor, before it ends the read's session */
+static void
+test_hedge_destroy (void)
+{
+   mock_rs_t *rs;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   future_t *future;
+   request_t *slow;
+   request_t *request;
+
+   rs = mock_rs_with_autoismaster (WIRE_VERSION_OP_MSG, true, 2, 0);
+   mock_rs_run (rs);
+
+   client = mongoc_client_new_from_uri (mock_rs_get_uri (rs));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   slow = _hedge_find_loses (rs, collection);
+   mongoc_collection_destroy (collection);
+
+   future = future_client_destroy (client);
+   request = mock_rs_receives_msg (
+      rs,
+      0,
+      tmp_bson ("{'killCursors': 'collection',"
+                " 'cursors': [{'$numberLong': '456'}]}"));
+   _assert_kills_orphan (slow, request);
+   mock_server_replies_ok_and_destroys (request);
+   future_wait (future);
+
+   future_destroy (future);
+   request_destroy (slow);
+   mock_rs_destroy (rs);
+}
+
+
 void
 test_read_prefs_install (TestSuite *suite)
 {
@@ -1083,4 +1408,11 @@ test_read_prefs_install (TestSuite *suite)
       suite, "/ReadPrefs/OP_MSG/mongos", test_op_msg_direct_mongos);
    TestSuite_AddMockServerTest (
       suite, "/ReadPrefs/OP_MSG/readPrefs", test_aggregate_inherits_read_prefs);
+   TestSuite_Add (suite, "/ReadPrefs/hedge/valid", test_hedge_valid);
+   TestSuite_AddMockServerTest (
+      suite, "/ReadPrefs/hedge/find", test_hedge_find);
+   TestSuite_AddMockServerTest (
+      suite, "/ReadPrefs/hedge/exhaust", test_hedge_exhaust);
+   TestSuite_AddMockServerTest (
+      suite, "/ReadPrefs/hedge/destroy", test_hedge_destroy);
 }
@@ -8,6 +8,7 @@
 
 #include "TestSuite.h"
 #include "mongoc-cluster-private.h"
+#include "mongoc-compression-private.h"
 
 
 static uint8_t *
@@ -660,6 +661,81 @@ test_mongoc_rpc_buffer_iov (void)
 }
 
 
+static void
+_test_compress_iovec (int32_t compressor_id)
+{
+   /* segment sizes chosen so the 16-byte header skip straddles segments */
+   size_t lens[] = {7, 5, 9, 0, 1000, 1, 30000, 3, 17000};
+   mongoc_iovec_t iov[sizeof lens / sizeof lens[0]];
+   size_t iovcnt = sizeof lens / sizeof lens[0];
+   uint8_t *data;
+   size_t total = 0;
+   size_t offset = 0;
+   size_t i;
+   char *compressed;
+   size_t compressed_len;
+   uint8_t *uncompressed;
+   size_t uncompressed_len;
+
+   for (i = 0; i < iovcnt; i++) {
+      total += lens[i];
+   }
+
+   data = bson_malloc (total);
+   for (i = 0; i < total; i++) {
+      /* compressible, but not trivially so */
+      data[i] = (uint8_t) ((i % 251) ^ (i / 4096));
+   }
+
+   for (i = 0; i < iovcnt; i++) {
+      iov[i].iov_base = (char *) data + offset;
+      iov[i].iov_len = lens[i];
+      offset += lens[i];
+   }
+
+   compressed_len =
+      mongoc_compressor_max_compressed_length (compressor_id, total - 16);
+   compressed = bson_malloc (compressed_len);
+   ASSERT (mongoc_compress_iovec (
+      compressor_id, -1, iov, iovcnt, 16, compressed, &compressed_len));
+
+   uncompressed_len = total - 16;
+   uncompressed = bson_malloc (uncompressed_len);
+   ASSERT (mongoc_uncompress (compressor_id,
+                              (const uint8_t *) compressed,
+                              compressed_len,
+                              uncompressed,
+                              &uncompressed_len));
+
+   ASSERT_CMPSIZE_T (uncompressed_len, ==, total - 16);
+   ASSERT_MEMCMP (uncompressed, data + 16, (int) uncompressed_len);
+
+   if (compressor_id != MONGOC_COMPRESSOR_NOOP_ID) {
+      ASSERT_CMPSIZE_T (compressed_len, <, total - 16);
+   }
+
+   bson_free (uncompressed);
+   bson_free (compressed);
+   bson_free (data);
+}
+
+
+static void
+test_mongoc_rpc_compress_iovec (void)
+{
+   _test_compress_iovec (MONGOC_COMPRESSOR_NOOP_ID);
+#ifdef MONGOC_ENABLE_COMPRESSION_SNAPPY
+   _test_compress_iovec (MONGOC_COMPRESSOR_SNAPPY_ID);
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   _test_compress_iovec (MONGOC_COMPRESSOR_ZLIB_ID);
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   _test_compress_iovec (MONGOC_COMPRESSOR_ZSTD_ID);
+#endif
+}
+
+
 void
 test_rpc_install (TestSuite *suite)
 {
@@ -683,4 +759,6 @@ test_rpc_install (TestSuite *suite)
    TestSuite_Add (suite, "/Rpc/update/gather", test_mongoc_rpc_update_gather);
    TestSuite_Add (suite, "/Rpc/update/scatter", test_mongoc_rpc_update_scatter);
    TestSuite_Add (suite, "/Rpc/buffer/iov", test_mongoc_rpc_buffer_iov);
+   TestSuite_Add (
+      suite, "/Rpc/compress/iovec", test_mongoc_rpc_compress_iovec);
 }
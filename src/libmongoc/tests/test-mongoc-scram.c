@@ -129,6 +129,48 @@ test_mongoc_scram_sasl_prep (void)
    }
 #endif
 }
+
+
+static void
+_check_pbkdf2 (mongoc_crypto_hash_algorithm_t algorithm,
+               size_t output_len,
+               const char *expected)
+{
+   mongoc_crypto_t crypto;
+   unsigned char output[32];
+   char hex[65];
+   size_t i;
+
+   mongoc_crypto_init (&crypto, algorithm);
+   ASSERT (mongoc_crypto_pbkdf2 (&crypto,
+                                 "password",
+                                 8,
+                                 (const uint8_t *) "salt",
+                                 4,
+                                 4096,
+                                 output_len,
+                                 output));
+
+   for (i = 0; i < output_len; i++) {
+      bson_snprintf (hex + 2 * i, 3, "%02x", output[i]);
+   }
+
+   ASSERT_CMPSTR (hex, expected);
+}
+
+
+static void
+test_mongoc_scram_pbkdf2 (void)
+{
+   /* RFC 6070 */
+   _check_pbkdf2 (MONGOC_CRYPTO_ALGORITHM_SHA_1,
+                  20,
+                  "4b007901b765489abead49d926f721d065a429c1");
+   _check_pbkdf2 (
+      MONGOC_CRYPTO_ALGORITHM_SHA_256,
+      32,
+      "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a");
+}
 #endif
 
 static void
@@ -553,6 +595,7 @@ test_scram_install (TestSuite *suite)
    TestSuite_Add (suite, "/scram/sasl_prep", test_mongoc_scram_sasl_prep);
    TestSuite_Add (
       suite, "/scram/iteration_count", test_mongoc_scram_iteration_count);
+   TestSuite_Add (suite, "/scram/pbkdf2", test_mongoc_scram_pbkdf2);
 #endif
    TestSuite_AddFull (suite,
                       "/scram/auth_tests",
@@ -3,6 +3,10 @@
 
 #ifdef MONGOC_ENABLE_SSL_OPENSSL
 #include <openssl/err.h>
+#include "mongoc-client-private.h"
+#include "mongoc-openssl-private.h"
+#include "mongoc-stream-tls-openssl-private.h"
+#include "mongoc-stream-tls-private.h"
 #endif
 
 #include "ssl-test.h"
@@ -385,6 +389,111 @@ test_mongoc_tls_trust_dir (void)
 }
 #endif
 
+
+#ifdef MONGOC_ENABLE_SSL_OPENSSL
+static void
+test_mongoc_tls_session_cache (void)
+{
+   mongoc_openssl_session_cache_t *cache;
+   mongoc_client_t *client;
+   SSL_CTX *ctx;
+   SSL *ssl;
+   SSL_SESSION *first;
+   SSL_SESSION *second;
+
+   ctx = SSL_CTX_new (SSLv23_client_method ());
+   BSON_ASSERT (ctx);
+   ssl = SSL_new (ctx);
+   BSON_ASSERT (ssl);
+
+   cache = _mongoc_openssl_session_cache_new ();
+   BSON_ASSERT (!_mongoc_openssl_session_cache_apply (cache, "a:27017", ssl));
+
+   /* the cache takes ownership of the session */
+   first = SSL_SESSION_new ();
+   _mongoc_openssl_session_cache_put (cache, "a:27017", first);
+   BSON_ASSERT (_mongoc_openssl_session_cache_apply (cache, "a:27017", ssl));
+   BSON_ASSERT (SSL_get_session (ssl) == first);
+
+   /* sessions are per host */
+   BSON_ASSERT (!_mongoc_openssl_session_cache_apply (cache, "b:27017", ssl));
+
+   /* a newer session replaces the cached one */
+   second = SSL_SESSION_new ();
+   _mongoc_openssl_session_cache_put (cache, "a:27017", second);
+   BSON_ASSERT (_mongoc_openssl_session_cache_apply (cache, "a:27017", ssl));
+   BSON_ASSERT (SSL_get_session (ssl) == second);
+
+   SSL_free (ssl);
+   SSL_CTX_free (ctx);
+   _mongoc_openssl_session_cache_destroy (cache);
+
+   /* the cache is opt-in */
+   client = mongoc_client_new ("mongodb://localhost/");
+   BSON_ASSERT (!client->topology->scanner->tls_session_cache);
+   mongoc_client_destroy (client);
+
+   client = mongoc_client_new ("mongodb://localhost/?sslsessioncache=true");
+   BSON_ASSERT (client->topology->scanner->tls_session_cache);
+   mongoc_client_destroy (client);
+}
+
+
+static mongoc_stream_t *
+_tls_stream_over (mongoc_stream_t *base_stream)
+{
+   mongoc_ssl_opt_t opt = {0};
+   mongoc_stream_t *stream;
+
+   opt.weak_cert_validation = true;
+   stream = mongoc_stream_tls_new_with_hostname (
+      base_stream, "localhost", &opt, true);
+   BSON_ASSERT (stream);
+
+   return stream;
+}
+
+
+static void
+test_mongoc_tls_ktls (void)
+{
+   mongoc_socket_t *sock;
+   mongoc_stream_t *stream;
+   mongoc_stream_tls_openssl_t *openssl;
+   mongoc_uri_t *uri;
+   bool enabled;
+
+   uri = mongoc_uri_new ("mongodb://localhost/?sslktls=true");
+   BSON_ASSERT (mongoc_uri_get_option_as_bool (uri, MONGOC_URI_SSLKTLS, false));
+   mongoc_uri_destroy (uri);
+
+   sock = mongoc_socket_new (AF_INET, SOCK_STREAM, 0);
+   BSON_ASSERT (sock);
+   stream = _tls_stream_over (mongoc_stream_socket_new (sock));
+   openssl =
+      (mongoc_stream_tls_openssl_t *) ((mongoc_stream_tls_t *) stream)->ctx;
+
+   enabled = _mongoc_stream_tls_openssl_enable_ktls (stream);
+#if defined(__linux__) && defined(SSL_OP_ENABLE_KTLS) && \
+   !defined(OPENSSL_NO_KTLS)
+   BSON_ASSERT (enabled);
+#endif
+   ASSERT_CMPINT (openssl->socket_bio, ==, enabled);
+
+   /* record encryption is only handed to the kernel during a handshake */
+   BSON_ASSERT (!openssl->ktls_send);
+   mongoc_stream_destroy (stream);
+
+   /* kTLS needs the socket itself */
+   sock = mongoc_socket_new (AF_INET, SOCK_STREAM, 0);
+   BSON_ASSERT (sock);
+   stream = _tls_stream_over (
+      mongoc_stream_buffered_new (mongoc_stream_socket_new (sock), 1024));
+   BSON_ASSERT (!_mongoc_stream_tls_openssl_enable_ktls (stream));
+   mongoc_stream_destroy (stream);
+}
+#endif
+
 #endif /* !MONGOC_ENABLE_SSL_SECURE_CHANNEL && !MONGOC_ENABLE_SSL_LIBRESSL */
 
 void
@@ -412,6 +521,8 @@ test_stream_tls_install (TestSuite *suite)
    TestSuite_Add (
       suite, "/TLS/weak_cert_validation", test_mongoc_tls_weak_cert_validation);
    TestSuite_Add (suite, "/TLS/crl", test_mongoc_tls_crl);
+   TestSuite_Add (suite, "/TLS/session_cache", test_mongoc_tls_session_cache);
+   TestSuite_Add (suite, "/TLS/ktls", test_mongoc_tls_ktls);
 #endif
 
 #if !defined(__APPLE__) && !defined(_WIN32) && \
@@ -2,6 +2,7 @@
 #include "mongoc-set-private.h"
 #include "mongoc-client-pool-private.h"
 #include "mongoc-client-private.h"
+#include "mongoc-thread-private.h"
 
 #include "TestSuite.h"
 #include "test-libmongoc.h"
@@ -141,6 +142,136 @@ test_get_servers (void)
 }
 
 
+/* selection among mongoses prefers the less loaded of two candidates */
+static void
+test_select_load_aware (void)
+{
+   mongoc_uri_t *uri;
+   mongoc_topology_t *topology;
+   mongoc_topology_description_t *td;
+   mongoc_server_description_t *sd_a;
+   mongoc_server_description_t *sd_b;
+   mongoc_server_description_t *sd_c;
+   mongoc_server_description_t *sd;
+   int n_b = 0;
+   int n_c = 0;
+   int i;
+
+   uri = mongoc_uri_new ("mongodb://a,b,c");
+   topology = mongoc_topology_new (uri, true /* single-threaded */);
+   td = &topology->description;
+
+   sd_a = _sd_for_host (td, "a");
+   sd_b = _sd_for_host (td, "b");
+   sd_c = _sd_for_host (td, "c");
+   mongoc_topology_description_handle_ismaster (
+      td, sd_a->id, tmp_bson ("{'ok': 1, 'msg': 'isdbgrid'}"), 10, NULL);
+   mongoc_topology_description_handle_ismaster (
+      td, sd_b->id, tmp_bson ("{'ok': 1, 'msg': 'isdbgrid'}"), 10, NULL);
+   mongoc_topology_description_handle_ismaster (
+      td, sd_c->id, tmp_bson ("{'ok': 1, 'msg': 'isdbgrid'}"), 10, NULL);
+
+   /* "a" has many commands in flight, so it loses every comparison */
+   for (i = 0; i < 50; i++) {
+      _mongoc_server_description_op_started (sd_a);
+   }
+
+   for (i = 0; i < 100; i++) {
+      sd = mongoc_topology_description_select (td, MONGOC_SS_READ, NULL, 15);
+      BSON_ASSERT (sd);
+      ASSERT_CMPUINT32 (sd->id, !=, sd_a->id);
+      if (sd == sd_b) {
+         n_b++;
+      } else {
+         n_c++;
+      }
+   }
+
+   /* "b" and "c" are equally loaded and both get a share */
+   ASSERT_CMPINT (n_b, >, 0);
+   ASSERT_CMPINT (n_c, >, 0);
+
+   /* "b" is slower, so it is chosen only when paired with "a" */
+   _mongoc_server_description_op_started (sd_b);
+   _mongoc_server_description_op_finished (sd_b, 50 * 1000);
+   _mongoc_server_description_op_started (sd_c);
+   _mongoc_server_description_op_finished (sd_c, 1000);
+   n_b = n_c = 0;
+   for (i = 0; i < 100; i++) {
+      sd = mongoc_topology_description_select (td, MONGOC_SS_READ, NULL, 15);
+      BSON_ASSERT (sd);
+      ASSERT_CMPUINT32 (sd->id, !=, sd_a->id);
+      if (sd == sd_b) {
+         n_b++;
+      } else {
+         n_c++;
+      }
+   }
+
+   ASSERT_CMPINT (n_b, >, 0);
+   ASSERT_CMPINT (n_c, >, n_b);
+
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+}
+
+
+#define LOAD_THREADS 8
+#define LOAD_OPS 10000
+
+static void *
+_op_finished_worker (void *data)
+{
+   mongoc_server_description_t *sd = (mongoc_server_description_t *) data;
+   int i;
+
+   for (i = 0; i < LOAD_OPS; i++) {
+      _mongoc_server_description_op_started (sd);
+      _mongoc_server_description_op_finished (sd, i % 2 ? 1000 : 3000);
+   }
+
+   return NULL;
+}
+
+
+/* many threads feed one server's load counters without the topology mutex */
+static void
+test_server_load_threads (void)
+{
+   mongoc_server_description_t sd;
+   mongoc_thread_t threads[LOAD_THREADS];
+   int64_t ewma;
+   int i;
+
+   mongoc_server_description_init (&sd, "a", 1);
+
+   for (i = 0; i < LOAD_THREADS; i++) {
+      BSON_ASSERT (
+         !mongoc_thread_create (&threads[i], &_op_finished_worker, &sd));
+   }
+
+   for (i = 0; i < LOAD_THREADS; i++) {
+      mongoc_thread_join (threads[i]);
+   }
+
+   ASSERT_CMPINT (sd.load->in_flight, ==, 0);
+   ASSERT_CMPINT (sd.load->n_samples, ==, LOAD_THREADS * LOAD_OPS);
+   ewma = sd.load->latency_ewma_usec;
+   ASSERT_CMPINT64 (ewma, >=, (int64_t) 999);
+   ASSERT_CMPINT64 (ewma, <=, (int64_t) 3000);
+   for (i = 0; i < MONGOC_SERVER_LOAD_SAMPLES; i++) {
+      BSON_ASSERT (sd.load->samples_usec[i] == 1000 ||
+                   sd.load->samples_usec[i] == 3000);
+   }
+
+   ASSERT_CMPINT64 (
+      _mongoc_server_description_latency_percentile (&sd, 100), ==, 3000);
+   ASSERT_CMPINT64 (sd.load->last_sample_usec, >, (int64_t) 0);
+
+   mongoc_server_description_cleanup (&sd);
+}
+
+
 void
 test_topology_description_install (TestSuite *suite)
 {
@@ -151,4 +282,8 @@ test_topology_description_install (TestSuite *suite)
                       "/TopologyDescription/readable_writable/pooled",
                       test_has_readable_writable_server_pooled);
    TestSuite_Add (suite, "/TopologyDescription/get_servers", test_get_servers);
+   TestSuite_Add (
+      suite, "/TopologyDescription/select/load", test_select_load_aware);
+   TestSuite_Add (
+      suite, "/TopologyDescription/load/threads", test_server_load_threads);
 }
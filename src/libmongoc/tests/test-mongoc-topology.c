@@ -1633,6 +1633,231 @@ test_cluster_time_updated_during_handshake ()
    mongoc_uri_destroy (uri);
 }
 
+#define SLOW_MONGOS_DELAY_MSEC 20
+#define SLOW_MONGOS_THREADS 4
+#define SLOW_MONGOS_PINGS 50
+
+typedef struct {
+   mongoc_client_pool_t *pool;
+   int64_t *latencies;
+} slow_mongos_ctx_t;
+
+
+static bool
+_slow_mongos_ping (request_t *request, void *data)
+{
+   if (!request->is_command || strcasecmp (request->command_name, "ping")) {
+      return false;
+   }
+
+   bson_atomic_int_add ((volatile int32_t *) data, 1);
+   _mongoc_usleep (SLOW_MONGOS_DELAY_MSEC * 1000);
+   mock_server_replies_ok_and_destroys (request);
+   return true;
+}
+
+
+static bool
+_fast_mongos_ping (request_t *request, void *data)
+{
+   if (!request->is_command || strcasecmp (request->command_name, "ping")) {
+      return false;
+   }
+
+   bson_atomic_int_add ((volatile int32_t *) data, 1);
+   mock_server_replies_ok_and_destroys (request);
+   return true;
+}
+
+
+static void *
+_slow_mongos_thread (void *data)
+{
+   slow_mongos_ctx_t *ctx = (slow_mongos_ctx_t *) data;
+   mongoc_client_t *client;
+   bson_error_t error;
+   int64_t start;
+   bool r;
+   int i;
+
+   client = mongoc_client_pool_pop (ctx->pool);
+   for (i = 0; i < SLOW_MONGOS_PINGS; i++) {
+      start = bson_get_monotonic_time ();
+      r = mongoc_client_command_simple (
+         client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+      ASSERT_OR_PRINT (r, error);
+      ctx->latencies[i] = bson_get_monotonic_time () - start;
+   }
+
+   mongoc_client_pool_push (ctx->pool, client);
+   return NULL;
+}
+
+
+static int
+_cmp_int64 (const void *a, const void *b)
+{
+   int64_t x = *(const int64_t *) a;
+   int64_t y = *(const int64_t *) b;
+
+   return x < y ? -1 : x > y;
+}
+
+
+/* with one mongos much slower than the other, load-aware selection sends
+ * it only a few commands, so the slow replies stay out of the p90. random
+ * selection within the latency window would send it half of them. */
+static void
+test_select_slow_mongos (void)
+{
+   mock_server_t *slow;
+   mock_server_t *fast;
+   volatile int32_t n_slow = 0;
+   volatile int32_t n_fast = 0;
+   char *uri_str;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   slow_mongos_ctx_t ctx[SLOW_MONGOS_THREADS];
+   mongoc_thread_t threads[SLOW_MONGOS_THREADS];
+   int64_t latencies[SLOW_MONGOS_THREADS * SLOW_MONGOS_PINGS];
+   const size_t n_latencies = sizeof latencies / sizeof latencies[0];
+   int i;
+
+   slow = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   fast = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   mock_server_autoresponds (slow, _slow_mongos_ping, (void *) &n_slow, NULL);
+   mock_server_autoresponds (fast, _fast_mongos_ping, (void *) &n_fast, NULL);
+   mock_server_auto_endsessions (slow);
+   mock_server_auto_endsessions (fast);
+   mock_server_run (slow);
+   mock_server_run (fast);
+
+   /* both mongoses are within the latency window */
+   uri_str = bson_strdup_printf ("mongodb://localhost:%hu,localhost:%hu/"
+                                 "?localThresholdMS=1000",
+                                 mock_server_get_port (slow),
+                                 mock_server_get_port (fast));
+   uri = mongoc_uri_new (uri_str);
+   pool = mongoc_client_pool_new (uri);
+
+   for (i = 0; i < SLOW_MONGOS_THREADS; i++) {
+      ctx[i].pool = pool;
+      ctx[i].latencies = latencies + i * SLOW_MONGOS_PINGS;
+      mongoc_thread_create (&threads[i], _slow_mongos_thread, &ctx[i]);
+   }
+
+   for (i = 0; i < SLOW_MONGOS_THREADS; i++) {
+      mongoc_thread_join (threads[i]);
+   }
+
+   ASSERT_CMPINT (n_slow + n_fast, ==, (int) n_latencies);
+   ASSERT_CMPINT (n_slow, <, (int) n_latencies / 10);
+
+   qsort (latencies, n_latencies, sizeof latencies[0], _cmp_int64);
+   ASSERT_CMPINT64 (latencies[n_latencies * 9 / 10],
+                    <,
+                    (int64_t) SLOW_MONGOS_DELAY_MSEC * 1000);
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   bson_free (uri_str);
+   mock_server_destroy (slow);
+   mock_server_destroy (fast);
+}
+
+
+/* a pooled topology publishes an immutable snapshot of its description,
+ * which server streams borrow instead of copying */
+static void
+test_topology_snapshot (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_topology_snapshot_t *new_snapshot;
+   mongoc_topology_cluster_time_t *cluster_time;
+   mongoc_server_stream_t *server_stream;
+   mongoc_server_stream_t *new_stream;
+   mongoc_server_description_t *sd;
+   bson_error_t error;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_int32 (uri, "heartbeatFrequencyMS", 99999);
+   pool = mongoc_client_pool_new (uri);
+   client = mongoc_client_pool_pop (pool);
+   topology = client->topology;
+
+   server_stream = mongoc_cluster_stream_for_server (
+      &client->cluster, 1, true, NULL, NULL, &error);
+   ASSERT_OR_PRINT (server_stream, error);
+
+   /* the stream's description is the latest snapshot's, not a copy */
+   snapshot = _mongoc_topology_snapshot_acquire (topology, NULL);
+   BSON_ASSERT (snapshot);
+   ASSERT (server_stream->snapshot == snapshot);
+   ASSERT (server_stream->sd == mongoc_topology_description_server_by_id (
+                                   &snapshot->description, 1, NULL));
+   ASSERT_CMPINT (server_stream->sd->type, ==, MONGOC_SERVER_STANDALONE);
+
+   /* a change publishes a new snapshot and leaves the old one alone */
+   bson_set_error (&error, MONGOC_ERROR_STREAM, 0, "invalidated");
+   mongoc_topology_invalidate_server (topology, 1, &error);
+   new_snapshot = _mongoc_topology_snapshot_acquire (topology, NULL);
+   ASSERT (new_snapshot != snapshot);
+   sd = mongoc_topology_description_server_by_id (
+      &new_snapshot->description, 1, NULL);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_UNKNOWN);
+   ASSERT_CMPINT (server_stream->sd->type, ==, MONGOC_SERVER_STANDALONE);
+
+   /* the old snapshot lives until its last reference is released */
+   _mongoc_topology_snapshot_release (snapshot);
+   ASSERT_CMPINT (server_stream->snapshot->refcount, ==, 1);
+   ASSERT_CMPINT (server_stream->sd->type, ==, MONGOC_SERVER_STANDALONE);
+
+   /* an unchanged description is not copied again, nor is a clusterTime */
+   mongoc_mutex_lock (&topology->mutex);
+   _mongoc_topology_publish_snapshot (topology);
+   mongoc_mutex_unlock (&topology->mutex);
+   _mongoc_topology_update_cluster_time (
+      topology,
+      tmp_bson ("{'$clusterTime': {'clusterTime': {'$timestamp': "
+                "{'t': 1, 'i': 1}}}}"));
+   snapshot = _mongoc_topology_snapshot_acquire (topology, &cluster_time);
+   ASSERT (snapshot == new_snapshot);
+   _mongoc_topology_snapshot_release (snapshot);
+
+   /* but server streams still send the latest clusterTime, borrowed */
+   new_stream = _mongoc_cluster_create_server_stream (
+      topology, 1, server_stream->stream, &error);
+   ASSERT_OR_PRINT (new_stream, error);
+   ASSERT (new_stream->snapshot == new_snapshot);
+   ASSERT (new_stream->shared_cluster_time == cluster_time);
+   ASSERT (bson_get_data (&new_stream->cluster_time) ==
+           bson_get_data (&cluster_time->doc));
+   ASSERT (bson_has_field (&new_stream->cluster_time, "clusterTime"));
+   mongoc_server_stream_cleanup (new_stream);
+   _mongoc_topology_cluster_time_release (cluster_time);
+
+   /* with no reader in the way, replaced snapshots and clusterTimes are
+    * reclaimed as soon as they are replaced */
+   mongoc_mutex_lock (&topology->mutex);
+   ASSERT_CMPSIZE_T (topology->retired.len, ==, (size_t) 0);
+   mongoc_mutex_unlock (&topology->mutex);
+
+   mongoc_server_stream_cleanup (server_stream);
+   _mongoc_topology_snapshot_release (new_snapshot);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+
 /* returns the last time the topology completed a full scan. */
 static int64_t
 _get_last_scan (mongoc_client_t *client)
@@ -1894,6 +2119,64 @@ test_request_scan_on_error ()
 }
 
 
+static void
+_assert_cluster_time (mongoc_topology_t *topology, uint32_t t, uint32_t i)
+{
+   uint32_t timestamp;
+   uint32_t increment;
+
+   ASSERT_CMPUINT64 ((uint64_t) topology->cluster_time,
+                     ==,
+                     ((uint64_t) t << 32) | i);
+   BSON_ASSERT (_mongoc_parse_cluster_time (
+      &topology->description.cluster_time, &timestamp, &increment));
+   ASSERT_CMPUINT32 (timestamp, ==, t);
+   ASSERT_CMPUINT32 (increment, ==, i);
+}
+
+
+/* a reply whose clusterTime is not later than the last one seen doesn't
+ * lock the topology mutex; a later one advances the clusterTime */
+static void
+test_cluster_time_not_later (void)
+{
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   const char *reply = "{'$clusterTime': {'clusterTime': "
+                       "{'$timestamp': {'t': %u, 'i': %u}}}}";
+
+   client = mongoc_client_new ("mongodb://localhost");
+   topology = client->topology;
+   ASSERT_CMPINT64 (topology->cluster_time, ==, (int64_t) 0);
+
+   _mongoc_topology_update_cluster_time (topology, tmp_bson (reply, 2, 2));
+   _assert_cluster_time (topology, 2, 2);
+
+   /* would deadlock if the mutex were taken */
+   mongoc_mutex_lock (&topology->mutex);
+   _mongoc_topology_update_cluster_time (topology, tmp_bson (reply, 2, 2));
+   _mongoc_topology_update_cluster_time (topology, tmp_bson (reply, 2, 1));
+   _mongoc_topology_update_cluster_time (topology, tmp_bson (reply, 1, 9));
+   _mongoc_topology_update_cluster_time (topology, tmp_bson ("{'ok': 1}"));
+   mongoc_mutex_unlock (&topology->mutex);
+   _assert_cluster_time (topology, 2, 2);
+
+   _mongoc_topology_update_cluster_time (topology, tmp_bson (reply, 2, 3));
+   _assert_cluster_time (topology, 2, 3);
+
+   /* timestamps compare unsigned */
+   _mongoc_topology_update_cluster_time (topology,
+                                         tmp_bson (reply, 3000000000u, 1));
+   _assert_cluster_time (topology, 3000000000u, 1);
+   mongoc_mutex_lock (&topology->mutex);
+   _mongoc_topology_update_cluster_time (topology, tmp_bson (reply, 4, 1));
+   mongoc_mutex_unlock (&topology->mutex);
+   _assert_cluster_time (topology, 3000000000u, 1);
+
+   mongoc_client_destroy (client);
+}
+
+
 void
 test_topology_install (TestSuite *suite)
 {
@@ -2035,4 +2318,10 @@ test_topology_install (TestSuite *suite)
                                 test_cluster_time_updated_during_handshake);
    TestSuite_AddMockServerTest (
       suite, "/Topology/request_scan_on_error", test_request_scan_on_error);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/snapshot", test_topology_snapshot);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/select/slow_mongos", test_select_slow_mongos);
+   TestSuite_Add (
+      suite, "/Topology/cluster_time/not_later", test_cluster_time_not_later);
 }
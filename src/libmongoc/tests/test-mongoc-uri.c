@@ -1091,6 +1091,61 @@ test_mongoc_uri_compressors (void)
    mongoc_uri_destroy (uri);
 
 #endif
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   uri = mongoc_uri_new ("mongodb://localhost/?compressors=zstd");
+   ASSERT (bson_has_field (mongoc_uri_get_compressors (uri), "zstd"));
+   mongoc_uri_destroy (uri);
+
+   uri = mongoc_uri_new ("mongodb://localhost/");
+   ASSERT (mongoc_uri_set_compressors (uri, "zstd,zlib"));
+   ASSERT (bson_has_field (mongoc_uri_get_compressors (uri), "zstd"));
+   mongoc_uri_destroy (uri);
+#endif
+
+   uri = mongoc_uri_new ("mongodb://localhost/?zstdCompressionLevel=19");
+   ASSERT_CMPINT32 (
+      mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_ZSTDCOMPRESSIONLEVEL, 1),
+      ==,
+      19);
+   mongoc_uri_destroy (uri);
+
+   capture_logs (true);
+   uri = mongoc_uri_new ("mongodb://localhost/?zstdCompressionLevel=0");
+   ASSERT_CAPTURED_LOG (
+      "mongoc_uri_set_compressors",
+      MONGOC_LOG_LEVEL_WARNING,
+      "Invalid \"zstdcompressionlevel\" of 0: must be -1 or between 1 and 22");
+   mongoc_uri_destroy (uri);
+
+   capture_logs (true);
+   uri = mongoc_uri_new ("mongodb://localhost/?zstdCompressionLevel=23");
+   ASSERT_CAPTURED_LOG (
+      "mongoc_uri_set_compressors",
+      MONGOC_LOG_LEVEL_WARNING,
+      "Invalid \"zstdcompressionlevel\" of 23: must be -1 or between 1 and 22");
+   mongoc_uri_destroy (uri);
+
+   uri = mongoc_uri_new ("mongodb://localhost/?compressionThresholdBytes=512"
+                         "&compressionMinSavingsPercent=20");
+   ASSERT_CMPINT32 (mongoc_uri_get_option_as_int32 (
+                       uri, MONGOC_URI_COMPRESSIONTHRESHOLDBYTES, 0),
+                    ==,
+                    512);
+   ASSERT_CMPINT32 (mongoc_uri_get_option_as_int32 (
+                       uri, MONGOC_URI_COMPRESSIONMINSAVINGSPERCENT, 0),
+                    ==,
+                    20);
+   mongoc_uri_destroy (uri);
+
+   capture_logs (true);
+   uri = mongoc_uri_new ("mongodb://localhost/?compressionMinSavingsPercent=101");
+   ASSERT_CAPTURED_LOG (
+      "mongoc_uri_set_compressors",
+      MONGOC_LOG_LEVEL_WARNING,
+      "Invalid \"compressionminsavingspercent\" of 101: must be between 0 "
+      "and 100");
+   mongoc_uri_destroy (uri);
 }
 
 static void
@@ -10,6 +10,7 @@
 
 #include "test-libmongoc.h"
 #include "test-conveniences.h"
+#include "mock_server/mock-server.h"
 
 
 static void
@@ -273,6 +274,132 @@ test_bypass_validation (void *context)
    mongoc_client_destroy (client);
 }
 
+/* appends each inserted document to the bson_t array in data */
+static bool
+_capture_inserts (request_t *request, void *data)
+{
+   bson_t *inserted = (bson_t *) data;
+   const bson_t *doc;
+   bson_iter_t iter;
+   bson_iter_t array;
+   bson_t tmp;
+   uint32_t len;
+   const uint8_t *buf;
+   char str[16];
+   const char *key;
+   int i;
+
+   if (!request->command_name ||
+       strcmp (request->command_name, "insert") != 0) {
+      return false;
+   }
+
+   if (request->docs.len > 1) {
+      /* OP_MSG, the documents follow the command */
+      for (i = 1; i < (int) request->docs.len; i++) {
+         bson_uint32_to_string (
+            bson_count_keys (inserted), &key, str, sizeof str);
+         BSON_APPEND_DOCUMENT (inserted, key, request_get_doc (request, i));
+      }
+   } else {
+      /* an OP_QUERY command with a "documents" array */
+      doc = request_get_doc (request, 0);
+      BSON_ASSERT (bson_iter_init_find (&iter, doc, "documents"));
+      BSON_ASSERT (bson_iter_recurse (&iter, &array));
+      while (bson_iter_next (&array)) {
+         bson_iter_document (&array, &len, &buf);
+         BSON_ASSERT (bson_init_static (&tmp, buf, len));
+         bson_uint32_to_string (
+            bson_count_keys (inserted), &key, str, sizeof str);
+         BSON_APPEND_DOCUMENT (inserted, key, &tmp);
+      }
+   }
+
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   request_destroy (request);
+
+   return true;
+}
+
+
+static void
+_assert_generated_id (const bson_t *inserted, const char *idx, int32_t a)
+{
+   bson_iter_t iter;
+   bson_iter_t doc;
+
+   BSON_ASSERT (bson_iter_init_find (&iter, inserted, idx));
+   BSON_ASSERT (bson_iter_recurse (&iter, &doc));
+
+   /* the generated "_id" comes first, then the caller's fields */
+   BSON_ASSERT (bson_iter_next (&doc));
+   ASSERT_CMPSTR (bson_iter_key (&doc), "_id");
+   BSON_ASSERT (BSON_ITER_HOLDS_OID (&doc));
+   BSON_ASSERT (bson_iter_next (&doc));
+   ASSERT_CMPSTR (bson_iter_key (&doc), "a");
+   ASSERT_CMPINT32 (bson_iter_int32 (&doc), ==, a);
+   BSON_ASSERT (!bson_iter_next (&doc));
+}
+
+
+static void
+_test_borrowed_insert (int32_t max_wire_version)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   bson_t inserted = BSON_INITIALIZER;
+   const bson_t *docs[3];
+   bson_error_t error;
+   bool r;
+
+   server = mock_server_with_autoismaster (max_wire_version);
+   mock_server_autoresponds (server, _capture_inserts, &inserted, NULL);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   docs[0] = tmp_bson ("{'a': 1}");
+   docs[1] = tmp_bson ("{'_id': 2, 'b': 2}");
+   docs[2] = tmp_bson ("{'a': 3}");
+   r = mongoc_collection_insert_many (collection, docs, 3, NULL, NULL, &error);
+   ASSERT_OR_PRINT (r, error);
+
+   r = mongoc_collection_insert_one (
+      collection, tmp_bson ("{'a': 4}"), NULL, NULL, &error);
+   ASSERT_OR_PRINT (r, error);
+
+   ASSERT_CMPINT (bson_count_keys (&inserted), ==, 4);
+   _assert_generated_id (&inserted, "0", 1);
+   ASSERT_MATCH (&inserted, "{'1': {'_id': 2, 'b': 2}}");
+   _assert_generated_id (&inserted, "2", 3);
+   _assert_generated_id (&inserted, "3", 4);
+
+   /* the caller's documents are untouched */
+   ASSERT_CMPINT (bson_count_keys (docs[0]), ==, 1);
+
+   bson_destroy (&inserted);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* documents inserted without copying are sent as an OP_MSG sequence */
+static void
+test_borrowed_insert_op_msg (void)
+{
+   _test_borrowed_insert (WIRE_VERSION_OP_MSG);
+}
+
+
+/* and copied together for an OP_QUERY insert command */
+static void
+test_borrowed_insert_op_query (void)
+{
+   _test_borrowed_insert (WIRE_VERSION_OP_MSG - 1);
+}
+
 void
 test_write_command_install (TestSuite *suite)
 {
@@ -285,4 +412,10 @@ test_write_command_install (TestSuite *suite)
                       NULL,
                       NULL,
                       test_framework_skip_if_max_wire_version_less_than_4);
+   TestSuite_AddMockServerTest (suite,
+                                "/WriteCommand/borrowed_insert/op_msg",
+                                test_borrowed_insert_op_msg);
+   TestSuite_AddMockServerTest (suite,
+                                "/WriteCommand/borrowed_insert/op_query",
+                                test_borrowed_insert_op_query);
 }
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Measure mongoc_client_pool_pop / mongoc_client_pool_push throughput with
+ * 1, 2, 4, ... threads up to the given maximum. No server is contacted.
+ *
+ *   mongoc-client-pool-bench [MAX_THREADS [SECONDS_PER_RUN]]
+ */
+
+
+#include <bson.h>
+#include <mongoc.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+typedef struct {
+   mongoc_client_pool_t *pool;
+   volatile int stop;
+   pthread_t thread;
+   int64_t ops;
+} worker_t;
+
+
+static void *
+worker (void *data)
+{
+   worker_t *w = (worker_t *) data;
+   mongoc_client_t *client;
+   int64_t ops = 0;
+
+   while (!w->stop) {
+      client = mongoc_client_pool_pop (w->pool);
+      mongoc_client_pool_push (w->pool, client);
+      ops++;
+   }
+
+   w->ops = ops;
+
+   return NULL;
+}
+
+
+static double
+run (mongoc_client_pool_t *pool, int n_threads, int seconds)
+{
+   worker_t *workers;
+   int64_t start;
+   int64_t elapsed;
+   int64_t ops = 0;
+   int i;
+
+   workers = (worker_t *) bson_malloc0 (n_threads * sizeof *workers);
+   start = bson_get_monotonic_time ();
+
+   for (i = 0; i < n_threads; i++) {
+      workers[i].pool = pool;
+      if (pthread_create (&workers[i].thread, NULL, worker, &workers[i])) {
+         perror ("pthread_create");
+         abort ();
+      }
+   }
+
+   sleep (seconds);
+
+   for (i = 0; i < n_threads; i++) {
+      workers[i].stop = 1;
+   }
+
+   for (i = 0; i < n_threads; i++) {
+      pthread_join (workers[i].thread, NULL);
+      ops += workers[i].ops;
+   }
+
+   elapsed = bson_get_monotonic_time () - start;
+   bson_free (workers);
+
+   return (double) ops * 1000000.0 / (double) elapsed;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+   mongoc_client_pool_t *pool;
+   mongoc_uri_t *uri;
+   int max_threads = 64;
+   int seconds = 2;
+   double base = 0;
+   double rate;
+   int n;
+
+   if (argc > 1) {
+      max_threads = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      seconds = atoi (argv[2]);
+   }
+
+   if (max_threads < 1 || seconds < 1) {
+      fprintf (stderr, "usage: %s [MAX_THREADS [SECONDS_PER_RUN]]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   mongoc_init ();
+
+   /* never contacted: the scanner just fails to connect in the background */
+   uri = mongoc_uri_new ("mongodb://localhost:1/?maxPoolSize=1024");
+   pool = mongoc_client_pool_new (uri);
+
+   printf ("%8s %14s %10s\n", "threads", "ops/sec", "scaling");
+
+   for (n = 1; n <= max_threads; n *= 2) {
+      rate = run (pool, n, seconds);
+      if (n == 1) {
+         base = rate;
+      }
+
+      printf ("%8d %14.0f %10.2f\n", n, rate, rate / base);
+   }
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mongoc_cleanup ();
+
+   return EXIT_SUCCESS;
+}